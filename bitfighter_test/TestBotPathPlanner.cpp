@@ -0,0 +1,268 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/BotPathPlanner.h"
+#include "../zap/BotNavMeshZone.h"
+#include "../zap/ServerGame.h"
+#include "../zap/LevelSource.h"
+#include "../zap/stringUtils.h"
+
+#include "tnlPlatform.h"
+#include "tnlThread.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+// A big box full of wall stubs, which makes thousands of zones, and a winding way through them
+static string getLevelCode()
+{
+   const S32 StubsPerSide = 40;
+   const S32 Spacing = 3;
+   const S32 Size = StubsPerSide * Spacing + 1;
+
+   string code = "GameType 10 8\nLevelName Stubs\nTeam Blue 0 0 1\n";
+   code += "BarrierMaker 40 -1 -1 " + itos(Size) + " -1 " + itos(Size) + " " + itos(Size) + " -1 " + itos(Size) + " -1 -1\n";
+
+   for(S32 x = 0; x < StubsPerSide; x++)
+      for(S32 y = 0; y < StubsPerSide; y++)
+      {
+         S32 px = x * Spacing + 1;
+         S32 py = y * Spacing + 1;
+
+         // Alternate which way they lie, so the way through isn't always a straight line
+         if((x + y) % 2 == 0)
+            code += "BarrierMaker 40 " + itos(px) + " " + itos(py) + " " + itos(px + 1) + " " + itos(py) + "\n";
+         else
+            code += "BarrierMaker 40 " + itos(px) + " " + itos(py) + " " + itos(px) + " " + itos(py + 1) + "\n";
+      }
+
+   // And long walls, open at alternate ends, so getting from top to bottom means going back and forth
+   for(S32 y = 6; y < Size - 3; y += 6)
+   {
+      if(y % 12 == 0)
+         code += "BarrierMaker 40 -1 " + itos(y) + " " + itos(Size - 4) + " " + itos(y) + "\n";
+      else
+         code += "BarrierMaker 40 3 " + itos(y) + " " + itos(Size) + " " + itos(y) + "\n";
+   }
+
+   return code;
+}
+
+
+// Checks that path leads, zone by zone, from startZone to targetZone: it should be laid out as AStar::findPath makes it,
+// with the target's zone center first, then gateways and the centers of the zones they lead from, back to the start
+static void expectValidPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Vector<Point> &path)
+{
+   ASSERT_GE(path.size(), 3);
+   EXPECT_EQ(zones->get(targetZone)->getCenter(), path[0]);
+   EXPECT_EQ(zones->get(targetZone)->getCenter(), path[1]);
+   EXPECT_EQ(zones->get(startZone)->getCenter(), path.last());
+
+   S32 zone = targetZone;
+
+   // Each gateway must be on the border of a zone that leads to the zone we're in, and that zone's center comes next
+   for(S32 i = 2; i < path.size() - 1; i += 2)
+   {
+      S32 parent = -1;
+
+      for(S32 j = 0; j < zones->size() && parent == -1; j++)
+      {
+         S32 index = zones->get(j)->getNeighborIndex(zone);
+
+         if(index >= 0 && zones->get(j)->mNeighbors[index].borderCenter == path[i] && zones->get(j)->getCenter() == path[i + 1])
+            parent = j;
+      }
+
+      ASSERT_NE(-1, parent) << "No way into zone " << zone << " through " << path[i].toString();
+      zone = parent;
+   }
+
+   EXPECT_EQ(startZone, zone);
+}
+
+
+static bool samePath(const Vector<Point> &path1, const Vector<Point> &path2)
+{
+   if(path1.size() != path2.size())
+      return false;
+
+   for(S32 i = 0; i < path1.size(); i++)
+      if(path1[i] != path2[i])
+         return false;
+
+   return true;
+}
+
+
+class BotPathPlannerTest : public testing::Test
+{
+public:
+   GameSettingsPtr mSettings;
+   ServerGame *mGame;
+
+   void SetUp()
+   {
+      mSettings = GameSettingsPtr(new GameSettings());
+      mSettings->getFolderManager()->cacheDir = "";      // Always build the zones
+
+      mGame = new ServerGame(Address(), mSettings, LevelSourcePtr(new StringLevelSource(getLevelCode())), false, false);
+      mGame->cycleLevel(FIRST_LEVEL);
+
+      for(S32 i = 0; i < 3000 && mGame->getBotZones()->size() == 0; i++)
+      {
+         Platform::sleep(10);
+         mGame->idle(10);
+      }
+   }
+
+   void TearDown()
+   {
+      delete mGame;
+   }
+};
+
+
+TEST_F(BotPathPlannerTest, ClusteredPathsAreSound)
+{
+   const Vector<BotNavMeshZone *> *zones = mGame->getBotZones();
+   ASSERT_GE(zones->size(), (S32)BotPathPlanner::HierarchicalZoneCount);
+
+   BotPathPlanner planner(zones);
+   EXPECT_GT(planner.getClusterCount(), zones->size() / BotPathPlanner::ClusterSize / 2);
+
+   AStarScratch scratch;
+   S32 pathCount = 0;
+
+   for(S32 i = 0; i < 50; i++)
+   {
+      // Spread the queries over the map, with plenty of long ones
+      S32 start = (i * 7919) % zones->size();
+      S32 target = (i * 104729 + zones->size() / 2) % zones->size();
+
+      if(start == target)
+         continue;
+
+      FlightPlanPtr plan = planner.findPath(start, target);
+      Vector<Point> full = AStar::findPath(scratch, zones, start, target, zones->get(target)->getCenter());
+
+      // Zones outside the box can't be reached from inside it, and vice versa; clusters mustn't change that
+      if(full.size() == 0)
+      {
+         EXPECT_EQ(0, plan->size()) << start << " to " << target;
+         continue;
+      }
+
+      expectValidPath(zones, start, target, *plan);
+      pathCount++;
+   }
+
+   EXPECT_GT(pathCount, 25);
+}
+
+
+TEST_F(BotPathPlannerTest, CacheIsBoundedAndShared)
+{
+   const Vector<BotNavMeshZone *> *zones = mGame->getBotZones();
+   ASSERT_GT(zones->size(), 20);
+
+   const S32 MaxPlans = 8;
+   BotPathPlanner planner(zones, MaxPlans);
+
+   FlightPlanPtr first = planner.findPath(0, 1);
+   EXPECT_EQ(first.get(), planner.findPath(0, 1).get());     // Same path, not a copy
+
+   for(S32 i = 2; i < 2 + MaxPlans * 2; i++)
+      planner.findPath(0, i);
+
+   EXPECT_EQ(MaxPlans, planner.getCachedPlanCount());
+
+   // Our first plan is long gone from the cache, but whoever's holding it still has it, unchanged
+   FlightPlanPtr again = planner.findPath(0, 1);
+   EXPECT_NE(first.get(), again.get());
+   EXPECT_TRUE(samePath(*first, *again));
+
+   // The most recently used plans stay
+   FlightPlanPtr recent = planner.findPath(0, 1 + MaxPlans * 2);
+   EXPECT_EQ(recent.get(), planner.findPath(0, 1 + MaxPlans * 2).get());
+
+   planner.reset();
+   EXPECT_EQ(0, planner.getCachedPlanCount());
+}
+
+
+static const S32 SearchCount = 40;
+
+// Asks one planner for a fixed set of paths
+class PathSearchThread : public Thread
+{
+private:
+   BotPathPlanner *mPlanner;
+   Semaphore *mDone;
+
+public:
+   S32 mOffset;
+   Vector<FlightPlanPtr> mPlans;
+
+   PathSearchThread(BotPathPlanner *planner, S32 offset, Semaphore *done) :
+         mPlanner(planner), mDone(done), mOffset(offset) { }
+
+   static S32 getStart(S32 offset, S32 i)  { return (i * 31 + offset) % 997; }
+   static S32 getTarget(S32 i)             { return (i * 577 + 500) % 997; }
+
+   U32 run()
+   {
+      for(S32 i = 0; i < SearchCount; i++)
+         mPlans.push_back(mPlanner->findPath(getStart(mOffset, i), getTarget(i)));
+
+      mDone->increment();
+      return 0;
+   }
+};
+
+
+// Searches on different threads share one cache, without getting in each other's way
+TEST_F(BotPathPlannerTest, SearchesCanRunTogether)
+{
+   const Vector<BotNavMeshZone *> *zones = mGame->getBotZones();
+   ASSERT_GE(zones->size(), 997);
+
+   BotPathPlanner planner(zones, 16);     // Small cache, so threads are evicting each other's plans as they go
+
+   // Pairs of threads ask for the same paths
+   Semaphore done;
+   PathSearchThread thread1(&planner, 0, &done);
+   PathSearchThread thread2(&planner, 0, &done);
+   PathSearchThread thread3(&planner, 1, &done);
+   PathSearchThread thread4(&planner, 1, &done);
+
+   PathSearchThread *threads[] = { &thread1, &thread2, &thread3, &thread4 };
+
+   for(U32 i = 0; i < ARRAYSIZE(threads); i++)
+      ASSERT_TRUE(threads[i]->start());
+
+   for(U32 i = 0; i < ARRAYSIZE(threads); i++)
+      done.wait();
+
+   // Every path should be just what we'd get searching on our own
+   BotPathPlanner soloPlanner(zones);
+
+   for(U32 i = 0; i < ARRAYSIZE(threads); i++)
+   {
+      ASSERT_EQ(SearchCount, threads[i]->mPlans.size());
+
+      for(S32 j = 0; j < SearchCount; j++)
+      {
+         S32 start = PathSearchThread::getStart(threads[i]->mOffset, j);
+         S32 target = PathSearchThread::getTarget(j);
+
+         EXPECT_TRUE(samePath(*threads[i]->mPlans[j], *soloPlanner.findPath(start, target))) << start << " to " << target;
+      }
+   }
+}
+
+
+};
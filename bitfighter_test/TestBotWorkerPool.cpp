@@ -0,0 +1,279 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TestUtils.h"
+#include "../zap/BotWorkerPool.h"
+#include "../zap/ServerGame.h"
+#include "../zap/LevelSource.h"
+#include "../zap/LuaScriptRunner.h"
+#include "../zap/luaLevelGenerator.h"
+#include "../zap/stringUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+static const string LevelCode =
+   "GameType 10 8\n"
+   "LevelName Pool\n"
+   "Team Blue 0 0 1\n"
+   "Spawn 0 0 0\n"
+   "BarrierMaker 40 -10 -10 10 -10 10 10 -10 10 -10 -10\n";
+
+static const string RobotDir = "BotWorkerPoolTest";
+
+// Looks at the game, draws a random number, turns, and tells the levelgen what it did
+static const string ThinkerCode =
+   "function main() name = arg[1] end\n"
+   "function onTick(deltaT)\n"
+   "   local robots = bf:findAllObjects(ObjType.Robot)\n"
+   "   local r = getRandomNumber(1, 1000000)\n"
+   "   bot:setAngle(r / 1000)\n"
+   "   bf:sendData(name .. ':' .. r .. ':' .. #robots)\n"
+   "end\n";
+
+// Dies on its third tick
+static const string FailerCode =
+   "ticks = 0\n"
+   "function main() end\n"
+   "function onTick(deltaT)\n"
+   "   ticks = ticks + 1\n"
+   "   if ticks == 3 then error('boom') end\n"
+   "end\n";
+
+// Dawdles a while, so robots on different threads finish in no particular order, then makes an item every tick, puts it
+// in the game, and says what id it got
+static const string BuilderCode =
+   "function main() name = arg[1] end\n"
+   "function onTick(deltaT)\n"
+   "   for i = 1, getRandomNumber(1, 3000000) do end\n"
+   "   local item = ResourceItem.new()\n"
+   "   if item == nil then error('no item') end\n"
+   "   item:setPos(point.new(0, 0))\n"
+   "   bf:addItem(item)\n"
+   "   bf:sendData(name .. ':' .. item:getId())\n"
+   "end\n";
+
+// Says what a method that changes the game gave back
+static const string DeployerCode =
+   "function main() name = arg[1] end\n"
+   "function onTick(deltaT)\n"
+   "   local deployed = bot:engineerDeployObject(EngineerBuildObject.Turret)\n"
+   "   bf:sendData(name .. ':' .. tostring(deployed))\n"
+   "end\n";
+
+static const string ListenerCode =
+   "received = ''\n"
+   "function onDataReceived(s) received = received .. s .. ' ' end\n"
+   "bf:subscribe(Event.DataReceived)\n";
+
+
+class BotWorkerPoolTest : public testing::Test
+{
+public:
+   TestRobotScripts mScripts;
+
+   BotWorkerPoolTest() : mScripts(RobotDir) { }
+
+   void SetUp()
+   {
+      mScripts.add("thinker.bot",  ThinkerCode);
+      mScripts.add("failer.bot",   FailerCode);
+      mScripts.add("builder.bot",  BuilderCode);
+      mScripts.add("deployer.bot", DeployerCode);
+   }
+
+   ServerGame *newGame(S32 threads)
+   {
+      GameSettingsPtr settings = newRobotSettings(RobotDir, threads);
+      settings->getIniSettings()->botRandomSeed = 1234;
+
+      return newServerGame(settings, LevelCode);
+   }
+
+   // Adds four robots running script, lets them think for a few ticks, and returns what they said, in the order it was heard
+   string think(S32 threads, const char *script = "thinker.bot")
+   {
+      ServerGame *game = newGame(threads);
+      EXPECT_EQ(threads, game->getBotWorkerPool() ? game->getBotWorkerPool()->getWorkerCount() : 0);
+
+      LuaLevelGenerator levelgen(game);
+      levelgen.prepareEnvironment();
+      EXPECT_TRUE(levelgen.runString(ListenerCode));
+
+      const char *names[] = { "a", "b", "c", "d" };
+      for(U32 i = 0; i < ARRAYSIZE(names); i++)
+         addRobot(game, script, names[i]);
+
+      idleWithRobots(game, 10);
+
+      string received = levelgen.getLuaGlobalVar<string>("received");
+
+      delete game;
+
+      return received;
+   }
+};
+
+
+TEST(BotRandomTest, SameSeedSameNumbers)
+{
+   BotRandom a(99), b(99), c(100);
+
+   bool allSame = true, allDifferent = true;
+   for(S32 i = 0; i < 100; i++)
+   {
+      U32 x = a.readU32();
+      allSame = allSame && x == b.readU32();
+      allDifferent = allDifferent && x != c.readU32();
+
+      F32 f = a.readF();
+      b.readF();
+      c.readF();
+      EXPECT_TRUE(f >= 0 && f < 1);
+
+      S32 n = a.readI(3, 7);
+      b.readI(3, 7);
+      c.readI(3, 7);
+      EXPECT_TRUE(n >= 3 && n <= 7);
+   }
+
+   EXPECT_TRUE(allSame);
+   EXPECT_TRUE(allDifferent);
+}
+
+
+// However many threads robots think on, they should all see and do the same things, and be heard in the same order
+TEST_F(BotWorkerPoolTest, SameResultsWithAnyNumberOfThreads)
+{
+   LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+
+   string one = think(1);
+   ASSERT_NE("", one);
+
+   Vector<string> words;
+   parseString(trim(one), words, ' ');
+   ASSERT_GE(words.size(), 8);
+
+   // Heard in the order they were added, each seeing all four
+   const char *names[] = { "a", "b", "c", "d" };
+   for(S32 i = 0; i < words.size(); i++)
+   {
+      EXPECT_EQ(string(names[i % 4]) + ":", words[i].substr(0, 2));
+      EXPECT_EQ(":4", words[i].substr(words[i].size() - 2));
+   }
+
+   EXPECT_EQ(one, think(3));
+   EXPECT_EQ(one, think(4));
+
+   LuaScriptRunner::shutdown();
+}
+
+
+// Objects robots make while they think get the same ids however the robots are spread over threads, and however the
+// threads happen to run
+TEST_F(BotWorkerPoolTest, SameIdsWithAnyNumberOfThreads)
+{
+   LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+
+   S32 serialNumber, defaultId;
+   BfObject::getNextIds(serialNumber, defaultId);
+
+   string one = think(1, "builder.bot");
+   ASSERT_NE("", one);
+
+   for(S32 threads = 2; threads <= 4; threads++)
+      for(S32 i = 0; i < 3; i++)
+      {
+         BfObject::setNextIds(serialNumber, defaultId);
+         EXPECT_EQ(one, think(threads, "builder.bot"));
+      }
+
+   LuaScriptRunner::shutdown();
+}
+
+
+// Methods that change the game are made after everyone has thought, so what they return is lost; robots get nil
+TEST_F(BotWorkerPoolTest, DeferredCallsReturnNil)
+{
+   LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+
+   string onMainThread = think(0, "deployer.bot");
+   string onWorkers    = think(2, "deployer.bot");
+
+   ASSERT_NE("", onMainThread);
+   EXPECT_EQ(string::npos, onMainThread.find("nil"));
+   EXPECT_NE(string::npos, onMainThread.find("a:false"));
+
+   EXPECT_EQ(string::npos, onWorkers.find("false"));
+   EXPECT_NE(string::npos, onWorkers.find("a:nil"));
+
+   LuaScriptRunner::shutdown();
+}
+
+
+// A robot whose script fails is removed on the main thread; the others keep thinking
+TEST_F(BotWorkerPoolTest, FailingScriptOnlyKillsItsRobot)
+{
+   LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+
+   ServerGame *game = newGame(2);
+   ASSERT_TRUE(game->getBotWorkerPool() != NULL);
+
+   addRobot(game, "thinker.bot", "a");
+   addRobot(game, "failer.bot",  "b");
+   addRobot(game, "thinker.bot", "c");
+   EXPECT_EQ(3, game->getBotWorkerPool()->getRobotCount());
+
+   idleWithRobots(game, 2);
+   EXPECT_EQ(3, game->getBotCount());      // Hasn't failed yet
+
+   idleWithRobots(game, 10);
+
+   EXPECT_EQ(2, game->getBotCount());
+   EXPECT_EQ(2, game->getBotWorkerPool()->getRobotCount());
+
+   delete game;
+
+   LuaScriptRunner::shutdown();
+}
+
+
+// Robots making things on several threads at once get their objects back, each with an id of its own
+TEST_F(BotWorkerPoolTest, RobotsCanBuildWhileThinking)
+{
+   LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+
+   ServerGame *game = newGame(4);
+   ASSERT_TRUE(game->getBotWorkerPool() != NULL);
+
+   for(S32 i = 0; i < 8; i++)
+      addRobot(game, "builder.bot", "builder");
+
+   idleWithRobots(game, 10);
+
+   EXPECT_EQ(8, game->getBotCount());        // None died for want of an item
+
+   Vector<DatabaseObject *> items;
+   game->getGameObjDatabase()->findObjects(ResourceItemTypeNumber, items);
+   EXPECT_GE(items.size(), 8);
+
+   bool idsUnique = true;
+   for(S32 i = 0; i < items.size(); i++)
+      for(S32 j = i + 1; j < items.size(); j++)
+         if(static_cast<BfObject *>(items[i])->getUserAssignedId() == static_cast<BfObject *>(items[j])->getUserAssignedId() ||
+            static_cast<BfObject *>(items[i])->getSerialNumber()   == static_cast<BfObject *>(items[j])->getSerialNumber())
+            idsUnique = false;
+
+   EXPECT_TRUE(idsUnique);
+
+   delete game;
+
+   LuaScriptRunner::shutdown();
+}
+
+
+};
@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/BotZoneCache.h"
+#include "../zap/BotNavMeshZone.h"
+#include "../zap/ServerGame.h"
+#include "../zap/LevelSource.h"
+#include "../zap/stringUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <stdio.h>
+
+namespace Zap
+{
+
+static const char *CacheFolder = "BotZoneCacheTest";
+
+// Walls, a turret, a core, a speedzone, and a teleporter: something for every kind of connection
+static const string LevelCode =
+   "GameType 10 8\n"
+   "LevelName Zones\n"
+   "Team Blue 0 0 1\n"
+   "BarrierMaker 40 -10 -10 10 -10 10 10 -10 10 -10 -10\n"
+   "BarrierMaker 40 -3 -2 3 -2\n"
+   "BarrierMaker 40 4 3 4 8\n"
+   "Turret 0 -5 -9.6\n"
+   "CoreItem 0 4000 6 -5\n"
+   "SpeedZone -6 5 -6 1 2000\n"
+   "Teleporter -7 -7 7 -7\n";
+
+
+static void expectSamePoint(const Point &expected, const Point &actual)
+{
+   EXPECT_EQ(expected.x, actual.x);
+   EXPECT_EQ(expected.y, actual.y);
+}
+
+
+static void expectSameMesh(const BotZoneMesh &expected, const BotZoneMesh &actual)
+{
+   expectSamePoint(expected.bounds.min, actual.bounds.min);
+   expectSamePoint(expected.bounds.max, actual.bounds.max);
+
+   ASSERT_EQ(expected.zones.size(), actual.zones.size());
+   ASSERT_EQ(expected.neighbors.size(), actual.neighbors.size());
+
+   for(S32 i = 0; i < expected.zones.size(); i++)
+   {
+      ASSERT_EQ(expected.zones[i].size(), actual.zones[i].size());
+      for(S32 j = 0; j < expected.zones[i].size(); j++)
+         expectSamePoint(expected.zones[i][j], actual.zones[i][j]);
+
+      ASSERT_EQ(expected.neighbors[i].size(), actual.neighbors[i].size()) << "zone " << i;
+      for(S32 j = 0; j < expected.neighbors[i].size(); j++)
+      {
+         const NeighboringZone &e = expected.neighbors[i][j];
+         const NeighboringZone &a = actual.neighbors[i][j];
+
+         EXPECT_EQ(e.zoneID, a.zoneID);
+         expectSamePoint(e.borderStart, a.borderStart);
+         expectSamePoint(e.borderEnd, a.borderEnd);
+         expectSamePoint(e.borderCenter, a.borderCenter);
+         expectSamePoint(e.center, a.center);
+         EXPECT_EQ(e.distTo, a.distTo);
+      }
+   }
+}
+
+
+// Copies the zones the game has in play
+static void getZones(ServerGame *game, BotZoneMesh &mesh)
+{
+   const Vector<BotNavMeshZone *> *zones = game->getBotZones();
+
+   mesh.bounds = game->getBotZoneDatabase()->getExtents();
+   mesh.zones.resize(zones->size());
+
+   for(S32 i = 0; i < zones->size(); i++)
+      mesh.zones[i] = *zones->get(i)->getOutline();
+
+   BotNavMeshZone::getBotZoneNeighbors(zones, mesh);
+}
+
+
+class BotZoneCacheTest : public testing::Test
+{
+public:
+   GameSettingsPtr mSettings;
+   ServerGame *mGame;
+
+   void SetUp()
+   {
+      mSettings = GameSettingsPtr(new GameSettings());
+      mSettings->getFolderManager()->cacheDir = CacheFolder;
+
+      mGame = new ServerGame(Address(), mSettings, LevelSourcePtr(new StringLevelSource(LevelCode)), false, false);
+   }
+
+   void TearDown()
+   {
+      delete mGame;
+
+      const string extensions[] = { "zones" };
+      Vector<string> files;
+      getFilesFromFolder(CacheFolder, files, extensions, ARRAYSIZE(extensions));
+
+      for(S32 i = 0; i < files.size(); i++)
+         remove(joindir(CacheFolder, files[i]).c_str());
+   }
+
+   // Load our level, and wait for its zones to be built on the secondary thread
+   void cycleLevelAndWaitForZones()
+   {
+      mGame->cycleLevel(FIRST_LEVEL);
+
+      for(S32 i = 0; i < 500 && mGame->getBotZones()->size() == 0; i++)
+      {
+         Platform::sleep(10);
+         mGame->idle(10);
+      }
+   }
+};
+
+
+TEST_F(BotZoneCacheTest, PackedZonesComeBackExactly)
+{
+   cycleLevelAndWaitForZones();
+
+   BotZoneMesh mesh;
+   getZones(mGame, mesh);
+   ASSERT_GT(mesh.zones.size(), 10);
+
+   // Make sure the level gave us some of everything: teleporters and speedzones make one way connections from a point
+   S32 oneWayCount = 0;
+   bool foundCore = false;
+
+   for(S32 i = 0; i < mesh.neighbors.size(); i++)
+      for(S32 j = 0; j < mesh.neighbors[i].size(); j++)
+      {
+         const NeighboringZone &neighbor = mesh.neighbors[i][j];
+
+         if(neighbor.borderCenter == neighbor.borderStart && neighbor.center == neighbor.borderStart)
+            oneWayCount++;
+
+         foundCore |= neighbor.distTo == BotNavMeshZone::CoreTraversalCost;
+      }
+
+   EXPECT_GE(oneWayCount, 2);
+   EXPECT_TRUE(foundCore);
+
+   Vector<U8> blob;
+   BotZoneCache::packMesh(mesh, blob);
+
+   BotZoneMesh unpacked;
+   ASSERT_TRUE(BotZoneCache::unpackMesh(blob, unpacked));
+   expectSameMesh(mesh, unpacked);
+
+   Vector<U8> truncated = blob;
+   truncated.resize(blob.size() / 2);
+   EXPECT_FALSE(BotZoneCache::unpackMesh(truncated, unpacked));
+
+   Vector<U8> wrongVersion = blob;
+   wrongVersion[0]++;
+   EXPECT_FALSE(BotZoneCache::unpackMesh(wrongVersion, unpacked));
+}
+
+
+// Points no delta can reach have to go as they are, without being converted to an int along the way
+TEST(BotZoneCachePackingTest, OutOfRangePointsComeBackExactly)
+{
+   BotZoneMesh mesh;
+   mesh.bounds = Rect(Point(-3e9f, -3e9f), Point(3e9f, 3e9f));
+
+   Vector<Point> zone;
+   zone.push_back(Point(3e9f, -3e9f));
+   zone.push_back(Point(numeric_limits<F32>::infinity(), 0));
+   zone.push_back(Point(0.5f, 0));
+   zone.push_back(Point(0, 0));
+   mesh.zones.push_back(zone);
+   mesh.neighbors.resize(1);
+
+   Vector<U8> blob;
+   BotZoneCache::packMesh(mesh, blob);
+
+   BotZoneMesh unpacked;
+   ASSERT_TRUE(BotZoneCache::unpackMesh(blob, unpacked));
+   expectSameMesh(mesh, unpacked);
+}
+
+
+TEST_F(BotZoneCacheTest, CachedZonesMatchBuiltOnes)
+{
+   // First time through, zones are built in the background, and saved
+   mGame->cycleLevel(FIRST_LEVEL);
+   EXPECT_EQ(0, mGame->getBotZones()->size());
+
+   cycleLevelAndWaitForZones();
+
+   BotZoneMesh built;
+   getZones(mGame, built);
+   ASSERT_GT(built.zones.size(), 0);
+
+   // Second time, they're loaded straight away, and are the same in every respect
+   mGame->cycleLevel(FIRST_LEVEL);
+
+   BotZoneMesh loaded;
+   getZones(mGame, loaded);
+   expectSameMesh(built, loaded);
+
+   // A damaged file gets the zones built again
+   const string extensions[] = { "zones" };
+   Vector<string> files;
+   getFilesFromFolder(CacheFolder, files, extensions, ARRAYSIZE(extensions));
+   ASSERT_EQ(1, files.size());
+
+   FILE *file = fopen(joindir(CacheFolder, files[0]).c_str(), "r+b");
+   ASSERT_TRUE(file != NULL);
+   fseek(file, 20, SEEK_SET);
+   U8 byte = U8(fgetc(file));
+   fseek(file, 20, SEEK_SET);
+   fputc(byte ^ 0x40, file);
+   fclose(file);
+
+   mGame->cycleLevel(FIRST_LEVEL);
+   EXPECT_EQ(0, mGame->getBotZones()->size());
+
+   cycleLevelAndWaitForZones();
+
+   BotZoneMesh rebuilt;
+   getZones(mGame, rebuilt);
+   expectSameMesh(built, rebuilt);
+}
+
+
+};
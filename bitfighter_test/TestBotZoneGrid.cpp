@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/BotZoneGrid.h"
+#include "../zap/BotNavMeshZone.h"
+#include "../zap/ServerGame.h"
+#include "../zap/LevelSource.h"
+#include "../zap/GeomUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+// Walls, and a turret, for zones of all shapes and sizes
+static const string LevelCode =
+   "GameType 10 8\n"
+   "LevelName Grid\n"
+   "Team Blue 0 0 1\n"
+   "BarrierMaker 40 -10 -10 10 -10 10 10 -10 10 -10 -10\n"
+   "BarrierMaker 40 -3 -2 3 -2\n"
+   "BarrierMaker 40 4 3 4 8\n"
+   "BarrierMaker 40 -8 4 -2 7\n"
+   "Turret 0 -5 -9.6\n";
+
+
+class BotZoneGridTest : public testing::Test
+{
+public:
+   GameSettingsPtr mSettings;
+   ServerGame *mGame;
+
+   void SetUp()
+   {
+      mSettings = GameSettingsPtr(new GameSettings());
+      mSettings->getFolderManager()->cacheDir = "";      // Always build the zones
+
+      mGame = new ServerGame(Address(), mSettings, LevelSourcePtr(new StringLevelSource(LevelCode)), false, false);
+      mGame->cycleLevel(FIRST_LEVEL);
+
+      for(S32 i = 0; i < 500 && mGame->getBotZones()->size() == 0; i++)
+      {
+         Platform::sleep(10);
+         mGame->idle(10);
+      }
+   }
+
+   void TearDown()
+   {
+      delete mGame;
+   }
+};
+
+
+// The grid should find just what looking through every zone finds
+TEST_F(BotZoneGridTest, FindsSameZonesAsSearchingThemAll)
+{
+   const Vector<BotNavMeshZone *> *zones = mGame->getBotZones();
+   ASSERT_GT(zones->size(), 10);
+
+   BotZoneGrid grid(zones);
+   EXPECT_GT(grid.getOwnedCellCount(), 0);
+   EXPECT_LT(grid.getOwnedCellCount(), grid.getCellCount());
+
+   Rect extents = mGame->getBotZoneDatabase()->getExtents();
+   S32 inZoneCount = 0;
+
+   for(F32 x = extents.min.x - 100; x < extents.max.x + 100; x += 13.7f)
+      for(F32 y = extents.min.y - 100; y < extents.max.y + 100; y += 11.3f)
+      {
+         Point point(x, y);
+
+         bool inAnyZone = false;
+         for(S32 i = 0; i < zones->size() && !inAnyZone; i++)
+            inAnyZone = polygonContainsPoint(zones->get(i)->getOutline()->address(), zones->get(i)->getOutline()->size(), point);
+
+         U16 zone = grid.findZoneContaining(point);
+
+         if(!inAnyZone)
+         {
+            EXPECT_EQ(U16_MAX, zone) << point.toString();
+            continue;
+         }
+
+         // Points right on the edge between two zones could go either way
+         ASSERT_NE(U16_MAX, zone) << point.toString();
+         EXPECT_TRUE(polygonContainsPoint(zones->get(zone)->getOutline()->address(), zones->get(zone)->getOutline()->size(), point));
+         EXPECT_EQ(zone, mGame->findZoneContaining(point));
+
+         inZoneCount++;
+      }
+
+   EXPECT_GT(inZoneCount, 100);
+}
+
+
+TEST_F(BotZoneGridTest, RemembersClosestZones)
+{
+   ASSERT_GT(mGame->getBotZones()->size(), 0);
+
+   GridDatabase::QueryContext context;
+   Point inWall(-3 * 255, -2 * 255);      // Level coordinates are in grid units
+
+   BotZoneGrid grid(mGame->getBotZones());
+   U16 zone;
+   EXPECT_FALSE(grid.getClosestZone(inWall, zone));
+
+   grid.setClosestZone(inWall, 7);
+   ASSERT_TRUE(grid.getClosestZone(inWall + Point(1, 1), zone));    // Close enough
+   EXPECT_EQ(7, zone);
+   EXPECT_FALSE(grid.getClosestZone(inWall + Point(BotZoneGrid::ClosestZoneQuantum, 0), zone));
+
+   U16 closest = mGame->findClosestZone(context, inWall);
+   ASSERT_NE(U16_MAX, closest);
+   EXPECT_EQ(closest, mGame->findClosestZone(context, inWall));
+
+   grid.reset();
+   EXPECT_FALSE(grid.getClosestZone(inWall, zone));
+}
+
+
+TEST(BotSightMemoTest, OnlyRemembersDuringTick)
+{
+   BotSightMemo memo;
+   Point from(100, 100), to(500, 300);
+   bool canSee;
+
+   // Not in a bot tick; nothing is kept
+   memo.store(from, to, 24, true, true);
+   EXPECT_FALSE(memo.lookup(from, to, 24, true, canSee));
+
+   memo.begin();
+   memo.store(from, to, 24, true, true);
+   memo.store(from, to, 24, false, false);
+
+   ASSERT_TRUE(memo.lookup(from + Point(0.2f, -0.2f), to, 24, true, canSee));
+   EXPECT_TRUE(canSee);
+   ASSERT_TRUE(memo.lookup(from, to, 24, false, canSee));
+   EXPECT_FALSE(canSee);
+
+   EXPECT_FALSE(memo.lookup(from + Point(2, 0), to, 24, true, canSee));
+   EXPECT_FALSE(memo.lookup(to, from, 24, true, canSee));
+   EXPECT_FALSE(memo.lookup(from, to, 30, true, canSee));
+   EXPECT_EQ(2, memo.getResultCount());
+
+   memo.end();
+   EXPECT_FALSE(memo.lookup(from, to, 24, true, canSee));
+   EXPECT_EQ(0, memo.getResultCount());
+}
+
+
+};
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/dataConnection.h"
+#include "../zap/config.h"
+
+#include "tnlNetInterface.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string>
+
+namespace Zap
+{
+
+using namespace std;
+
+static const char *SentFile = "DataConnectionTest_sent.level";
+static const char *ReceivedFile = "DataConnectionTest_received.level";
+
+
+class DataConnectionTest : public testing::Test
+{
+public:
+   string mSentData;
+
+   // Writes a level with lineCount objects in it
+   void writeSentFile(S32 lineCount)
+   {
+      char line[64];
+
+      mSentData = "LevelFormat 2\nGameType 10 8\nLevelName DataConnectionTest\n";
+      for(S32 i = 0; i < lineCount; i++)
+      {
+         dSprintf(line, sizeof(line), "BarrierMaker 40 %d %d %d %d\n", i % 97, i / 97, (i * 7) % 89, (i * 13) % 83);
+         mSentData += line;
+      }
+
+      FILE *file = fopen(SentFile, "w");
+      ASSERT_TRUE(file != NULL);
+      fwrite(mSentData.c_str(), 1, mSentData.size(), file);
+      fclose(file);
+   }
+
+   void TearDown()
+   {
+      remove(SentFile);
+      remove(ReceivedFile);
+   }
+
+   static string readReceivedFile()
+   {
+      string data;
+      FILE *file = fopen(ReceivedFile, "r");
+      if(!file)
+         return data;
+
+      char buffer[4096];
+      size_t size;
+      while((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+         data.append(buffer, size);
+
+      fclose(file);
+      return data;
+   }
+
+   // Sends SentFile to ReceivedFile over a pair of DataConnections on loopback NetInterfaces, and returns how many
+   // times we had to idle the connections to get it there.  If damage is set, we corrupt the receiver's checksum
+   // partway through.
+   S32 transferFile(bool sendBlocks, bool damage = false)
+   {
+      NetInterface senderInterface(Address(IPProtocol, Address::Any, 0));
+      NetInterface receiverInterface(Address(IPProtocol, Address::Any, 0));
+
+      RefPtr<DataConnection> sender = new DataConnection();
+      EXPECT_TRUE(sender->connectLocal(&senderInterface, &receiverInterface));
+
+      RefPtr<DataConnection> receiver = dynamic_cast<DataConnection *>(sender->getRemoteConnectionObject());
+
+      // Don't wait on the clock between packets; bandwidth is still limited by the packet size
+      sender->useZeroLatencyForTesting();
+      receiver->useZeroLatencyForTesting();
+
+      EXPECT_TRUE(receiver->openOutputFile(ReceivedFile));
+
+      FolderManager folderManager;
+      EXPECT_EQ(STATUS_OK, sender->mDataSender.initialize(sender, &folderManager, SentFile, LEVEL_TYPE));
+      EXPECT_TRUE(sender->mDataSender.mSendBlocks);      // Both ends are current, so they should agree on blocks
+      sender->mDataSender.mSendBlocks = sendBlocks;
+
+      S32 ticks = 0;
+      while(receiver->isEstablished() && ticks < 10000)
+      {
+         if(!sender->mDataSender.isDone())
+            sender->mDataSender.sendPendingData();
+
+         senderInterface.processConnections();
+         receiverInterface.processConnections();
+
+         if(damage && receiver->mReceivedLineCount > 0)
+         {
+            receiver->mReceivedChecksum ^= 1;
+            damage = false;
+         }
+
+         Platform::sleep(1);     // As transferResource() does
+         ticks++;
+      }
+
+      EXPECT_FALSE(receiver->isEstablished());
+      return ticks;
+   }
+};
+
+
+TEST_F(DataConnectionTest, TransferArrivesIntact)
+{
+   writeSentFile(1000);
+
+   S32 blockTicks = transferFile(true);
+   EXPECT_EQ(mSentData, readReceivedFile());
+
+   remove(ReceivedFile);
+
+   // Line at a time, as older hosts would do it
+   S32 lineTicks = transferFile(false);
+   EXPECT_EQ(mSentData, readReceivedFile());
+
+   // Blocks should need far fewer trips through the idle loop than sending a line per tick
+   EXPECT_LT(blockTicks * 2, lineTicks);
+}
+
+
+TEST_F(DataConnectionTest, DamagedTransferIsDiscarded)
+{
+   writeSentFile(1000);
+
+   transferFile(true, true);
+
+   FILE *file = fopen(ReceivedFile, "r");
+   EXPECT_TRUE(file == NULL);
+   if(file)
+      fclose(file);
+}
+
+
+};
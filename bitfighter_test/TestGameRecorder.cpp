@@ -0,0 +1,189 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/GameRecorder.h"
+#include "../zap/ServerGame.h"
+#include "../zap/gameType.h"
+#include "../zap/ship.h"
+#include "../zap/EngineeredItem.h"
+#include "../zap/teamInfo.h"
+#include "../zap/LevelSource.h"
+#include "../zap/stringUtils.h"
+#include "../zap/version.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+static const char *RecordFolder = "GameRecorderTest";
+
+
+class GameRecorderTest : public testing::Test
+{
+public:
+   string mFilename;
+
+   // Records seconds of a game with a few ships flying about, and waits for the writer to finish the file
+   void record(S32 seconds)
+   {
+      GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+      settings->getFolderManager()->recordDir = RecordFolder;
+
+      ServerGame *game = new ServerGame(Address(), settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+      game->addTeam(new Team());
+
+      GameType *gameType = new GameType();
+      gameType->addToGame(game, game->getGameObjDatabase());
+      game->unsuspendGame(false);
+
+      for(S32 i = 0; i < 5; i++)
+      {
+         Ship *ship = new Ship;
+         ship->addToGame(game, game->getGameObjDatabase());
+         ship->setMove(Move(1, 0.5f));
+      }
+
+      for(S32 i = 0; i < 200; i++)
+      {
+         Turret *turret = new Turret(0, Point(71 + i * 50, -100), Point(0, 1));
+         turret->addToGame(game, game->getGameObjDatabase());
+      }
+
+      GameRecorderServer *recorder = new GameRecorderServer(game);
+      mFilename = joindir(RecordFolder, recorder->mFileName);
+
+      for(S32 i = 0; i < seconds * 10; i++)
+      {
+         game->idle(100);
+         recorder->idle(100);
+      }
+
+      delete recorder;
+      delete game;      // Waits for the writer to finish the file
+   }
+
+   bool readIndex(U32 &totalTime, Vector<RecordingKeyframe> &keyframes)
+   {
+      RecordingReader reader;
+      U8 header[4];
+      return reader.open(mFilename.c_str(), header) && reader.readIndex(totalTime, keyframes);
+   }
+
+   void TearDown()
+   {
+      remove(mFilename.c_str());
+   }
+};
+
+
+// However little time the writer gets, the file is complete once the game is gone
+TEST_F(GameRecorderTest, FinishedBeforeGameIsDeleted)
+{
+   record(3);
+
+   U32 totalTime;
+   Vector<RecordingKeyframe> keyframes;
+   EXPECT_TRUE(readIndex(totalTime, keyframes));
+   EXPECT_TRUE(GameRecorderServer::waitForWriters(0));
+}
+
+
+TEST_F(GameRecorderTest, RecordingReadsBack)
+{
+   record(25);
+
+   U32 totalTime;
+   Vector<RecordingKeyframe> keyframes;
+   ASSERT_TRUE(readIndex(totalTime, keyframes));
+   EXPECT_EQ(2, keyframes.size());      // At 10 and 20 seconds
+
+   RecordingReader reader;
+   U8 header[4];
+   ASSERT_TRUE(reader.open(mFilename.c_str(), header));
+   EXPECT_EQ(CS_PROTOCOL_VERSION, header[0]);
+   EXPECT_TRUE((U32(header[3]) << 8) & GameRecorderServer::HeaderBlocksFlag);
+
+   Vector<U8> record;
+   record.resize(GameRecorderServer::MaxRecordSize);
+
+   U32 size, milliseconds;
+   U32 time = 0;
+   U32 rawBytes = 0;
+   S32 keyframe = 0;
+
+   while(reader.readRecord(record.address(), size, milliseconds))
+   {
+      time += milliseconds;
+      rawBytes += size + GameRecorderServer::RecordHeaderSize;
+
+      S32 flags = GameRecorderServer::getKeyframeFlags(record.address(), size);
+      if(flags != -1 && (flags & GameRecorderServer::FirstKeyframeRecord))
+      {
+         ASSERT_LT(keyframe, keyframes.size());
+         EXPECT_EQ(keyframes[keyframe].time, time);
+         EXPECT_EQ(keyframes[keyframe].offset, reader.getRecordOffset());
+         keyframe++;
+      }
+   }
+
+   EXPECT_EQ(keyframes.size(), keyframe);
+   EXPECT_EQ(totalTime, time);
+
+   // Players seek straight to keyframes
+   ASSERT_TRUE(reader.seek(keyframes[1].offset));
+   ASSERT_TRUE(reader.readRecord(record.address(), size, milliseconds));
+   S32 flags = GameRecorderServer::getKeyframeFlags(record.address(), size);
+   EXPECT_TRUE(flags != -1 && (flags & GameRecorderServer::FirstKeyframeRecord));
+
+   // Compression should be earning its keep
+   FILE *file = fopen(mFilename.c_str(), "rb");
+   ASSERT_TRUE(file != NULL);
+   fseek(file, 0, SEEK_END);
+   U32 fileSize = U32(ftell(file));
+   fclose(file);
+
+   EXPECT_LT(fileSize, rawBytes * 3 / 4);
+}
+
+
+TEST_F(GameRecorderTest, DamagedBlocksAreNotPlayed)
+{
+   record(25);
+
+   U32 totalTime;
+   Vector<RecordingKeyframe> keyframes;
+   ASSERT_TRUE(readIndex(totalTime, keyframes));
+   ASSERT_EQ(2, keyframes.size());
+
+   // Spoil a byte just inside the second keyframe's block
+   FILE *file = fopen(mFilename.c_str(), "r+b");
+   ASSERT_TRUE(file != NULL);
+   fseek(file, keyframes[1].offset + GameRecorderServer::BlockHeaderSize + 10, SEEK_SET);
+   U8 byte = U8(fgetc(file));
+   fseek(file, keyframes[1].offset + GameRecorderServer::BlockHeaderSize + 10, SEEK_SET);
+   fputc(byte ^ 0x40, file);
+   fclose(file);
+
+   RecordingReader reader;
+   U8 header[4];
+   ASSERT_TRUE(reader.open(mFilename.c_str(), header));
+
+   Vector<U8> record;
+   record.resize(GameRecorderServer::MaxRecordSize);
+
+   U32 size, milliseconds;
+   U32 time = 0;
+   while(reader.readRecord(record.address(), size, milliseconds))
+      time += milliseconds;
+
+   // Everything up to the damage, and nothing after it
+   EXPECT_EQ(keyframes[1].time, time);
+}
+
+
+};
@@ -3,12 +3,169 @@
 // See LICENSE.txt for full copyright information
 //------------------------------------------------------------------------------
 
-#include "gameType.h"
+#include "TestUtils.h"
+#include "../zap/gameType.h"
+#include "../zap/LuaScriptRunner.h"
+#include "../zap/ServerGame.h"
+#include "../zap/ClientInfo.h"
+#include "../zap/projectile.h"
+#include "../zap/robot.h"
+
 #include "gtest/gtest.h"
 
 namespace Zap
 {
 
-// Need some tests here!
+static const string LevelCode =
+   "GameType 10 8\n"
+   "LevelName Scopes\n"
+   "Team Blue 0 0 1\n"
+   "Team Red 1 0 0\n"
+   "Spawn 0 0 0\n"
+   "Spawn 1 0 0\n";
+
+static const string RobotDir = "GameTypeTest";
+
+
+class GameTypeTest : public testing::Test
+{
+public:
+   TestRobotScripts mScripts;
+   ServerGame *mGame;
+
+   GameTypeTest() : mScripts(RobotDir) { }
+
+   void SetUp()
+   {
+      LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+
+      mScripts.add("idler.bot", "function main() end\n");
+      mGame = newServerGame(newRobotSettings(RobotDir, 0), LevelCode);
+   }
+
+   void TearDown()
+   {
+      delete mGame;
+      LuaScriptRunner::shutdown();
+   }
+
+   Robot *addPlayer(S32 team, const Point &pos)
+   {
+      Robot *robot = addRobot(mGame, "idler.bot", "", team);
+      robot->setPos(pos);
+      return robot;
+   }
+
+   ResourceItem *addItem(const Point &pos)
+   {
+      ResourceItem *item = new ResourceItem();
+      item->setPos(pos);
+      item->addToGame(mGame, mGame->getGameObjDatabase());
+      return item;
+   }
+
+   const Vector<DatabaseObject *> *teamScope(S32 team)
+   {
+      return &mGame->getGameType()->getTeamCmdrScope(team);
+   }
+
+   // Everything performScopeQuery finds for a player in the commander's map, beyond their own ship's surroundings:
+   // their team's shared set, and what each spy bug they can see sees
+   Vector<DatabaseObject *> sharedView(Robot *player)
+   {
+      GameType *gameType = mGame->getGameType();
+      ClientInfo *clientInfo = player->getClientInfo();
+
+      Vector<DatabaseObject *> objects = gameType->getTeamCmdrScope(clientInfo->getTeamIndex());
+
+      const Vector<DatabaseObject *> *spyBugs = mGame->getGameObjDatabase()->findObjects_fast(SpyBugTypeNumber);
+      for(S32 i = 0; i < spyBugs->size(); i++)
+      {
+         if(static_cast<SpyBug *>(spyBugs->get(i))->isVisibleToPlayer(clientInfo, gameType->isTeamGame()))
+         {
+            const Vector<DatabaseObject *> &seen = gameType->getSpyBugScope(i);
+            for(S32 j = 0; j < seen.size(); j++)
+               objects.push_back(seen[j]);
+         }
+      }
+
+      return objects;
+   }
+
+   static bool same(const Vector<DatabaseObject *> &a, const Vector<DatabaseObject *> &b)
+   {
+      if(a.size() != b.size())
+         return false;
+
+      for(S32 i = 0; i < a.size(); i++)
+         if(a[i] != b[i])
+            return false;
+
+      return true;
+   }
+};
+
+
+// Teammates far apart each see what the other shows on the commander's map, through the one set their team shares
+TEST_F(GameTypeTest, TeammatesShareOneCmdrScope)
+{
+   Robot *blue1 = addPlayer(0, Point(0, 0));
+   Robot *blue2 = addPlayer(0, Point(5000, 0));
+   Robot *red   = addPlayer(1, Point(0, 5000));
+
+   ResourceItem *nearBlue1 = addItem(Point(100, 0));
+   ResourceItem *nearBlue2 = addItem(Point(5100, 0));
+   ResourceItem *nearRed   = addItem(Point(100, 5000));
+
+   ASSERT_TRUE(mGame->getGameType()->isTeamGame());
+
+   // Same storage for both, not just the same contents
+   EXPECT_EQ(teamScope(blue1->getTeam()), teamScope(blue2->getTeam()));
+
+   Vector<DatabaseObject *> blueView = sharedView(blue1);
+   EXPECT_TRUE(same(blueView, sharedView(blue2)));
+
+   EXPECT_TRUE(blueView.contains(blue1));
+   EXPECT_TRUE(blueView.contains(blue2));
+   EXPECT_TRUE(blueView.contains(nearBlue1));
+   EXPECT_TRUE(blueView.contains(nearBlue2));
+   EXPECT_FALSE(blueView.contains(red));
+   EXPECT_FALSE(blueView.contains(nearRed));
+
+   Vector<DatabaseObject *> redView = sharedView(red);
+   EXPECT_TRUE(redView.contains(red));
+   EXPECT_TRUE(redView.contains(nearRed));
+   EXPECT_FALSE(redView.contains(blue1));
+   EXPECT_FALSE(redView.contains(nearBlue2));
+}
+
+
+// A spy bug placed or removed mid-tick shows up in, or drops out of, every teammate's view at once, and the other
+// team's view stays as it was
+TEST_F(GameTypeTest, SpyBugsUpdateTheWholeTeam)
+{
+   Robot *blue1 = addPlayer(0, Point(0, 0));
+   Robot *blue2 = addPlayer(0, Point(5000, 0));
+   Robot *red   = addPlayer(1, Point(0, 5000));
+
+   Vector<DatabaseObject *> redView = sharedView(red);
+   EXPECT_FALSE(sharedView(blue1).contains(red));       // Also leaves the shared sets found and cached
+   EXPECT_FALSE(sharedView(blue2).contains(red));
+
+   SpyBug *spyBug = new SpyBug(Point(100, 5000), blue1);
+   spyBug->addToGame(mGame, mGame->getGameObjDatabase());
+   ASSERT_EQ(blue1->getTeam(), spyBug->getTeam());
+
+   EXPECT_TRUE(sharedView(blue1).contains(red));
+   EXPECT_TRUE(sharedView(blue2).contains(red));
+   EXPECT_TRUE(same(sharedView(blue1), sharedView(blue2)));
+   EXPECT_TRUE(same(redView, sharedView(red)));
+
+   spyBug->removeFromGame(true);
+
+   EXPECT_FALSE(sharedView(blue1).contains(red));
+   EXPECT_FALSE(sharedView(blue2).contains(red));
+   EXPECT_TRUE(same(redView, sharedView(red)));
+}
 
 };
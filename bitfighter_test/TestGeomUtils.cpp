@@ -293,6 +293,32 @@ TEST(GeomUtilsTest, triangulateOverlappingSegments)
 }
 
 
+TEST(GeomUtilsTest, isConvex)
+{
+	POLY(square, ARRAYDEF({
+		" 1-2-3 ",
+		" |   | ",
+		" 6-5-4 "
+	}));
+
+	POLY(notched, ARRAYDEF({
+		" 1-2 4-5 ",
+		" | | | | ",
+		" | 3-| | ",
+		" 7-----6 "
+	}));
+
+	EXPECT_TRUE(isConvex(&square));       // Straight runs along the edges don't matter
+	EXPECT_FALSE(isConvex(&notched));
+
+	Vector<Point> reversed;
+	for(S32 i = square.size() - 1; i >= 0; i--)
+		reversed.push_back(square[i]);
+
+	EXPECT_TRUE(isConvex(&reversed));
+}
+
+
 TEST(GeomUtilsTest, triangulateRepeatedlySelfIntersecting)
 {
 	POLY(poly, ARRAYDEF({
@@ -429,4 +455,111 @@ TEST(GeomUtilsTest, pointInHexagon)
 
 
 
+
+// Small deterministic generator so failures reproduce on every platform
+struct TestRandom
+{
+   U32 state;
+   TestRandom(U32 seed) { state = seed; }
+   F32 next()     { state = state * 1664525 + 1013904223; return (state >> 8) / F32(1 << 24); }   // [0, 1)
+   F32 next(F32 lo, F32 hi) { return lo + (hi - lo) * next(); }
+};
+
+
+static bool sameBits(const Point &a, const Point &b)
+{
+   return memcmp(&a.x, &b.x, sizeof(F32)) == 0 && memcmp(&a.y, &b.y, sizeof(F32)) == 0;
+}
+
+
+static bool sameBits(F32 a, F32 b)
+{
+   return memcmp(&a, &b, sizeof(F32)) == 0;
+}
+
+
+// Barrier-like quads plus concave star shapes of assorted sizes, so some polygons need padding lanes
+static void makeTestPolygons(TestRandom &random, Vector<Vector<Point> > &polygons)
+{
+   for(S32 i = 0; i < 40; i++)
+   {
+      Point center(random.next(-500, 500), random.next(-500, 500));
+      polygons.push_back(createPolygon(center, random.next(20, 300), 4, random.next(0, Float2Pi)));
+
+      S32 sides = 3 + i % 11;
+      Vector<Point> star;
+      for(S32 j = 0; j < sides; j++)
+      {
+         F32 radius = random.next(30, 250) * (j % 2 ? 0.4f : 1.0f);
+         F32 angle = Float2Pi * j / sides;
+         star.push_back(center + Point(radius * cos(angle), radius * sin(angle)));
+      }
+      polygons.push_back(star);
+   }
+}
+
+
+// The packed collision routines must give exactly the same answers as the scalar ones, or physics
+// would diverge between machines with and without SSE2
+TEST(GeomUtilsTest, packedPolygonMatchesScalar)
+{
+   TestRandom random(1234);
+   Vector<Vector<Point> > polygons;
+   makeTestPolygons(random, polygons);
+
+   S32 hits = 0;
+
+   for(S32 i = 0; i < polygons.size(); i++)
+   {
+      const Vector<Point> &poly = polygons[i];
+      PackedPolygon packed(poly);
+      ASSERT_EQ(poly.size(), packed.getEdgeCount());
+
+      for(S32 j = 0; j < 500; j++)
+      {
+         F32 radius = random.next(5, 40);
+         Point begin;
+
+         // Half of the sweeps start almost exactly one radius away from the outline, where rounding matters most
+         if(j % 2)
+         {
+            Point v1 = poly[j % poly.size()];
+            Point v2 = poly[(j + 1) % poly.size()];
+            Point onEdge = v1 + (v2 - v1) * (j % 4 == 1 ? 0 : random.next());
+            F32 angle = random.next(0, Float2Pi);
+            begin = onEdge + Point(cos(angle), sin(angle)) * radius * random.next(0.999f, 1.001f);
+         }
+         else
+            begin.set(random.next(-800, 800), random.next(-800, 800));
+
+         Point delta(random.next(-100, 100), random.next(-100, 100));
+
+         Point scalarPoint(-1, -1), packedPoint(-1, -1);
+         F32 scalarFraction = -1, packedFraction = -1;
+
+         bool scalarHit = PolygonSweptCircleIntersect(poly.address(), poly.size(), begin, delta, radius, scalarPoint, scalarFraction);
+         bool packedHit = PolygonSweptCircleIntersect(packed, begin, delta, radius, packedPoint, packedFraction);
+
+         ASSERT_EQ(scalarHit, packedHit) << "polygon " << i << ", sweep " << j;
+         ASSERT_TRUE(sameBits(scalarPoint, packedPoint)) << "polygon " << i << ", sweep " << j;
+         ASSERT_TRUE(sameBits(scalarFraction, packedFraction)) << "polygon " << i << ", sweep " << j;
+
+         scalarPoint.set(-1, -1);
+         packedPoint.set(-1, -1);
+         ASSERT_EQ(polygonCircleIntersect(poly.address(), poly.size(), begin, radius * radius, scalarPoint),
+                   polygonCircleIntersect(packed, begin, radius * radius, packedPoint));
+         ASSERT_TRUE(sameBits(scalarPoint, packedPoint));
+
+         ASSERT_EQ(polygonContainsPoint(poly.address(), poly.size(), begin), polygonContainsPoint(packed, begin));
+
+         if(scalarHit)
+            hits++;
+      }
+   }
+
+   // Make sure the sweeps actually exercised the collision paths
+   EXPECT_LT(1000, hits);
+}
+
+
 };
\ No newline at end of file
@@ -0,0 +1,356 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlGhostConnection.h"
+#include "tnlNetObject.h"
+#include "tnlBitStream.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// NetObject with a fixed update priority and a fixed size update, so we know exactly what should fit in a packet
+class PriorityObject : public NetObject
+{
+   typedef NetObject Parent;
+
+public:
+   F32 mPriority;
+   static const S32 PayloadBits = 400;
+
+   PriorityObject(F32 priority = 0)
+   {
+      mPriority = priority;
+      mNetFlags.set(Ghostable);
+   }
+
+   F32 getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips)
+   {
+      return mPriority;
+   }
+
+   U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream)
+   {
+      stream->write(mPriority);
+      stream->advanceBitPosition(PayloadBits - 32);
+      return 0;
+   }
+
+   void unpackUpdate(GhostConnection *connection, BitStream *stream)
+   {
+      stream->read(&mPriority);
+      stream->advanceBitPosition(PayloadBits - 32);
+   }
+
+   TNL_DECLARE_CLASS(PriorityObject);
+};
+
+TNL_IMPLEMENT_NETOBJECT(PriorityObject);
+
+
+// Scopes every object it is given
+class ScopeEverything : public NetObject
+{
+public:
+   Vector<NetObject *> mObjects;
+
+   void performScopeQuery(GhostConnection *connection)
+   {
+      for(S32 i = 0; i < mObjects.size(); i++)
+         connection->objectInScope(mObjects[i]);
+   }
+};
+
+
+// GhostConnection that writes its packets straight into a PacketStream, with no network or remote host.  Every packet
+// is acknowledged as soon as it is written.
+class PacketWriteConnection : public GhostConnection
+{
+public:
+   PacketWriteConnection()
+   {
+      NetClassRep::initialize();    // Normally done by NetInterface, which we don't have
+
+      setGhostFrom(true);
+      setTranslatesStrings();
+
+      mGhostClassCount = NetClassRep::getNetClassCount(NetClassGroupGame, NetClassTypeObject);
+      mGhostClassBitSize = getNextBinLog2(mGhostClassCount);
+      mScoping = true;
+      mGhosting = true;
+   }
+
+   NetClassGroup getNetClassGroup() const
+   {
+      return NetClassGroupGame;
+   }
+
+   // Writes one packet, filling written with the objects it carried, in the order they were written
+   void writeTestPacket(Vector<NetObject *> &written)
+   {
+      PacketStream stream;
+      writeTestPacket(written, stream);
+   }
+
+   void writeTestPacket(Vector<NetObject *> &written, BitStream &stream)
+   {
+      PacketNotify *notify = allocNotify();
+
+      // Queue the notify as writeRawPacket() would, so the string table can find it
+      TNLAssert(!mNotifyQueueHead, "Packets are acknowledged as they are written; there shouldn't be any outstanding!");
+      mNotifyQueueHead = mNotifyQueueTail = notify;
+      notify->nextPacket = NULL;
+
+      prepareWritePacket();
+      writePacket(&stream, notify);
+
+      written.clear();
+      for(GhostRef *ref = static_cast<GhostPacketNotify *>(notify)->ghostList; ref; ref = ref->nextRef)
+         written.push_back(ref->ghost->obj);
+      written.reverse();      // Refs are prepended as they're written
+
+      mNotifyQueueHead = mNotifyQueueTail = NULL;
+      packetReceived(notify);
+      delete notify;
+   }
+
+   bool writeTestSnapshot(BitStream *stream)
+   {
+      return writeSnapshot(stream);
+   }
+};
+
+
+// GhostConnection that reads what a PacketWriteConnection writes
+class PacketReadConnection : public GhostConnection
+{
+public:
+   PacketReadConnection()
+   {
+      setGhostTo(true);
+
+      mGhostClassCount = NetClassRep::getNetClassCount(NetClassGroupGame, NetClassTypeObject);
+      mGhostClassBitSize = getNextBinLog2(mGhostClassCount);
+      mEventClassCount = NetClassRep::getNetClassCount(NetClassGroupGame, NetClassTypeEvent);
+      mEventClassBitSize = getNextBinLog2(mEventClassCount);
+   }
+
+   NetClassGroup getNetClassGroup() const
+   {
+      return NetClassGroupGame;
+   }
+
+   bool readTestSnapshot(BitStream *stream)
+   {
+      return readSnapshot(stream);
+   }
+
+   void readTestPacket(BitStream *stream)
+   {
+      readPacket(stream);
+   }
+};
+
+
+static F32 getPriority(NetObject *object)
+{
+   return static_cast<PriorityObject *>(object)->mPriority;
+}
+
+
+TEST(GhostConnectionTest, PacketsCarryHighestPriorityFirst)
+{
+   const S32 ObjectCount = 100;
+
+   ScopeEverything scopeObject;
+   Vector<PriorityObject *> objects;
+
+   // Priorities out of order, so nothing can come out right by accident
+   for(S32 i = 0; i < ObjectCount; i++)
+      objects.push_back(new PriorityObject(F32((i * 37) % ObjectCount)));
+
+   for(S32 i = 0; i < objects.size(); i++)
+      scopeObject.mObjects.push_back(objects[i]);
+
+   PacketWriteConnection *connection = new PacketWriteConnection();
+   connection->setScopeObject(&scopeObject);
+
+   Vector<NetObject *> written;
+   Vector<S32> timesWritten;
+   timesWritten.resize(ObjectCount);
+   for(S32 i = 0; i < ObjectCount; i++)
+      timesWritten[i] = 0;
+
+   F32 lowestWritten = F32_MAX;
+   S32 packets = 0;
+
+   while(packets < ObjectCount)
+   {
+      connection->writeTestPacket(written);
+      packets++;
+
+      if(written.size() == 0)
+         break;
+
+      // Each packet should be full of only the most important of the remaining updates, most important first
+      EXPECT_LT(written.size(), ObjectCount);
+      for(S32 i = 0; i < written.size(); i++)
+      {
+         EXPECT_LT(getPriority(written[i]), lowestWritten);
+         lowestWritten = getPriority(written[i]);
+         timesWritten[S32(lowestWritten)]++;
+      }
+   }
+
+   // And in the end, everything gets written once
+   for(S32 i = 0; i < ObjectCount; i++)
+      EXPECT_EQ(1, timesWritten[i]) << "priority " << i;
+
+   delete connection;
+
+   for(S32 i = 0; i < objects.size(); i++)
+      delete objects[i];
+}
+
+
+TEST(GhostConnectionTest, SnapshotRecreatesGhosts)
+{
+   const S32 ObjectCount = 50;
+
+   ScopeEverything scopeObject;
+   Vector<PriorityObject *> objects;
+
+   for(S32 i = 0; i < ObjectCount; i++)
+   {
+      objects.push_back(new PriorityObject(F32(i)));
+      scopeObject.mObjects.push_back(objects[i]);
+   }
+
+   PacketWriteConnection *writer = new PacketWriteConnection();
+   writer->setScopeObject(&scopeObject);
+
+   Vector<NetObject *> written;
+   do
+      writer->writeTestPacket(written);
+   while(written.size() > 0);
+
+   // Kill off a few, so there are gaps in the ghost indices
+   for(S32 i = objects.size() - 1; i >= 0; i -= 7)
+   {
+      delete objects[i];
+      objects.erase(i);
+      scopeObject.mObjects.erase(i);
+   }
+
+   writer->writeTestPacket(written);
+
+   BitStream snapshot;
+   ASSERT_TRUE(writer->writeTestSnapshot(&snapshot));
+
+   PacketReadConnection *reader = new PacketReadConnection();
+   BitStream readStream(snapshot.getBuffer(), snapshot.getBytePosition());
+   ASSERT_TRUE(reader->readTestSnapshot(&readStream));
+
+   // Everything still in scope is there, at the same index, with the same state
+   S32 ghostCount = 0;
+   for(S32 i = 0; i < GhostConnection::MaxGhostCount; i++)
+      if(reader->resolveGhost(i))
+         ghostCount++;
+
+   EXPECT_EQ(scopeObject.mObjects.size(), ghostCount);
+
+   for(S32 i = 0; i < scopeObject.mObjects.size(); i++)
+   {
+      NetObject *ghost = reader->resolveGhost(writer->getGhostIndex(scopeObject.mObjects[i]));
+      ASSERT_TRUE(ghost != NULL);
+      EXPECT_EQ(getPriority(scopeObject.mObjects[i]), getPriority(ghost));
+   }
+
+   // And the writer carries on as though nothing happened
+   writer->writeTestPacket(written);
+   EXPECT_EQ(0, written.size());
+
+   delete reader;
+   delete writer;
+
+   for(S32 i = 0; i < objects.size(); i++)
+      delete objects[i];
+}
+
+
+TEST(GhostConnectionTest, ReceivedUpdatesAreCounted)
+{
+   const S32 ObjectCount = 20;
+
+   ScopeEverything scopeObject;
+   Vector<PriorityObject *> objects;
+
+   for(S32 i = 0; i < ObjectCount; i++)
+   {
+      objects.push_back(new PriorityObject(F32(i)));
+      scopeObject.mObjects.push_back(objects[i]);
+   }
+
+   PacketWriteConnection *writer = new PacketWriteConnection();
+   writer->setScopeObject(&scopeObject);
+
+   PacketReadConnection *reader = new PacketReadConnection();
+   reader->setCountReceivedUpdates(true);
+
+   NetClassRep *classRep = objects[0]->getClassRep();
+   U32 classIdBits = getNextBinLog2(NetClassRep::getNetClassCount(NetClassGroupGame, NetClassTypeObject));
+   Vector<NetObject *> written;
+
+   // Everything arrives once as a new ghost, with its class id, then once more as an update
+   for(S32 pass = 0; pass < 2; pass++)
+   {
+      for(S32 i = 0; i < objects.size(); i++)
+         objects[i]->setMaskBits(1);
+
+      while(true)
+      {
+         BitStream stream;
+         writer->writeTestPacket(written, stream);
+         if(written.size() == 0)
+            break;
+
+         // Sending is counted too, so we only look at what the reader adds
+         U32 initialCount = classRep->getInitialUpdateCount();
+         U32 initialBits  = classRep->getInitialUpdateBits();
+         U32 partialCount = classRep->getPartialUpdateCount();
+         U32 partialBits  = classRep->getPartialUpdateBits();
+
+         BitStream readStream(stream.getBuffer(), stream.getBytePosition());
+         reader->readTestPacket(&readStream);
+
+         U32 count = written.size();
+         if(pass == 0)
+         {
+            EXPECT_EQ(count, classRep->getInitialUpdateCount() - initialCount);
+            EXPECT_EQ(count * (PriorityObject::PayloadBits + classIdBits), classRep->getInitialUpdateBits() - initialBits);
+            EXPECT_EQ(partialCount, classRep->getPartialUpdateCount());
+         }
+         else
+         {
+            EXPECT_EQ(count, classRep->getPartialUpdateCount() - partialCount);
+            EXPECT_EQ(count * PriorityObject::PayloadBits, classRep->getPartialUpdateBits() - partialBits);
+            EXPECT_EQ(initialCount, classRep->getInitialUpdateCount());
+         }
+      }
+   }
+
+   delete reader;
+   delete writer;
+
+   for(S32 i = 0; i < objects.size(); i++)
+      delete objects[i];
+}
+
+
+};
@@ -0,0 +1,475 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "gridDB.h"
+#include "moveObject.h"
+#include "barrier.h"
+#include "loadoutZone.h"
+
+#include "tnlThread.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+static TestItem *addItem(GridDatabase &db, const Point &pos)
+{
+   TestItem *item = new TestItem();       // Will be deleted by the database's destructor
+   item->setExtent(Rect(pos, 10));
+   db.addToDatabase(item);
+
+   return item;
+}
+
+
+static Barrier *addBarrier(GridDatabase &db, const Point &pos)
+{
+   Vector<Point> points;
+   points.push_back(pos);
+   points.push_back(pos);
+   points.push_back(pos + Point(100, 0));
+   points.push_back(pos + Point(100, 0));
+
+   Barrier *barrier = Barrier::createBarrier(points, Barrier::DEFAULT_BARRIER_WIDTH, false);
+   barrier->setExtent(Rect(pos, pos + Point(100, 0)));
+   db.addToDatabase(barrier);
+
+   return barrier;
+}
+
+
+static PolyWall *addPolyWall(GridDatabase &db, const Point &pos)
+{
+   PolyWall *polyWall = new PolyWall();
+   polyWall->setExtent(Rect(pos, 40));
+   db.addToDatabase(polyWall);
+
+   return polyWall;
+}
+
+
+static LoadoutZone *addZone(GridDatabase &db, const Point &pos)
+{
+   LoadoutZone *zone = new LoadoutZone();
+   zone->setExtent(Rect(pos, 40));
+   db.addToDatabase(zone);
+
+   return zone;
+}
+
+
+static bool barriersAreFirst(const Vector<DatabaseObject *> &objects)
+{
+   bool foundNonBarrier = false;
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      if(objects[i]->getObjectTypeNumber() != BarrierTypeNumber)
+         foundNonBarrier = true;
+      else if(foundNonBarrier)
+         return false;
+   }
+
+   return true;
+}
+
+
+static bool hasDuplicates(const Vector<DatabaseObject *> &objects)
+{
+   for(S32 i = 0; i < objects.size(); i++)
+      for(S32 j = i + 1; j < objects.size(); j++)
+         if(objects[i] == objects[j])
+            return true;
+
+   return false;
+}
+
+
+// Objects far apart used to share buckets back when the grid wrapped around every 16 buckets
+TEST(GridDatabaseTest, NoAliasingAcrossGrid)
+{
+   GridDatabase db(false);
+   db.resizeGrid(Rect(0, 0, 20000, 20000));
+
+   addItem(db, Point(100, 100));
+   addItem(db, Point(100 + 16 * 256, 100));     // Would have landed in the same bucket as the item above
+   addItem(db, Point(100, 100 + 16 * 256));
+
+   Vector<DatabaseObject *> found;
+
+   db.resetQueryStats();
+   db.findObjects(TestItemTypeNumber, found, Rect(Point(100, 100), 5));
+
+   EXPECT_EQ(1, found.size());
+   EXPECT_EQ(1, db.getQueryStats().entriesVisited);
+}
+
+
+// Resizing the grid should never change what a query finds, including for objects outside the grid
+TEST(GridDatabaseTest, ResizeKeepsQueryResults)
+{
+   GridDatabase db(false);
+
+   for(S32 i = -20; i < 20; i++)
+      addItem(db, Point(i * 500, i * -300));
+
+   Rect query(-3000, -3000, 3000, 3000);
+   Vector<DatabaseObject *> before, after;
+
+   db.findObjects(TestItemTypeNumber, before, query);
+   db.resizeGrid(Rect(-1000, -1000, 1000, 1000));     // Deliberately smaller than the spread of objects
+   db.findObjects(TestItemTypeNumber, after, query);
+
+   ASSERT_EQ(before.size(), after.size());
+   for(S32 i = 0; i < before.size(); i++)
+      EXPECT_TRUE(after.contains(before[i]));
+
+   // Moving an object off the grid and back again should keep it findable
+   DatabaseObject *obj = after[0];
+   obj->setExtent(Rect(Point(50000, 50000), 10));
+   after.clear();
+   db.findObjects(TestItemTypeNumber, after, Rect(Point(50000, 50000), 5));
+   ASSERT_EQ(1, after.size());
+   EXPECT_EQ(obj, after[0]);
+}
+
+
+// Sizing the grid to a large level cuts how many bucket entries a typical small query walks
+TEST(GridDatabaseTest, BucketWalkCountsOnLargeLevel)
+{
+   const S32 LevelSize = 16000;
+   const S32 Spacing = 200;
+
+   GridDatabase db(false);
+
+   for(S32 x = 0; x < LevelSize; x += Spacing)
+      for(S32 y = 0; y < LevelSize; y += Spacing)
+         addItem(db, Point(x, y));
+
+   Vector<DatabaseObject *> found;
+
+   db.resetQueryStats();
+   for(S32 x = 0; x < LevelSize; x += 1000)
+      for(S32 y = 0; y < LevelSize; y += 1000)
+         db.findObjects(TestItemTypeNumber, found, Rect(Point(x, y), 150));
+   GridDatabase::QueryStats unsized = db.getQueryStats();
+
+   db.resizeGrid(Rect(0, 0, LevelSize, LevelSize));
+
+   S32 foundBefore = found.size();
+   found.clear();
+
+   db.resetQueryStats();
+   for(S32 x = 0; x < LevelSize; x += 1000)
+      for(S32 y = 0; y < LevelSize; y += 1000)
+         db.findObjects(TestItemTypeNumber, found, Rect(Point(x, y), 150));
+   GridDatabase::QueryStats sized = db.getQueryStats();
+
+   EXPECT_EQ(foundBefore, found.size());
+   EXPECT_LT(sized.entriesVisited * 10, unsized.entriesVisited);
+}
+
+
+// Moving walls and zones into the static index should not change what queries find
+TEST(GridDatabaseTest, StaticIndex)
+{
+   GridDatabase db(false);
+   db.resizeGrid(Rect(0, -100, 5000, 100));
+
+   for(S32 i = 0; i < 50; i++)
+   {
+      addItem(db, Point(i * 100, 0));
+      addZone(db, Point(i * 100, -50));
+      addPolyWall(db, Point(i * 100, 25));
+      addBarrier(db, Point(i * 100, 50));
+   }
+
+   Rect query(1000, -100, 3000, 100);
+   Vector<DatabaseObject *> before, after;
+
+   db.findObjects((TestFunc)isAnyObjectType, before, query);
+   db.buildStaticIndex();
+   db.findObjects((TestFunc)isAnyObjectType, after, query);
+
+   EXPECT_EQ(150, db.getStaticObjectCount());
+   ASSERT_EQ(before.size(), after.size());
+   for(S32 i = 0; i < before.size(); i++)
+      EXPECT_TRUE(after.contains(before[i]));
+
+   // Barriers from the static index come back ahead of everything else, polywalls included, so no sorting is needed
+   EXPECT_TRUE(barriersAreFirst(after));
+
+   // If a "static" object moves, it should still be found in its new location
+   DatabaseObject *zone = NULL;
+   for(S32 i = 0; i < after.size() && !zone; i++)
+      if(after[i]->getObjectTypeNumber() == LoadoutZoneTypeNumber)
+         zone = after[i];
+
+   ASSERT_TRUE(zone != NULL);
+   zone->setExtent(Rect(Point(4000, 4000), 40));
+   EXPECT_FALSE(zone->isInStaticIndex());
+   EXPECT_EQ(149, db.getStaticObjectCount());
+
+   after.clear();
+   db.findObjects(LoadoutZoneTypeNumber, after, Rect(Point(4000, 4000), 5));
+   ASSERT_EQ(1, after.size());
+   EXPECT_EQ(zone, after[0]);
+
+   // And static objects can be removed
+   after.clear();
+   db.findObjects(BarrierTypeNumber, after, query);
+   S32 barrierCount = after.size();
+   db.removeFromDatabase(after[0], true);
+
+   after.clear();
+   db.findObjects(BarrierTypeNumber, after, query);
+   EXPECT_EQ(barrierCount - 1, after.size());
+   EXPECT_EQ(148, db.getStaticObjectCount());
+
+   // Emptying the database takes the static index with it
+   db.removeEverythingFromDatabase();
+   EXPECT_EQ(0, db.getStaticObjectCount());
+
+   after.clear();
+   db.findObjects((TestFunc)isAnyObjectType, after, query);
+   EXPECT_EQ(0, after.size());
+}
+
+
+// Objects spanning many buckets must only be reported once per search, and chained searches must skip what earlier
+// searches in the chain already found
+TEST(GridDatabaseTest, QueryContextDeduplicates)
+{
+   GridDatabase db(false);
+   db.resizeGrid(Rect(0, 0, 5000, 5000));
+
+   for(S32 i = 0; i < 20; i++)
+   {
+      TestItem *item = new TestItem();
+      item->setExtent(Rect(Point(i * 250, i * 250), 600));      // Each of these spans a number of buckets
+      db.addToDatabase(item);
+   }
+
+   GridDatabase::QueryContext context;
+   Vector<DatabaseObject *> found;
+
+   db.findObjects(context, (TestFunc)isAnyObjectType, found, Rect(0, 0, 5000, 5000));
+   EXPECT_EQ(20, found.size());
+   EXPECT_FALSE(hasDuplicates(found));
+
+   // Two overlapping searches, chained together, should find each object once
+   found.clear();
+   db.findObjects(context, (TestFunc)isAnyObjectType, found, Rect(0, 0, 2000, 2000));
+   S32 firstCount = found.size();
+   db.findObjects(context, (TestFunc)isAnyObjectType, found, Rect(1000, 1000, 5000, 5000), true);
+
+   EXPECT_LT(0, firstCount);
+   EXPECT_LT(firstCount, found.size());
+   EXPECT_EQ(20, found.size());
+   EXPECT_FALSE(hasDuplicates(found));
+
+   // Starting a new chain forgets what was found before
+   found.clear();
+   db.findObjects(context, (TestFunc)isAnyObjectType, found, Rect(1000, 1000, 5000, 5000));
+   EXPECT_LT(20 - firstCount, found.size());
+}
+
+
+// Runs the same set of searches over and over with its own QueryContext
+class QueryThread : public Thread
+{
+private:
+   const GridDatabase *mDatabase;
+   const Vector<Rect> *mQueries;
+   Semaphore *mDone;
+
+public:
+   S32 mFoundCount;
+
+   QueryThread(const GridDatabase *database, const Vector<Rect> *queries, Semaphore *done) :
+         mDatabase(database), mQueries(queries), mDone(done), mFoundCount(0) { }
+
+   U32 run()
+   {
+      GridDatabase::QueryContext context;
+      Vector<DatabaseObject *> found;
+
+      for(S32 pass = 0; pass < 50; pass++)
+      {
+         found.clear();
+         for(S32 i = 0; i < mQueries->size(); i++)
+            mDatabase->findObjects(context, TestItemTypeNumber, found, mQueries->get(i));
+
+         if(pass == 0)
+            mFoundCount = found.size();
+         else if(found.size() != mFoundCount)
+            mFoundCount = -1;
+      }
+
+      mDone->increment();
+      return 0;
+   }
+};
+
+
+// Searches using different contexts can run at the same time without interfering with one another
+TEST(GridDatabaseTest, ConcurrentQueries)
+{
+   GridDatabase db(false);
+   db.resizeGrid(Rect(0, 0, 10000, 10000));
+
+   for(S32 x = 0; x < 10000; x += 200)
+      for(S32 y = 0; y < 10000; y += 200)
+         addItem(db, Point(x, y));
+
+   Vector<Rect> queries;
+   for(S32 i = 0; i < 100; i++)
+      queries.push_back(Rect(Point(i * 97 % 10000, i * 61 % 10000), 400));
+
+   Vector<DatabaseObject *> expected;
+   for(S32 i = 0; i < queries.size(); i++)
+      db.findObjects(TestItemTypeNumber, expected, queries[i]);
+
+   Semaphore done;
+   QueryThread thread1(&db, &queries, &done);
+   QueryThread thread2(&db, &queries, &done);
+
+   ASSERT_TRUE(thread1.start());
+   ASSERT_TRUE(thread2.start());
+
+   done.wait();
+   done.wait();
+
+   EXPECT_EQ(expected.size(), thread1.mFoundCount);
+   EXPECT_EQ(expected.size(), thread2.mFoundCount);
+}
+
+
+// Lots of objects coming and going, as happens with projectiles and asteroid fragments, shouldn't confuse our object lists
+TEST(GridDatabaseTest, ChurnKeepsListsConsistent)
+{
+   GridDatabase db(false);
+   db.resizeGrid(Rect(0, 0, 5000, 5000));
+
+   Vector<DatabaseObject *> items, zones;
+
+   for(S32 round = 0; round < 20; round++)
+   {
+      for(S32 i = 0; i < 100; i++)
+         items.push_back(addItem(db, Point((round * 100 + i * 37) % 5000, (i * 53) % 5000)));
+      zones.push_back(addZone(db, Point(round * 200, 0)));
+
+      // Thin out the newer half of our items, so removals come from the middle of the lists rather than the end
+      for(S32 i = items.size() / 2; i < items.size(); i += 2)
+      {
+         db.removeFromDatabase(items[i], true);
+         items.erase(i);
+      }
+   }
+
+   EXPECT_EQ(items.size() + zones.size(), db.getObjectCount());
+   EXPECT_EQ(items.size(), db.getObjectCount(TestItemTypeNumber));
+   EXPECT_EQ(zones.size(), db.getObjectCount(LoadoutZoneTypeNumber));
+   EXPECT_TRUE(db.hasObjectOfType(LoadoutZoneTypeNumber));
+   EXPECT_FALSE(db.hasObjectOfType(BarrierTypeNumber));
+
+   Vector<DatabaseObject *> found;
+   db.findObjects(TestItemTypeNumber, found);
+   ASSERT_EQ(items.size(), found.size());
+   for(S32 i = 0; i < items.size(); i++)
+      EXPECT_TRUE(found.contains(items[i]));
+
+   const Vector<DatabaseObject *> *fastZones = db.findObjects_fast(LoadoutZoneTypeNumber);
+   ASSERT_EQ(zones.size(), fastZones->size());
+   for(S32 i = 0; i < zones.size(); i++)
+      EXPECT_TRUE(fastZones->contains(zones[i]));
+
+   found.clear();
+   db.findObjects((TestFunc)isAnyObjectType, found);
+   EXPECT_EQ(db.getObjectCount(), found.size());
+
+   // Removing everything, in an arbitrary order, should leave nothing behind
+   for(S32 i = 0; i < items.size(); i += 2)
+      db.removeFromDatabase(items[i], true);
+   for(S32 i = 1; i < items.size(); i += 2)
+      db.removeFromDatabase(items[i], true);
+
+   EXPECT_EQ(zones.size(), db.getObjectCount());
+   EXPECT_EQ(0, db.getObjectCount(TestItemTypeNumber));
+}
+
+
+static Rect computeExtents(const GridDatabase &db)
+{
+   const Vector<DatabaseObject *> *objects = db.findObjects_fast();
+
+   Rect extents = objects->get(0)->getExtent();
+   for(S32 i = 1; i < objects->size(); i++)
+      extents.unionRect(objects->get(i)->getExtent());
+
+   return extents;
+}
+
+
+// The database's extents should always match what we'd get by looking at every object
+TEST(GridDatabaseTest, ExtentsFollowObjects)
+{
+   GridDatabase db(false);
+   EXPECT_EQ(Rect(), db.getExtents());
+
+   Vector<DatabaseObject *> items;
+   for(S32 i = 0; i < 10; i++)
+      items.push_back(addItem(db, Point(i * 100, i * -50)));
+
+   EXPECT_EQ(computeExtents(db), db.getExtents());
+
+   // Grow, by moving an object outward
+   items[3]->setExtent(Rect(Point(5000, 5000), 10));
+   EXPECT_EQ(computeExtents(db), db.getExtents());
+
+   // Shrink, by moving it back again
+   items[3]->setExtent(Rect(Point(300, -150), 10));
+   EXPECT_EQ(computeExtents(db), db.getExtents());
+
+   // Two objects sharing an edge; moving one of them shouldn't move the edge
+   items[5]->setExtent(items[9]->getExtent());
+   items[9]->setExtent(Rect(Point(450, -225), 10));
+   EXPECT_EQ(computeExtents(db), db.getExtents());
+
+   // Removing the objects that define the edges
+   db.removeFromDatabase(items[0], true);
+   db.removeFromDatabase(items[5], true);
+   EXPECT_EQ(computeExtents(db), db.getExtents());
+
+   // Objects that are re-extented without moving shouldn't disturb anything
+   items[1]->setExtent(items[1]->getExtent());
+   EXPECT_EQ(computeExtents(db), db.getExtents());
+}
+
+
+// Cached scope queries rely on the change count to know when the database has moved on
+TEST(GridDatabaseTest, ChangeCountTracksEdits)
+{
+   GridDatabase db(false);
+   U32 count = db.getChangeCount();
+
+   DatabaseObject *item = addItem(db, Point(0, 0));
+   EXPECT_NE(count, db.getChangeCount());
+
+   count = db.getChangeCount();
+   Vector<DatabaseObject *> found;
+   db.findObjects(found);                          // Searching changes nothing
+   EXPECT_EQ(count, db.getChangeCount());
+
+   item->setExtent(Rect(Point(100, 100), 10));
+   EXPECT_NE(count, db.getChangeCount());
+
+   count = db.getChangeCount();
+   db.removeFromDatabase(item, true);
+   EXPECT_NE(count, db.getChangeCount());
+}
+
+};
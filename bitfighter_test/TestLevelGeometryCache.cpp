@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/LevelGeometryCache.h"
+#include "../zap/barrier.h"
+#include "../zap/stringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <stdio.h>
+
+namespace Zap
+{
+
+static const char *CacheFolder = "LevelGeometryCacheTest";
+
+
+static WallRec makeWall(F32 width, bool solid, F32 x, F32 y, S32 vertCount, F32 step)
+{
+   Vector<F32> verts;
+   for(S32 i = 0; i < vertCount; i++)
+   {
+      verts.push_back(x + i * step);
+      verts.push_back(y - i * step * 2);
+   }
+
+   return WallRec(width, solid, verts);
+}
+
+
+static void expectSameWalls(const Vector<WallRec> &expected, const Vector<WallRec> &actual)
+{
+   ASSERT_EQ(expected.size(), actual.size());
+
+   for(S32 i = 0; i < expected.size(); i++)
+   {
+      EXPECT_EQ(expected[i].solid, actual[i].solid);
+      EXPECT_EQ(expected[i].width, actual[i].width);
+      ASSERT_EQ(expected[i].verts.size(), actual[i].verts.size());
+
+      for(S32 j = 0; j < expected[i].verts.size(); j++)
+         EXPECT_EQ(expected[i].verts[j], actual[i].verts[j]) << "wall " << i << " vert " << j;
+   }
+}
+
+
+TEST(LevelGeometryCacheTest, PackedWallsComeBackExactly)
+{
+   Vector<WallRec> walls;
+   walls.push_back(makeWall(50, false, 0, 0, 4, 255));               // Whole numbers, small steps
+   walls.push_back(makeWall(1, true, 127.5f, -63.75f, 5, 0.1f));      // Fractions
+   walls.push_back(makeWall(30, false, 1e6f, -1e6f, 3, 100000));     // Steps too big for a delta
+   walls.push_back(makeWall(40, false, 10, 10, 300, 2));             // More verts than fit in a short count
+
+   Vector<U8> blob;
+   LevelGeometryCache::packWalls(walls, blob);
+
+   Vector<WallRec> unpacked;
+   ASSERT_TRUE(LevelGeometryCache::unpackWalls(blob, unpacked));
+   expectSameWalls(walls, unpacked);
+
+   // Should beat sending raw floats by a good margin
+   S32 floatCount = 0;
+   for(S32 i = 0; i < walls.size(); i++)
+      floatCount += walls[i].verts.size();
+
+   EXPECT_LT(blob.size(), floatCount * (S32)sizeof(F32) * 2 / 3);
+
+   // Same walls, same hash
+   Vector<U8> blob2;
+   LevelGeometryCache::packWalls(unpacked, blob2);
+   EXPECT_EQ(LevelGeometryCache::getHash(blob), LevelGeometryCache::getHash(blob2));
+}
+
+
+// Vertices no delta can reach have to go as they are, without being converted to an int along the way
+TEST(LevelGeometryCacheTest, OutOfRangeVerticesComeBackExactly)
+{
+   Vector<F32> verts;
+   verts.push_back(3e9f);
+   verts.push_back(-3e9f);
+   verts.push_back(numeric_limits<F32>::infinity());
+   verts.push_back(numeric_limits<F32>::quiet_NaN());
+   verts.push_back(0);
+   verts.push_back(0);
+
+   Vector<WallRec> walls;
+   walls.push_back(WallRec(50, false, verts));
+
+   Vector<U8> blob;
+   LevelGeometryCache::packWalls(walls, blob);
+
+   Vector<WallRec> unpacked;
+   ASSERT_TRUE(LevelGeometryCache::unpackWalls(blob, unpacked));
+   ASSERT_EQ(1, unpacked.size());
+   ASSERT_EQ(verts.size(), unpacked[0].verts.size());
+
+   // Compare bits, as NaN never equals itself
+   EXPECT_EQ(0, memcmp(verts.address(), unpacked[0].verts.address(), verts.size() * sizeof(F32)));
+}
+
+
+TEST(LevelGeometryCacheTest, DamagedBlobsAreRejected)
+{
+   Vector<WallRec> walls;
+   walls.push_back(makeWall(50, false, 0, 0, 20, 255));
+
+   Vector<U8> blob;
+   LevelGeometryCache::packWalls(walls, blob);
+
+   Vector<WallRec> unpacked;
+
+   Vector<U8> truncated = blob;
+   truncated.resize(blob.size() / 2);
+   EXPECT_FALSE(LevelGeometryCache::unpackWalls(truncated, unpacked));
+
+   Vector<U8> wrongVersion = blob;
+   wrongVersion[0]++;
+   EXPECT_FALSE(LevelGeometryCache::unpackWalls(wrongVersion, unpacked));
+}
+
+
+TEST(LevelGeometryCacheTest, SaveAndLoad)
+{
+   LevelGeometryCache cache(CacheFolder);
+
+   Vector<WallRec> walls;
+   walls.push_back(makeWall(50, false, 0, 0, 10, 255));
+
+   Vector<U8> blob;
+   LevelGeometryCache::packWalls(walls, blob);
+   string hash = LevelGeometryCache::getHash(blob);
+
+   Vector<U8> loaded;
+   EXPECT_FALSE(cache.load(hash, loaded));
+
+   ASSERT_TRUE(cache.save(hash, blob));
+   ASSERT_TRUE(cache.load(hash, loaded));
+   ASSERT_EQ(blob.size(), loaded.size());
+   EXPECT_EQ(0, memcmp(blob.address(), loaded.address(), blob.size()));
+
+   // A file that doesn't match its name is no good to us
+   string otherHash = string(hash.size(), '0');
+   ASSERT_TRUE(cache.save(otherHash, blob));
+   EXPECT_FALSE(cache.load(otherHash, loaded));
+
+   // Only so many levels are kept
+   for(S32 i = 0; i < LevelGeometryCache::MaxCachedLevels + 5; i++)
+   {
+      walls[0].width = F32(i);
+      LevelGeometryCache::packWalls(walls, blob);
+      cache.save(LevelGeometryCache::getHash(blob), blob);
+   }
+
+   const string extensions[] = { "geom" };
+   Vector<string> files;
+   getFilesFromFolder(CacheFolder, files, extensions, ARRAYSIZE(extensions));
+   EXPECT_EQ((S32)LevelGeometryCache::MaxCachedLevels, files.size());
+
+   for(S32 i = 0; i < files.size(); i++)
+      remove(joindir(CacheFolder, files[i]).c_str());
+}
+
+
+};
@@ -0,0 +1,320 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+// Leave LogGhostConnection out of this file, so we can see TNLLog compile it away.  Must come before tnlLog.h.
+#define TNL_LOG_COMPILED_TYPES (TNL::LogConsumer::All & ~TNL::LogConsumer::LogGhostConnection)
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+#include "tnlThread.h"
+
+#include "../zap/stringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+// Counts what it's sent, and throws it away
+class CountingLogConsumer : public LogConsumer
+{
+public:
+   S32 count;
+
+   explicit CountingLogConsumer(S32 types) { count = 0; setMsgTypes(types); }
+
+private:
+   void writeString(const char *string) { count++; }
+};
+
+
+static S32 evaluated = 0;
+
+static S32 countEvaluation()
+{
+   evaluated++;
+   return evaluated;
+}
+
+
+TEST(LoggingTest, KnowsWhatConsumersWant)
+{
+   ASSERT_FALSE(LogConsumer::isLogging(LogConsumer::LogNetConnection));
+
+   {
+      CountingLogConsumer a(LogConsumer::LogNetConnection);
+      CountingLogConsumer b(LogConsumer::LogEventConnection);
+
+      EXPECT_TRUE(LogConsumer::isLogging(LogConsumer::LogNetConnection));
+      EXPECT_TRUE(LogConsumer::isLogging(LogConsumer::LogEventConnection));
+      EXPECT_FALSE(LogConsumer::isLogging(LogConsumer::LogConnectionProtocol));
+
+      a.setMsgType(LogConsumer::LogNetConnection, false);
+      EXPECT_FALSE(LogConsumer::isLogging(LogConsumer::LogNetConnection));
+
+      a.setMsgTypes(LogConsumer::LogConnectionProtocol);
+      EXPECT_TRUE(LogConsumer::isLogging(LogConsumer::LogConnectionProtocol));
+   }
+
+   // Gone with the consumers
+   EXPECT_FALSE(LogConsumer::isLogging(LogConsumer::LogEventConnection));
+   EXPECT_FALSE(LogConsumer::isLogging(LogConsumer::LogConnectionProtocol));
+}
+
+
+TEST(LoggingTest, SkipsMessagesNobodyWants)
+{
+   CountingLogConsumer consumer(LogConsumer::LogNetConnection);
+
+   evaluated = 0;
+
+   TNLLog(LogConsumer::LogNetConnection, "wanted %d", countEvaluation());
+   TNLLog(LogConsumer::LogEventConnection, "unwanted %d", countEvaluation());
+   logprintf(LogConsumer::LogEventConnection, "unwanted");
+
+   EXPECT_EQ(1, consumer.count);
+   EXPECT_EQ(1, evaluated);         // Arguments to the unwanted message weren't even looked at
+}
+
+
+TEST(LoggingTest, CompilesOutLeftOutTypes)
+{
+   CountingLogConsumer consumer(LogConsumer::LogGhostConnection);
+   ASSERT_TRUE(LogConsumer::isLogging(LogConsumer::LogGhostConnection));
+
+   evaluated = 0;
+
+   TNLLog(LogConsumer::LogGhostConnection, "compiled out %d", countEvaluation());
+
+   EXPECT_EQ(0, consumer.count);
+   EXPECT_EQ(0, evaluated);
+
+   // logprintf itself doesn't know about this file's TNL_LOG_COMPILED_TYPES
+   logprintf(LogConsumer::LogGhostConnection, "still logged");
+   EXPECT_EQ(1, consumer.count);
+}
+
+
+// Messages nobody wants are dropped whichever way they're logged; ones somebody does all get through
+TEST(LoggingTest, DisabledMessagesAreDropped)
+{
+   static const S32 Messages = 1000;
+   const char *address = "IP:192.168.1.1:28000";
+
+   CountingLogConsumer consumer(LogConsumer::LogEventConnection);
+
+   for(S32 i = 0; i < Messages; i++)
+   {
+      TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: SEND - %d bytes", address, i);
+      logprintf(LogConsumer::LogNetConnection, "NetConnection %s: SEND - %d bytes", address, i);
+   }
+
+   EXPECT_EQ(0, consumer.count);
+
+   for(S32 i = 0; i < Messages; i++)
+      TNLLog(LogConsumer::LogEventConnection, "NetConnection %s: SEND - %d bytes", address, i);
+
+   EXPECT_EQ(Messages, consumer.count);
+}
+
+
+// Not a test, as timings depend on the machine and what else it's doing; run with --gtest_also_run_disabled_tests to
+// see what a message nobody wants costs next to one that somebody does
+TEST(LoggingTest, DISABLED_DisabledMessagesCostNothing)
+{
+   static const S32 Messages = 200000;
+   const char *address = "IP:192.168.1.1:28000";
+
+   CountingLogConsumer consumer(LogConsumer::LogEventConnection);
+
+   U32 start = Platform::getRealMilliseconds();
+   for(S32 i = 0; i < Messages; i++)
+      TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: SEND - %d bytes", address, i);
+   U32 disabledMacroMs = Platform::getRealMilliseconds() - start;
+
+   start = Platform::getRealMilliseconds();
+   for(S32 i = 0; i < Messages; i++)
+      logprintf(LogConsumer::LogNetConnection, "NetConnection %s: SEND - %d bytes", address, i);
+   U32 disabledCallMs = Platform::getRealMilliseconds() - start;
+
+   start = Platform::getRealMilliseconds();
+   for(S32 i = 0; i < Messages; i++)
+      TNLLog(LogConsumer::LogEventConnection, "NetConnection %s: SEND - %d bytes", address, i);
+   U32 enabledMs = Platform::getRealMilliseconds() - start;
+
+   printf("%d messages: disabled TNLLog %dms, disabled logprintf %dms, enabled %dms\n",
+          Messages, disabledMacroMs, disabledCallMs, enabledMs);
+}
+
+
+// Logs lines numbered from first, then says it's done
+class LoggingThread : public Thread
+{
+private:
+   S32 mFirst, mCount;
+   Semaphore &mDone;
+
+public:
+   LoggingThread(S32 first, S32 count, Semaphore &done) : mDone(done) { mFirst = first; mCount = count; }
+
+   U32 run()
+   {
+      for(S32 i = mFirst; i < mFirst + mCount; i++)
+         logprintf(LogConsumer::ServerFilter, "line %d", i);
+
+      mDone.increment();
+      return 0;
+   }
+};
+
+
+static S32 countLines(const string &text)
+{
+   S32 count = 0;
+
+   for(size_t i = 0; i < text.size(); i++)
+      if(text[i] == '\n')
+         count++;
+
+   return count;
+}
+
+
+static const string LogFile = "LoggingTest.log";
+
+
+class FileLogConsumerTest : public testing::Test
+{
+public:
+   void TearDown()
+   {
+      remove(LogFile.c_str());
+
+      for(S32 i = 1; i <= 5; i++)
+         remove((LogFile + "." + itos(i)).c_str());
+   }
+};
+
+
+TEST_F(FileLogConsumerTest, WritesEveryLineFromEveryThread)
+{
+   static const S32 Threads = 4;
+   static const S32 Lines = 5000;
+
+   FileLogConsumer log;
+   log.init(LogFile, "w");
+   log.setMsgTypes(LogConsumer::ServerFilter);
+
+   Semaphore done;
+   LoggingThread *threads[Threads];
+
+   for(S32 i = 0; i < Threads; i++)
+   {
+      threads[i] = new LoggingThread(i * Lines, Lines, done);
+      threads[i]->start();
+   }
+
+   for(S32 i = 0; i < Threads; i++)
+      done.wait();
+
+   log.flush();
+
+   string text = readFile(LogFile);
+   EXPECT_EQ(Threads * Lines, countLines(text));
+
+   // Each thread's lines are in the order it logged them
+   for(S32 i = 0; i < Threads; i++)
+   {
+      size_t first = text.find("line " + itos(i * Lines) + "\n");
+      size_t last  = text.find("line " + itos(i * Lines + Lines - 1) + "\n");
+
+      ASSERT_NE(string::npos, first);
+      ASSERT_NE(string::npos, last);
+      EXPECT_LT(first, last);
+   }
+
+   for(S32 i = 0; i < Threads; i++)
+      delete threads[i];
+}
+
+
+// Lines get to disk on their own, a little while after they're logged
+TEST_F(FileLogConsumerTest, WritesLinesSoonAfterTheyreLogged)
+{
+   FileLogConsumer log;
+   log.init(LogFile, "w");
+   log.setMsgTypes(LogConsumer::ServerFilter);
+
+   logprintf(LogConsumer::ServerFilter, "hello");
+
+   string text;
+   for(S32 i = 0; i < 200 && text == ""; i++)
+   {
+      Platform::sleep(10);
+      text = readFile(LogFile);
+   }
+
+   EXPECT_EQ("hello\n", text);
+}
+
+
+TEST_F(FileLogConsumerTest, WritesEverythingWhenDeleted)
+{
+   {
+      FileLogConsumer log;
+      log.init(LogFile, "w");
+      log.setMsgTypes(LogConsumer::ServerFilter);
+
+      for(S32 i = 0; i < 1000; i++)
+         logprintf(LogConsumer::ServerFilter, "line %d", i);
+   }
+
+   EXPECT_EQ(1000, countLines(readFile(LogFile)));
+}
+
+
+// What a crashing program's signal handler does: lines still queued go straight to the file
+TEST_F(FileLogConsumerTest, WritesQueuedLinesFromSignalHandler)
+{
+   FileLogConsumer log;
+   log.init(LogFile, "w");
+   log.setMsgTypes(LogConsumer::ServerFilter);
+
+   for(S32 i = 0; i < 3; i++)
+      logprintf(LogConsumer::ServerFilter, "line %d", i);
+
+   log.flushFromSignal();     // Well before the writer gets to them
+
+   EXPECT_EQ("line 0\nline 1\nline 2\n", readFile(LogFile));
+}
+
+
+TEST_F(FileLogConsumerTest, RotatesBySize)
+{
+   FileLogConsumer log;
+   log.init(LogFile, "w");
+   log.setMsgTypes(LogConsumer::ServerFilter);
+   log.setRotation(100, 0);
+
+   // 10 bytes a line, so 10 lines a file
+   for(S32 i = 0; i < 25; i++)
+      logprintf(LogConsumer::ServerFilter, "line %04d", i);
+
+   log.flush();
+
+   EXPECT_EQ("line 0000\n", readFile(LogFile + ".2").substr(0, 10));
+   EXPECT_EQ(10, countLines(readFile(LogFile + ".2")));
+   EXPECT_EQ("line 0010\n", readFile(LogFile + ".1").substr(0, 10));
+   EXPECT_EQ(10, countLines(readFile(LogFile + ".1")));
+   EXPECT_EQ("line 0020\n", readFile(LogFile).substr(0, 10));
+   EXPECT_EQ(5, countLines(readFile(LogFile)));
+}
+
+
+};
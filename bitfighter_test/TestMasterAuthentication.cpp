@@ -0,0 +1,437 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../master/master.h"
+#include "../master/MasterServerConnection.h"
+#include "../master/DatabaseAccessThread.h"
+#include "../master/database.h"
+#include "../zap/ServerGame.h"
+#include "../zap/LevelSource.h"
+#include "../zap/stringUtils.h"
+#include "../zap/version.h"
+#include "masterConnection.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Master
+{
+
+using namespace DbWriter;
+
+static const S32 Logins = 300;
+static const S32 LoginsPerIdle = 20;             // All at once would overflow the master's socket buffer, and wait on resends
+static const char *DatabaseFile = "stats.db";     // Where the master keeps its stats when not using MySQL
+
+
+// Stands in for the forum database: checks logins against a table of our own, in the master's SQLite database
+static MasterServerConnection::PHPBB3AuthenticationStatus checkTestUsers(string &username, string password)
+{
+   DatabaseWriter databaseWriter(DatabaseFile);
+   Vector<Vector<string> > results;
+
+   databaseWriter.selectHandler("SELECT password FROM test_users WHERE name = '" + username + "';", 1, results);
+
+   if(results.size() == 0)
+      return MasterServerConnection::UnknownUser;
+
+   return results[0][0] == password ? MasterServerConnection::Authenticated : MasterServerConnection::WrongPassword;
+}
+
+
+// Holds the database up until the test says it can answer, or until it's clear the test is never going to
+static Semaphore *databaseGate = NULL;
+static bool databaseGateTimedOut = false;
+static const U32 DatabaseGateTimeout = 10000;
+
+static MasterServerConnection::PHPBB3AuthenticationStatus checkTestUsersWhenAllowed(string &username, string password)
+{
+   if(!databaseGate->timedWait(DatabaseGateTimeout))
+      databaseGateTimedOut = true;
+
+   return checkTestUsers(username, password);
+}
+
+
+// Logs in to the master the way clients from 017 and before did, and remembers what it was told
+class LegacyLoginConnection : public Zap::MasterServerConnection
+{
+   typedef Zap::MasterServerConnection Parent;
+
+private:
+   string mName;
+   string mPassword;
+   U32 mCSProtocolVersion;
+
+public:
+   bool accepted;
+   bool rejected;
+   TerminationReason rejectReason;
+
+   // Pass CS_PROTOCOL_VERSION to log in like a current client instead
+   LegacyLoginConnection(Game *game, const string &name, const string &password, U32 csProtocolVersion = 35) : Parent(game)
+   {
+      mName = name;
+      mPassword = password;
+      mCSProtocolVersion = csProtocolVersion;
+      accepted = false;
+      rejected = false;
+      rejectReason = ReasonNone;
+
+      setConnectionType(MasterConnectionTypeClient);
+   }
+
+   // Parent writes what a ClientGame would; we have no ClientGame, and want to look older anyway
+   void writeConnectRequest(BitStream *bstream)
+   {
+      MasterServerInterface::writeConnectRequest(bstream);
+
+      bstream->write(U32(MASTER_PROTOCOL_VERSION));
+      bstream->write(mCSProtocolVersion);       // 35 is the client-server protocol of 017
+      bstream->write(U32(BUILD_VERSION));
+      bstream->writeEnum(MasterConnectionTypeClient, MasterConnectionTypeCount);
+
+      bstream->writeString("");                 // Controller
+      bstream->writeString(mName.c_str());
+      bstream->writeString(mPassword.c_str());
+      bstream->writeInt(0, 8);                  // Flags
+
+      Nonce playerId;
+      playerId.getRandom();
+      playerId.write(bstream);
+   }
+
+   void onConnectionEstablished() { accepted = true; }
+   void onConnectTerminated(TerminationReason reason, const char *reasonStr) { rejected = true; rejectReason = reason; }
+};
+
+
+class MasterAuthenticationTest : public testing::Test
+{
+public:
+   bool mHadDatabase;
+
+   void SetUp()
+   {
+      mHadDatabase = fileExists(DatabaseFile);
+
+      DatabaseWriter databaseWriter(DatabaseFile);      // Creates the database if need be
+      Vector<Vector<string> > results;
+
+      databaseWriter.selectHandler("CREATE TABLE IF NOT EXISTS test_users (name TEXT PRIMARY KEY, password TEXT);", 0, results);
+      databaseWriter.selectHandler("DELETE FROM test_users;", 0, results);
+
+      // One user in three has an account
+      string sql = "INSERT INTO test_users VALUES ";
+      for(S32 i = 0; i < Logins; i += 3)
+         sql += string(i == 0 ? "" : ", ") + "('" + getName(i) + "', 'right')";
+
+      databaseWriter.selectHandler(sql + ";", 0, results);
+
+      setVerifier(checkTestUsers);
+      databaseGateTimedOut = false;
+   }
+
+   void TearDown()
+   {
+      setVerifier(MasterServerConnection::verifyCredentials);
+
+      if(mHadDatabase)
+      {
+         Vector<Vector<string> > results;
+         DatabaseWriter(DatabaseFile).selectHandler("DROP TABLE test_users;", 0, results);
+      }
+      else
+         remove(DatabaseFile);
+   }
+
+   // Tests themselves aren't friends of MasterServerConnection, only this fixture
+   static void setVerifier(MasterServerConnection::CredentialsVerifier verifier)
+   {
+      MasterServerConnection::mVerifyCredentials = verifier;
+   }
+
+   static string getName(S32 i)
+   {
+      return "player" + itos(i);
+   }
+
+   // Users with accounts type their password right on every other login
+   static string getPassword(S32 i)
+   {
+      return i % 6 == 0 ? "right" : "wrong";
+   }
+
+   static S32 countAuthenticated(const MasterServer &master)
+   {
+      const Vector<MasterServerConnection *> *clients = master.getClientList();
+      S32 count = 0;
+
+      for(S32 i = 0; i < clients->size(); i++)
+         if(clients->get(i)->isAuthenticated())
+            count++;
+
+      return count;
+   }
+};
+
+
+// Hundreds of old clients log in at once.  Each is told whether it can connect only once its password has been
+// checked, but the master gets on with everything else meanwhile, rather than waiting on the database for each.
+TEST_F(MasterAuthenticationTest, ManyLegacyLoginsAtOnce)
+{
+   MasterSettings masterSettings("");     // Don't read from an INI file
+   masterSettings.mSettings.setVal<U32>("Port", 0);
+   masterSettings.mSettings.setVal<string>("JsonOutfile", "");
+
+   MasterServer master(&masterSettings);
+   master.getNetInterface()->setPuzzleDifficulty(1);     // Hundreds of real puzzles would take a minute to solve
+
+   Address masterAddress;
+   masterAddress.set("IP:127.0.0.1");
+   masterAddress.port = master.getNetInterface()->getSocket().getBoundAddress().port;
+
+   // The connections need a Game; a server one ignores whatever the master tells it
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   ServerGame *game = new ServerGame(Address(), settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+
+   Vector<NetInterface *> interfaces;
+   Vector<RefPtr<LegacyLoginConnection> > connections;
+
+   U32 start = Platform::getRealMilliseconds();
+   S32 answered = 0;
+
+   while(answered < Logins && Platform::getRealMilliseconds() - start < 20000)
+   {
+      for(S32 i = 0; i < LoginsPerIdle && connections.size() < Logins; i++)
+      {
+         S32 index = connections.size();
+         interfaces.push_back(new NetInterface(Address(IPProtocol, Address::Any, 0)));
+         connections.push_back(new LegacyLoginConnection(game, getName(index), getPassword(index)));
+         connections.last()->connect(interfaces.last(), masterAddress);
+      }
+
+      master.idle(5);
+
+      for(S32 i = 0; i < interfaces.size(); i++)
+      {
+         interfaces[i]->checkIncomingPackets();
+         interfaces[i]->processConnections();
+      }
+
+      answered = 0;
+      for(S32 i = 0; i < connections.size(); i++)
+         if(connections[i]->accepted || connections[i]->rejected)
+            answered++;
+
+      Platform::sleep(1);
+   }
+
+   ASSERT_EQ(Logins, answered);
+
+   // Wrong passwords were turned away before connecting, where old clients can see why; everyone else got in
+   for(S32 i = 0; i < Logins; i++)
+      if(i % 3 == 0 && getPassword(i) == "wrong")
+      {
+         EXPECT_TRUE(connections[i]->rejected) << getName(i);
+         EXPECT_EQ(NetConnection::ReasonBadLogin, connections[i]->rejectReason) << getName(i);
+      }
+      else
+         EXPECT_TRUE(connections[i]->accepted) << getName(i);
+
+   EXPECT_EQ(Logins - Logins / 6, master.getClientList()->size());
+   EXPECT_EQ(Logins / 6, countAuthenticated(master));
+   EXPECT_EQ(0, master.getDatabaseAccessThread()->getBacklog());
+
+   for(S32 i = 0; i < interfaces.size(); i++)
+      delete interfaces[i];
+
+   connections.clear();
+   delete game;
+}
+
+
+// An old client's login waits on the database, but nothing else does: with the database stuck, the master keeps
+// handling packets, and lets a current client in, while the old one is still waiting for its answer
+TEST_F(MasterAuthenticationTest, LegacyLoginDoesNotHoldUpOthers)
+{
+   Semaphore gate;
+   databaseGate = &gate;
+   setVerifier(checkTestUsersWhenAllowed);
+
+   MasterSettings masterSettings("");
+   masterSettings.mSettings.setVal<U32>("Port", 0);
+   masterSettings.mSettings.setVal<string>("JsonOutfile", "");
+
+   MasterServer master(&masterSettings);
+   master.getNetInterface()->setPuzzleDifficulty(1);
+
+   Address masterAddress;
+   masterAddress.set("IP:127.0.0.1");
+   masterAddress.port = master.getNetInterface()->getSocket().getBoundAddress().port;
+
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   ServerGame *game = new ServerGame(Address(), settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+
+   Vector<NetInterface *> interfaces;
+   interfaces.push_back(new NetInterface(Address(IPProtocol, Address::Any, 0)));
+   interfaces.push_back(new NetInterface(Address(IPProtocol, Address::Any, 0)));
+
+   RefPtr<LegacyLoginConnection> legacy = new LegacyLoginConnection(game, getName(0), getPassword(0));
+   legacy->connect(interfaces[0], masterAddress);
+
+   for(S32 i = 0; i < 1000 && master.getDatabaseAccessThread()->getBacklog() < 1; i++)
+   {
+      master.idle(5);
+      interfaces[0]->checkIncomingPackets();
+      interfaces[0]->processConnections();
+      Platform::sleep(1);
+   }
+
+   ASSERT_EQ(1, master.getDatabaseAccessThread()->getBacklog());     // Stuck on the gate
+
+   // Well short of DeferredConnectTimeout, so the old client can't get in by timing out
+   RefPtr<LegacyLoginConnection> current = new LegacyLoginConnection(game, getName(1), "", CS_PROTOCOL_VERSION);
+   current->connect(interfaces[1], masterAddress);
+
+   U32 start = Platform::getRealMilliseconds();
+
+   while(!current->accepted && !current->rejected && Platform::getRealMilliseconds() - start < 2000)
+   {
+      master.idle(5);
+
+      for(S32 i = 0; i < interfaces.size(); i++)
+      {
+         interfaces[i]->checkIncomingPackets();
+         interfaces[i]->processConnections();
+      }
+
+      Platform::sleep(1);
+   }
+
+   EXPECT_TRUE(current->accepted);
+   EXPECT_FALSE(legacy->accepted);
+   EXPECT_FALSE(legacy->rejected);
+   EXPECT_EQ(1, master.getClientList()->size());
+   EXPECT_GE(master.getDatabaseAccessThread()->getBacklog(), 1);
+
+   // Now let the database answer, and the old client in
+   gate.increment(2);
+
+   for(S32 i = 0; i < 1000 && !legacy->accepted && !legacy->rejected; i++)
+   {
+      master.idle(5);
+
+      for(S32 j = 0; j < interfaces.size(); j++)
+      {
+         interfaces[j]->checkIncomingPackets();
+         interfaces[j]->processConnections();
+      }
+
+      Platform::sleep(1);
+   }
+
+   EXPECT_TRUE(legacy->accepted);
+   EXPECT_EQ(2, master.getClientList()->size());
+   EXPECT_EQ(1, countAuthenticated(master));
+   EXPECT_FALSE(databaseGateTimedOut);
+
+   for(S32 i = 0; i < interfaces.size(); i++)
+      delete interfaces[i];
+
+   legacy = NULL;
+   current = NULL;
+   delete game;
+}
+
+
+// A client that gives up waiting and tries again with a fresh request replaces the one we were still deciding about,
+// rather than getting in twice.  The fresh request is from a current client, which is accepted straight away, so
+// nothing else clears the old one out of the pending list.
+TEST_F(MasterAuthenticationTest, NewRequestReplacesOneStillBeingDecided)
+{
+   Semaphore gate;
+   databaseGate = &gate;
+   setVerifier(checkTestUsersWhenAllowed);
+
+   MasterSettings masterSettings("");
+   masterSettings.mSettings.setVal<U32>("Port", 0);
+   masterSettings.mSettings.setVal<string>("JsonOutfile", "");
+
+   MasterServer master(&masterSettings);
+   master.getNetInterface()->setPuzzleDifficulty(1);
+
+   Address masterAddress;
+   masterAddress.set("IP:127.0.0.1");
+   masterAddress.port = master.getNetInterface()->getSocket().getBoundAddress().port;
+
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   ServerGame *game = new ServerGame(Address(), settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+
+   NetInterface *client = new NetInterface(Address(IPProtocol, Address::Any, 0));
+   U16 clientPort = client->getSocket().getBoundAddress().port;
+
+   RefPtr<LegacyLoginConnection> first = new LegacyLoginConnection(game, getName(2), "");    // No account; an authenticated name would kick its twin
+   first->connect(client, masterAddress);
+
+   for(S32 i = 0; i < 1000 && master.getDatabaseAccessThread()->getBacklog() < 1; i++)
+   {
+      master.idle(5);
+      client->checkIncomingPackets();
+      client->processConnections();
+      Platform::sleep(1);
+   }
+
+   // Client restarts, from the same address, while the database is still thinking about the first request
+   delete client;
+   client = new NetInterface(Address(IPProtocol, Address::Any, clientPort));
+
+   RefPtr<LegacyLoginConnection> second = new LegacyLoginConnection(game, getName(2), "", CS_PROTOCOL_VERSION);
+   second->connect(client, masterAddress);
+
+   for(S32 i = 0; i < 1000 && master.getDatabaseAccessThread()->getBacklog() < 2; i++)
+   {
+      master.idle(5);
+      client->checkIncomingPackets();
+      client->processConnections();
+      Platform::sleep(1);
+   }
+
+   ASSERT_EQ(2, master.getDatabaseAccessThread()->getBacklog());
+
+   gate.increment(2);
+
+   for(S32 i = 0; i < 1000 && (!second->accepted || master.getDatabaseAccessThread()->getBacklog() > 0); i++)
+   {
+      master.idle(5);
+      client->checkIncomingPackets();
+      client->processConnections();
+      Platform::sleep(1);
+   }
+
+   // Give the old request's answer a chance to turn up, if it's going to
+   for(S32 i = 0; i < 20; i++)
+   {
+      master.idle(5);
+      client->checkIncomingPackets();
+      client->processConnections();
+      Platform::sleep(1);
+   }
+
+   EXPECT_TRUE(second->accepted);
+   EXPECT_EQ(1, master.getClientList()->size());
+   EXPECT_EQ(1, master.getNetInterface()->getConnectionList().size());
+
+   delete client;
+   first = NULL;
+   second = NULL;
+   delete game;
+}
+
+
+};
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TestUtils.h"
+#include "../zap/moveObject.h"
+#include "../zap/ServerGame.h"
+#include "../zap/stringUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+class MoveObjectTest : public testing::Test
+{
+public:
+   ServerGame *mGame;
+
+   void SetUp()
+   {
+      mGame = newServerGame(GameSettingsPtr(new GameSettings()), "GameType 10 8\nLevelName Moving\n");
+   }
+
+   void TearDown()
+   {
+      delete mGame;
+   }
+
+   // Asks the database for any object of the given type near pos
+   bool isFoundAt(U8 typeNumber, const Point &pos)
+   {
+      Vector<DatabaseObject *> found;
+      mGame->getGameObjDatabase()->findObjects(typeNumber, found, Rect(pos, 10));
+      return found.size() > 0;
+   }
+
+   static void expectOutlineOffsetBy(const Vector<Point> &original, const Vector<Point> *outline, const Point &offset)
+   {
+      ASSERT_EQ(original.size(), outline->size());
+      for(S32 i = 0; i < original.size(); i++)
+      {
+         EXPECT_FLOAT_EQ(original[i].x + offset.x, outline->get(i).x);
+         EXPECT_FLOAT_EQ(original[i].y + offset.y, outline->get(i).y);
+      }
+   }
+};
+
+
+// Setting the actual position relies on Item::setPos() to rebuild the outline; make sure the outline follows, and that the
+// extents follow wherever the object is placed
+TEST_F(MoveObjectTest, OutlineAndExtentsFollowActualPos)
+{
+   Asteroid *asteroid = new Asteroid();
+   asteroid->setPos(Point(0, 0));
+   asteroid->addToGame(mGame, mGame->getGameObjDatabase());
+
+   Vector<Point> outline = *asteroid->getOutline();
+   ASSERT_GT(outline.size(), 0);
+
+   // Placing an object sets both its actual and render positions, and moves it in the database
+   Point pos(1000, -500);
+   asteroid->setPos(pos);
+
+   expectOutlineOffsetBy(outline, asteroid->getOutline(), pos);
+   EXPECT_TRUE(asteroid->getExtent().contains(pos));
+   EXPECT_FALSE(asteroid->getExtent().contains(Point(0, 0)));
+   EXPECT_TRUE(isFoundAt(AsteroidTypeNumber, pos));
+   EXPECT_FALSE(isFoundAt(AsteroidTypeNumber, Point(0, 0)));
+
+   // Just the actual position
+   pos.set(-2000, 300);
+   asteroid->setActualPos(pos);
+   expectOutlineOffsetBy(outline, asteroid->getOutline(), pos);
+
+   // Moving under its own steam goes through the same path
+   asteroid->setActualVel(Point(100, 0));
+   asteroid->move(2.0f, ActualState, false);
+
+   Point dest = pos + Point(200, 0);
+   EXPECT_FLOAT_EQ(dest.x, asteroid->getActualPos().x);
+   EXPECT_FLOAT_EQ(dest.y, asteroid->getActualPos().y);
+   expectOutlineOffsetBy(outline, asteroid->getOutline(), dest);
+}
+
+
+// Other states still rebuild the outline themselves; ResourceItems draw theirs around the render position
+TEST_F(MoveObjectTest, OutlineFollowsRenderPos)
+{
+   ResourceItem *item = new ResourceItem();
+   item->setPos(Point(0, 0));
+   item->addToGame(mGame, mGame->getGameObjDatabase());
+
+   Vector<Point> outline = *item->getOutline();
+   Rect extent = item->getExtent();
+
+   Point pos(300, 400);
+   item->setRenderPos(pos);
+
+   expectOutlineOffsetBy(outline, item->getOutline(), pos);
+   EXPECT_EQ(Point(0, 0), item->getActualPos());
+   EXPECT_TRUE(extent == item->getExtent());      // The database only cares where the item actually is
+}
+
+
+// Not a test, as timings depend on the machine and what else it's doing; run with --gtest_also_run_disabled_tests to
+// see what a tick of a level full of asteroids bouncing off each other and the walls costs
+TEST(MoveObjectBenchmark, DISABLED_AsteroidField)
+{
+   static const S32 Rows = 20;
+   static const S32 Ticks = 500;
+
+   string levelCode = "GameType 10 8\nLevelName Asteroids\n"
+                      "BarrierMaker 40 -1 -1 " + itos(Rows * 2) + " -1 " + itos(Rows * 2) + " " + itos(Rows * 2) +
+                      " -1 " + itos(Rows * 2) + " -1 -1\n";
+
+   for(S32 i = 0; i < Rows; i++)
+      for(S32 j = 0; j < Rows; j++)
+         levelCode += "Asteroid " + itos(i * 2) + " " + itos(j * 2) + "\n";
+
+   ServerGame *game = newServerGame(GameSettingsPtr(new GameSettings()), levelCode);
+   S32 asteroids = game->getGameObjDatabase()->getObjectCount(AsteroidTypeNumber);
+
+   U32 start = Platform::getRealMilliseconds();
+   for(S32 i = 0; i < Ticks; i++)
+   {
+      game->unsuspendGame(false);      // Nobody's playing, so the game would otherwise sit still
+      game->idle(10);
+   }
+   U32 elapsed = Platform::getRealMilliseconds() - start;
+
+   printf("%d asteroids, %d ticks: %dms, %.3fms per tick\n", asteroids, Ticks, elapsed, F32(elapsed) / Ticks);
+
+   delete game;
+}
+
+};
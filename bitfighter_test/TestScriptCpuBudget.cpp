@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TestUtils.h"
+#include "../zap/ServerGame.h"
+#include "../zap/LevelSource.h"
+#include "../zap/LuaScriptRunner.h"
+#include "../zap/robot.h"
+#include "../zap/stringUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+static const string LevelCode =
+   "GameType 10 8\n"
+   "LevelName Budget\n"
+   "Team Blue 0 0 1\n"
+   "Spawn 0 0 0\n"
+   "BarrierMaker 40 -10 -10 10 -10 10 10 -10 10 -10 -10\n";
+
+static const string RobotDir = "ScriptCpuBudgetTest";
+
+static const string CounterCode =
+   "ticks = 0\n"
+   "function main() end\n"
+   "function onTick(deltaT) ticks = ticks + 1 end\n";
+
+// Gets stuck on its second tick, in a loop LuaJIT would compile
+static const string LooperCode =
+   "ticks = 0\n"
+   "function main() end\n"
+   "function onTick(deltaT)\n"
+   "   ticks = ticks + 1\n"
+   "   if ticks == 2 then\n"
+   "      local x = 0\n"
+   "      while true do x = x + 1 end\n"
+   "   end\n"
+   "end\n";
+
+// Gets stuck on its second tick, and catches the errors meant to get it out
+static const string SpinnerCode =
+   "ticks = 0\n"
+   "function main() end\n"
+   "function onTick(deltaT)\n"
+   "   ticks = ticks + 1\n"
+   "   if ticks == 2 then\n"
+   "      while true do pcall(function() local x = 0; for i = 1, 100 do x = x + i end end) end\n"
+   "   end\n"
+   "end\n";
+
+
+class ScriptCpuBudgetTest : public testing::Test
+{
+public:
+   TestRobotScripts mScripts;
+
+   ScriptCpuBudgetTest() : mScripts(RobotDir) { }
+
+   void SetUp()
+   {
+      mScripts.add("counter.bot", CounterCode);
+      mScripts.add("looper.bot",  LooperCode);
+      mScripts.add("spinner.bot", SpinnerCode);
+
+      LuaScriptRunner::startLua(GameSettings().getFolderManager()->luaDir);
+   }
+
+   void TearDown()
+   {
+      LuaScriptRunner::shutdown();
+   }
+
+   ServerGame *newGame(S32 threads)
+   {
+      GameSettingsPtr settings = newRobotSettings(RobotDir, threads);
+      settings->getIniSettings()->scriptCpuBudget = 20;
+
+      return newServerGame(settings, LevelCode);
+   }
+
+   // Scripts stuck in loops are stopped and suspended, while the server and other scripts carry on
+   void checkLoopersAreSuspended(S32 threads)
+   {
+      ServerGame *game = newGame(threads);
+
+      Robot *counter = addRobot(game, "counter.bot");
+      Robot *loopers[] = { addRobot(game, "looper.bot"), addRobot(game, "spinner.bot") };
+
+      U32 longest = idleWithRobots(game, 20);
+
+      EXPECT_LT(longest, 1000U);
+      ASSERT_EQ(3, game->getBotCount());        // Nobody was killed
+
+      for(U32 i = 0; i < ARRAYSIZE(loopers); i++)
+      {
+         EXPECT_TRUE(loopers[i]->isSuspended());
+         EXPECT_EQ(1, loopers[i]->getCpuStats().overruns);
+         EXPECT_GE(loopers[i]->getCpuStats().peakTickMs, 20);
+         EXPECT_EQ(2, loopers[i]->getLuaGlobalVar<S32>("ticks"));
+      }
+
+      EXPECT_FALSE(counter->isSuspended());
+      EXPECT_EQ(0, counter->getCpuStats().overruns);
+      EXPECT_GT(counter->getLuaGlobalVar<S32>("ticks"), 2);
+
+      delete game;
+   }
+};
+
+
+TEST_F(ScriptCpuBudgetTest, CountsCpuTime)
+{
+   ServerGame *game = newGame(0);
+
+   Robot *counter = addRobot(game, "counter.bot");
+   idleWithRobots(game, 20);
+
+   const ScriptCpuStats &stats = counter->getCpuStats();
+   S32 ticks = counter->getLuaGlobalVar<S32>("ticks");
+
+   EXPECT_GT(ticks, 2);
+   EXPECT_GT(stats.calls, U32(ticks));          // Also main(), and timers
+   EXPECT_GT(stats.totalMs, 0);
+   EXPECT_EQ(stats.totalMs, stats.periodMs);
+   EXPECT_LE(stats.peakTickMs, stats.totalMs);
+
+   Vector<string> report = game->getScriptCpuReport();
+   ASSERT_EQ(1, report.size());
+   EXPECT_NE(string::npos, report[0].find("counter.bot"));
+
+   counter->resetCpuStatsPeriod();
+   EXPECT_EQ(0, counter->getCpuStats().periodMs);
+   EXPECT_GT(counter->getCpuStats().totalMs, 0);
+
+   delete game;
+}
+
+
+TEST_F(ScriptCpuBudgetTest, SuspendsScriptOverBudget)
+{
+   checkLoopersAreSuspended(0);
+}
+
+
+TEST_F(ScriptCpuBudgetTest, SuspendsScriptOverBudgetOnWorkerThread)
+{
+   checkLoopersAreSuspended(2);
+}
+
+
+};
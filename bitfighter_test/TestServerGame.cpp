@@ -6,6 +6,9 @@
 #include "gameType.h"
 #include "ServerGame.h"
 #include "EngineeredItem.h"
+#include "gameConnection.h"
+#include "LineItem.h"
+#include "TextItem.h"
 
 #include "TestUtils.h"
 
@@ -165,4 +168,83 @@ TEST(ServerGameTest, LoadoutManagementTests)
 }
 
 
+
+// BfObject::computeUpdatePriorities() should rank ghosts exactly as their getUpdatePriority() overrides would
+TEST(ServerGameTest, BatchedUpdatePrioritiesMatchVirtuals)
+{
+   Address addr;
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   LevelSourcePtr levelSource = LevelSourcePtr(new StringLevelSource(""));
+
+   ServerGame *serverGame = new ServerGame(addr, settings, levelSource, false, false);
+   GridDatabase *database = serverGame->getGameObjDatabase();
+
+   GameType *gt = new GameType();    // Cleaned up by database
+   gt->addToGame(serverGame, database);
+
+   Vector<NetObject *> objects;
+   objects.push_back(gt);
+
+   // These are all cleaned up by database
+   Ship *controlShip = new Ship();
+   controlShip->addToGame(serverGame, database);
+   controlShip->setActualVel(Point(100, 0));
+   objects.push_back(controlShip);
+
+   Ship *otherShip = new Ship();
+   otherShip->addToGame(serverGame, database);
+   otherShip->setActualPos(Point(300, 50), false);
+   otherShip->setActualVel(Point(-200, 0));
+   objects.push_back(otherShip);
+
+   for(S32 i = 0; i < 6; i++)
+   {
+      TestItem *testItem = new TestItem();
+      testItem->addToGame(serverGame, database);
+      testItem->setActualPos(Point(i * 150 - 400, i * 80 - 200));
+      testItem->setActualVel(Point(50 - i * 20, i * 15));
+      objects.push_back(testItem);
+   }
+
+   LineItem *lineItem = new LineItem();
+   lineItem->addToGame(serverGame, database);
+   objects.push_back(lineItem);
+
+   TextItem *textItem = new TextItem();
+   textItem->addToGame(serverGame, database);
+   objects.push_back(textItem);
+
+   Vector<GhostInfo> ghosts;
+   ghosts.resize(objects.size());
+
+   Vector<GhostInfo *> ghostPtrs;
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      ghosts[i].obj = objects[i];
+      ghosts[i].updateMask = (i % 2) ? 0xFFFFFFFF : 1;
+      ghosts[i].updateSkipCount = i % 3;
+      ghostPtrs.push_back(&ghosts[i]);
+   }
+
+   BfObject *controlObjects[] = { NULL, controlShip };
+
+   for(S32 i = 0; i < 2; i++)
+   {
+      GameConnection *connection = new GameConnection();
+      connection->setControlObject(controlObjects[i]);
+
+      BfObject::computeUpdatePriorities(connection, ghostPtrs.address(), ghostPtrs.size(), controlObjects[i]);
+
+      for(S32 j = 0; j < objects.size(); j++)
+         EXPECT_EQ(objects[j]->getUpdatePriority(connection, ghosts[j].updateMask, ghosts[j].updateSkipCount), 
+                   ghosts[j].priority) << "object " << j << ", control object " << i;
+
+      connection->setControlObject(NULL);
+      delete connection;
+   }
+
+   delete serverGame;
+}
+
+
 };
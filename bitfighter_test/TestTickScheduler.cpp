@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../zap/TickScheduler.h"
+
+#include "tnlUDP.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+TEST(TickSchedulerTest, TicksAtTheRateAsked)
+{
+   TickScheduler scheduler;
+   scheduler.setTickRate(100);
+   EXPECT_EQ(10, scheduler.getTickLength());
+
+   U64 start = TickScheduler::getMicroseconds();
+
+   S32 ticks = 0;
+   while(ticks < 20)
+      ticks += scheduler.wait();
+
+   U64 elapsedMs = (TickScheduler::getMicroseconds() - start) / 1000;
+
+   EXPECT_EQ(20, ticks);
+   EXPECT_GE(elapsedMs, 190U);
+   EXPECT_LT(elapsedMs, 400U);      // Generous, for busy build machines
+
+   const TickStats &stats = scheduler.getStats();
+   EXPECT_EQ(20U, stats.ticks);
+   EXPECT_EQ(0U, stats.skippedTicks);
+   EXPECT_LE(stats.getMeanJitterUs(), stats.peakJitterUs);
+}
+
+
+// Game time adds up to real time, even when the tick length isn't a whole number of ms
+TEST(TickSchedulerTest, TickTimeKeepsUpWithTheClock)
+{
+   TickScheduler scheduler;
+   scheduler.setTickRate(60);
+
+   U32 total = 0;
+   for(S32 i = 0; i < 60; i++)
+   {
+      U32 ms = scheduler.takeTickTime();
+      EXPECT_TRUE(ms == 16 || ms == 17);
+      total += ms;
+   }
+
+   EXPECT_GE(total, 999U);
+   EXPECT_LE(total, 1000U);
+}
+
+
+// After a long stall we run a few ticks back to back, and let the rest go
+TEST(TickSchedulerTest, CatchesUpAFewTicksAtATime)
+{
+   TickScheduler scheduler;
+   scheduler.setTickRate(100);
+
+   scheduler.wait();
+   Platform::sleep(85);
+
+   EXPECT_EQ(5, scheduler.wait());     // Most we'll catch up
+
+   const TickStats &stats = scheduler.getStats();
+   EXPECT_EQ(6U, stats.ticks);
+   EXPECT_GE(stats.skippedTicks, 2U);
+   EXPECT_GT(stats.peakJitterUs, 0U);     // Late by however far the sleep ran past the last tick due
+
+   scheduler.resetPeriodStats();
+   EXPECT_EQ(0U, scheduler.getPeriodStats().ticks);
+   EXPECT_EQ(6U, scheduler.getStats().ticks);
+
+   // And then we're back on the beat
+   EXPECT_EQ(1, scheduler.wait());
+}
+
+
+#ifdef TNL_OS_LINUX
+// A packet wakes us straight away, without waiting for the tick
+TEST(TickSchedulerTest, WakesForPackets)
+{
+   Socket sender(Address(IPProtocol, Address::Any, 0));
+   Socket receiver(Address(IPProtocol, Address::Any, 0));
+   ASSERT_TRUE(sender.isValid());
+   ASSERT_TRUE(receiver.isValid());
+
+   Address receiverAddress;
+   receiverAddress.set("IP:127.0.0.1");
+   receiverAddress.port = receiver.getBoundAddress().port;
+
+   TickScheduler scheduler;
+   scheduler.setTickRate(1);        // So the tick won't come first
+   scheduler.setSocket(receiver.getPlatformSocket());
+
+   U8 packet[] = { 1, 2, 3 };
+   ASSERT_EQ(NoError, sender.sendto(receiverAddress, packet, sizeof(packet)));
+
+   U64 start = TickScheduler::getMicroseconds();
+   EXPECT_EQ(0, scheduler.wait());
+   EXPECT_LT(TickScheduler::getMicroseconds() - start, 100000U);
+   EXPECT_EQ(1U, scheduler.getStats().packetWakeups);
+
+   // Read it, and we can sleep again: the next wake is the tick
+   U8 buffer[MaxPacketDataSize];
+   Address from;
+   S32 size;
+   ASSERT_EQ(NoError, receiver.recvfrom(&from, buffer, sizeof(buffer), &size));
+
+   scheduler.setTickRate(100);
+   EXPECT_EQ(1, scheduler.wait());
+   EXPECT_EQ(1U, scheduler.getStats().packetWakeups);
+}
+#endif
+
+
+};
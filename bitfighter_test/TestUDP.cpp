@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlUDP.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const U32 BufferSize = 256 * 1024;      // Big enough that loopback doesn't drop anything
+
+
+class UDPTest : public testing::Test
+{
+public:
+   Socket *sender;
+   Socket *receiver;
+   Address receiverAddress;
+
+   void SetUp()
+   {
+      sender   = new Socket(Address(IPProtocol, Address::Any, 0), BufferSize, BufferSize);
+      receiver = new Socket(Address(IPProtocol, Address::Any, 0), BufferSize, BufferSize);
+
+      ASSERT_TRUE(sender->isValid());
+      ASSERT_TRUE(receiver->isValid());
+
+      receiverAddress.set("IP:127.0.0.1");
+      receiverAddress.port = receiver->getBoundAddress().port;
+   }
+
+   void TearDown()
+   {
+      delete sender;
+      delete receiver;
+   }
+
+   // Packet i is i + 1 bytes long, each byte set to i
+   void send(S32 first, S32 count)
+   {
+      U8 buffer[MaxPacketDataSize];
+
+      for(S32 i = first; i < first + count; i++)
+      {
+         memset(buffer, i, i + 1);
+         EXPECT_EQ(NoError, sender->sendto(receiverAddress, buffer, i + 1));
+      }
+   }
+
+   // Reads until count packets arrive, or there's been nothing for a while; checks they're the ones send() sent
+   S32 receive(S32 first, S32 count)
+   {
+      U8 buffer[MaxPacketDataSize];
+      Address from;
+      S32 size;
+      S32 received = 0;
+
+      for(S32 waits = 0; received < count && waits < 50; )
+      {
+         if(receiver->recvfrom(&from, buffer, sizeof(buffer), &size) != NoError)
+         {
+            Platform::sleep(2);
+            waits++;
+            continue;
+         }
+
+         S32 i = first + received;
+         EXPECT_EQ(i + 1, size);
+         EXPECT_EQ(U8(i), buffer[0]);
+         EXPECT_EQ(U8(i), buffer[size - 1]);
+         EXPECT_EQ(sender->getBoundAddress().port, from.port);
+
+         received++;
+      }
+
+      return received;
+   }
+};
+
+
+TEST_F(UDPTest, SendsAndReceivesOneAtATime)
+{
+   send(0, 5);
+   EXPECT_EQ(5, receive(0, 5));
+}
+
+
+// More packets than fit in one system call, read and written in order
+TEST_F(UDPTest, SendsBatchesWhenAsked)
+{
+   static const S32 Packets = Socket::BatchSize * 2 + 10;
+
+   sender->beginSendBatch();
+   send(0, Packets);
+
+#ifdef TNL_OS_LINUX
+   // Two full batches have gone, the rest are waiting
+   EXPECT_EQ(Socket::BatchSize * 2, receive(0, Packets));
+   EXPECT_EQ(0, receive(Socket::BatchSize * 2, 1));
+
+   sender->endSendBatch();
+   EXPECT_EQ(10, receive(Socket::BatchSize * 2, 10));
+#else
+   sender->endSendBatch();
+   EXPECT_EQ(Packets, receive(0, Packets));
+#endif
+}
+
+
+TEST_F(UDPTest, NestedBatchesGoWhenOutermostEnds)
+{
+   sender->beginSendBatch();
+   sender->beginSendBatch();
+   send(0, 3);
+   sender->endSendBatch();
+
+#ifdef TNL_OS_LINUX
+   EXPECT_EQ(0, receive(0, 1));
+#endif
+
+   sender->endSendBatch();
+   EXPECT_EQ(3, receive(0, 3));
+
+   // And we're back to sending straight away
+   send(3, 2);
+   EXPECT_EQ(2, receive(3, 2));
+}
+
+
+TEST_F(UDPTest, HeldPacketsGoWhenSocketCloses)
+{
+   sender->beginSendBatch();
+   send(0, 4);
+
+   delete sender;
+   sender = new Socket(Address(IPProtocol, Address::Any, 0));
+
+   U8 buffer[MaxPacketDataSize];
+   Address from;
+   S32 size, received = 0;
+
+   for(S32 waits = 0; received < 4 && waits < 50; )
+      if(receiver->recvfrom(&from, buffer, sizeof(buffer), &size) == NoError)
+         received++;
+      else
+      {
+         Platform::sleep(2);
+         waits++;
+      }
+
+   EXPECT_EQ(4, received);
+}
+
+
+};
@@ -13,8 +13,13 @@
 #include "../zap/SystemFunctions.h"
 
 #include "../zap/stringUtils.h"
+#include "../zap/robot.h"
 #include "gtest/gtest.h"
 
+#include "tnlPlatform.h"
+
+#include <fstream>
+#include <stdio.h>
 #include <string>
 
 using namespace std;
@@ -59,6 +64,87 @@ ServerGame *newServerGame()
 }
 
 
+// Create a new ServerGame playing levelCode -- be sure to delete this somewhere!
+ServerGame *newServerGame(const GameSettingsPtr &settings, const string &levelCode)
+{
+   LevelSourcePtr levelSource = LevelSourcePtr(new StringLevelSource(levelCode));
+
+   ServerGame *game = new ServerGame(Address(), settings, levelSource, false, false);
+   game->cycleLevel(FIRST_LEVEL);
+
+   return game;
+}
+
+
+GameSettingsPtr newRobotSettings(const string &robotDir, S32 botWorkerThreads)
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+
+   settings->getFolderManager()->cacheDir = "";       // Don't leave bot zones lying about
+   settings->getFolderManager()->robotDir = robotDir;
+   settings->getIniSettings()->botWorkerThreads = botWorkerThreads;
+
+   return settings;
+}
+
+
+// Adds a robot running script to team, passing it name if there is one
+Robot *addRobot(ServerGame *game, const string &script, const string &name, S32 team)
+{
+   string teamArg = itos(team);
+
+   Vector<const char *> args;
+   args.push_back(teamArg.c_str());
+   args.push_back(script.c_str());
+
+   if(name != "")
+      args.push_back(name.c_str());
+
+   EXPECT_EQ("", game->addBot(args, ClientInfo::ClassRobotAddedByAddbots));
+
+   return game->getBot(game->getBotCount() - 1);
+}
+
+
+// A game with nobody but robots playing suspends itself, so wake it up each time.  Returns the longest any one idle took.
+U32 idleWithRobots(ServerGame *game, S32 cycles, U32 timeDelta)
+{
+   U32 longest = 0;
+
+   for(S32 i = 0; i < cycles; i++)
+   {
+      game->unsuspendGame(false);
+
+      U32 start = Platform::getRealMilliseconds();
+      game->idle(timeDelta);
+      longest = max(longest, Platform::getRealMilliseconds() - start);
+   }
+
+   return longest;
+}
+
+
+TestRobotScripts::TestRobotScripts(const string &folder)
+{
+   this->folder = folder;
+   makeSureFolderExists(folder);
+}
+
+
+TestRobotScripts::~TestRobotScripts()
+{
+   for(S32 i = 0; i < filenames.size(); i++)
+      remove(joindir(folder, filenames[i]).c_str());
+}
+
+
+void TestRobotScripts::add(const string &filename, const string &code)
+{
+   ofstream(joindir(folder, filename).c_str()) << code;
+   filenames.push_back(filename);
+}
+
+
 GamePair::GamePair(GameSettingsPtr settings)
 {
    initialize(settings, "", 0);
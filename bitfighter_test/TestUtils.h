@@ -22,11 +22,32 @@ using namespace TNL;
 
 class ServerGame;
 class ClientGame;
+class Robot;
 
 ClientGame *newClientGame();
 ClientGame *newClientGame(const GameSettingsPtr &settings);
 
 ServerGame *newServerGame();
+ServerGame *newServerGame(const GameSettingsPtr &settings, const string &levelCode);
+
+// For tests of robots: settings for a server that finds its robots in robotDir, and runs them on botWorkerThreads
+GameSettingsPtr newRobotSettings(const string &robotDir, S32 botWorkerThreads);
+Robot *addRobot(ServerGame *game, const string &script, const string &name = "", S32 team = 0);
+U32 idleWithRobots(ServerGame *game, S32 cycles, U32 timeDelta = 10);
+
+/**
+ * Robot scripts for a test, written to a folder of their own, and deleted again when this goes
+ */
+struct TestRobotScripts
+{
+   explicit TestRobotScripts(const string &folder);
+   ~TestRobotScripts();
+
+   void add(const string &filename, const string &code);
+
+   string folder;
+   Vector<string> filenames;
+};
 
 // Generic pack/unpack function -- feed it any class that supports pack/unpack
 template <class T>
@@ -9,6 +9,7 @@
 
 #include "tnlThread.h"
 #include "tnlLog.h"
+#include "tnlVector.h"
 
 namespace Master
 {
@@ -22,27 +23,28 @@ public:
    virtual void finish() {};  // finishes the entry on primary thread after "run()" is done to avoid 2 threads crashing in to the same network TNL and others.
 };
 
+// Runs entries one after another on a thread of its own, then finishes them on the main thread when it calls idle().
+// The queue grows as needed, so a burst of entries (logins at peak time, say) waits its turn rather than being
+// dropped, and the thread sleeps until there's something for it to do.
 class DatabaseAccessThread : public TNL::Thread
 {
 private:
-   U32 mEntryStart;
-   U32 mEntryThread;
-   U32 mEntryEnd;
-
-   bool mRunning;
+   // Only the main thread touches these, so RefPtr counts never change on two threads at once
+   Vector<RefPtr<ThreadEntry> > mEntries;    // Every entry not yet finished, in the order added
    bool mThreadActive;
 
-   static const U32 mEntrySize = 128;
+   // Shared with the thread, guarded by mMutex
+   Mutex mMutex;
+   Vector<ThreadEntry *> mToRun;             // Added, but not yet run
+   Vector<ThreadEntry *> mRan;               // Run, but not yet finished
+   bool mRunning;
 
-   RefPtr<ThreadEntry> mEntry[mEntrySize];
+   Semaphore mWakeup;                        // Something to run, or time to stop
+   Semaphore mStopped;
 
 public:
    DatabaseAccessThread() // Constructor
    {
-      mEntryStart = 0;
-      mEntryThread = 0;
-      mEntryEnd = 0;
-
       mRunning = true;
       mThreadActive = false;
    }
@@ -50,19 +52,16 @@ public:
 
    void addEntry(ThreadEntry *entry)
    {
-      U32 entryEnd = mEntryEnd + 1;
+      mEntries.push_back(entry);
 
-      if(entryEnd >= mEntrySize)
-         entryEnd = 0;
+      mMutex.lock();
+      bool wasIdle = mToRun.size() == 0;
+      mToRun.push_back(entry);
+      mMutex.unlock();
 
-      if(entryEnd == mEntryStart)      // Too many entries
-      {
-         logprintf(LogConsumer::LogError, "Database thread overloaded - database access too slow?");
-         return;
-      }
+      if(wasIdle)
+         mWakeup.increment();
 
-      mEntry[mEntryEnd] = entry;
-      mEntryEnd = entryEnd;
       if(!mThreadActive)
       {
          mThreadActive = true;
@@ -71,48 +70,87 @@ public:
    }
 
 
+   // Number of entries added but not yet finished
+   S32 getBacklog() const
+   {
+      return mEntries.size();
+   }
+
+
    U32 run()
    {
-      mThreadActive = true;
-      while(mRunning)
+      for(;;)
       {
-         if(mEntryThread != mEntryEnd)
+         mMutex.lock();
+
+         if(!mRunning)
          {
-            mEntry[mEntryThread]->run();
-            mEntryThread++;
-            if(mEntryThread >= mEntrySize)
-               mEntryThread = 0;
+            mMutex.unlock();
+            break;
          }
-         else
-            Platform::sleep(50);
-      }
 
-      mThreadActive = false;
+         ThreadEntry *entry = NULL;
+         if(mToRun.size() > 0)
+         {
+            entry = mToRun[0];
+            mToRun.erase(0);
+         }
+
+         mMutex.unlock();
 
+         if(!entry)
+         {
+            mWakeup.wait();
+            continue;
+         }
+
+         entry->run();
+
+         mMutex.lock();
+         mRan.push_back(entry);
+         mMutex.unlock();
+      }
+
+      mStopped.increment();
       return 0;
    }
 
 
    void idle()
    {
-      while(mEntryStart != mEntryThread)
-      {
-         mEntry[mEntryStart]->finish();
-         mEntry[mEntryStart].set(NULL);  // RefPtr, we can just set to NULL and it will delete itself
-         mEntryStart++;
+      mMutex.lock();
+      Vector<ThreadEntry *> ran = mRan;
+      mRan.clear();
+      mMutex.unlock();
 
-         if(mEntryStart >= mEntrySize)
-            mEntryStart = 0;
+      // Entries run in the order they were added, so the ones that have run are at the front of mEntries
+      for(S32 i = 0; i < ran.size(); i++)
+      {
+         TNLAssert(mEntries[i] == ran[i], "Entries finishing out of order!");
+         ran[i]->finish();
       }
+
+      for(S32 i = 0; i < ran.size(); i++)
+         mEntries.erase(0);
    }
 
+
    void terminate()
    {
+      if(!mThreadActive)
+         return;
+
+      mMutex.lock();
       mRunning = false;
-      while(mThreadActive)
-         Platform::sleep(50);
+      mMutex.unlock();
+
+      mWakeup.increment();
+      mStopped.wait();
+
+      mThreadActive = false;
    }
 
+
    ~DatabaseAccessThread()
    {
       terminate();
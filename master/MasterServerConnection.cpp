@@ -188,7 +188,7 @@ struct Auth_Stats : public MasterThreadEntry
 
    void run()
    {
-      stat = MasterServerConnection::verifyCredentials(playerName, password);
+      stat = MasterServerConnection::mVerifyCredentials(playerName, password);
       if(stat == MasterServerConnection::Authenticated)
       {
          DatabaseWriter databaseWriter = getDatabaseWriter(mSettings);
@@ -210,7 +210,12 @@ struct Auth_Stats : public MasterThreadEntry
 };
 
 
-MasterServerConnection::PHPBB3AuthenticationStatus MasterServerConnection::checkAuthentication(const char *password, bool doNotDelay)
+MasterServerConnection::CredentialsVerifier MasterServerConnection::mVerifyCredentials = MasterServerConnection::verifyCredentials;
+
+
+// Starts checking the password on the database thread, which calls processAutentication with the answer.  Returns
+// InvalidUsername if we can tell that much without asking, UnknownStatus otherwise.
+MasterServerConnection::PHPBB3AuthenticationStatus MasterServerConnection::checkAuthentication(const char *password)
 {
    // Don't let username start with spaces or be zero length.
    if(mPlayerOrServerName.getString()[0] == ' ' || mPlayerOrServerName.getString()[0] == 0)
@@ -223,25 +228,64 @@ MasterServerConnection::PHPBB3AuthenticationStatus MasterServerConnection::check
    auth->stat = UnknownStatus;
    mMaster->getDatabaseAccessThread()->addEntry(auth);
 
-   if(doNotDelay)  // Wait up to 1000 milliseconds so we can return some value, for clients version 017 and older
-   {
-      U32 timer = Platform::getRealMilliseconds();
-      while(Platform::getRealMilliseconds() - timer < 1000 && auth->stat == UnknownStatus)
-      {
-         Platform::sleep(5);
-      }
-      return auth->stat;
-   }
    return UnknownStatus;
 }
 
 
+// Once we've decided to let a client connect
+void MasterServerConnection::addToClientList()
+{
+   mMaster->addClient(this);
+
+   // CLIENT_CONNECT | timestamp | player name
+   logprintf(LogConsumer::LogConnection, "CLIENT_CONNECT\t%s\t%s",
+                                         getTimeStamp().c_str(), mPlayerOrServerName.getString());
+
+   // Delay writing JSON to reduce chances of incorrectly showing new player as unauthenticated
+   mMaster->writeJsonDelayed();
+}
+
+
+// A client we're not letting connect until we've checked their password (see readConnectRequest) has been waiting
+// too long for the database.  Let them in, and deal with the password when the answer comes, as for newer clients.
+bool MasterServerConnection::onConnectDecisionTimedOut()
+{
+   logprintf(LogConsumer::LogConnection, "Database slow to authenticate %s; letting them connect meanwhile",
+                                         mPlayerOrServerName.getString());
+   addToClientList();
+
+   return true;
+}
+
+
 Vector<string> master_admins;  // --> move to settings struct
 
 
 void MasterServerConnection::processAutentication(StringTableEntry newName, PHPBB3AuthenticationStatus stat,
                                                   TNL::Int<32> badges, U16 gamesPlayed)
 {
+   // Clients 017 and older are still waiting to hear whether they can connect at all
+   if(getConnectionState() == NetConnection::DecidingConnectRequest)
+   {
+      RefPtr<MasterServerConnection> keepAlive = this;    // Rejecting lets go of us
+
+      if(stat == WrongPassword)
+      {
+         mLoggingStatus = "Wrong password";
+         getInterface()->rejectDeferredConnection(this, ReasonBadLogin, "Incorrect password");
+         return;
+      }
+      else if(stat == InvalidUsername)
+      {
+         mLoggingStatus = "Invalid username";
+         getInterface()->rejectDeferredConnection(this, ReasonInvalidUsername, "Invalid username");
+         return;
+      }
+
+      addToClientList();
+      getInterface()->acceptDeferredConnection(this);
+   }
+
    mBadges = NO_BADGES;
    if(stat == WrongPassword)
    {
@@ -1620,55 +1664,26 @@ bool MasterServerConnection::readConnectRequest(BitStream *bstream, NetConnectio
                return false;
             }
 
-         // Start the authentication by reading database on seperate thread
-         // On clients 017 and older, they completely ignore any disconnect reason once fully connected,
-         // so we pause waiting for database instead of fully connecting yet.
-
          for(S32 i = 0; i < gListAddressHide.size(); i++)
             if(getNetAddress().isEqualAddress(gListAddressHide[i]))
                mIsIgnoredFromList = true;
 
-         switch(checkAuthentication(readstr, mCSProtocolVersion <= 35)) // readstr is password
+         // Start the authentication by reading database on seperate thread
+         if(checkAuthentication(readstr) == InvalidUsername)    // readstr is password
          {
-            case WrongPassword:
-               reason = ReasonBadLogin;
-               mLoggingStatus = "Wrong password";
-               reasonStr = "Incorrect password";
-               return false;
-
-            case InvalidUsername:
-               reason = ReasonInvalidUsername;
-               mLoggingStatus = "Invalid username";
-               reasonStr = "Invalid username";
-               return false;
-
-            case UnknownStatus:
-               mMaster->addClient(this);
-
-               // CLIENT_CONNECT | timestamp | player name
-               logprintf(LogConsumer::LogConnection, "CLIENT_CONNECT\t%s\t%s",
-                                                     getTimeStamp().c_str(), mPlayerOrServerName.getString());
-
-               // Delay writing JSON to reduce chances of incorrectly showing new player as unauthenticated
-               mMaster->writeJsonDelayed();
-               break;
-
-            case Authenticated:
-               mMaster->addClient(this);
-
-               // CLIENT_CONNECT | timestamp | player name
-               logprintf(LogConsumer::LogConnection, "CLIENT_CONNECT\t%s\t%s",
-                                                     getTimeStamp().c_str(), mPlayerOrServerName.getString());
-
-               mMaster->writeJsonNow();      // Write immediately
-               break;
-
-            case CantConnect:
-            case UnknownUser:
-            case Unsupported:
-               // Do nothing
-               break;
+            reason = ReasonInvalidUsername;
+            mLoggingStatus = "Invalid username";
+            reasonStr = "Invalid username";
+            return false;
          }
+
+         // Clients 017 and older completely ignore any disconnect reason once fully connected, so we put off
+         // accepting them until the database has answered, and processAutentication can reject a wrong password.
+         // Meanwhile we get on with everyone else.
+         if(mCSProtocolVersion <= 35 && !getConnectionParameters().mIsLocal)
+            setConnectionState(DecidingConnectRequest);
+         else
+            addToClientList();
       }
       break;
 
@@ -199,10 +199,21 @@ public:
    // Check username & password against database
    static PHPBB3AuthenticationStatus verifyCredentials(string &username, string password);
 
-   PHPBB3AuthenticationStatus checkAuthentication(const char *password, bool doNotDelay = false);
+   PHPBB3AuthenticationStatus checkAuthentication(const char *password);
    void processAutentication(StringTableEntry newName, PHPBB3AuthenticationStatus status, TNL::Int<32> badges,
                              U16 gamesPlayed);
 
+private:
+   typedef PHPBB3AuthenticationStatus (*CredentialsVerifier)(string &username, string password);
+   static CredentialsVerifier mVerifyCredentials;     // verifyCredentials, unless a test has its own database
+
+   friend struct Auth_Stats;
+   friend class MasterAuthenticationTest;
+
+   void addToClientList();
+
+public:
+
    // Client has contacted us and requested a list of active servers
    // that match their criteria.
    //
@@ -300,6 +311,7 @@ public:
    bool readConnectRequest(BitStream *stream, NetConnection::TerminationReason &reason, string &reasonStr);
    void writeConnectAccept(BitStream *stream);
    void onConnectionEstablished();
+   bool onConnectDecisionTimedOut();
 
 
    TNL_DECLARE_RPC_OVERRIDE(c2mJoinGlobalChat, ());
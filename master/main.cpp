@@ -161,6 +161,8 @@ int main(int argc, const char **argv)
    statisticsLogConsumer.init("bitfighter_player_stats.log", "a");
    statisticsLogConsumer.setMsgTypes(LogConsumer::StatisticsFilter);
 
+   LogConsumer::flushAllOnExit();               // Logs are written on threads of their own; don't lose the last lines
+
    // Set INI location
    MasterSettings settings("master.ini");
    settings.readConfigFile();
@@ -50,6 +50,7 @@ EventConnection::EventConnection()
    mEventClassCount = 0;
    mEventClassBitSize = 0;
    mTNLDataBuffer = NULL;
+   mCapturedEvents = NULL;
 }
 
 static const U32 mTNLDataBufferMaxSize = 1024 * 1024 * 4;  // 4 MB
@@ -91,7 +92,8 @@ void EventConnection::clearSendEvents()
    mNextSendEventSeq = FirstValidSendEventSeq;
 }
 
-void EventConnection::clearRecvEvents()
+// Forgets everything received so far; nextRecvEventSeq is the sequence number of the next ordered event to expect
+void EventConnection::clearRecvEvents(S32 nextRecvEventSeq)
 {
    while(mWaitSeqEvents)
    {
@@ -99,9 +101,10 @@ void EventConnection::clearRecvEvents()
       mWaitSeqEvents = temp->mNextEvent;
       mEventNoteChunker.free(temp);
    }
-   mNextRecvEventSeq = FirstValidSendEventSeq;
-   if(mTNLDataBuffer)
-      delete mTNLDataBuffer;
+   mNextRecvEventSeq = nextRecvEventSeq;
+
+   delete mTNLDataBuffer;
+   mTNLDataBuffer = NULL;
 }
 
 void EventConnection::writeConnectRequest(BitStream *stream)
@@ -213,7 +216,7 @@ void EventConnection::packetDropped(PacketNotify *pnotify)
             // It was a guaranteed ordered packet, reinsert it back into
             // mSendEventQueueHead in the right place (based on seq numbers)
 
-            logprintf(LogConsumer::LogEventConnection, "EventConnection %s: DroppedGuaranteed - %d", getNetAddressString(), walk->mSeqCount);
+            TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: DroppedGuaranteed - %d", getNetAddressString(), walk->mSeqCount);
             while(*insertList && (*insertList)->mSeqCount < walk->mSeqCount)
                insertList = &((*insertList)->mNextEvent);
             
@@ -279,7 +282,7 @@ void EventConnection::packetReceived(PacketNotify *pnotify)
    {
       mLastAckedEventSeq++;
       EventNote *next = mNotifyEventList->mNextEvent;
-      logprintf(LogConsumer::LogEventConnection, "EventConnection %s: NotifyDelivered - %d", getNetAddressString(), mNotifyEventList->mSeqCount);
+      TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: NotifyDelivered - %d", getNetAddressString(), mNotifyEventList->mSeqCount);
       mNotifyEventList->mEvent->notifyDelivered(this, true);
       mEventNoteChunker.free(mNotifyEventList);
       mNotifyEventList = next;
@@ -316,7 +319,7 @@ void EventConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
       bstream->writeInt(classId, mEventClassBitSize);
 
       ev->mEvent->pack(this, bstream);
-      logprintf(LogConsumer::LogEventConnection, "EventConnection %s: WroteEvent %s - %d bits", getNetAddressString(), ev->mEvent->getDebugName(), bstream->getBitPosition() - start);
+      TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: WroteEvent %s - %d bits", getNetAddressString(), ev->mEvent->getDebugName(), bstream->getBitPosition() - start);
 
       if(mConnectionParameters.mDebugObjectSizes)
          bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, start);
@@ -392,7 +395,7 @@ void EventConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
       ev->mEvent->pack(this, bstream);
 
       ev->mEvent->getClassRep()->addInitialUpdate(bstream->getBitPosition() - start);
-      logprintf(LogConsumer::LogEventConnection, "EventConnection %s: WroteEvent %s - %d bits", getNetAddressString(), ev->mEvent->getDebugName(), bstream->getBitPosition() - start);
+      TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: WroteEvent %s - %d bits", getNetAddressString(), ev->mEvent->getDebugName(), bstream->getBitPosition() - start);
 
       if(mConnectionParameters.mDebugObjectSizes)
          bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, start - BitStreamPosBitSize);
@@ -498,7 +501,7 @@ void EventConnection::readPacket(BitStream *bstream)
       EventNote *note = mEventNoteChunker.alloc();
       note->mEvent = evt;
       note->mSeqCount = seq;
-      logprintf(LogConsumer::LogEventConnection, "EventConnection %s: RecvdGuaranteed %d", getNetAddressString(), seq);
+      TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: RecvdGuaranteed %d", getNetAddressString(), seq);
 
       while(*waitInsert && (*waitInsert)->mSeqCount < seq)
          waitInsert = &((*waitInsert)->mNextEvent);
@@ -513,7 +516,7 @@ void EventConnection::readPacket(BitStream *bstream)
       EventNote *temp = mWaitSeqEvents;
       mWaitSeqEvents = temp->mNextEvent;
       
-      logprintf(LogConsumer::LogEventConnection, "EventConnection %s: ProcessGuaranteed %d", getNetAddressString(), temp->mSeqCount);
+      TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: ProcessGuaranteed %d", getNetAddressString(), temp->mSeqCount);
       processEvent(temp->mEvent);
       mEventNoteChunker.free(temp);
       if(mErrorBuffer[0])
@@ -537,6 +540,12 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
       return false;
    }
 
+   if(mCapturedEvents)
+   {
+      mCapturedEvents->push_back(theEvent);
+      return true;
+   }
+
    theEvent->notifyPosted(this);
 
    EventNote *event = mEventNoteChunker.alloc();
@@ -565,7 +574,7 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
       bstream.writeInt(classId, mEventClassBitSize);
 
       event->mEvent->pack(this, &bstream);
-      logprintf(LogConsumer::LogEventConnection, "EventConnection %s: WroteEvent %s - %d bits", getNetAddressString(), event->mEvent->getDebugName(), bstream.getBitPosition() - start);
+      TNLLog(LogConsumer::LogEventConnection, "EventConnection %s: WroteEvent %s - %d bits", getNetAddressString(), event->mEvent->getDebugName(), bstream.getBitPosition() - start);
 
       if(mConnectionParameters.mDebugObjectSizes)
          bstream.writeIntAt(bstream.getBitPosition(), BitStreamPosBitSize, start);
@@ -601,6 +610,26 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
    return true;
 }
 
+void EventConnection::writeUnorderedEvents(BitStream *bstream, const Vector<RefPtr<NetEvent> > &events)
+{
+   TNLAssert(!mConnectionParameters.mDebugObjectSizes, "Debug object sizes are not written here!");
+
+   for(S32 i = 0; i < events.size(); i++)
+   {
+      bstream->writeFlag(true);
+      bstream->writeInt(events[i]->getClassId(getNetClassGroup()), mEventClassBitSize);
+      events[i]->pack(this, bstream);
+   }
+
+   bstream->writeFlag(false);    // End of unordered events
+   bstream->writeFlag(false);    // And there are no ordered ones
+}
+
+bool EventConnection::isEventSupported(NetEvent *event)
+{
+   return U32(event->getClassId(getNetClassGroup())) < mEventClassCount;
+}
+
 bool EventConnection::isDataToTransmit()
 {
    return mUnorderedSendEventQueueHead || mSendEventQueueHead || Parent::isDataToTransmit();
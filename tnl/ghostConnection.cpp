@@ -31,6 +31,8 @@
 #include "tnlNetObject.h"
 #include "tnlNetInterface.h"
 
+#include <algorithm>
+
 namespace TNL {
 
 GhostConnection::GhostConnection()
@@ -45,6 +47,7 @@ GhostConnection::GhostConnection()
 
    mGhostFrom = false;
    mGhostTo = false;
+   mCountReceivedUpdates = false;
 }
 
 GhostConnection::~GhostConnection()
@@ -143,7 +146,7 @@ void GhostConnection::packetDropped(PacketNotify *pnotify)
          packRef->ghost->flags &= ~GhostInfo::KillingGhost;
       }
 
-      delete packRef;
+      mGhostRefPool.free(packRef);
       packRef = temp;
    }
 }
@@ -177,20 +180,22 @@ void GhostConnection::packetReceived(PacketNotify *pnotify)
       else if(packRef->ghostInfoFlags & GhostInfo::KillingGhost)
          freeGhostInfo(packRef->ghost);
 
-      delete packRef;
+      mGhostRefPool.free(packRef);
       packRef = temp;
    }
 }
 
-static S32 QSORT_CALLBACK UQECompare(const void *a,const void *b)
+// Heap ordering for mUpdateQueue, which puts the highest priority ghost on top
+static bool hasLowerPriority(const GhostInfo *a, const GhostInfo *b)
 {
-   GhostInfo *ga = *((GhostInfo **) a);
-   GhostInfo *gb = *((GhostInfo **) b);
-
-   F32 ret = ga->priority - gb->priority;
-   return (ret < 0) ? -1 : ((ret > 0) ? 1 : 0);
+   return a->priority < b->priority;
 } 
 
+static bool hasLowerIndex(const GhostInfo *a, const GhostInfo *b)
+{
+   return a->index < b->index;
+}
+
 void GhostConnection::prepareWritePacket()
 {
    Parent::prepareWritePacket();
@@ -264,7 +269,7 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
 
    // 2. call scoped objects' priority functions if the flag set is nonzero
    //    A removed ghost is assumed to have a high priority
-   // 3. call updates based on sorted priority until the packet is
+   // 3. call updates in priority order until the packet is
    //    full.  set flags to zero for all updated objects
 
    GhostInfo *walk;
@@ -276,6 +281,11 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    }
 
    U32 maxIndex = 0;
+   mUpdateQueue.clear();
+
+   // Ghosts that need a priority computed are kept at the front of the queue, ahead of any being killed
+   S32 rankedCount = 0;
+
    for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
    {
       walk = mGhostArray[i];
@@ -292,20 +302,29 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
       // or in the process of ghosting
       else if(!(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting)))
       {
+         mUpdateQueue.push_back(walk);
+
          if(walk->flags & GhostInfo::KillGhost)
             walk->priority = 10000;
          else
-            walk->priority = walk->obj->getUpdatePriority(this, walk->updateMask, walk->updateSkipCount);
+         {
+            mUpdateQueue[mUpdateQueue.size() - 1] = mUpdateQueue[rankedCount];
+            mUpdateQueue[rankedCount] = walk;
+            rankedCount++;
+         }
       }
       else
          walk->priority = 0;
    }
+
+   computeUpdatePriorities(mUpdateQueue.address(), rankedCount);
+
    GhostRef *updateList = NULL;
-   if(mGhostZeroUpdateIndex != 0)
-      qsort(&mGhostArray[0], mGhostZeroUpdateIndex, sizeof(GhostInfo *), UQECompare);
-   // reset the array indices...
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
-      mGhostArray[i]->arrayIndex = i;
+
+   // Heapify rather than sort: building the heap is linear, and we only pay to pop the updates that fit
+   GhostInfo **queue = mUpdateQueue.address();
+   S32 queueSize = mUpdateQueue.size();
+   std::make_heap(queue, queue + queueSize, hasLowerPriority);
 
    U8 sendSize = 0;
    while(maxIndex != 0)
@@ -321,11 +340,10 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
 
    U32 count = 0;
    bool have_something_to_send = bstream->getBitPosition() >= 256;
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0 && !bstream->isFull(); i--)
+   while(queueSize > 0 && !bstream->isFull())
    {
-      GhostInfo *walk = mGhostArray[i];
-      if(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting))
-         continue;
+      std::pop_heap(queue, queue + queueSize, hasLowerPriority);
+      GhostInfo *walk = queue[--queueSize];
 
       U32 updateStart = bstream->getBitPosition();
       U32 updateMask = walk->updateMask;
@@ -369,7 +387,7 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
          if(mConnectionParameters.mDebugObjectSizes)
             bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, startPos - BitStreamPosBitSize);
 
-         logprintf(LogConsumer::LogGhostConnection, "GhostConnection %s GHOST %d", walk->obj->getClassName(), bstream->getBitPosition() - 16 - startPos);
+         TNLLog(LogConsumer::LogGhostConnection, "GhostConnection %s GHOST %d", walk->obj->getClassName(), bstream->getBitPosition() - 16 - startPos);
 
          TNLAssert((retMask & (~updateMask)) == 0, "Cannot set new bits in packUpdate return");
       }
@@ -391,7 +409,7 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
 
       // otherwise, create a record of this ghost update and
       // attach it to the packet.
-      GhostRef *upd = new GhostRef;
+      GhostRef *upd = mGhostRefPool.alloc();
 
       upd->nextRef = updateList;
       updateList = upd;
@@ -480,6 +498,9 @@ void GhostConnection::readPacket(BitStream *bstream)
          while(U32(mLocalGhosts.size()) <= index)  // Increase vector size when needed
             mLocalGhosts.push_back(NULL);
 
+         U32 startPos = bstream->getBitPosition();
+         bool initialUpdate = !mLocalGhosts[index];
+
          if(!mLocalGhosts[index]) // it's a new ghost... cool
          {
             S32 classId = bstream->readInt(mGhostClassBitSize);
@@ -536,10 +557,107 @@ void GhostConnection::readPacket(BitStream *bstream)
 
          if(mErrorBuffer[0])
             return;
+
+         if(mCountReceivedUpdates)
+         {
+            NetClassRep *classRep = mLocalGhosts[index]->getClassRep();
+            if(initialUpdate)
+               classRep->addInitialUpdate(bstream->getBitPosition() - startPos);
+            else
+               classRep->addPartialUpdate(bstream->getBitPosition() - startPos);
+         }
       }
    }
 }
 
+bool GhostConnection::writeSnapshot(BitStream *bstream)
+{
+   TNLAssert(!mConnectionParameters.mDebugObjectSizes, "Debug object sizes are not written in snapshots!");
+
+   // The reader will start counting ordered events from here, so it must not miss any before
+   if(getPendingOrderedEventCount() != 0)
+      return false;
+
+   bstream->writeInt(getNextSendEventSeq(), 32);
+
+   // Everything the remote host has, or has been told about.  In index order, so that the objects that have been
+   // around the longest, like the GameType, are created first, as they would have been originally.
+   Vector<GhostInfo *> ghosts;
+   for(S32 i = 0; i < mGhostFreeIndex; i++)
+      if(!(mGhostArray[i]->flags & (GhostInfo::NotYetGhosted | GhostInfo::KillingGhost)))
+         ghosts.push_back(mGhostArray[i]);
+
+   std::sort(ghosts.address(), ghosts.address() + ghosts.size(), hasLowerIndex);
+
+   // First packet creates the objects, so events aimed at them have something to arrive at
+   Vector<RefPtr<NetEvent> > events;
+   writeUnorderedEvents(bstream, events);
+
+   bstream->writeFlag(true);     // Ghosting
+
+   U32 maxIndex = ghosts.size() ? ghosts.last()->index : 0;
+   U8 sendSize = 0;
+   while(maxIndex != 0)
+   {
+      maxIndex >>= 1;
+      sendSize++;
+   }
+
+   if(sendSize < ID_BIT_OFFSET)
+      sendSize = ID_BIT_OFFSET;
+
+   for(S32 i = 0; i < ghosts.size(); i++)
+   {
+      bstream->writeFlag(true);
+      if(i == 0)
+         bstream->writeInt(sendSize - ID_BIT_OFFSET, ID_BIT_SIZE);
+
+      bstream->writeInt(ghosts[i]->index, sendSize);
+      bstream->writeFlag(false);    // Not being killed
+
+      bstream->writeInt(ghosts[i]->obj->getClassId(getNetClassGroup()), mGhostClassBitSize);
+
+      // Whatever is left unsent here is still pending in the GhostInfo, and will go out in the next packet as usual
+      NetObject::mIsInitialUpdate = true;
+      ghosts[i]->obj->packUpdate(this, 0xFFFFFFFF, bstream);
+      NetObject::mIsInitialUpdate = false;
+   }
+
+   bstream->writeFlag(false);
+
+   // Second packet has the events the objects send when they first become available, as things stand now
+   setEventCapture(&events);
+   for(S32 i = 0; i < ghosts.size(); i++)
+   {
+      NetObject::setRPCDestConnection(this);
+      ghosts[i]->obj->onGhostAvailable(this);
+   }
+   NetObject::setRPCDestConnection(NULL);
+   setEventCapture(NULL);
+
+   writeUnorderedEvents(bstream, events);
+   bstream->writeFlag(false);    // No ghosts this time
+
+   return bstream->isValid();
+}
+
+
+bool GhostConnection::readSnapshot(BitStream *bstream)
+{
+   mErrorBuffer[0] = 0;
+
+   clearRecvEvents(bstream->readInt(32));
+
+   readPacket(bstream);
+   if(!mErrorBuffer[0])
+      readPacket(bstream);
+
+   bool ok = bstream->isValid() && !mErrorBuffer[0];
+   mErrorBuffer[0] = 0;
+
+   return ok;
+}
+
 //-----------------------------------------------------------------------------
 
 
@@ -727,7 +845,7 @@ void GhostConnection::activateGhosting()
       return;
 
    mGhostingSequence++;
-   logprintf(LogConsumer::LogGhostConnection, "Ghosting activated - %d", mGhostingSequence);
+   TNLLog(LogConsumer::LogGhostConnection, "Ghosting activated - %d", mGhostingSequence);
 
    TNLAssert((mGhostFreeIndex == 0) && (mGhostZeroUpdateIndex == 0), "Error: ghosts in the ghost list before activate.");
 
@@ -741,7 +859,7 @@ TNL_IMPLEMENT_RPC(GhostConnection, rpcStartGhosting,
                   (U32 sequence), (sequence),
       NetClassGroupGameMask, RPCGuaranteedOrdered, RPCDirAny, 0)
 {
-   logprintf(LogConsumer::LogGhostConnection, "Got GhostingStarting %d", sequence);
+   TNLLog(LogConsumer::LogGhostConnection, "Got GhostingStarting %d", sequence);
 
    if(!doesGhostTo())
    {
@@ -756,7 +874,7 @@ TNL_IMPLEMENT_RPC(GhostConnection, rpcReadyForNormalGhosts,
                   (U32 sequence), (sequence),
       NetClassGroupGameMask, RPCGuaranteedOrdered, RPCDirAny, 0)
 {
-   logprintf(LogConsumer::LogGhostConnection, "Got ready for normal ghosts %d %d", sequence, mGhostingSequence);
+   TNLLog(LogConsumer::LogGhostConnection, "Got ready for normal ghosts %d %d", sequence, mGhostingSequence);
    if(!doesGhostFrom())
    {
       setLastError("Invalid packet.");
@@ -811,7 +929,7 @@ void GhostConnection::clearGhostInfo()
       while(delWalk)
       {
          GhostRef *next = delWalk->nextRef;
-         delete delWalk;
+         mGhostRefPool.free(delWalk);
          delWalk = next;
       }
    }
@@ -879,6 +997,12 @@ S32 GhostConnection::getGhostIndex(NetObject *obj)
 
 //-----------------------------------------------------------------------------
 
+void GhostConnection::computeUpdatePriorities(GhostInfo **ghosts, S32 count)
+{
+   for(S32 i = 0; i < count; i++)
+      ghosts[i]->priority = ghosts[i]->obj->getUpdatePriority(this, ghosts[i]->updateMask, ghosts[i]->updateSkipCount);
+}
+
 void GhostConnection::onStartGhosting()
 {
    // Do nothing
@@ -26,11 +26,23 @@
 
 #include "tnlLog.h"
 #include "tnlDataChunker.h"
+#include "tnlThread.h"
+#include "tnlPlatform.h"
 #include "../zap/oglconsole.h"   // For logging to the console
 #include <time.h>
 #include <string.h>
 #include <stdio.h>               // For newer versions of gcc?
 #include <stdarg.h>              // For va_list
+#include <signal.h>
+#include <stdlib.h>               // For atexit
+
+#ifdef TNL_OS_WIN32
+#  include <io.h>                 // For write
+#else
+#  include <unistd.h>
+#endif
+
+#include <atomic>
 
 #ifdef TNL_OS_ANDROID
 #include <android/log.h>
@@ -47,6 +59,7 @@ namespace TNL
 ////////////////////////////////////////
 
 LogConsumer *LogConsumer::mLinkedList = NULL;
+U32 LogConsumer::mAllMsgTypes = 0;
 
 // Constructor -- add log to consumer list
 LogConsumer::LogConsumer()    
@@ -61,6 +74,8 @@ LogConsumer::LogConsumer()
 
    mPrevConsumer = NULL;
    mLinkedList = this;
+
+   updateAllMsgTypes();
 }
 
 // Destructor -- remove log from consumer list
@@ -73,12 +88,15 @@ LogConsumer::~LogConsumer()
       mPrevConsumer->mNextConsumer = mNextConsumer;
    else
       mLinkedList = mNextConsumer;
+
+   updateAllMsgTypes();
 }
 
 
 void LogConsumer::setMsgTypes(S32 types)
 {
    mMsgTypes = types;
+   updateAllMsgTypes();
 }
 
 
@@ -88,6 +106,20 @@ void LogConsumer::setMsgType(MsgType msgType, bool enable)
       mMsgTypes |= msgType;
    else
       mMsgTypes &= ~msgType;
+
+   updateAllMsgTypes();
+}
+
+
+// Static method
+void LogConsumer::updateAllMsgTypes()
+{
+   U32 types = 0;
+
+   for(LogConsumer *walk = mLinkedList; walk; walk = walk->mNextConsumer)
+      types |= walk->mMsgTypes;
+
+   mAllMsgTypes = types;
 }
 
 
@@ -100,13 +132,80 @@ void LogConsumer::logString(LogConsumer::MsgType msgType, std::string message)
 }
 
 
+// Most consumers write as soon as they're told
+void LogConsumer::flush()
+{
+   // Do nothing
+}
+
+
+// Static method
+void LogConsumer::flushAll()
+{
+   for(LogConsumer *walk = mLinkedList; walk; walk = walk->mNextConsumer)
+      walk->flush();
+}
+
+
+// Most consumers have nothing waiting to be written
+void LogConsumer::flushFromSignal()
+{
+   // Do nothing
+}
+
+
+// Static method; safe to call from a signal handler
+void LogConsumer::flushAllFromSignal()
+{
+   for(LogConsumer *walk = mLinkedList; walk; walk = walk->mNextConsumer)
+      walk->flushFromSignal();
+}
+
+
+// We've crashed, and can't trust the heap or the locks: write what we can without either, then crash as we would have
+static void flushAndCrash(int sig)
+{
+   signal(sig, SIG_DFL);
+   LogConsumer::flushAllFromSignal();
+   raise(sig);
+}
+
+
+static void flushAtExit()
+{
+   LogConsumer::flushAll();
+}
+
+
+// Static method; also covers exit(), which skips the destructors of consumers living on main()'s stack.  ^C and
+// SIGTERM are left to the program, which should shut down the usual way, and so get here through exit().
+void LogConsumer::flushAllOnExit()
+{
+   const int fatalSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+
+   for(U32 i = 0; i < ARRAYSIZE(fatalSignals); i++)
+      signal(fatalSignals[i], flushAndCrash);
+
+   atexit(flushAtExit);
+}
+
+
 // Create reusable buffer for our logging functions.  Make it big because when we use datadumper 
 // in a script, some messages can get very long
 static char msg[1024 * 8];
 
+// Guards msg, and the consumers, as robot scripts can log from threads of their own
+static Mutex &getLogMutex()
+{
+   static Mutex mutex;
+   return mutex;
+}
+
 
 void LogConsumer::logprintf(const char *format, ...)
 {
+   getLogMutex().lock();
+
    va_list args; 
    va_start(args, format); 
 
@@ -117,6 +216,8 @@ void LogConsumer::logprintf(const char *format, ...)
    std::string message(msg);
 
    prepareAndLogString(message);
+
+   getLogMutex().unlock();
 }
 
 
@@ -149,27 +250,353 @@ void LogConsumer::prepareAndLogString(std::string message)
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-// Constructor -- open the file
-FileLogConsumer::FileLogConsumer()    // Constructor
+// Writes a FileLogConsumer's lines out on a thread of its own.  Any thread can queue a line without waiting for anyone;
+// the queue is a linked list that loggers add to with a single atomic exchange, and that only whoever holds
+// mFileMutex takes lines from.
+class FileLogConsumer::Writer : public Thread
+{
+private:
+   enum {
+      FlushInterval = 250,          // Ms we let lines pile up before writing them
+      FlushBytes = 64 * 1024,       // Or write them as soon as there are this many
+      RotatedFiles = 5,             // How many old logs we keep when rotating
+   };
+
+   struct Line
+   {
+      std::atomic<Line *> next;
+      std::string text;
+   };
+
+   std::atomic<Line *> mHead;       // Line queued most recently
+   Line *mTail;                     // Next line to write, or mStub
+   Line mStub;                      // Keeps the list from ever being empty
+
+   std::atomic<U32> mQueuedLines;
+   std::atomic<U32> mQueuedBytes;
+   std::atomic<bool> mOpen;
+   std::atomic<bool> mStopping;
+   std::atomic<bool> mFlushing;     // In flush(), which the mutex can't tell us if it's this thread that's in there
+
+   bool mThreaded;
+   Semaphore mWakeup;
+   Semaphore mDone;
+   Mutex mFileMutex;                // Held by whoever is writing
+
+   // Only touched while holding mFileMutex
+   FILE *mFile;
+   S32 mFd;                         // mFile's descriptor, for writing from a signal handler
+   std::string mPath;
+   U32 mFileBytes;
+   time_t mOpenedTime;
+   U32 mRotateBytes;
+   U32 mRotateSeconds;
+
+   void enqueue(Line *line);
+   Line *dequeue();
+   void rotate();
+
+public:
+   Writer();      // Constructor
+   ~Writer();     // Destructor
+
+   bool open(const std::string &path, const char *mode);
+   bool isOpen() const;
+   void setRotation(U32 maxBytes, U32 maxSeconds);
+
+   void push(const char *text);
+   void flush();
+   void flushFromSignal();
+
+   U32 run();
+};
+
+
+// Constructor
+FileLogConsumer::Writer::Writer() : mHead(&mStub), mQueuedLines(0), mQueuedBytes(0), mOpen(false), mStopping(false),
+                                   mFlushing(false)
+{
+   mStub.next = NULL;
+   mTail = &mStub;
+
+   mThreaded = false;
+   mFile = NULL;
+   mFd = -1;
+   mFileBytes = 0;
+   mOpenedTime = 0;
+   mRotateBytes = 0;
+   mRotateSeconds = 0;
+}
+
+
+// Destructor
+FileLogConsumer::Writer::~Writer()
+{
+   if(mThreaded)
+   {
+      mStopping = true;
+      mWakeup.increment(2);      // Past both waits in run()
+      mDone.wait();
+   }
+
+   // A line can only be stuck if its logger is still part way through push(); give it a moment to finish
+   for(S32 i = 0; i < 100 && mQueuedLines > 0; i++)
+   {
+      flush();
+
+      if(mQueuedLines > 0)
+         Platform::sleep(1);
+   }
+
+   if(mFile)
+      fclose(mFile);
+}
+
+
+bool FileLogConsumer::Writer::open(const std::string &path, const char *mode)
 {
-   f = NULL;
+   mFileMutex.lock();
+
+   if(mFile)
+      fclose(mFile);
+
+   mPath = path;
+   mFile = fopen(path.c_str(), mode);
+   mFd = mFile ? fileno(mFile) : -1;
+   mOpen = mFile != NULL;
+
+   if(mFile)
+   {
+      fseek(mFile, 0, SEEK_END);
+      mFileBytes = (U32)ftell(mFile);
+      mOpenedTime = time(NULL);
+
+#ifndef TNL_NO_THREADS
+      if(!mThreaded)
+         mThreaded = start();    // Otherwise every line is written as it's logged
+#endif
+   }
+
+   mFileMutex.unlock();
+
+   return mFile != NULL;
+}
+
+
+bool FileLogConsumer::Writer::isOpen() const
+{
+   return mOpen;
+}
+
+
+void FileLogConsumer::Writer::setRotation(U32 maxBytes, U32 maxSeconds)
+{
+   mFileMutex.lock();
+   mRotateBytes = maxBytes;
+   mRotateSeconds = maxSeconds;
+   mFileMutex.unlock();
+}
+
+
+void FileLogConsumer::Writer::enqueue(Line *line)
+{
+   line->next.store(NULL, std::memory_order_relaxed);
+
+   Line *prev = mHead.exchange(line, std::memory_order_acq_rel);
+   prev->next.store(line, std::memory_order_release);
 }
 
 
-// Destructor -- close the file
+// Returns NULL if there's nothing to write, or the next line is still being queued.  Only call while holding
+// mFileMutex.
+FileLogConsumer::Writer::Line *FileLogConsumer::Writer::dequeue()
+{
+   Line *tail = mTail;
+   Line *next = tail->next.load(std::memory_order_acquire);
+
+   if(tail == &mStub)
+   {
+      if(!next)
+         return NULL;
+
+      mTail = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+   }
+
+   if(next)
+   {
+      mTail = next;
+      return tail;
+   }
+
+   if(tail != mHead.load(std::memory_order_acquire))
+      return NULL;
+
+   // tail is the last line; put the stub back behind it, so we can take it
+   enqueue(&mStub);
+
+   next = tail->next.load(std::memory_order_acquire);
+   if(!next)
+      return NULL;
+
+   mTail = next;
+   return tail;
+}
+
+
+// Any thread
+void FileLogConsumer::Writer::push(const char *text)
+{
+   Line *line = new Line;
+   line->text = text;
+
+   // Counted before they're queued, so the writer never takes away more than we've added
+   U32 size = (U32)line->text.size();
+   U32 bytes = mQueuedBytes.fetch_add(size) + size;
+   bool first = mQueuedLines.fetch_add(1) == 0;
+
+   enqueue(line);
+
+   if(!mThreaded)
+      flush();
+
+   // Wake the writer for the first line, so it can start the clock, and again when there's enough to write straight away
+   else if(first || (bytes >= FlushBytes && bytes - size < FlushBytes))
+      mWakeup.increment();
+}
+
+
+// Only call while holding mFileMutex
+void FileLogConsumer::Writer::rotate()
+{
+   fclose(mFile);
+   mFile = NULL;
+   mFd = -1;
+
+   char from[1024], to[1024];
+
+   dSprintf(to, sizeof(to), "%s.%d", mPath.c_str(), RotatedFiles);
+   remove(to);
+
+   for(S32 i = RotatedFiles - 1; i > 0; i--)
+   {
+      dSprintf(from, sizeof(from), "%s.%d", mPath.c_str(), i);
+      dSprintf(to,   sizeof(to),   "%s.%d", mPath.c_str(), i + 1);
+      rename(from, to);
+   }
+
+   dSprintf(to, sizeof(to), "%s.1", mPath.c_str());
+   rename(mPath.c_str(), to);
+
+   open(mPath, "w");
+}
+
+
+// Any thread; writes out what's been queued, in one go
+void FileLogConsumer::Writer::flush()
+{
+   mFileMutex.lock();
+   mFlushing = true;
+
+   time_t now = time(NULL);
+   U32 written = 0;
+
+   while(Line *line = dequeue())
+   {
+      if(mFile)
+      {
+         U32 size = (U32)line->text.size();
+
+         if((mRotateBytes > 0 && mFileBytes > 0 && mFileBytes + size > mRotateBytes) ||
+            (mRotateSeconds > 0 && now - mOpenedTime >= (time_t)mRotateSeconds))
+            rotate();
+      }
+
+      if(mFile)
+      {
+         fwrite(line->text.c_str(), 1, line->text.size(), mFile);
+         mFileBytes += (U32)line->text.size();
+      }
+
+      written += (U32)line->text.size();
+      mQueuedLines--;
+      delete line;
+   }
+
+   if(mFile)
+      fflush(mFile);
+
+   mQueuedBytes -= written;
+
+   mFlushing = false;
+   mFileMutex.unlock();
+}
+
+
+// From a handler for a fatal signal: writes out what's queued straight to the file, without taking anything off the
+// queue or freeing anything.  Gives up if someone's in the middle of writing, as we'd only make a mess of it.
+void FileLogConsumer::Writer::flushFromSignal()
+{
+   if(!mFileMutex.tryLock())
+      return;
+
+   if(!mFlushing && mFd >= 0)
+      for(Line *line = mTail; line; line = line->next.load(std::memory_order_acquire))
+         if(line != &mStub && write(mFd, line->text.data(), line->text.size()) < 0)
+            break;
+
+   mFileMutex.unlock();
+}
+
+
+U32 FileLogConsumer::Writer::run()
+{
+   for(;;)
+   {
+      mWakeup.wait();                           // Until the first line comes in
+
+      if(!mStopping && mQueuedBytes < FlushBytes)
+         mWakeup.timedWait(FlushInterval);      // Let some more pile up, unless there's plenty already
+
+      flush();
+
+      if(mStopping)
+         break;
+
+      // Lines logged while we were writing didn't wake us, as there were still lines queued
+      if(mQueuedLines > 0)
+         mWakeup.increment();
+   }
+
+   mDone.increment();      // We mustn't touch this after this point, as the consumer may now delete us
+
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+FileLogConsumer::FileLogConsumer()
+{
+   mWriter = new Writer();
+}
+
+
+// Destructor -- write out what's left, and close the file
 FileLogConsumer::~FileLogConsumer()    
 {
-   if(f)
-      fclose(f);
+   delete mWriter;
 }
 
+
 void FileLogConsumer::init(std::string logFile, const char *mode)
 {
-   if(f)
-      fclose(f);
+   mWriter->flush();          // Anything queued for the old file goes there
 
-   f = fopen(logFile.c_str(), mode);
-   if(!f)
+   if(!mWriter->open(logFile, mode))
    {
       TNLAssert(false, "Can't open log file for writing!");
       printf("Can't open log file for writing!\n");  // Fallback to printf
@@ -177,13 +604,28 @@ void FileLogConsumer::init(std::string logFile, const char *mode)
 }
 
 
+void FileLogConsumer::setRotation(U32 maxBytes, U32 maxSeconds)
+{
+   mWriter->setRotation(maxBytes, maxSeconds);
+}
+
+
+void FileLogConsumer::flush()
+{
+   mWriter->flush();
+}
+
+
+void FileLogConsumer::flushFromSignal()
+{
+   mWriter->flushFromSignal();
+}
+
+
 void FileLogConsumer::writeString(const char *string)
 {
-   if(f)
-   {
-      fprintf(f, "%s", string);
-      fflush(f);
-   }
+   if(mWriter->isOpen())
+      mWriter->push(string);
    else
    {
       TNLAssert(false, "Logfile not initialized!");
@@ -230,6 +672,11 @@ LogType *LogType::find(const char *name)
 // Logs to logfiles that have subscribed to specified message type
 void logprintf(LogConsumer::MsgType msgType, const char *format, ...)
 {
+   if(!LogConsumer::isLogging(msgType))    // Don't format what nobody will read
+      return;
+
+   getLogMutex().lock();
+
    va_list args; 
    va_start(args, format); 
 
@@ -240,12 +687,19 @@ void logprintf(LogConsumer::MsgType msgType, const char *format, ...)
    std::string message(msg);
 
    LogConsumer::logString(msgType, message);
+
+   getLogMutex().unlock();
 }
 
 
 // Logs to general log
 void logprintf(const char *format, ...)
 {
+   if(!LogConsumer::isLogging(LogConsumer::All))
+      return;
+
+   getLogMutex().lock();
+
    va_list args; 
    va_start(args, format); 
 
@@ -256,6 +710,8 @@ void logprintf(const char *format, ...)
    std::string message(msg);
 
    LogConsumer::logString(LogConsumer::All, message);
+
+   getLogMutex().unlock();
 }
 
 
@@ -238,9 +238,9 @@ void NetConnection::writeRawPacket(BitStream *bstream, NetPacketType packetType)
       S32 start = bstream->getBitPosition();
       bstream->setStringTable(mStringTable);
 
-      logprintf(LogConsumer::LogNetConnection, "NetConnection %s: START %s", mNetAddress.toString(), getClassName());
+      TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: START %s", mNetAddress.toString(), getClassName());
       writePacket(bstream, note);
-      logprintf(LogConsumer::LogNetConnection, "NetConnection %s: END %s - %d bits", mNetAddress.toString(), getClassName(), bstream->getBitPosition() - start);
+      TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: END %s - %d bits", mNetAddress.toString(), getClassName(), bstream->getBitPosition() - start);
    }
    if(!mSymmetricCipher.isNull())
    {
@@ -256,13 +256,13 @@ void NetConnection::readRawPacket(BitStream *bstream)
 {
    if(mSimulatedReceivePacketLoss && Random::readF() < mSimulatedReceivePacketLoss)
    {
-      logprintf(LogConsumer::LogNetConnection, "NetConnection %s: RECVDROP - %d", mNetAddress.toString(), getLastSendSequence());
+      TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: RECVDROP - %d", mNetAddress.toString(), getLastSendSequence());
       return;
    }
    mPacketRecvBytesLast = bstream->getMaxReadBitPosition() >> 3;
    mPacketRecvBytesTotal += mPacketRecvBytesLast;
    mPacketRecvCount++;
-   logprintf(LogConsumer::LogNetConnection, "NetConnection %s: RECV- %d bytes", mNetAddress.toString(), mPacketRecvBytesLast);
+   TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: RECV- %d bytes", mNetAddress.toString(), mPacketRecvBytesLast);
 
    mErrorBuffer[0] = 0;
 
@@ -330,7 +330,7 @@ void NetConnection::writePacketHeader(BitStream *stream, NetPacketType packetTyp
    //      mLastSendSeq, mLastSeqRecvd, packetType, ackByteCount));
    //}
 
-   logprintf(LogConsumer::LogConnectionProtocol, "build hdr %d %d", mLastSendSeq, packetType);
+   TNLLog(LogConsumer::LogConnectionProtocol, "build hdr %d %d", mLastSendSeq, packetType);
 }
 
 bool NetConnection::readPacketHeader(BitStream *pstream)
@@ -405,7 +405,7 @@ bool NetConnection::readPacketHeader(BitStream *pstream)
       mSymmetricCipher->setupCounter(pkSequenceNumber, pkHighestAck, pkPacketType, 0);
       if(!pstream->decryptAndCheckHash(MessageSignatureBytes, PacketHeaderByteSize, mSymmetricCipher))
       {
-         logprintf(LogConsumer::LogNetConnection, "Packet failed crypto");
+         TNLLog(LogConsumer::LogNetConnection, "Packet failed crypto");
          return false;
       }
    }
@@ -432,10 +432,10 @@ bool NetConnection::readPacketHeader(BitStream *pstream)
    for(U32 i = mLastSeqRecvd+1; i < pkSequenceNumber; i++)
    {
       mPacketRecvDropped++;
-      logprintf(LogConsumer::LogConnectionProtocol, "Not recv %d", i);
+      TNLLog(LogConsumer::LogConnectionProtocol, "Not recv %d", i);
    }
 
-   logprintf(LogConsumer::LogConnectionProtocol, "Recv %d %s", pkSequenceNumber, packetTypeNames[pkPacketType]);
+   TNLLog(LogConsumer::LogConnectionProtocol, "Recv %d %s", pkSequenceNumber, packetTypeNames[pkPacketType]);
 
    // shift up the ack mask by the packet difference
    // this essentially nacks all the packets dropped
@@ -472,7 +472,7 @@ bool NetConnection::readPacketHeader(BitStream *pstream)
       U32 ackMaskWord = (pkHighestAck - notifyIndex) >> 5;
 
       bool packetTransmitSuccess = (pkAckMask[ackMaskWord] & (1 << ackMaskBit)) != 0;
-      logprintf(LogConsumer::LogConnectionProtocol, "Ack %d %d", notifyIndex, packetTransmitSuccess ? 1 : 0);
+      TNLLog(LogConsumer::LogConnectionProtocol, "Ack %d %d", notifyIndex, packetTransmitSuccess ? 1 : 0);
 
       mHighestAckedSendTime = 0;
       handleNotify(notifyIndex, packetTransmitSuccess);
@@ -593,7 +593,7 @@ void NetConnection::sendPingPacket()
 {
    PacketStream ps;
    writeRawPacket(&ps, PingPacket);
-   logprintf(LogConsumer::LogConnectionProtocol, "send ping %d", mLastSendSeq);
+   TNLLog(LogConsumer::LogConnectionProtocol, "send ping %d", mLastSendSeq);
 
    sendPacket(&ps);
 }
@@ -602,7 +602,7 @@ void NetConnection::sendAckPacket()
 {
    PacketStream ps;
    writeRawPacket(&ps, AckPacket);
-   logprintf(LogConsumer::LogConnectionProtocol, "send ack %d", mLastSendSeq);
+   TNLLog(LogConsumer::LogConnectionProtocol, "send ack %d", mLastSendSeq);
 
    sendPacket(&ps);
 }
@@ -611,7 +611,7 @@ void NetConnection::sendAckPacket()
 
 void NetConnection::handleNotify(U32 sequence, bool recvd)
 {
-   logprintf(LogConsumer::LogNetConnection, "NetConnection %s: NOTIFY %d %s", mNetAddress.toString(), sequence, recvd ? "RECVD" : "DROPPED");
+   TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: NOTIFY %d %s", mNetAddress.toString(), sequence, recvd ? "RECVD" : "DROPPED");
 
    PacketNotify *note = mNotifyQueueHead;
    TNLAssert(note != NULL, "Error: got a notify with a null notify head.");
@@ -631,14 +631,14 @@ void NetConnection::handleNotify(U32 sequence, bool recvd)
          {
             // Slow start strategy
             cwnd++;
-            logprintf(LogConsumer::LogNetConnection, "PKT SSOK - ssthresh = %f     cwnd=%f", ssthresh, cwnd);
+            TNLLog(LogConsumer::LogNetConnection, "PKT SSOK - ssthresh = %f     cwnd=%f", ssthresh, cwnd);
 
          } else {
             // We are in normal state..
             if(cwnd < MaxPacketWindowSize-2)
                cwnd += 1/cwnd;
 
-            logprintf(LogConsumer::LogNetConnection, "PKT   OK - ssthresh = %f     cwnd=%f", ssthresh, cwnd);
+            TNLLog(LogConsumer::LogNetConnection, "PKT   OK - ssthresh = %f     cwnd=%f", ssthresh, cwnd);
 
          }
       }
@@ -743,11 +743,11 @@ NetError NetConnection::sendPacket(BitStream *stream)
 {
    if(mSimulatedSendPacketLoss && Random::readF() < mSimulatedSendPacketLoss)
    {
-      logprintf(LogConsumer::LogNetConnection, "NetConnection %s: SENDDROP - %d", mNetAddress.toString(), getLastSendSequence());
+      TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: SENDDROP - %d", mNetAddress.toString(), getLastSendSequence());
       return NoError;
    }
 
-   logprintf(LogConsumer::LogNetConnection, "NetConnection %s: SEND - %d bytes", mNetAddress.toString(), stream->getBytePosition());
+   TNLLog(LogConsumer::LogNetConnection, "NetConnection %s: SEND - %d bytes", mNetAddress.toString(), stream->getBytePosition());
 
    // do nothing on send if this is a demo replay.
    if(isLocalConnection())
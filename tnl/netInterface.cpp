@@ -74,6 +74,11 @@ NetInterface::~NetInterface()
       free(mSendPacketList);
       mSendPacketList = next;
    }
+
+   // And let go of any we were still deciding about
+   for(S32 i = mPendingConnections.size() - 1; i >= 0; i--)
+      if(mPendingConnections[i]->getConnectionState() == NetConnection::DecidingConnectRequest)
+         removePendingConnection(mPendingConnections[i]);
 }
 
 Address NetInterface::getFirstBoundInterfaceAddress()
@@ -327,6 +332,8 @@ void NetInterface::processConnections()
    mCurrentTime = Platform::getRealMilliseconds();
    mPuzzleManager.tick(mCurrentTime);
 
+   mSocket.beginSendBatch();     // Everything we send goes out together, at the end
+
    // first see if there are any delayed packets that need to be sent...
    while(mSendPacketList && S32(mSendPacketList->sendTime - getCurrentTime()) < 0)
    {
@@ -413,6 +420,15 @@ void NetInterface::processConnections()
             pending->onConnectTerminated(NetConnection::ReasonTimedOut, "Timeout");
             removePendingConnection(pending);
          }
+         else if(pending->getConnectionState() == NetConnection::DecidingConnectRequest &&
+            getCurrentTime() - pending->mConnectLastSendTime > DeferredConnectTimeout)
+         {
+            if(pending->onConnectDecisionTimedOut())
+               acceptDeferredConnection(pending);
+            else
+               rejectDeferredConnection(pending, NetConnection::ReasonTimedOut, "Timeout");
+            continue;
+         }
          i++;
       }
       mLastTimeoutCheckTime = getCurrentTime();
@@ -439,6 +455,8 @@ void NetInterface::processConnections()
          break;
       }
    }
+
+   mSocket.endSendBatch();
 }
 
 //-----------------------------------------------------------------------------
@@ -453,9 +471,13 @@ void NetInterface::checkIncomingPackets()
 
    mCurrentTime = Platform::getRealMilliseconds();
 
+   mSocket.beginSendBatch();     // Replies go out together, once we've read everything
+
    // read out all the available packets:
    while((error = stream.recvfrom(mSocket, &sourceAddress)) == NoError)
       processPacket(sourceAddress, &stream);
+
+   mSocket.endSendBatch();
 }
 
 void NetInterface::processPacket(const Address &sourceAddress, BitStream *pStream)
@@ -768,6 +790,15 @@ void NetInterface::handleConnectRequest(const Address &address, BitStream *strea
       }
    }
 
+   // If we're still deciding whether to accept this same request, there's nothing to do but keep deciding
+   NetConnection *deciding = findPendingConnection(address);
+   if(deciding && deciding->getConnectionState() == NetConnection::DecidingConnectRequest)
+   {
+      ConnectionParameters &cp = deciding->getConnectionParameters();
+      if(cp.mNonce == theParams.mNonce && cp.mServerNonce == theParams.mServerNonce)
+         return;
+   }
+
    // Check the puzzle solution
    ClientPuzzleManager::ErrorCode result = mPuzzleManager.checkSolution(
       theParams.mPuzzleSolution, theParams.mNonce, theParams.mServerNonce,
@@ -811,6 +842,14 @@ void NetInterface::handleConnectRequest(const Address &address, BitStream *strea
    if(connect)
       disconnect(connect, NetConnection::ReasonSelfDisconnect, "NewConnection");
 
+   // Likewise a different request from the same place that we were still deciding about; its decision, when it comes,
+   // now goes nowhere
+   if(deciding && deciding->getConnectionState() == NetConnection::DecidingConnectRequest)
+   {
+      deciding->setConnectionState(NetConnection::ConnectRejected);
+      removePendingConnection(deciding);
+   }
+
    char connectionClass[256];
    stream->readString(connectionClass);
 
@@ -836,12 +875,55 @@ void NetInterface::handleConnectRequest(const Address &address, BitStream *strea
       sendConnectReject(&theParams, address, reason, reasonStr.c_str());
       return;
    }
+
+   // The connection wants to think about it; hang on to it until it makes up its mind, or times out
+   if(conn->getConnectionState() == NetConnection::DecidingConnectRequest)
+   {
+      conn->mConnectLastSendTime = getCurrentTime();
+      addPendingConnection(conn);
+      return;
+   }
+
+   finishAcceptingConnection(conn);
+}
+
+
+void NetInterface::finishAcceptingConnection(NetConnection *conn)
+{
    addConnection(conn);
    conn->setConnectionState(NetConnection::Connected);
    conn->onConnectionEstablished();
    sendConnectAccept(conn);
 }
 
+
+void NetInterface::acceptDeferredConnection(NetConnection *conn)
+{
+   if(conn->getConnectionState() != NetConnection::DecidingConnectRequest)
+      return;
+
+   RefPtr<NetConnection> theConnection = conn;     // Keep it alive once it's off the pending list
+   removePendingConnection(conn);
+
+   logprintf(LogConsumer::LogNetInterface, "Accepting deferred connect request %8x",
+             conn->getConnectionParameters().mClientIdentity);
+
+   finishAcceptingConnection(conn);
+}
+
+
+void NetInterface::rejectDeferredConnection(NetConnection *conn, NetConnection::TerminationReason reason, const char *reasonString)
+{
+   if(conn->getConnectionState() != NetConnection::DecidingConnectRequest)
+      return;
+
+   RefPtr<NetConnection> theConnection = conn;
+   sendConnectReject(&conn->getConnectionParameters(), conn->getNetAddress(), reason, reasonString);
+
+   conn->setConnectionState(NetConnection::ConnectRejected);
+   removePendingConnection(conn);
+}
+
 //-----------------------------------------------------------------------------
 // NetInterface connection acceptance and handling
 //-----------------------------------------------------------------------------
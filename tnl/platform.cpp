@@ -414,6 +414,7 @@ U32 x86UNIXGetTickCountMicro()
    return uSecs;
 }
 
+// Counts microseconds, so short things (like a script's onTick) can be timed
 class UnixTimer
 {
    public:
@@ -422,11 +423,14 @@ class UnixTimer
       }
       S64 getCurrentTime()
       {
-         return x86UNIXGetTickCount();
+         timeval t;
+         ::gettimeofday(&t, NULL);
+
+         return S64(t.tv_sec) * 1000000 + t.tv_usec;
       }
       F64 convertToMS(S64 delta)
       {
-         return F64(delta);
+         return F64(delta) / 1000.0;
       }
 };
 
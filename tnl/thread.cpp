@@ -29,6 +29,8 @@
 
 #ifndef TNL_OS_WIN32
 #include "stdint.h"
+#include <errno.h>
+#include <time.h>
 #endif
 
 namespace TNL
@@ -39,6 +41,7 @@ namespace TNL
 Semaphore::Semaphore(U32 initialCount, U32 maximumCount) {}
 Semaphore::~Semaphore() {}
 void Semaphore::wait() {}
+bool Semaphore::timedWait(U32 timeoutMs) { return true; }
 void Semaphore::increment(U32 count) {}
 
 Mutex::Mutex() {}
@@ -77,6 +80,11 @@ void Semaphore::wait()
    WaitForSingleObject(mSemaphore, INFINITE);
 }
 
+bool Semaphore::timedWait(U32 timeoutMs)
+{
+   return WaitForSingleObject(mSemaphore, timeoutMs) == WAIT_OBJECT_0;
+}
+
 void Semaphore::increment(U32 count)
 {
    ReleaseSemaphore(mSemaphore, count, NULL);
@@ -104,7 +112,7 @@ void Mutex::unlock()
 
 bool Mutex::tryLock()
 {
-   return false;//   return TryEnterCriticalSection(&mLock);
+   return TryEnterCriticalSection(&mLock) != 0;
 }
 
 ThreadStorage::ThreadStorage()
@@ -171,6 +179,26 @@ void Semaphore::wait()
    sem_wait(&mSemaphore);
 }
 
+bool Semaphore::timedWait(U32 timeoutMs)
+{
+   timespec until;
+   clock_gettime(CLOCK_REALTIME, &until);
+
+   until.tv_sec += timeoutMs / 1000;
+   until.tv_nsec += (timeoutMs % 1000) * 1000000;
+   if(until.tv_nsec >= 1000000000)
+   {
+      until.tv_sec++;
+      until.tv_nsec -= 1000000000;
+   }
+
+   while(sem_timedwait(&mSemaphore, &until) != 0)
+      if(errno != EINTR)
+         return false;
+
+   return true;
+}
+
 void Semaphore::increment(U32 count)
 {
    for(U32 i = 0; i < count; i++)
@@ -209,7 +237,7 @@ void Mutex::unlock()
 
 bool Mutex::tryLock()
 {
-   return false;//   return TryEnterCriticalSection(&mLock);
+   return pthread_mutex_trylock(&mMutex) == 0;
 }
 
 ThreadStorage::ThreadStorage()
@@ -137,6 +137,9 @@ public:
 
    /// Returns the current client puzzle difficulty
    U32 getCurrentDifficulty() { return mCurrentDifficulty; }
+
+   /// Sets the difficulty of puzzles handed out from now on, up to MaxPuzzleDifficulty
+   void setCurrentDifficulty(U32 difficulty) { mCurrentDifficulty = difficulty < MaxPuzzleDifficulty ? difficulty : +MaxPuzzleDifficulty; }
 };
 
 };
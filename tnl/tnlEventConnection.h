@@ -80,7 +80,7 @@ public:
    ~EventConnection();
 protected:
    void clearSendEvents();
-   void clearRecvEvents();
+   void clearRecvEvents(S32 nextRecvEventSeq = FirstValidSendEventSeq);
 
    enum DebugConstants
    {
@@ -109,6 +109,17 @@ protected:
    /// Dispatches an event
    void processEvent(NetEvent *theEvent);
 
+   /// While events is set, events posted to this connection are added to it instead of being queued to send, so
+   /// a connection that writes its own packets (a game recording, for instance) can write them however it likes.
+   void setEventCapture(Vector<RefPtr<NetEvent> > *events) { mCapturedEvents = events; }
+
+   /// Writes events to be processed as soon as they are read, in the form readPacket() expects.  Nothing is queued
+   /// or tracked, so this is only of use to connections that write their own packets.
+   void writeUnorderedEvents(BitStream *bstream, const Vector<RefPtr<NetEvent> > &events);
+
+   /// Returns the sequence number the next ordered event posted to this connection will get
+   S32 getNextSendEventSeq() const { return mNextSendEventSeq; }
+
 
 //----------------------------------------------------------------
 // event manager functions/code:
@@ -128,6 +139,8 @@ private:
    S32 mNextRecvEventSeq;  ///< The next receive event sequence to process
    S32 mLastAckedEventSeq; ///< The last event the remote host is known to have processed
 
+   Vector<RefPtr<NetEvent> > *mCapturedEvents;  ///< Where posted events go instead of the send queues, or NULL
+
    enum {
       InvalidSendEventSeq = -1,
       FirstValidSendEventSeq = 0
@@ -164,6 +177,14 @@ public:
    /// For fake connections (AI for instance)
    virtual bool canPostNetEvent() const { return true; }
 
+   /// Returns true if the remote host knows about this event's class.  Events newer than the
+   /// remote host are quietly dropped by postNetEvent(), so this can be used to pick a fallback.
+   bool isEventSupported(NetEvent *event);
+
+   /// Returns the number of guaranteed ordered events that have been posted but not yet
+   /// acknowledged by the remote host, whether they are still queued or in flight.
+   S32 getPendingOrderedEventCount() const { return mNextSendEventSeq - mLastAckedEventSeq - 1; }
+
    TNL_DECLARE_RPC(s2rTNLSendDataParts, (U8 type, ByteBufferPtr data));
 private:
    TNL::ByteBuffer *mTNLDataBuffer;
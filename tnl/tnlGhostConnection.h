@@ -38,6 +38,10 @@
 #  include "tnlVector.h"
 #endif
 
+#ifndef _TNL_DATACHUNKER_H_
+#  include "tnlDataChunker.h"
+#endif
+
 namespace TNL {
 
 struct GhostInfo;
@@ -58,7 +62,8 @@ struct GhostInfo;
 /// Each object that is in scope, and in need of update (based on its maskbits) is given a priority
 /// ranking by calling that object's getUpdatePriority() method.  The packet is then filled with
 /// updates, ordered by priority. This way the most important updates get through first, with less
-/// important updates being sent as space is available.
+/// important updates being sent as space is available.  Pending updates are kept in a heap rather than
+/// fully sorted, as a packet usually fills up long before every pending update has been written.
 ///
 /// There is a cap on the maximum number of ghosts that can be active through a GhostConnection at once.
 /// The enum GhostIdBitSize (defaults to 10) determines how many bits will be used to transmit the ID for
@@ -125,6 +130,17 @@ protected:
    /// Override to check if there is data pending on this GhostConnection.
    bool isDataToTransmit();
 
+   /// Writes everything a reader needs to pick up this connection's stream from this point, without any of what came
+   /// before: every object the remote host has, with a full update, followed by whatever events those objects would
+   /// send on first becoming available.  The state of the connection is left alone, so this only makes sense for
+   /// one-way streams, such as game recordings, where every packet written is known to arrive.  Returns false, having
+   /// written nothing, while ordered events are still waiting to be written, as a reader could never get those.
+   bool writeSnapshot(BitStream *bstream);
+
+   /// Reads a snapshot written by writeSnapshot(), after which packets written from the same point can be read as
+   /// normal.  Anything received before should be cleared out with deleteLocalGhosts() first.
+   bool readSnapshot(BitStream *bstream);
+
 //----------------------------------------------------------------
 // ghost manager functions/code:
 //----------------------------------------------------------------
@@ -146,6 +162,9 @@ protected:
    Vector<NetObject *> mLocalGhosts;        ///< Local ghost array for remote objects, or NULL if mGhostTo is false.
 
    Vector<GhostInfo *> mGhostRefs;           ///< Allocated array of ghostInfos, or NULL if mGhostFrom is false.
+
+   Vector<GhostInfo *> mUpdateQueue;         ///< Ghosts waiting to be written into the current packet, as a heap ordered by priority.
+   ClassChunker<GhostRef> mGhostRefPool;     ///< Every packet creates and frees a GhostRef per update, so we recycle them.
    GhostInfo **mGhostLookupTable;   ///< Table indexed by object id->GhostInfo, or NULL if mGhostFrom is false.
 
    SafePtr<NetObject> mScopeObject; ///< The local NetObject that performs scoping queries to determine what
@@ -157,6 +176,11 @@ protected:
 
    void freeGhostInfo(GhostInfo *);
 
+   /// Sets the priority of each of the given ghosts, all of which have pending updates.  By default this calls
+   /// NetObject::getUpdatePriority() on each one; subclasses that can rank every ghost in a single pass, sharing
+   /// the per-connection setup, can override this instead.
+   virtual void computeUpdatePriorities(GhostInfo **ghosts, S32 count);
+
    /// Notifies subclasses that the remote host is about to start ghosting objects.
    virtual void onStartGhosting();                              
 
@@ -165,6 +189,7 @@ protected:
 
    bool mGhostFrom;
    bool mGhostTo;
+   bool mCountReceivedUpdates;
 
    U32 mGhostClassCount;
    U32 mGhostClassBitSize;
@@ -178,6 +203,10 @@ public:
    bool doesGhostFrom() { return mGhostFrom; } ///< Does this GhostConnection ghost NetObjects to the remote host?
    bool doesGhostTo() { return mGhostTo; }  ///< Does this GhostConnection receive ghosts from the remote host?
 
+   /// Sets whether ghost updates read on this connection are added to the NetClassRep bit usage counts, which
+   /// otherwise only count what is sent.
+   void setCountReceivedUpdates(bool count) { mCountReceivedUpdates = count; }
+
    /// Returns the sequence number of this ghosting session.
    U32 getGhostingSequence() { return mGhostingSequence; }
 
@@ -51,6 +51,9 @@ private:
    LogConsumer *mPrevConsumer;         ///< Previous LogConsumer in the global linked list of log consumers.
 
    static LogConsumer *mLinkedList;    ///< Head of the global linked list of log consumers.
+   static U32 mAllMsgTypes;            ///< Every type some consumer wants, or'ed together
+
+   static void updateAllMsgTypes();
 
 public:
    enum MsgType {   
@@ -93,7 +96,10 @@ public:
       ConsoleMsg              = BIT(23),     // Message that goes only to the console
       
       All = 0xFFFFFFFF,
-      AllErrorTypes = LogFatalError | LogError | LogWarning | LogLevelError | ConfigurationError
+      AllErrorTypes = LogFatalError | LogError | LogWarning | LogLevelError | ConfigurationError,
+
+      // Types logged for every packet, event, or ghost; see TNL_NO_VERBOSE_LOGGING below
+      VerboseTypes = LogConnectionProtocol | LogNetConnection | LogEventConnection | LogGhostConnection
    };
 
 
@@ -108,6 +114,10 @@ public:
    void setMsgType(MsgType msgType, bool enable);  // Enable or disable a single type
 
 
+   /// Returns true if any consumer wants messages of this type.  Cheap enough to call before every message, so we
+   /// needn't format (or even gather) what nobody will read.
+   static bool isLogging(MsgType msgType) { return (mAllMsgTypes & msgType) != 0; }
+
    /// Returns the head of the linked list of all log consumers.
    static LogConsumer *getLinkedList() { return mLinkedList; }
 
@@ -119,6 +129,13 @@ public:
 
    static void logString(LogConsumer::MsgType msgType, std::string message);
 
+   virtual void flush();               // Finish writing anything this consumer is holding on to
+   virtual void flushFromSignal();     // Same, as best we can from a crashing program's signal handler
+
+   static void flushAll();
+   static void flushAllFromSignal();   // Only takes locks it can get, and frees nothing
+   static void flushAllOnExit();       // Have exit() and fatal signals flush every consumer before the program goes
+
 private:
    S32 mMsgTypes;    // A bitmap of MsgType values
    void prepareAndLogString(std::string message);
@@ -129,17 +146,27 @@ private:
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-class FileLogConsumer : public LogConsumer    // Dumps logs to file
+// Dumps logs to file.  Whoever logs only queues the line; a thread of our own writes the queue out in batches, flushing
+// the file when enough has piled up, or a little while after the first line came in, so the disk never holds up the game.
+class FileLogConsumer : public LogConsumer
 {
-protected:
-   FILE *f;
+private:
+   class Writer;
+   Writer *mWriter;
 
 public:
    FileLogConsumer();      // Constructor
-   ~FileLogConsumer();     // Destructor
+   ~FileLogConsumer();     // Destructor; writes out anything still queued
 
    void init(std::string logFile, const char *mode = "a");
 
+   // Move the log to logFile.1 (and older ones to .2 and so on) and start a new one once it gets bigger than maxBytes,
+   // or older than maxSeconds.  0 means no limit.
+   void setRotation(U32 maxBytes, U32 maxSeconds);
+
+   void flush();           // Writes out everything queued so far, and returns when it's on disk
+   void flushFromSignal(); // Writes what's queued without locking or freeing anything; may give up
+
 private:
    void writeString(const char *string);
 }; 
@@ -187,6 +214,32 @@ struct LogType
 extern void logprintf(LogConsumer::MsgType msgType, const char *format, ...);
 extern void logprintf(const char *format, ...);
 
+
+/// Types of message that can be logged at all.  Building with TNL_NO_VERBOSE_LOGGING leaves out the VerboseTypes, which
+/// are only of use when debugging TNL itself, so the code that logs them isn't even compiled; define
+/// TNL_LOG_COMPILED_TYPES yourself to choose some other set.
+#ifndef TNL_LOG_COMPILED_TYPES
+#  ifdef TNL_NO_VERBOSE_LOGGING
+#     define TNL_LOG_COMPILED_TYPES (TNL::LogConsumer::All & ~TNL::LogConsumer::VerboseTypes)
+#  else
+#     define TNL_LOG_COMPILED_TYPES TNL::LogConsumer::All
+#  endif
+#endif
+
+
+/// Use in place of logprintf(msgType, ...) where messages are logged often, and are usually turned off.  Unless some
+/// consumer wants msgType, the arguments aren't evaluated and nothing is formatted; if msgType isn't in
+/// TNL_LOG_COMPILED_TYPES, the whole statement compiles to nothing.
+#ifndef TNL_DISABLE_LOGGING
+#  define TNLLog(msgType, ...)                                                                     \
+      do {                                                                                          \
+         if(((msgType) & (TNL_LOG_COMPILED_TYPES)) && TNL::LogConsumer::isLogging(msgType))         \
+            TNL::logprintf(msgType, __VA_ARGS__);                                                   \
+      } while(0)
+#else
+#  define TNLLog(msgType, ...) do { } while(0)
+#endif
+
 extern std::string getTimeStamp();
 extern std::string getShortTimeStamp();
 
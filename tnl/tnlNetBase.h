@@ -255,6 +255,11 @@ public:
       mPartialUpdateBitsUsed += bitCount;
    }
 
+   U32 getInitialUpdateCount() const { return mInitialUpdateCount; }       ///< Returns the number of initial updates recorded.
+   U32 getInitialUpdateBits() const  { return mInitialUpdateBitsUsed; }    ///< Returns the bits used by initial updates.
+   U32 getPartialUpdateCount() const { return mPartialUpdateCount; }       ///< Returns the number of partial updates recorded.
+   U32 getPartialUpdateBits() const  { return mPartialUpdateBitsUsed; }    ///< Returns the bits used by partial updates.
+
    virtual Object *create() const = 0;             ///< Creates an instance of the class this represents.
 
    /// Returns the number of classes registered under classGroup and classType.
@@ -276,8 +276,15 @@ protected:
    ///
    /// Reads data sent by the writeConnectRequest method and returns true if the connection is accepted
    /// or false if it's not.  The errorString pointer should be filled if the connection is rejected.
+   ///
+   /// To put off deciding, set the connection state to DecidingConnectRequest and return true; then call
+   /// NetInterface::acceptDeferredConnection or rejectDeferredConnection once the decision is made.
    virtual bool readConnectRequest(BitStream *stream, NetConnection::TerminationReason &reason, std::string &reasonStr);
 
+   /// Called when readConnectRequest put off deciding whether to accept this connection, and nothing has been decided
+   /// after NetInterface::DeferredConnectTimeout.  Return true to accept the connection anyway, or false to reject it.
+   virtual bool onConnectDecisionTimedOut() { return false; }
+
    /// Writes any data needed to start the connection on the accept packet
    virtual void writeConnectAccept(BitStream *stream);
 
@@ -566,6 +573,7 @@ public:
       SendingPunchPackets,       ///< The state of a pending arranged connection when both sides haven't heard from the other yet
       ComputingPuzzleSolution,   ///< We've received a challenge response, and are in the process of computing a solution to its puzzle
       AwaitingConnectResponse,   ///< We've received a challenge response and sent a connect request
+      DecidingConnectRequest,    ///< We've received a connect request, and haven't yet decided whether to accept it
       ConnectTimedOut,           ///< The connection timed out during the connection process
       ConnectRejected,           ///< The connection was rejected
       Connected,                 ///< We've accepted a connect request, or we've received a connect response accept
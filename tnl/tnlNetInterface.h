@@ -175,7 +175,7 @@ protected:
    Vector<NetConnection *> mConnectionHashTable;   /// A resizable hash table for all connected connections.  This is a flat hash table (no buckets).
 
    Vector<NetConnection *> mPendingConnections;    /// List of connections that are in the startup state, where the remote host has not fully
-                                                   /// validated the connection.
+                                                   /// validated the connection, or we haven't decided whether to accept it.
 
    RefPtr<AsymmetricKey> mPrivateKey;  /// The private key used by this NetInterface for secure key exchange.
    RefPtr<Certificate> mCertificate;   /// A certificate, signed by some Certificate Authority, to authenticate this host.
@@ -225,6 +225,7 @@ protected:
 
       TimeoutCheckInterval = 1500,     /// Interval in milliseconds between checking for connection timeouts.
       PuzzleSolutionTimeout = 30000,   /// If the server gives us a puzzle that takes more than 30 seconds, time out.
+      DeferredConnectTimeout = 5000,   /// How long a connect request can wait for a deferred decision; see NetConnection::onConnectDecisionTimedOut.
    };
 
    /// Computes an identity token for the connecting client based on the address of the client and the
@@ -287,6 +288,9 @@ protected:
    /// Sends a connect accept packet to acknowledge the successful acceptance of a connect request.
    void sendConnectAccept(NetConnection *conn);
 
+   /// Puts a connection whose readConnectRequest deferred its decision in the connected state, and tells the remote host.
+   void finishAcceptingConnection(NetConnection *conn);
+
    /// Handles a connect accept packet, putting the connection associated with the
    /// remote host (if there is one) into an active state.
    void handleConnectAccept(const Address &address, BitStream *stream);
@@ -344,6 +348,10 @@ public:
    /// in another way.
    void setCertificate(Certificate *theCertificate);
 
+   /// Sets how hard a puzzle clients must solve before we'll consider their connect requests.  Easier puzzles make
+   /// connecting cheaper for everyone, including anyone trying to flood us with requests.
+   void setPuzzleDifficulty(U32 difficulty) { mPuzzleManager.setCurrentDifficulty(difficulty); }
+
    /// Returns whether or not this NetInterface allows connections from remote hosts.
    bool doesAllowConnections() { return mAllowConnections; }
 
@@ -375,6 +383,12 @@ public:
    /// and pending connections.
    void processConnections();
 
+   /// Accepts a connection whose readConnectRequest put off deciding whether to accept it.
+   void acceptDeferredConnection(NetConnection *conn);
+
+   /// Rejects a connection whose readConnectRequest put off deciding whether to accept it.
+   void rejectDeferredConnection(NetConnection *conn, NetConnection::TerminationReason reason, const char *reasonString);
+
    /// Returns the list of connections on this NetInterface.
    Vector<NetConnection *> &getConnectionList() { return mConnectionList; }
 
@@ -343,6 +343,10 @@ public:
    /// isGhostable returns true if this object can be ghosted to any clients.
    bool isGhostable() const;
 
+   /// testNetFlags returns true if any of the given flags are set.  Subclasses may define
+   /// their own flags above MaxNetFlagBit.
+   bool testNetFlags(U32 flags) const;
+
    /// Return a hash for this object.
    ///
    /// @note This is based on its location in memory.
@@ -374,6 +378,11 @@ inline bool NetObject::isGhostable() const
     return mNetFlags.test(Ghostable);
 }
 
+inline bool NetObject::testNetFlags(U32 flags) const
+{
+    return mNetFlags.test(flags);
+}
+
 // New method gives same results as old, but without the type-punning
 inline U32 NetObject::getHashId() const
 {
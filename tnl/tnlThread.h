@@ -72,6 +72,10 @@ public:
    /// will be awakened and the semaphore will decrement.
    void wait();
 
+   /// Like wait, but gives up after timeoutMs.  Returns true if the
+   /// semaphore was decremented, false if we timed out.
+   bool timedWait(U32 timeoutMs);
+
    /// Increments the semaphore's internal count.  This will wake
    /// count threads that are waiting on this semaphore.
    void increment(U32 count = 1);
@@ -144,14 +144,31 @@ enum NetError {
    UnknownError,          ///< There was some other, unknown error.
 };
 
+struct PacketBatch;
+
 /// The Socket class encapsulates a platform's network socket.
+///
+/// Where the platform can (Linux, with recvmmsg and sendmmsg), the socket moves packets a batch at a time: recvfrom
+/// hands out packets from a ring filled by a single system call, and packets sent between beginSendBatch and
+/// endSendBatch are held, and sent together.  Elsewhere both work one packet at a time, as always.
 class Socket
 {
    S32 mPlatformSocket;    ///< The OS-level socket
    U32 mTransportProtocol; ///< The transport type this socket uses.
+
+   PacketBatch *mRecvBatch;   ///< Packets read, but not yet handed out; allocated on first use
+   PacketBatch *mSendBatch;   ///< Packets waiting for endSendBatch; allocated on first use
+   S32 mSendBatchDepth;
+   bool mBatchingWorks;       ///< False if the kernel turned out not to support batching after all
+
+   S32 recvBatched(Address *address, U8 *buffer, S32 bufferSize);
+   void sendBatched(const Address &address, const U8 *buffer, S32 bufferSize);
+   void flushSendBatch();
+
 public:
    enum {
       DefaultBufferSize = 32768, ///< The default send and receive buffer sizes
+      BatchSize = 32,            ///< Most packets moved by one system call
    };
 
    /// Opens a socket on the specified address/port
@@ -166,6 +183,9 @@ public:
    /// Returns true if the socket was created successfully.
    bool isValid();
 
+   /// Returns the OS-level socket, for waiting on with select, epoll and the like.
+   S32 getPlatformSocket() const { return mPlatformSocket; }
+
    /// Sends a packet to the address through sourceSocket.
    NetError sendto(const Address &address, const U8 *buffer, S32 bufferSize);
 
@@ -177,6 +197,11 @@ public:
    /// @param   bytesRead       Specifies the number of bytes which were actually in the packet.
    NetError recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *bytesRead);
 
+   /// Packets sent from now until the matching endSendBatch() are held, and sent together.  Calls can be nested; the
+   /// packets go when the outermost batch ends, or sooner if there are more than BatchSize of them.
+   void beginSendBatch();
+   void endSendBatch();
+
    /// Returns the Address corresponding to this socket, as bound on the local machine.
    Address getBoundAddress();
 
@@ -76,11 +76,16 @@ typedef in_addr IN_ADDR;
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <errno.h>
 
+#ifdef TNL_OS_LINUX
+#  define TNL_BATCHED_UDP     // recvmmsg and sendmmsg
+#endif
+
 /* for PROTO_IPX */
 #include <sys/ioctl.h>   /* ioctl() */
 #define NO_IPX_SUPPORT
@@ -153,6 +158,49 @@ static bool init()
    return success;
 }
 
+#ifdef TNL_BATCHED_UDP
+
+// Room for a batch of packets, with everything recvmmsg or sendmmsg needs to know about them
+struct PacketBatch
+{
+   U8 data[Socket::BatchSize][MaxPacketDataSize];
+   SOCKADDR addresses[Socket::BatchSize];
+   iovec iovecs[Socket::BatchSize];
+   mmsghdr messages[Socket::BatchSize];
+
+   S32 count;        // Packets in the batch
+   S32 next;         // Next one to hand out, when receiving
+
+   PacketBatch()
+   {
+      memset(messages, 0, sizeof(messages));
+      count = 0;
+      next = 0;
+   }
+
+   void prepare(S32 index, S32 size, socklen_t addressSize)
+   {
+      iovecs[index].iov_base = data[index];
+      iovecs[index].iov_len = size;
+
+      msghdr &header = messages[index].msg_hdr;
+      header.msg_name = &addresses[index];
+      header.msg_namelen = addressSize;
+      header.msg_iov = &iovecs[index];
+      header.msg_iovlen = 1;
+   }
+};
+
+#else
+
+struct PacketBatch
+{
+   // Never used
+};
+
+#endif
+
+
 static void shutdown()
 {
    initCount--;
@@ -223,6 +271,15 @@ Socket::Socket(const Address &bindAddress, U32 sendBufferSize, U32 recvBufferSiz
    mPlatformSocket = INVALID_SOCKET;
    mTransportProtocol = bindAddress.transport;
 
+   mRecvBatch = NULL;
+   mSendBatch = NULL;
+   mSendBatchDepth = 0;
+#ifdef TNL_BATCHED_UDP
+   mBatchingWorks = bindAddress.transport == IPProtocol;
+#else
+   mBatchingWorks = false;
+#endif
+
    const char *socketType;
 
    if(bindAddress.transport == IPProtocol)
@@ -325,6 +382,14 @@ Socket::Socket(const Address &bindAddress, U32 sendBufferSize, U32 recvBufferSiz
 
 Socket::~Socket()
 {
+#ifdef TNL_BATCHED_UDP
+   if(mSendBatch && mSendBatch->count > 0)
+      flushSendBatch();
+#endif
+
+   delete mRecvBatch;
+   delete mSendBatch;
+
    TNL_JOURNAL_READ_BLOCK(Socket::~Socket,
       return;
    )
@@ -348,6 +413,14 @@ NetError Socket::sendto(const Address &address, const U8 *buffer, S32 bufferSize
    if(address.transport != mTransportProtocol)
       return InvalidPacketProtocol;
 
+#ifdef TNL_BATCHED_UDP
+   if(mSendBatchDepth > 0 && mBatchingWorks && bufferSize <= (S32)MaxPacketDataSize)
+   {
+      sendBatched(address, buffer, bufferSize);
+      return NoError;      // Like any UDP packet, it might still get lost
+   }
+#endif
+
    SOCKADDR destAddress;
    socklen_t addressSize;
 
@@ -380,11 +453,23 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
       return NoError;
    )
 
-   SOCKADDR sa;
-   socklen_t addrLen = sizeof(sa);
    S32 bytesRead = SOCKET_ERROR;
 
-   bytesRead = ::recvfrom(mPlatformSocket, (char *) buffer, bufferSize, 0, &sa, &addrLen);
+#ifdef TNL_BATCHED_UDP
+   if(mBatchingWorks)
+      bytesRead = recvBatched(address, buffer, bufferSize);
+   else
+#endif
+   {
+      SOCKADDR sa;
+      socklen_t addrLen = sizeof(sa);
+
+      bytesRead = ::recvfrom(mPlatformSocket, (char *) buffer, bufferSize, 0, &sa, &addrLen);
+
+      if(bytesRead != SOCKET_ERROR)
+         SocketToTNLAddress(&sa, address);
+   }
+
    if(bytesRead == SOCKET_ERROR)
    {
       TNL_JOURNAL_WRITE_BLOCK(Socket::recvfrom,
@@ -393,8 +478,6 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
       return WouldBlock;
    }
 
-   SocketToTNLAddress(&sa, address);
-
    *outSize = bytesRead;
 
    TNL_JOURNAL_WRITE_BLOCK(Socket::recvfrom,
@@ -411,6 +494,122 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
    return NoError;
 }
 
+#ifdef TNL_BATCHED_UDP
+
+// Hands out the next packet from mRecvBatch, reading a new batch when it's empty.  Returns the packet's size, or
+// SOCKET_ERROR if there's nothing to read.
+S32 Socket::recvBatched(Address *address, U8 *buffer, S32 bufferSize)
+{
+   if(!mRecvBatch)
+      mRecvBatch = new PacketBatch;
+
+   PacketBatch &batch = *mRecvBatch;
+
+   if(batch.next == batch.count)
+   {
+      batch.count = 0;
+      batch.next = 0;
+
+      for(S32 i = 0; i < BatchSize; i++)
+         batch.prepare(i, MaxPacketDataSize, sizeof(SOCKADDR));
+
+      // MSG_WAITFORONE, so a blocking socket blocks for the first packet only, just as it would in recvfrom()
+      S32 count = recvmmsg(mPlatformSocket, batch.messages, BatchSize, MSG_WAITFORONE, NULL);
+
+      if(count <= 0)
+      {
+         if(count < 0 && errno == ENOSYS)
+         {
+            logprintf(LogConsumer::LogUDP, "recvmmsg unsupported; reading packets one at a time");
+            mBatchingWorks = false;
+         }
+
+         return SOCKET_ERROR;
+      }
+
+      batch.count = count;
+   }
+
+   S32 index = batch.next++;
+   S32 size = getMin((S32)batch.messages[index].msg_len, bufferSize);
+
+   SocketToTNLAddress(&batch.addresses[index], address);
+   memcpy(buffer, batch.data[index], size);
+
+   return size;
+}
+
+
+void Socket::sendBatched(const Address &address, const U8 *buffer, S32 bufferSize)
+{
+   if(!mSendBatch)
+      mSendBatch = new PacketBatch;
+
+   PacketBatch &batch = *mSendBatch;
+   S32 index = batch.count++;
+
+   socklen_t addressSize;
+   TNLToSocketAddress(address, &batch.addresses[index], &addressSize);
+   memcpy(batch.data[index], buffer, bufferSize);
+   batch.prepare(index, bufferSize, addressSize);
+
+   if(batch.count == BatchSize)
+      flushSendBatch();
+}
+
+
+void Socket::flushSendBatch()
+{
+   PacketBatch &batch = *mSendBatch;
+   S32 sent = 0;
+
+   while(sent < batch.count)
+   {
+      S32 count = sendmmsg(mPlatformSocket, &batch.messages[sent], batch.count - sent, 0);
+
+      if(count > 0)
+         sent += count;
+
+      else if(errno == ENOSYS)
+      {
+         logprintf(LogConsumer::LogUDP, "sendmmsg unsupported; sending packets one at a time");
+         mBatchingWorks = false;
+
+         for(; sent < batch.count; sent++)
+            ::sendto(mPlatformSocket, (const char *)batch.data[sent], batch.iovecs[sent].iov_len, 0,
+                     &batch.addresses[sent], batch.messages[sent].msg_hdr.msg_namelen);
+      }
+
+      // The first packet couldn't be sent; sendto() would have failed too, and the packet been lost, so drop it
+      else
+         sent++;
+   }
+
+   batch.count = 0;
+}
+
+#endif
+
+
+void Socket::beginSendBatch()
+{
+   mSendBatchDepth++;
+}
+
+
+void Socket::endSendBatch()
+{
+   TNLAssert(mSendBatchDepth > 0, "endSendBatch() without beginSendBatch()!");
+
+   mSendBatchDepth--;
+
+#ifdef TNL_BATCHED_UDP
+   if(mSendBatchDepth == 0 && mSendBatch && mSendBatch->count > 0)
+      flushSendBatch();
+#endif
+}
+
+
 NetError Socket::connect(const Address &theAddress)
 {
    SOCKADDR destAddress;
@@ -9,6 +9,9 @@
 #include "game.h"
 #include "ClientInfo.h"
 #include "moveObject.h"
+#include "ship.h"                // For update priority adjustments
+#include "LineItem.h"            // Ditto
+#include "TextItem.h"            // Ditto
 #include "TeamConstants.h"
 
 #ifndef ZAP_DEDICATED
@@ -25,6 +28,8 @@
 #include "gameType.h"
 #include "EventManager.h"        // For EventType enum
 
+#include "tnlThread.h"
+
 using namespace TNL;
 
 namespace Zap
@@ -389,11 +394,28 @@ F32 EditorObject::getEditorRadius(F32 currentScale)
 // BfObject - the declarations are in GameObject.h
 
 
+static S32 gNextSerialNumber = 0;
+static S32 gNextDefaultId = -1;
+
+
+// Set on a robot worker thread while its robot thinks
+static ThreadStorage &getThreadIdBlocks()
+{
+   static ThreadStorage blocks;
+   return blocks;
+}
+
+
 static S32 getNextDefaultId() 
 {
-   static S32 nextId = 0;
-   nextId--;
-   return nextId;
+   BfObject::IdBlock *block = static_cast<BfObject::IdBlock *>(getThreadIdBlocks().get());
+
+   if(!block)
+      return gNextDefaultId--;
+
+   S32 id = block->nextDefaultId;
+   block->nextDefaultId -= block->stride;
+   return id;
 }
 
 
@@ -412,6 +434,8 @@ BfObject::BfObject()
 
    mOwner = NULL;
 
+   mNetFlags.set(IsBfObject);
+
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
 }
 
@@ -443,9 +467,16 @@ void BfObject::assignNewUserAssignedId()
 // to which wall, even as walls are being moved around, and wall edits are undone/redone.
 void BfObject::assignNewSerialNumber()
 {
-   static S32 mNextSerialNumber = 0;
+   IdBlock *block = static_cast<IdBlock *>(getThreadIdBlocks().get());
+
+   if(!block)
+   {
+      mSerialNumber = gNextSerialNumber++;
+      return;
+   }
 
-   mSerialNumber = mNextSerialNumber++;
+   mSerialNumber = block->nextSerialNumber;
+   block->nextSerialNumber += block->stride;
 }
 
 
@@ -866,23 +897,44 @@ S32 BfObject::getUserAssignedId()
 }
 
 
+// Static method
+void BfObject::getNextIds(S32 &serialNumber, S32 &defaultId)
+{
+   serialNumber = gNextSerialNumber;
+   defaultId = gNextDefaultId;
+}
+
+
+// Static method; only for moving the counters on past numbers handed out from IdBlocks
+void BfObject::setNextIds(S32 serialNumber, S32 defaultId)
+{
+   gNextSerialNumber = serialNumber;
+   gNextDefaultId = defaultId;
+}
+
+
+// Static method; block must stay put for as long as it's set
+void BfObject::setThreadIdBlock(IdBlock *block)
+{
+   getThreadIdBlocks().set(block);
+}
+
+
 void BfObject::setScopeAlways()
 {
    getGame()->setScopeAlwaysObject(this);
 }
 
 
-F32 BfObject::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips)
+// Priority of an update to an object with the given extent and velocity, for a connection whose control object
+// is centered at center and moving at scopeVel
+static F32 computeUpdatePriority(const Rect &extent, const Point &vel, bool hasScopeObject, 
+                                 const Point &center, const Point &scopeVel, U32 updateMask, S32 updateSkips)
 {
-   GameConnection *gc = dynamic_cast<GameConnection *>(connection);
-   BfObject *so = gc ? gc->getControlObject() : NULL;
    F32 add = 0;
-   if(so)
+   if(hasScopeObject)
    {
-      Point center = so->getExtent().getCenter();
-
       Point nearest;
-      const Rect &extent = getExtent();
 
       if(center.x < extent.min.x)
          nearest.x = extent.min.x;
@@ -902,7 +954,7 @@ F32 BfObject::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32
 
       F32 distance = (nearest - center).len();
 
-      Point deltav = getVel() - so->getVel();
+      Point deltav = vel - scopeVel;
 
 
       // initial scoping factor is distance based.
@@ -920,6 +972,83 @@ F32 BfObject::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32
 }
 
 
+F32 BfObject::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips)
+{
+   GameConnection *gc = dynamic_cast<GameConnection *>(connection);
+   BfObject *so = gc ? gc->getControlObject() : NULL;
+
+   if(!so)
+      return computeUpdatePriority(getExtent(), Point(), false, Point(), Point(), updateMask, updateSkips);
+
+   return computeUpdatePriority(getExtent(), getVel(), true, so->getExtent().getCenter(), so->getVel(), updateMask, updateSkips);
+}
+
+
+typedef F32 (*UpdatePriorityAdjustment)(BfObject *object);
+
+// Stands in for the getUpdatePriority() overrides in computeUpdatePriorities(), indexed by type number
+struct UpdatePriorityAdjustmentTable
+{
+   UpdatePriorityAdjustment adjustments[TypesNumbers];
+
+   UpdatePriorityAdjustmentTable()
+   {
+      for(S32 i = 0; i < TypesNumbers; i++)
+         adjustments[i] = NULL;
+
+      adjustments[PlayerShipTypeNumber] = Ship::getUpdatePriorityAdjustment;
+      adjustments[RobotShipTypeNumber]  = Ship::getUpdatePriorityAdjustment;
+      adjustments[LineTypeNumber]       = LineItem::getUpdatePriorityAdjustment;
+      adjustments[TextItemTypeNumber]   = TextItem::getUpdatePriorityAdjustment;
+   }
+};
+
+static const UpdatePriorityAdjustmentTable updatePriorityAdjustments;
+
+
+// Static
+void BfObject::computeUpdatePriorities(GhostConnection *connection, GhostInfo **ghosts, S32 count, BfObject *scopeObject)
+{
+   // The scope object is the same for every ghost, so only look at it once
+   bool hasScopeObject = (scopeObject != NULL);
+   Point scopeCenter, scopeVel;
+
+   if(hasScopeObject)
+   {
+      scopeCenter = scopeObject->getExtent().getCenter();
+      scopeVel = scopeObject->getVel();
+   }
+
+   for(S32 i = 0; i < count; i++)
+   {
+      GhostInfo *ghost = ghosts[i];
+
+      if(!ghost->obj->testNetFlags(IsBfObject))
+      {
+         ghost->priority = ghost->obj->getUpdatePriority(connection, ghost->updateMask, ghost->updateSkipCount);
+         continue;
+      }
+
+      BfObject *object = static_cast<BfObject *>(ghost->obj);
+
+      U8 typeNumber = object->getObjectTypeNumber();
+
+      // Objects that have been deleted but not yet removed still rank as what they were
+      if(typeNumber == DeletedTypeNumber)
+         typeNumber = object->mOriginalTypeNumber;
+
+      F32 priority = computeUpdatePriority(object->getExtent(), hasScopeObject ? object->getVel() : Point(), hasScopeObject, 
+                                           scopeCenter, scopeVel, ghost->updateMask, ghost->updateSkipCount);
+
+      UpdatePriorityAdjustment adjust = updatePriorityAdjustments.adjustments[typeNumber];
+      if(adjust)
+         priority += adjust(object);
+
+      ghost->priority = priority;
+   }
+}
+
+
 void BfObject::damageObject(DamageInfo *theInfo)
 {
    // Do nothing
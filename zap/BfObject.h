@@ -18,7 +18,7 @@
 #  pragma warning( disable : 4250)
 #endif
 
-namespace TNL{ class BitStream; }
+namespace TNL{ class BitStream; struct GhostInfo; }
 
 
 namespace Zap
@@ -224,6 +224,16 @@ public:
       ClientReplayingPendingMoves,  
    };
 
+   // Where objects made on a robot worker thread get their serial numbers and default ids.  Each thinking robot has its
+   // own, and takes every strideth number from its own starting point, so what it gets doesn't depend on how far the
+   // robots on other threads have got.
+   struct IdBlock
+   {
+      S32 nextSerialNumber;
+      S32 nextDefaultId;      // Default ids count down
+      S32 stride;
+   };
+
 private:
    SafePtr<GameConnection> mControllingClient;     // Only has meaning on the server, will be null on the client
    SafePtr<ClientInfo> mOwner;
@@ -264,6 +274,10 @@ public:
    void setUserAssignedId(S32 id, bool permitZero);
    S32 getUserAssignedId();
 
+   static void getNextIds(S32 &serialNumber, S32 &defaultId);
+   static void setNextIds(S32 serialNumber, S32 defaultId);
+   static void setThreadIdBlock(IdBlock *block);      // NULL goes back to the shared counters
+
    StringTableEntry getKillString();
 
    enum MaskBits {
@@ -272,6 +286,10 @@ public:
       FirstFreeMask = BIT(2)
    };
 
+   enum BfObjectNetFlag {
+      IsBfObject = BIT(MaxNetFlagBit + 1)    // Lets a connection tell BfObjects from the GameType without a dynamic_cast
+   };
+
    BfObject *findObjectLOS(U8 typeNumber, U32 stateIndex, const Point &start, const Point &end, float &collisionTime, Point &normal) const;
    BfObject *findObjectLOS(TestFunc,      U32 stateIndex, const Point &start, const Point &end, float &collisionTime, Point &normal) const;
 
@@ -284,6 +302,12 @@ public:
 
    F32 getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips);
 
+   // Sets the priority of a batch of ghosts for a connection controlling scopeObject (which may be NULL).  Gives the
+   // same answers as getUpdatePriority(), but subclass adjustments are looked up by type number rather than through
+   // the virtual, so a BfObject overriding getUpdatePriority() must register its adjustment in the table in
+   // BfObject.cpp as well.  Ghosts that aren't BfObjects are passed to their own getUpdatePriority().
+   static void computeUpdatePriorities(GhostConnection *connection, GhostInfo **ghosts, S32 count, BfObject *scopeObject);
+
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
    void findObjects(TestFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
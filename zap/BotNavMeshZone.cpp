@@ -14,6 +14,7 @@
 #include "speedZone.h"
 #include "GeomUtils.h"
 #include "MathUtils.h"
+#include "stringUtils.h"              // For itos()
 
 #include "tnlLog.h"
 
@@ -153,11 +154,11 @@ struct rcEdge
 //
 // Adapted from RecastMesh::buildMeshAdjacency() to fill connection data into
 // BotNavMeshZone instead of Recast's adjaceny data
-bool BotNavMeshZone::buildConnectionsRecastStyle(const Vector<BotNavMeshZone *> *allZones,
+bool BotNavMeshZone::buildConnectionsRecastStyle(Vector<Vector<NeighboringZone> > &neighbors,
       rcPolyMesh &mesh, const Vector<S32> &polyToZoneMap, S32 coreRecastPolyStartIdx,
       S32 szRecastPolyStartIdx)
 {
-   if(allZones->size() == 0)      // Nothing to do!
+   if(neighbors.size() == 0)      // Nothing to do!
       return true;
 
    /////////////////////////////
@@ -261,6 +262,10 @@ bool BotNavMeshZone::buildConnectionsRecastStyle(const Vector<BotNavMeshZone *>
       U16 polyId0 = e.poly[0];
       U16 polyId1 = e.poly[1];
 
+      // Polys that didn't make it into a zone (we hit MAX_ZONES) can't be connected to anything
+      if(polyToZoneMap[polyId0] == -1 || polyToZoneMap[polyId1] == -1)
+         continue;
+
       if(polyId0 != polyId1)      // Should normally be the case
       {
          U16 *v;
@@ -290,7 +295,7 @@ bool BotNavMeshZone::buildConnectionsRecastStyle(const Vector<BotNavMeshZone *>
                neighbor.distTo = CoreTraversalCost;
 
             // Save poly1 as neighbor to poly0 (copies neighbor implicitly)
-            allZones->get(polyToZoneMap[polyId0])->mNeighbors.push_back(neighbor);
+            neighbors[polyToZoneMap[polyId0]].push_back(neighbor);
          }
 
          // Now do the same for poly1 to get poly0 as a neighbor
@@ -302,7 +307,7 @@ bool BotNavMeshZone::buildConnectionsRecastStyle(const Vector<BotNavMeshZone *>
             if(poly0isCore && !poly1isCore)
                neighbor.distTo = CoreTraversalCost;
 
-            allZones->get(polyToZoneMap[polyId1])->mNeighbors.push_back(neighbor);
+            neighbors[polyToZoneMap[polyId1]].push_back(neighbor);
          }
       }
    }
@@ -408,11 +413,6 @@ bool isSpeedZoneProblemObject(U8 x)
 }
 
 
-static S32 QSORT_CALLBACK sortBarriersFirst(DatabaseObject **a, DatabaseObject **b)
-{
-   return ((*b)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0) - ((*a)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0);
-}
-
 // This is patterned after MoveObject::findFirstCollision(), but modified with
 // different assumptions because we are not a moving ship
 static BfObject* findFirstCollision(const GridDatabase *gameObjDatabase, F32 &collisionTime, Point &collisionPoint,
@@ -426,7 +426,7 @@ static BfObject* findFirstCollision(const GridDatabase *gameObjDatabase, F32 &co
 
    gameObjDatabase->findObjects(isSpeedZoneProblemObject, fillVector, queryRect);
 
-   fillVector.sort(sortBarriersFirst);
+   sortBarriersFirst(fillVector);
 
    BfObject *collisionObject = NULL;
    F32 closestCollisionFraction = F32_MAX;
@@ -708,51 +708,6 @@ static bool meshArea(const PolyTree &polytree, const Rect &levelBounds,
 bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
                                        const Rect *worldExtents, bool triangulateZones)
 {
-   // Start by finding all objects that'll matter for meshing the level
-
-   // Teleporters form extra connections
-   fillVector.clear();
-   gameObjDatabase->findObjects(TeleporterTypeNumber, fillVector);
-
-   Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
-   pair<Point, const Vector<Point> *> teldat;
-
-   for(S32 i = 0; i < fillVector.size(); i++)
-   {
-      Teleporter *teleporter = static_cast<Teleporter *>(fillVector[i]);
-
-      teldat.first  = teleporter->getPos();
-      teldat.second = teleporter->getDestList();
-
-      teleporterData.push_back(teldat);
-   }
-
-   // So do speedzones
-   Vector<DatabaseObject *> speedZoneList;
-   gameObjDatabase->findObjects(SpeedZoneTypeNumber, speedZoneList);
-
-   // Cores can be destroyed and open up new paths - need special handling
-   Vector<DatabaseObject *> coreList;
-   gameObjDatabase->findObjects(CoreTypeNumber, coreList);
-
-
-   // Get our parameters together
-   Vector<DatabaseObject *> barrierList;
-   gameObjDatabase->findObjects((TestFunc)isWallType, barrierList, *worldExtents);
-
-   Vector<DatabaseObject *> turretList;
-   gameObjDatabase->findObjects(TurretTypeNumber, turretList, *worldExtents);
-
-   Vector<DatabaseObject *> forceFieldProjectorList;
-   gameObjDatabase->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList, *worldExtents);
-
-
-
-#ifdef LOG_TIMER
-   U32 starttime = Platform::getRealMilliseconds();
-#endif
-
-   Rect bounds(worldExtents);      // Modifiable copy
    // allZones is a Vector cache of all zones held in memory by the server to
    // be used by Robots without having to call the grid database
    //
@@ -760,93 +715,166 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    // repopulating it below
    allZones->deleteAndClear();
 
-   bounds.expandToInt(Point(LevelZoneBuffer, LevelZoneBuffer));      // Provide a little breathing room
+   BotZoneInput input;
+   if(!gatherBotZoneInput(gameObjDatabase, worldExtents, input))
+      return false;
+
+   BotZoneMesh mesh;
+   string error;
+   Vector<string> messages;
 
-   // Make sure level isn't too big for zone generation, which uses 16 bit ints
-   if(bounds.getHeight() >= (F32)U16_MAX || bounds.getWidth() >= (F32)U16_MAX)
+   bool built = buildBotZoneMesh(input, mesh, error, messages);
+
+   for(S32 i = 0; i < messages.size(); i++)
+      logprintf("%s", messages[i].c_str());
+
+   if(!built)
    {
-      logprintf(LogConsumer::LogLevelError, "Level too big for zone generation! (max allowed dimension is %d)", U16_MAX);
+      logprintf(LogConsumer::LogLevelError, "%s", error.c_str());
       return false;
    }
 
+   addBotZones(mesh, botZoneDatabase, allZones, triangulateZones);
+   linkBotZones(botZoneDatabase, gameObjDatabase, allZones, mesh.speedZoneStartId);
 
-   // Merge bot zone buffers from barriers, turrets, and forcefield projectors
-   // The Clipper library is the work horse here.  Its output is essential for the
-   // triangulation.  The output contains the upscaled Clipper points (you will need to downscale)
+   return true;
+}
 
-   // Keep track of all the non-navigable polygons to merge
-   Vector<Vector<Point> > blockingPolygons;
 
+// Start by finding all objects that'll matter for meshing the level, and copy out their geometry
+bool BotNavMeshZone::gatherBotZoneInput(GridDatabase *gameObjDatabase, const Rect *worldExtents, BotZoneInput &input)
+{
+   input.bounds = *worldExtents;
+   input.bounds.expandToInt(Point(LevelZoneBuffer, LevelZoneBuffer));      // Provide a little breathing room
 
-   // First merge all barrier polygons
-   if(barrierList.size() > 0)
+   // Make sure level isn't too big for zone generation, which uses 16 bit ints
+   if(input.bounds.getHeight() >= (F32)U16_MAX || input.bounds.getWidth() >= (F32)U16_MAX)
    {
-      Vector<Vector<Point> > barrierInputPolygons;
-      bool unionSucceeded = Barrier::unionBarriers(barrierList,  barrierInputPolygons);
-      if(!unionSucceeded)
-      {
-         logprintf(LogConsumer::LogLevelError, "Barriers failed to merge for bot zones!", U16_MAX);
-         return false;
-      }
-
-      // Now offset and fill inputPolygons directly
-      offsetPolygons(barrierInputPolygons, blockingPolygons, BufferRadius);
+      logprintf(LogConsumer::LogLevelError, "Level too big for zone generation! (max allowed dimension is %d)", U16_MAX);
+      return false;
    }
 
+   // Barriers get merged when the mesh is built; BarrierType is the server-side degenerate object for BarrierMaker and PolyWall
+   Vector<DatabaseObject *> barrierList;
+   gameObjDatabase->findObjects((TestFunc)isWallType, barrierList, *worldExtents);
+
+   for(S32 i = 0; i < barrierList.size(); i++)
+      if(barrierList[i]->getObjectTypeNumber() == BarrierTypeNumber)
+         input.barrierPolygons.push_back(*static_cast<Barrier *>(barrierList[i])->getCollisionPoly());
+
    // Add turrets
-   for (S32 i = 0; i < turretList.size(); i++)
+   Vector<DatabaseObject *> turretList;
+   gameObjDatabase->findObjects(TurretTypeNumber, turretList, *worldExtents);
+
+   for(S32 i = 0; i < turretList.size(); i++)
    {
       if(turretList[i]->getObjectTypeNumber() != TurretTypeNumber)
          continue;
 
       Turret *turret = static_cast<Turret *>(turretList[i]);
 
-      blockingPolygons.push_back(Vector<Point>());
-      turret->getBufferForBotZone(BufferRadius, blockingPolygons.last());
+      input.blockingPolygons.push_back(Vector<Point>());
+      turret->getBufferForBotZone(BufferRadius, input.blockingPolygons.last());
    }
 
    // Add forcefield projectors
-   for (S32 i = 0; i < forceFieldProjectorList.size(); i++)
+   Vector<DatabaseObject *> forceFieldProjectorList;
+   gameObjDatabase->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList, *worldExtents);
+
+   for(S32 i = 0; i < forceFieldProjectorList.size(); i++)
    {
       if(forceFieldProjectorList[i]->getObjectTypeNumber() != ForceFieldProjectorTypeNumber)
          continue;
 
       ForceFieldProjector *forceFieldProjector = static_cast<ForceFieldProjector *>(forceFieldProjectorList[i]);
 
-      blockingPolygons.push_back(Vector<Point>());
-
-      forceFieldProjector->getBufferForBotZone(BufferRadius, blockingPolygons.last());
+      input.blockingPolygons.push_back(Vector<Point>());
+      forceFieldProjector->getBufferForBotZone(BufferRadius, input.blockingPolygons.last());
    }
 
 
    // The next items are special items that need to be meshed, but must be
    // excluded from initial mesh for various reasons
 
-   // Add Cores - they are destructible
-   Vector<Vector<Point> > corePolygons;
+   // Add Cores - they are destructible and can open up new paths
+   Vector<DatabaseObject *> coreList;
+   gameObjDatabase->findObjects(CoreTypeNumber, coreList);
 
    // Increase buffer radius a little to handle the spinning corners
    F32 coreBufferRadius = BufferRadius + 5;
 
-   for (S32 i = 0; i < coreList.size(); i++)
+   for(S32 i = 0; i < coreList.size(); i++)
    {
       CoreItem *core = static_cast<CoreItem *>(coreList[i]);
 
-      corePolygons.push_back(Vector<Point>());
-      core->getBufferForBotZone(coreBufferRadius, corePolygons.last());
+      input.corePolygons.push_back(Vector<Point>());
+      core->getBufferForBotZone(coreBufferRadius, input.corePolygons.last());
    }
 
    // Add SpeedZones - they are one-way like areas
-   Vector<Vector<Point> > speedZonePolygons;
+   Vector<DatabaseObject *> speedZoneList;
+   gameObjDatabase->findObjects(SpeedZoneTypeNumber, speedZoneList);
 
-   for (S32 i = 0; i < speedZoneList.size(); i++)
+   for(S32 i = 0; i < speedZoneList.size(); i++)
    {
       SpeedZone *speedZone = static_cast<SpeedZone *>(speedZoneList[i]);
 
-      speedZonePolygons.push_back(Vector<Point>());
-      speedZone->getBufferForBotZone(BufferRadius, speedZonePolygons.last());
+      input.speedZonePolygons.push_back(Vector<Point>());
+      speedZone->getBufferForBotZone(BufferRadius, input.speedZonePolygons.last());
+   }
+
+   return true;
+}
+
+
+// Does the heavy lifting: Clipper, poly2tri, and Recast.  Touches nothing but its arguments, so it can run on any thread;
+// anything worth logging goes in messages, for the caller to log once it's back on the main thread.  Returns false, and
+// sets error, if the zones couldn't be built.
+bool BotNavMeshZone::buildBotZoneMesh(const BotZoneInput &input, BotZoneMesh &mesh, string &error, Vector<string> &messages)
+{
+#ifdef LOG_TIMER
+   U32 starttime = Platform::getRealMilliseconds();
+#endif
+
+   const Rect &bounds = input.bounds;
+
+   mesh.bounds = bounds;
+   mesh.zones.clear();
+   mesh.neighbors.clear();
+   mesh.speedZoneStartId = -1;
+
+   // Merge bot zone buffers from barriers, turrets, and forcefield projectors
+   // The Clipper library is the work horse here.  Its output is essential for the
+   // triangulation.  The output contains the upscaled Clipper points (you will need to downscale)
+
+   // Keep track of all the non-navigable polygons to merge
+   Vector<Vector<Point> > blockingPolygons;
+
+   // First merge all barrier polygons
+   if(input.barrierPolygons.size() > 0)
+   {
+      Vector<const Vector<Point> *> barrierPolygons(input.barrierPolygons.size());
+      for(S32 i = 0; i < input.barrierPolygons.size(); i++)
+         barrierPolygons.push_back(&input.barrierPolygons[i]);
+
+      Vector<Vector<Point> > barrierInputPolygons;
+      if(!mergePolys(barrierPolygons, barrierInputPolygons))
+      {
+         error = "Barriers failed to merge for bot zones!";
+         return false;
+      }
+
+      // Now offset and fill inputPolygons directly
+      offsetPolygons(barrierInputPolygons, blockingPolygons, BufferRadius);
    }
 
+   // Add turrets and forcefield projectors
+   for(S32 i = 0; i < input.blockingPolygons.size(); i++)
+      blockingPolygons.push_back(input.blockingPolygons[i]);
+
+   const Vector<Vector<Point> > &corePolygons = input.corePolygons;
+   const Vector<Vector<Point> > &speedZonePolygons = input.speedZonePolygons;
+
    bool hasCores = corePolygons.size() > 0;
    bool hasSpeedZones = speedZonePolygons.size() > 0;
 
@@ -900,7 +928,7 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    // Any failures
    if(!clipSuccess)
    {
-      logprintf(LogConsumer::LogLevelError, "Clipper failed to generate input polygons for bot zones!");
+      error = "Clipper failed to generate input polygons for bot zones!";
       return false;
    }
 
@@ -925,15 +953,15 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    // Any failures
    if(!meshSuccess)
    {
-      logprintf(LogConsumer::LogLevelError, "Bot zone mesh failed to generate!");
+      error = "Bot zone mesh failed to generate!";
       return false;
    }
 
    // Merge meshes
-   rcPolyMesh mesh;
+   rcPolyMesh polyMesh;
    // Reapply bounds
-   mesh.offsetX = -1 * (int)round(bounds.min.x);
-   mesh.offsetY = -1 * (int)round(bounds.min.y);
+   polyMesh.offsetX = -1 * (int)round(bounds.min.x);
+   polyMesh.offsetY = -1 * (int)round(bounds.min.y);
 
    // Build up references to send to the merge method
    const S32 meshCount = 3;
@@ -944,11 +972,11 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    meshes[2] = &szMesh;
 
    // Do the merge
-   bool mergeSuccess = rcMergePolyMeshes(meshes, meshCount, mesh);
+   bool mergeSuccess = rcMergePolyMeshes(meshes, meshCount, polyMesh);
 
    if(!mergeSuccess)
    {
-      logprintf(LogConsumer::LogLevelError, "Bot zone mesh failed to merge!");
+      error = "Bot zone mesh failed to merge!";
       return false;
    }
 
@@ -963,12 +991,9 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    U32 done2 = Platform::getRealMilliseconds();  // poly2tri and Recast done
 #endif
 
-   // If Recast succeeded, our triangles were successfully aggregatedinto zones,
+   // If Recast succeeded, our triangles were successfully aggregated into zones,
    // but will need further polishing.
 
-   BotNavMeshZone *botzone = NULL;
-   bool addedZones = false;
-
    const S32 bytesPerVertex = sizeof(U16);      // Recast coords are U16s
 
    // Instead of using polyMeshToPolygons() we choose to keep the Recast mesh to
@@ -976,82 +1001,150 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    //
    // This polyToZoneMap is required for that
    Vector<S32> polyToZoneMap;
-   polyToZoneMap.resize(mesh.npolys);
+   polyToZoneMap.resize(polyMesh.npolys);
 
-   // Generate BotNavMeshZone objects for each valid polygon
-   for(S32 i = 0; i < mesh.npolys; i++)
+   // Generate a zone outline for each valid polygon; a zone's ID is its index in zones
+   for(S32 i = 0; i < polyMesh.npolys; i++)
    {
-      S32 j = 0;
-      botzone = NULL;
+      polyToZoneMap[i] = -1;
+
+      if(mesh.zones.size() >= MAX_ZONES)      // Don't add too many zones...
+         continue;
 
-      while(j < mesh.nvp)
+      Vector<Point> outline;
+
+      for(S32 j = 0; j < polyMesh.nvp; j++)
       {
-         if(mesh.polys[(i * mesh.nvp + j)] == RC_MESH_NULL_IDX)
+         if(polyMesh.polys[(i * polyMesh.nvp + j)] == RC_MESH_NULL_IDX)
             break;
 
-         const U16 *vert = &mesh.verts[mesh.polys[(i * mesh.nvp + j)] * bytesPerVertex];
+         const U16 *vert = &polyMesh.verts[polyMesh.polys[(i * polyMesh.nvp + j)] * bytesPerVertex];
 
          if(vert[0] == RC_MESH_NULL_IDX)
             break;
 
-         if(botZoneDatabase->getObjectCount() >= MAX_ZONES)      // Don't add too many zones...
-            break;
-
-         if(j == 0)     // New poly, add new zone
-         {
-            // Create new zone, give it an ID that is +1 to the highest already in the database
-            // This assumes zones are already added sequentially in this manner
-            botzone = new BotNavMeshZone(botZoneDatabase->getObjectCount());
-
-            // Triangulation only needed for display on local client... it is expensive to compute for so many zones,
-            // and there is really no point if they will never be viewed.  Once disabled, triangluation cannot be re-enabled
-            // for this object.
-            if(!triangulateZones)
-               botzone->disableTriangulation();
-
-            polyToZoneMap[i] = botzone->getZoneId();
-         }
-
-         botzone->addVert(Point(vert[0] - mesh.offsetX, vert[1] - mesh.offsetY));
-         j++;
+         outline.push_back(Point(vert[0] - polyMesh.offsetX, vert[1] - polyMesh.offsetY));
       }
 
-      if(botzone != NULL)
+      if(outline.size() > 0)
       {
-         botzone->addToZoneDatabase(botZoneDatabase);
-         addedZones = true;
+         polyToZoneMap[i] = mesh.zones.size();
+         mesh.zones.push_back(outline);
       }
    }
 
-   // Repopulate allZones with the zones we modified above
-   if(addedZones)
-      populateZoneList(botZoneDatabase, allZones);
-
+   mesh.neighbors.resize(mesh.zones.size());
 
    // Build connections between zones
    // Build connections for standard zones
-   buildConnectionsRecastStyle(allZones, mesh, polyToZoneMap,
+   buildConnectionsRecastStyle(mesh.neighbors, polyMesh, polyToZoneMap,
          coreRecastPolyStartIdx, szRecastPolyStartIdx);
 
+   // SpeedZones need special connections too, but they can't be made until the zones are in a database
+   if(szRecastPolyStartIdx < polyToZoneMap.size())
+      mesh.speedZoneStartId = polyToZoneMap[szRecastPolyStartIdx];
+
+#ifdef LOG_TIMER
+   U32 done3 = Platform::getRealMilliseconds();  // Done
+   messages.push_back("Built " + itos(mesh.zones.size()) + " zones!");
+   messages.push_back("Timings: " + itos(done1-starttime) + " " + itos(done2-done1) + " " + itos(done3-done2));
+#endif
+
+   return true;
+}
+
+
+// Create a BotNavMeshZone object for each zone in mesh, along with the connections between them
+void BotNavMeshZone::addBotZones(const BotZoneMesh &mesh, GridDatabase *botZoneDatabase, Vector<BotNavMeshZone *> *allZones,
+                                 bool triangulateZones)
+{
+   // Clearing allZones *also* clears the botZoneDatabase, which must be empty for the zone IDs to line up
+   allZones->deleteAndClear();
+
+   botZoneDatabase->resizeGrid(mesh.bounds);      // Size the zone database to the level before we start filling it
+
+   for(S32 i = 0; i < mesh.zones.size(); i++)
+   {
+      // Give each zone an ID that is +1 to the highest already in the database
+      BotNavMeshZone *botzone = new BotNavMeshZone(botZoneDatabase->getObjectCount());
+
+      // Triangulation only needed for display on local client... it is expensive to compute for so many zones,
+      // and there is really no point if they will never be viewed.  Once disabled, triangluation cannot be re-enabled
+      // for this object.
+      if(!triangulateZones)
+         botzone->disableTriangulation();
+
+      for(S32 j = 0; j < mesh.zones[i].size(); j++)
+         botzone->addVert(mesh.zones[i][j]);
+
+      botzone->mNeighbors = mesh.neighbors[i];
+      botzone->addToZoneDatabase(botZoneDatabase);
+   }
+
+   // Repopulate allZones with the zones we added above
+   populateZoneList(botZoneDatabase, allZones);
+}
+
+
+// Teleporters and SpeedZones make one way connections between zones, which we can only find once the zones are in a database
+void BotNavMeshZone::linkBotZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
+                                  S32 speedZoneStartId)
+{
    // Teleporters require special connections
+   fillVector.clear();
+   gameObjDatabase->findObjects(TeleporterTypeNumber, fillVector);
+
+   Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
+   pair<Point, const Vector<Point> *> teldat;
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      Teleporter *teleporter = static_cast<Teleporter *>(fillVector[i]);
+
+      teldat.first  = teleporter->getPos();
+      teldat.second = teleporter->getDestList();
+
+      teleporterData.push_back(teldat);
+   }
+
    linkConnectionsTeleporters(botZoneDatabase, teleporterData);
 
    // And SpeedZones, if they exist
-   if(szRecastPolyStartIdx < polyToZoneMap.size())
-   {
-      S32 szBotZoneStartId = polyToZoneMap[szRecastPolyStartIdx];
+   if(speedZoneStartId < 0)
+      return;
 
-      linkConnectionsSpeedZones(gameObjDatabase, botZoneDatabase, allZones,
-            speedZoneList, speedZonePolygons, szBotZoneStartId);
+   Vector<DatabaseObject *> speedZoneList;
+   gameObjDatabase->findObjects(SpeedZoneTypeNumber, speedZoneList);
+
+   Vector<Vector<Point> > speedZonePolygons(speedZoneList.size());   // Aligned with speedZoneList
+
+   for(S32 i = 0; i < speedZoneList.size(); i++)
+   {
+      speedZonePolygons.push_back(Vector<Point>());
+      static_cast<SpeedZone *>(speedZoneList[i])->getBufferForBotZone(BufferRadius, speedZonePolygons.last());
    }
 
-#ifdef LOG_TIMER
-   U32 done3 = Platform::getRealMilliseconds();  // Done
-   logprintf("Built %d zones!", botZoneDatabase->getObjectCount());
-   logprintf("Timings: %d %d %d", done1-starttime, done2-done1, done3-done2);
-#endif
+   linkConnectionsSpeedZones(gameObjDatabase, botZoneDatabase, allZones, speedZoneList, speedZonePolygons, speedZoneStartId);
+}
 
-   return true;
+
+// Copy the connections out of allZones, teleporters and SpeedZones included, so the whole lot can be cached
+void BotNavMeshZone::getBotZoneNeighbors(const Vector<BotNavMeshZone *> *allZones, BotZoneMesh &mesh)
+{
+   mesh.neighbors.resize(allZones->size());
+
+   for(S32 i = 0; i < allZones->size(); i++)
+      mesh.neighbors[i] = allZones->get(i)->mNeighbors;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+BotZoneMesh::BotZoneMesh()
+{
+   speedZoneStartId = -1;
 }
 
 
@@ -1070,29 +1163,82 @@ NeighboringZone::NeighboringZone()
 ////////////////////////////////////////
 
 
-// Rough guess as to distance from fromZone to toZone
-F32 AStar::heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 toZone)
+// Rough guess as to distance from fromZone to toZone; in a corridor, by way of the clusters along it
+F32 AStar::heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 toZone, const AStarCorridor *corridor)
 {
+   if(corridor)
+   {
+      S32 cluster = corridor->zoneClusters->get(fromZone);
+
+      if(cluster != corridor->targetCluster)
+         return zones->get(fromZone)->getCenter().distanceTo(corridor->clusterCenters->get(cluster)) +
+                corridor->costToGo[cluster];
+   }
+
    return zones->get(fromZone)->getCenter().distanceTo(zones->get(toZone)->getCenter());
 }
 
 
+// Constructor
+AStarScratch::AStarScratch()
+{
+   onClosedList = 0;
+   onOpenList = 0;
+}
+
+
+void AStarScratch::prepare(S32 zoneCount)
+{
+   S32 oldSize = whichList.size();
+
+   if(zoneCount <= oldSize)
+      return;
+
+   whichList.resize(zoneCount);
+   for(S32 i = oldSize; i < zoneCount; i++)
+      whichList[i] = 0;
+
+   // Heap entries are numbered from 1, and each zone is opened at most once per search
+   openList.resize(zoneCount + 2);
+   openZone.resize(zoneCount + 1);
+   parentZones.resize(zoneCount);
+
+   Fcost.resize(zoneCount + 1);
+   Gcost.resize(zoneCount);
+   Hcost.resize(zoneCount + 1);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+AStarCorridor::AStarCorridor()
+{
+   zoneClusters = NULL;
+   clusterCenters = NULL;
+   targetCluster = -1;
+   mark = 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
 // Returns a path, including the startZone and targetZone 
-Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target)
+Vector<Point> AStar::findPath(AStarScratch &scratch, const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone,
+                              const Point &target, const AStarCorridor *corridor)
 {
-   // Because of these variables...
-   static U16 onClosedList = 0;
-   static U16 onOpenList;
+   scratch.prepare(zones->size());
 
-   // ...these arrays can be reused without further initialization
-   static U16 whichList[MAX_ZONES];       // Record whether a zone is on the open or closed list
-   static S16 openList[MAX_ZONES + 1]; 
-   static S16 openZone[MAX_ZONES]; 
-   static S16 parentZones[MAX_ZONES]; 
+   U16 *whichList   = scratch.whichList.address();
+   S16 *openList    = scratch.openList.address();
+   S16 *openZone    = scratch.openZone.address();
+   S16 *parentZones = scratch.parentZones.address();
 
-   static F32 Fcost[MAX_ZONES];   
-   static F32 Gcost[MAX_ZONES];    
-   static F32 Hcost[MAX_ZONES];   
+   F32 *Fcost = scratch.Fcost.address();
+   F32 *Gcost = scratch.Gcost.address();
+   F32 *Hcost = scratch.Hcost.address();
 
    S16 numberOfOpenListItems = 0;
    bool foundPath;
@@ -1104,17 +1250,20 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
    // This block here lets us repeatedly reuse the whichList array without resetting it or recreating it
    // which, for larger numbers of zones should be a real time saver.  It's not clear if it is particularly
    // more efficient for the zone counts we typically see in Bitfighter levels.
-   if(onClosedList > U16_MAX - 3 ) // Reset whichList when we've run out of headroom
+   if(scratch.onClosedList > U16_MAX - 3 ) // Reset whichList when we've run out of headroom
    {
-      for(S32 i = 0; i < MAX_ZONES; i++) 
+      for(S32 i = 0; i < scratch.whichList.size(); i++) 
          whichList[i] = 0;
-      onClosedList = 0;   
+      scratch.onClosedList = 0;   
    }
-   onClosedList = onClosedList + 2; // Changing the values of onOpenList and onClosed list is faster than redimming whichList() array
-   onOpenList = onClosedList - 1;
+   scratch.onClosedList = scratch.onClosedList + 2; // Changing the values of onOpenList and onClosed list is faster than redimming whichList() array
+   scratch.onOpenList = scratch.onClosedList - 1;
+
+   const U16 onClosedList = scratch.onClosedList;
+   const U16 onOpenList   = scratch.onOpenList;
 
    Gcost[startZone] = 0;         // That's the cost of going from the startZone to the startZone!
-   Fcost[0] = Hcost[0] = heuristic(zones, startZone, targetZone);
+   Fcost[0] = Hcost[0] = heuristic(zones, startZone, targetZone, corridor);
 
    numberOfOpenListItems = 1;    // Start with one open item: the startZone
 
@@ -1188,11 +1337,11 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
          // Add these adjacent child squares to the open list
          //   for later consideration if appropriate.
 
-         Vector<NeighboringZone> neighboringZones = zones->get(parentZone)->mNeighbors;
+         const Vector<NeighboringZone> &neighboringZones = zones->get(parentZone)->mNeighbors;
 
          for(S32 a = 0; a < neighboringZones.size(); a++)
          {
-            NeighboringZone zone = neighboringZones[a];
+            const NeighboringZone &zone = neighboringZones[a];
             S32 zoneID = zone.zoneID;
 
             //   Check if zone is already on the closed list (items on the closed list have
@@ -1200,6 +1349,10 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
             if(whichList[zoneID] == onClosedList) 
                continue;
 
+            // Stay inside the corridor, if we've been given one
+            if(corridor && corridor->clusterMarks[corridor->zoneClusters->get(zoneID)] != corridor->mark)
+               continue;
+
             //   Add zone to the open list if it's not already on it
             TNLAssert(newOpenListItemID < MAX_ZONES, "Too many nav zones... try increasing MAX_ZONES!");
             if(whichList[zoneID] != onOpenList && newOpenListItemID < MAX_ZONES) 
@@ -1210,7 +1363,7 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
                openList[m] = newOpenListItemID;             // Place the new open list item (actually, its ID#) at the bottom of the heap
                openZone[newOpenListItemID] = zoneID;        // Record zone as a newly opened
 
-               Hcost[openList[m]] = heuristic(zones, zoneID, targetZone);
+               Hcost[openList[m]] = heuristic(zones, zoneID, targetZone, corridor);
                Gcost[zoneID] = Gcost[parentZone] + zone.distTo;
                Fcost[openList[m]] = Gcost[zoneID] + Hcost[openList[m]];
                parentZones[zoneID] = parentZone; 
@@ -9,6 +9,8 @@
 #include "gridDB.h"            // Parent
 #include "../recast/Recast.h"  // for rcPolyMesh;
 
+#include <string>
+
 namespace Zap
 {
 
@@ -41,6 +43,33 @@ public:
 
 class ServerGame;
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Everything about a level that shapes its bot zones, copied out of the game so the zones can be built on another thread
+struct BotZoneInput
+{
+   Rect bounds;                                    // World extents, plus LevelZoneBuffer
+   Vector<Vector<Point> > barrierPolygons;         // Wall collision polys, not yet merged or buffered
+   Vector<Vector<Point> > blockingPolygons;        // Buffered turrets and forcefield projectors
+   Vector<Vector<Point> > corePolygons;            // Buffered cores
+   Vector<Vector<Point> > speedZonePolygons;       // Buffered speedzones
+};
+
+
+// A level's bot zones and the connections between them, as plain data that can be built anywhere and kept on disk.
+// Zone ids are indices into zones and neighbors.
+struct BotZoneMesh
+{
+   BotZoneMesh();          // Constructor
+
+   Rect bounds;                                    // Extents of the zone database
+   Vector<Vector<Point> > zones;                   // Outline of each zone
+   Vector<Vector<NeighboringZone> > neighbors;     // Connections out of each zone
+   S32 speedZoneStartId;                           // First zone under a speedzone, or -1 if there are none
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -86,7 +115,17 @@ public:
    static bool buildBotMeshZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
                                  const Rect *worldExtents, bool triangulateZones);
 
-   static bool buildConnectionsRecastStyle(const Vector<BotNavMeshZone *> *allZones,
+   // buildBotMeshZones() in stages, so the slow part can be done off the main thread, and the result kept
+   static bool gatherBotZoneInput(GridDatabase *gameObjDatabase, const Rect *worldExtents, BotZoneInput &input);
+   static bool buildBotZoneMesh(const BotZoneInput &input, BotZoneMesh &mesh, string &error,       // Thread safe
+                                Vector<string> &messages);
+   static void addBotZones(const BotZoneMesh &mesh, GridDatabase *botZoneDatabase, Vector<BotNavMeshZone *> *allZones,
+                           bool triangulateZones);
+   static void linkBotZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
+                            S32 speedZoneStartId);
+   static void getBotZoneNeighbors(const Vector<BotNavMeshZone *> *allZones, BotZoneMesh &mesh);
+
+   static bool buildConnectionsRecastStyle(Vector<Vector<NeighboringZone> > &neighbors,
          rcPolyMesh &mesh, const Vector<S32> &polyToZoneMap, S32 coreRecastPolyStartIdx,
          S32 szRecastPolyStartIdx);
 };
@@ -95,15 +134,58 @@ public:
 ////////////////////////////////////////
 ////////////////////////////////////////
 
+// Working space for one AStar search.  A search touches nothing else that it writes to, so searches with a scratch each
+// can run side by side, on as many threads as you like.
+class AStarScratch
+{
+public:
+   AStarScratch();      // Constructor
+
+   void prepare(S32 zoneCount);     // Make room to search zoneCount zones
+
+   // Because of these variables...
+   U16 onClosedList;
+   U16 onOpenList;
+
+   // ...these arrays can be reused without further initialization
+   Vector<U16> whichList;           // Record whether a zone is on the open or closed list
+   Vector<S16> openList;
+   Vector<S16> openZone;
+   Vector<S16> parentZones;
+
+   Vector<F32> Fcost;
+   Vector<F32> Gcost;
+   Vector<F32> Hcost;
+};
+
+
+// Keeps a search within a corridor of zone clusters, and steers it along them: rather than heading straight for the
+// target, it heads for the center of the next cluster along the way
+struct AStarCorridor
+{
+   AStarCorridor();     // Constructor
+
+   const Vector<U16> *zoneClusters;       // Which cluster each zone is in
+   const Vector<Point> *clusterCenters;
+   S32 targetCluster;
+
+   // Only clusters marked with mark are in the corridor; their costToGo is about how far it is from their center to
+   // the target
+   Vector<U32> clusterMarks;
+   Vector<F32> costToGo;
+   U32 mark;
+};
+
+
 class AStar
 {
 private:
-   static F32 heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 toZone);
+   static F32 heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 toZone, const AStarCorridor *corridor);
    static Point findGateway(const Vector<BotNavMeshZone *> *zones, S32 zone1, S32 zone2);
 
 public:
-   static Vector<Point> findPath (const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target);
-   
+   static Vector<Point> findPath(AStarScratch &scratch, const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone,
+                                 const Point &target, const AStarCorridor *corridor = NULL);
 };
 
 
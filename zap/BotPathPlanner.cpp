@@ -0,0 +1,361 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotPathPlanner.h"
+
+#include "BotNavMeshZone.h"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace Zap
+{
+
+// Everything one search writes to
+struct BotPathPlanner::Scratch
+{
+   AStarScratch zoneSearch;
+   AStarCorridor corridor;
+
+   Vector<F32> clusterCost;
+   Vector<S32> clusterParent;
+   Vector<U8> clusterClosed;
+};
+
+
+// Constructor
+BotPathPlanner::BotPathPlanner(const Vector<BotNavMeshZone *> *zones, S32 maxCachedPlans)
+{
+   mZones = zones;
+   mMaxCachedPlans = maxCachedPlans > 0 ? maxCachedPlans : 1;
+
+   buildClusters();
+}
+
+
+// Destructor
+BotPathPlanner::~BotPathPlanner()
+{
+   mScratchPool.deleteAndClear();
+}
+
+
+void BotPathPlanner::reset()
+{
+   mMutex.lock();
+
+   mCachedPlans.clear();
+   mLru.clear();
+   buildClusters();
+
+   mMutex.unlock();
+}
+
+
+// Grow clusters outward from each zone not yet in one, until they're ClusterSize zones big, or run out of neighbors
+void BotPathPlanner::buildClusters()
+{
+   mZoneClusters.clear();
+   mClusterCenters.clear();
+   mClusterLinks.clear();
+
+   S32 zoneCount = mZones->size();
+
+   if(zoneCount < HierarchicalZoneCount)
+      return;
+
+   mZoneClusters.resize(zoneCount);
+   for(S32 i = 0; i < zoneCount; i++)
+      mZoneClusters[i] = U16_MAX;
+
+   Vector<S32> members;
+
+   for(S32 seed = 0; seed < zoneCount; seed++)
+   {
+      if(mZoneClusters[seed] != U16_MAX)
+         continue;
+
+      U16 cluster = U16(mClusterCenters.size());
+
+      members.clear();
+      members.push_back(seed);
+      mZoneClusters[seed] = cluster;
+
+      for(S32 i = 0; i < members.size() && members.size() < ClusterSize; i++)
+      {
+         const Vector<NeighboringZone> &neighbors = mZones->get(members[i])->mNeighbors;
+
+         for(S32 j = 0; j < neighbors.size() && members.size() < ClusterSize; j++)
+            if(mZoneClusters[neighbors[j].zoneID] == U16_MAX)
+            {
+               mZoneClusters[neighbors[j].zoneID] = cluster;
+               members.push_back(neighbors[j].zoneID);
+            }
+      }
+
+      Point center;
+      for(S32 i = 0; i < members.size(); i++)
+         center += mZones->get(members[i])->getCenter();
+
+      mClusterCenters.push_back(center / F32(members.size()));
+   }
+
+   // Link clusters wherever one of their zones leads to the other's
+   mClusterLinks.resize(mClusterCenters.size());
+
+   for(S32 i = 0; i < zoneCount; i++)
+   {
+      U16 from = mZoneClusters[i];
+      const Vector<NeighboringZone> &neighbors = mZones->get(i)->mNeighbors;
+
+      for(S32 j = 0; j < neighbors.size(); j++)
+      {
+         U16 to = mZoneClusters[neighbors[j].zoneID];
+         if(to == from)
+            continue;
+
+         Vector<ClusterLink> &links = mClusterLinks[from];
+
+         bool found = false;
+         for(S32 k = 0; k < links.size() && !found; k++)
+            found = links[k].cluster == to;
+
+         if(!found)
+         {
+            ClusterLink link;
+            link.cluster = to;
+            link.cost = mClusterCenters[from].distanceTo(mClusterCenters[to]);
+            links.push_back(link);
+         }
+      }
+   }
+}
+
+
+// Adds cluster to the corridor, unless it's there already with a shorter way to go
+static void setCostToGo(AStarCorridor &corridor, S32 cluster, F32 costToGo)
+{
+   if(corridor.clusterMarks[cluster] == corridor.mark && corridor.costToGo[cluster] <= costToGo)
+      return;
+
+   corridor.clusterMarks[cluster] = corridor.mark;
+   corridor.costToGo[cluster] = costToGo;
+}
+
+
+// A* over the clusters.  If there's a way through, marks the clusters along it, and those beside them, as the corridor
+// the zone search may use.  Returns false if there's no way through, in which case there's no zone path either.
+bool BotPathPlanner::findCorridor(Scratch &scratch, S32 startZone, S32 targetZone) const
+{
+   S32 clusterCount = mClusterCenters.size();
+   S32 startCluster = mZoneClusters[startZone];
+   S32 targetCluster = mZoneClusters[targetZone];
+
+   scratch.clusterCost.resize(clusterCount);
+   scratch.clusterParent.resize(clusterCount);
+   scratch.clusterClosed.resize(clusterCount);
+
+   for(S32 i = 0; i < clusterCount; i++)
+   {
+      scratch.clusterCost[i] = F32_MAX;
+      scratch.clusterClosed[i] = false;
+   }
+
+   typedef pair<F32, S32> OpenCluster;    // Estimated total cost, cluster
+   priority_queue<OpenCluster, vector<OpenCluster>, greater<OpenCluster> > open;
+
+   const Point &targetCenter = mClusterCenters[targetCluster];
+
+   scratch.clusterCost[startCluster] = 0;
+   scratch.clusterParent[startCluster] = -1;
+   open.push(OpenCluster(mClusterCenters[startCluster].distanceTo(targetCenter), startCluster));
+
+   bool found = false;
+
+   while(!open.empty())
+   {
+      S32 cluster = open.top().second;
+      open.pop();
+
+      if(cluster == targetCluster)
+      {
+         found = true;
+         break;
+      }
+
+      if(scratch.clusterClosed[cluster])     // Already reached more cheaply
+         continue;
+
+      scratch.clusterClosed[cluster] = true;
+
+      const Vector<ClusterLink> &links = mClusterLinks[cluster];
+
+      for(S32 i = 0; i < links.size(); i++)
+      {
+         S32 next = links[i].cluster;
+         F32 cost = scratch.clusterCost[cluster] + links[i].cost;
+
+         if(scratch.clusterClosed[next] || cost >= scratch.clusterCost[next])
+            continue;
+
+         scratch.clusterCost[next] = cost;
+         scratch.clusterParent[next] = cluster;
+         open.push(OpenCluster(cost + mClusterCenters[next].distanceTo(targetCenter), next));
+      }
+   }
+
+   if(!found)
+      return false;
+
+   AStarCorridor &corridor = scratch.corridor;
+
+   corridor.zoneClusters = &mZoneClusters;
+   corridor.clusterCenters = &mClusterCenters;
+   corridor.targetCluster = targetCluster;
+
+   if(corridor.clusterMarks.size() < clusterCount || corridor.mark == U32_MAX)
+   {
+      corridor.clusterMarks.resize(clusterCount);
+      corridor.costToGo.resize(clusterCount);
+
+      for(S32 i = 0; i < clusterCount; i++)
+         corridor.clusterMarks[i] = 0;
+
+      corridor.mark = 0;
+   }
+
+   corridor.mark++;
+
+   // Work back from the target, adding up the distance as we go
+   F32 costToGo = 0;
+
+   for(S32 cluster = targetCluster; cluster != -1; cluster = scratch.clusterParent[cluster])
+   {
+      S32 parent = scratch.clusterParent[cluster];
+
+      setCostToGo(corridor, cluster, costToGo);
+
+      const Vector<ClusterLink> &links = mClusterLinks[cluster];
+      for(S32 i = 0; i < links.size(); i++)
+         setCostToGo(corridor, links[i].cluster, costToGo + links[i].cost);
+
+      if(parent != -1)
+         costToGo += mClusterCenters[parent].distanceTo(mClusterCenters[cluster]);
+   }
+
+   return true;
+}
+
+
+FlightPlanPtr BotPathPlanner::computePath(Scratch &scratch, S32 startZone, S32 targetZone) const
+{
+   Point target = mZones->get(targetZone)->getCenter();
+
+   if(mZoneClusters.size() > 0)
+   {
+      if(!findCorridor(scratch, startZone, targetZone))
+         return FlightPlanPtr(new Vector<Point>());
+
+      Vector<Point> path = AStar::findPath(scratch.zoneSearch, mZones, startZone, targetZone, target, &scratch.corridor);
+
+      // Zones in a cluster don't always lead to one another, so the corridor can be a dead end; then we look everywhere
+      if(path.size() > 0)
+         return FlightPlanPtr(new Vector<Point>(path));
+   }
+
+   return FlightPlanPtr(new Vector<Point>(AStar::findPath(scratch.zoneSearch, mZones, startZone, targetZone, target)));
+}
+
+
+BotPathPlanner::Scratch *BotPathPlanner::acquireScratch()
+{
+   if(mScratchPool.size() == 0)
+      return new Scratch();
+
+   Scratch *scratch = mScratchPool.last();
+   mScratchPool.pop_back();
+
+   return scratch;
+}
+
+
+void BotPathPlanner::releaseScratch(Scratch *scratch)
+{
+   mScratchPool.push_back(scratch);
+}
+
+
+// Returns an empty path if there's no way from startZone to targetZone
+FlightPlanPtr BotPathPlanner::findPath(S32 startZone, S32 targetZone)
+{
+   if(startZone < 0 || startZone >= mZones->size() || targetZone < 0 || targetZone >= mZones->size())
+      return FlightPlanPtr(new Vector<Point>());
+
+   U32 key = (U32(startZone) << 16) | U32(targetZone);
+
+   mMutex.lock();
+
+   map<U32, CachedPlan>::iterator it = mCachedPlans.find(key);
+   if(it != mCachedPlans.end())
+   {
+      mLru.splice(mLru.begin(), mLru, it->second.lruPos);     // Move to the front
+      FlightPlanPtr plan = it->second.plan;
+
+      mMutex.unlock();
+      return plan;
+   }
+
+   Scratch *scratch = acquireScratch();
+   mMutex.unlock();
+
+   // Search without holding the lock, so other threads can search too
+   FlightPlanPtr plan = computePath(*scratch, startZone, targetZone);
+
+   mMutex.lock();
+
+   releaseScratch(scratch);
+
+   it = mCachedPlans.find(key);
+   if(it != mCachedPlans.end())     // Someone else got here first; hand out theirs, so everyone shares the one path
+      plan = it->second.plan;
+   else
+   {
+      mLru.push_front(key);
+
+      CachedPlan &cached = mCachedPlans[key];
+      cached.plan = plan;
+      cached.lruPos = mLru.begin();
+
+      while((S32)mCachedPlans.size() > mMaxCachedPlans)
+      {
+         mCachedPlans.erase(mLru.back());
+         mLru.pop_back();
+      }
+   }
+
+   mMutex.unlock();
+
+   return plan;
+}
+
+
+S32 BotPathPlanner::getClusterCount() const
+{
+   return mClusterCenters.size();
+}
+
+
+S32 BotPathPlanner::getCachedPlanCount()
+{
+   mMutex.lock();
+   S32 count = (S32)mCachedPlans.size();
+   mMutex.unlock();
+
+   return count;
+}
+
+
+};
@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_PATH_PLANNER_H_
+#define _BOT_PATH_PLANNER_H_
+
+#include "Point.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlThread.h"
+
+#include <list>
+#include <map>
+#include <memory>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class BotNavMeshZone;
+
+// Zone-to-zone paths, as AStar::findPath makes them: the target zone's center first, and the start zone's center last.
+// Once made they are never changed, so any number of robots can follow the same one.
+typedef shared_ptr<const Vector<Point> > FlightPlanPtr;
+
+
+// Finds paths between bot zones for all the robots in a game, remembering the ones asked for most recently.  findPath()
+// can be called from any thread; each search gets scratch space of its own, and only the cache is shared.
+//
+// On big levels, zones are grouped into clusters of neighbors, and a search first finds its way through the clusters,
+// then looks for a zone path only in the clusters along that route and those beside them.  That keeps long searches
+// from wandering over the whole map.
+class BotPathPlanner
+{
+private:
+   struct ClusterLink
+   {
+      U16 cluster;
+      F32 cost;
+   };
+
+   typedef list<U32> LruList;
+
+   struct CachedPlan
+   {
+      FlightPlanPtr plan;
+      LruList::iterator lruPos;
+   };
+
+   struct Scratch;
+
+   const Vector<BotNavMeshZone *> *mZones;
+   S32 mMaxCachedPlans;
+
+   Vector<U16> mZoneClusters;                      // Which cluster each zone is in; empty if we aren't using clusters
+   Vector<Point> mClusterCenters;
+   Vector<Vector<ClusterLink> > mClusterLinks;     // One way, like the zone connections they come from
+
+   Mutex mMutex;                                   // Guards everything below
+   map<U32, CachedPlan> mCachedPlans;
+   LruList mLru;                                   // Keys of mCachedPlans, most recently used first
+   Vector<Scratch *> mScratchPool;
+
+   void buildClusters();
+   bool findCorridor(Scratch &scratch, S32 startZone, S32 targetZone) const;
+   FlightPlanPtr computePath(Scratch &scratch, S32 startZone, S32 targetZone) const;
+
+   Scratch *acquireScratch();
+   void releaseScratch(Scratch *scratch);
+
+public:
+   enum {
+      ClusterSize = 32,                // Zones per cluster, give or take
+      HierarchicalZoneCount = 1000,    // Levels with fewer zones than this are searched zone by zone
+      MaxCachedPlans = 2048,           // Least recently used plans are dropped beyond this
+   };
+
+   explicit BotPathPlanner(const Vector<BotNavMeshZone *> *zones, S32 maxCachedPlans = MaxCachedPlans);  // Constructor
+   virtual ~BotPathPlanner();
+
+   void reset();                       // Call whenever the zones change; not while anyone is searching!
+
+   FlightPlanPtr findPath(S32 startZone, S32 targetZone);
+
+   S32 getClusterCount() const;
+   S32 getCachedPlanCount();
+};
+
+
+};
+
+#endif
@@ -0,0 +1,578 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotWorkerPool.h"
+
+#include "LuaScriptRunner.h"
+#include "robot.h"
+
+#include "tnlLog.h"
+#include "tnlRandom.h"
+
+#include <string.h>
+
+namespace Zap
+{
+
+// Constructor
+BotRandom::BotRandom(U64 seed)
+{
+   mState = seed ? seed : 0x9E3779B97F4A7C15ULL;     // Zero would get us nothing but zeros
+}
+
+
+// xorshift64*; quick, and plenty random enough for robots
+U32 BotRandom::readU32()
+{
+   mState ^= mState >> 12;
+   mState ^= mState << 25;
+   mState ^= mState >> 27;
+
+   return U32((mState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+
+F32 BotRandom::readF()
+{
+   return F32(readU32() >> 8) / F32(1 << 24);
+}
+
+
+S32 BotRandom::readI(S32 min, S32 max)
+{
+   TNLAssert(min <= max, "Bad range!");
+   return min + S32(readU32() % U32(max - min + 1));
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Set on each worker thread, for the job it's running
+static ThreadStorage &getCurrentJobs()
+{
+   static ThreadStorage jobs;
+   return jobs;
+}
+
+
+// Set on each worker thread for as long as it runs
+static ThreadStorage &getCurrentWorkers()
+{
+   static ThreadStorage workers;
+   return workers;
+}
+
+
+class BotWorkerPool::WorkerThread : public Thread
+{
+private:
+   BotWorkerPool *mPool;
+   Worker *mWorker;
+
+public:
+   WorkerThread(BotWorkerPool *pool, Worker *worker)
+   {
+      mPool = pool;
+      mWorker = worker;
+   }
+
+   // Thinks whenever it's woken, until it's told to stop
+   U32 run()
+   {
+      getCurrentWorkers().set(mWorker);
+      GridDatabase::setThreadQueryContext(&mWorker->queryContext);
+
+      while(true)
+      {
+         mWorker->wakeup.wait();
+
+         if(mWorker->stopping)
+            break;
+
+         mPool->runJobs(mWorker);
+         mWorker->done.increment();
+      }
+
+      mWorker->done.increment();
+      delete this;
+
+      return 0;
+   }
+};
+
+
+// Methods that only read the game, and touch nothing shared but the grid database and Lua proxies, which are safe to
+// use from any thread; these run while robots think.  Everything else gets deferred, or serialized, below.  Check a
+// method's C++ before adding it here: a name that sounds like a getter is no proof.
+static const char *threadSafeMethods[] = {
+   "canSeePoint", "containsPoint", "findAllObjects", "findAllObjectsInArea", "findClosestEnemy", "findObjectById",
+   "findVisibleObjects", "getActiveWeapon", "getAimAngle", "getAllObjects", "getAngle", "getAnglePt", "getCaptureZone",
+   "getColor", "getCurrentHealth", "getDelay", "getDest", "getDestCount", "getDir", "getDisabledThreshold", "getEnergy",
+   "getEngineered", "getEventScore", "getFiringSolution", "getFlagCount", "getFullHealth", "getGameTimeRemaining",
+   "getGameTimeTotal", "getGameType", "getGameTypeName", "getGeom", "getGlobal", "getHealRate", "getHealth", "getId",
+   "getIndex", "getInterceptCourse", "getLeadingScore", "getLeadingTeam", "getLevelName", "getLoadout",
+   "getMountAngle", "getMountedItems", "getName", "getNexusTimeLeft", "getObjType", "getPlayerCount", "getPos",
+   "getRad", "getRating", "getRegenTime", "getRotationSpeed", "getScore", "getScriptName", "getShip", "getSizeCount",
+   "getSizeIndex", "getSlipFactor", "getSpawnTime", "getSpeed", "getTeam", "getTeamCount", "getTeamIndex", "getText",
+   "getVel", "getWaypoint", "getWeapon", "getWidth", "getWinningScore", "hasFlag", "hasModule", "hasWeapon",
+   "isActive", "isAlive", "isInCaptureZone", "isInInitLoc", "isModActive", "isNexusOpen", "isOnShip", "isOpen",
+   "isRobot", "isSelected", "isTeamGame", "isVis", "pointCanSeePoint",
+};
+
+// Methods whose results robots need straight away, but that can change things shared between robots: constructors
+// add to the string table and the like (their ids come from the robot's IdBlock), and these getters create PlayerInfos
+// and the GameInfo the first time they're asked for.  Workers run them one at a time.
+static const char *serializedMethods[] = {
+   "new", "clone", "getGameInfo", "getOwner", "getPlayerInfo", "getPlayers",
+};
+
+
+static bool isListed(const char *name, const char **list, U32 count)
+{
+   for(U32 i = 0; i < count; i++)
+      if(!strcmp(name, list[i]))
+         return true;
+
+   return false;
+}
+
+
+// Held by a worker while it runs one of the serializedMethods; the main thread is waiting in think() meanwhile
+static Mutex &getSerializedMethodMutex()
+{
+   static Mutex mutex;
+   return mutex;
+}
+
+
+// Constructor
+BotWorkerPool::BotWorkerPool(S32 threadCount, U32 seed)
+{
+   mDeltaT = 0;
+
+   while(seed == 0)
+      seed = TNL::Random::readI();
+
+   logprintf(LogConsumer::ServerFilter, "Robots' random numbers are seeded with %u", seed);
+   setSeed(seed);
+
+   for(S32 i = 0; i < threadCount; i++)
+   {
+      lua_State *L = lua_open();
+
+      if(!L || !LuaScriptRunner::configureNewLuaInstance(L))
+      {
+         logprintf(LogConsumer::LogError, "Could not create a Lua state for robot worker thread %d; running with %d", i, mWorkers.size());
+
+         if(L)
+            lua_close(L);
+         break;
+      }
+
+      wrapMethods(L);
+
+      Worker *worker = new Worker();
+      worker->L = L;
+      worker->stopping = false;
+
+      WorkerThread *thread = new WorkerThread(this, worker);    // Deletes itself when it stops
+
+      if(!thread->start())
+      {
+         logprintf(LogConsumer::LogError, "Could not start robot worker thread %d; running with %d", i, mWorkers.size());
+
+         delete thread;
+         lua_close(L);
+         delete worker;
+         break;
+      }
+
+      mWorkers.push_back(worker);
+   }
+}
+
+
+// Destructor
+BotWorkerPool::~BotWorkerPool()
+{
+   for(S32 i = 0; i < mWorkers.size(); i++)
+   {
+      Worker *worker = mWorkers[i];
+
+      worker->stopping = true;
+      worker->wakeup.increment();
+      worker->done.wait();
+
+      // Robots still about can't run their scripts any more
+      for(S32 j = 0; j < worker->members.size(); j++)
+      {
+         worker->members[j]->script->setLuaState(NULL);
+         delete worker->members[j];
+      }
+
+      lua_close(worker->L);
+      delete worker;
+   }
+}
+
+
+S32 BotWorkerPool::getWorkerCount() const
+{
+   return mWorkers.size();
+}
+
+
+S32 BotWorkerPool::getRobotCount() const
+{
+   S32 count = 0;
+
+   for(S32 i = 0; i < mWorkers.size(); i++)
+      count += mWorkers[i]->members.size();
+
+   return count;
+}
+
+
+// Robots added from here on get their random numbers from seed, so a game can be played over with the same robots
+void BotWorkerPool::setSeed(U64 seed)
+{
+   mSeeds = BotRandom(seed);
+}
+
+
+// Puts the robot on the worker with the fewest robots; ties go to the first, so the same robots always end up together
+void BotWorkerPool::addRobot(Robot *robot)
+{
+   if(mWorkers.size() == 0)
+      return;
+
+   Worker *worker = mWorkers[0];
+
+   for(S32 i = 1; i < mWorkers.size(); i++)
+      if(mWorkers[i]->members.size() < worker->members.size())
+         worker = mWorkers[i];
+
+   Member *member = new Member();
+   member->script = robot;
+   member->random = BotRandom((U64(mSeeds.readU32()) << 32) | U64(mSeeds.readU32()));
+
+   worker->members.push_back(member);
+   robot->setLuaState(worker->L);
+}
+
+
+// The robot's script stays in its worker's Lua state until the robot is gone
+void BotWorkerPool::removeRobot(Robot *robot)
+{
+   Worker *worker;
+   Member *member = findMember(robot, worker);
+
+   if(!member)
+      return;
+
+   worker->members.erase(worker->members.getIndex(member));
+   delete member;
+}
+
+
+BotWorkerPool::Worker *BotWorkerPool::findWorker(lua_State *L) const
+{
+   for(S32 i = 0; i < mWorkers.size(); i++)
+      if(mWorkers[i]->L == L)
+         return mWorkers[i];
+
+   return NULL;
+}
+
+
+BotWorkerPool::Member *BotWorkerPool::findMember(LuaScriptRunner *script, Worker *&worker) const
+{
+   for(S32 i = 0; i < mWorkers.size(); i++)
+      for(S32 j = 0; j < mWorkers[i]->members.size(); j++)
+         if(mWorkers[i]->members[j]->script == script)
+         {
+            worker = mWorkers[i];
+            return mWorkers[i]->members[j];
+         }
+
+   worker = NULL;
+   return NULL;
+}
+
+
+void BotWorkerPool::think(const Vector<Thinker> &thinkers, U32 deltaT)
+{
+   mDeltaT = deltaT;
+   mJobs.clear();
+
+   for(S32 i = 0; i < mWorkers.size(); i++)
+      mWorkers[i]->jobs.clear();
+
+   for(S32 i = 0; i < thinkers.size(); i++)
+   {
+      Worker *worker;
+      Member *member = findMember(thinkers[i].script, worker);
+
+      if(!member)
+      {
+         TNLAssert(false, "Script isn't one of ours!");
+         continue;
+      }
+
+      Job job;
+      job.script = thinkers[i].script;
+      job.context = thinkers[i].context;
+      job.random = &member->random;
+      job.callsRef = LUA_NOREF;
+      job.failed = false;
+      job.dumpedStack = false;
+
+      worker->jobs.push_back(mJobs.size());
+      mJobs.push_back(job);
+   }
+
+   // Robot i gets every mJobs.size()th id, starting i along from where the counters are now
+   S32 firstSerialNumber, firstDefaultId;
+   BfObject::getNextIds(firstSerialNumber, firstDefaultId);
+
+   for(S32 i = 0; i < mJobs.size(); i++)
+   {
+      mJobs[i].ids.nextSerialNumber = firstSerialNumber + i;
+      mJobs[i].ids.nextDefaultId = firstDefaultId - i;
+      mJobs[i].ids.stride = mJobs.size();
+   }
+
+   // Think!
+   for(S32 i = 0; i < mWorkers.size(); i++)
+      if(mWorkers[i]->jobs.size() > 0)
+         mWorkers[i]->wakeup.increment();
+
+   for(S32 i = 0; i < mWorkers.size(); i++)
+      if(mWorkers[i]->jobs.size() > 0)
+         mWorkers[i]->done.wait();
+
+   // Move the counters past the last round of ids anyone took
+   S32 rounds = 0;
+   for(S32 i = 0; i < mJobs.size(); i++)
+      rounds = max(rounds, (mJobs[i].ids.nextSerialNumber - firstSerialNumber - i) / mJobs.size());
+
+   BfObject::setNextIds(firstSerialNumber + rounds * mJobs.size(), firstDefaultId - rounds * mJobs.size());
+
+   // Then do what everyone asked, in order
+   for(S32 i = 0; i < mJobs.size(); i++)
+   {
+      Job &job = mJobs[i];
+      lua_State *L = job.script->getLuaState();
+
+      runDeferredCalls(job, L);
+
+      if(job.failed)
+         job.script->terminateScript(job.error, job.dumpedStack);
+   }
+}
+
+
+// Runs on a worker thread
+void BotWorkerPool::runJobs(Worker *worker)
+{
+   lua_State *L = worker->L;
+
+   for(S32 i = 0; i < worker->jobs.size(); i++)
+   {
+      Job &job = mJobs[worker->jobs[i]];
+
+      lua_newtable(L);
+      job.callsRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+      getCurrentJobs().set(&job);
+      BfObject::setThreadIdBlock(&job.ids);
+
+      setScriptContext(L, job.context);
+      lua_pushinteger(L, mDeltaT);                          // -- deltaT
+      job.script->runCmd("onTick", 1, 0);
+
+      BfObject::setThreadIdBlock(NULL);
+      getCurrentJobs().set(NULL);
+
+      lua_settop(L, 0);
+   }
+}
+
+
+// Runs on the main thread, once the workers are done
+void BotWorkerPool::runDeferredCalls(Job &job, lua_State *L)
+{
+   if(job.callsRef == LUA_NOREF)
+      return;
+
+   setScriptContext(L, job.context);
+   lua_rawgeti(L, LUA_REGISTRYINDEX, job.callsRef);        // -- calls
+
+   S32 callCount = (S32)lua_objlen(L, -1);
+
+   for(S32 i = 1; i <= callCount && !job.failed; i++)
+   {
+      lua_rawgeti(L, 1, i);                                 // -- calls, call
+
+      lua_getfield(L, -1, "n");
+      S32 argCount = (S32)lua_tointeger(L, -1);
+      lua_pop(L, 1);
+
+      for(S32 j = 1; j <= argCount + 1; j++)                // Function first, then its args
+         lua_rawgeti(L, 2, j);                              // -- calls, call, fn, args
+
+      if(lua_pcall(L, argCount, 0, 0))                      // -- calls, call, [error]
+      {
+         job.failed = true;
+         job.error = string("In a call made during onTick():\n") + (lua_isstring(L, -1) ? lua_tostring(L, -1) : "Unknown error");
+         job.dumpedStack = false;
+      }
+
+      lua_settop(L, 1);                                     // -- calls
+   }
+
+   lua_settop(L, 0);
+   luaL_unref(L, LUA_REGISTRYINDEX, job.callsRef);
+   job.callsRef = LUA_NOREF;
+}
+
+
+// Stands in for a method that changes the game.  On a worker thread, while its robot thinks, it saves the call to be made
+// on the main thread when everyone is done, and returns nil; whatever the call returns then is thrown away.  Anywhere
+// else, it just makes the call.
+int BotWorkerPool::deferredMethod(lua_State *L)
+{
+   Job *job = static_cast<Job *>(getCurrentJobs().get());
+
+   if(!job)
+   {
+      lua_pushvalue(L, lua_upvalueindex(1));                // -- args, fn
+      lua_insert(L, 1);                                     // -- fn, args
+      lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);          // -- results
+
+      return lua_gettop(L);
+   }
+
+   S32 argCount = lua_gettop(L);
+
+   lua_createtable(L, argCount + 1, 1);                     // -- args, call
+   lua_pushvalue(L, lua_upvalueindex(1));                   // -- args, call, fn
+   lua_rawseti(L, -2, 1);                                   // -- args, call
+
+   for(S32 i = 1; i <= argCount; i++)
+   {
+      lua_pushvalue(L, i);                                  // -- args, call, arg
+      lua_rawseti(L, -2, i + 1);                            // -- args, call
+   }
+
+   lua_pushinteger(L, argCount);                            // -- args, call, n
+   lua_setfield(L, -2, "n");                                // -- args, call
+
+   lua_rawgeti(L, LUA_REGISTRYINDEX, job->callsRef);        // -- args, call, calls
+   lua_insert(L, -2);                                       // -- args, calls, call
+   lua_rawseti(L, -2, (S32)lua_objlen(L, -2) + 1);          // -- args, calls
+
+   return 0;
+}
+
+
+// Stands in for a method that robots need an answer from, but that isn't safe for two workers to run at once
+int BotWorkerPool::serializedMethod(lua_State *L)
+{
+   lua_pushvalue(L, lua_upvalueindex(1));                   // -- args, fn
+   lua_insert(L, 1);                                        // -- fn, args
+
+   if(!isWorkerThread())
+   {
+      lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);          // -- results
+      return lua_gettop(L);
+   }
+
+   // Catch any error, so we don't leave the other workers locked out when we raise it
+   getSerializedMethodMutex().lock();
+   S32 error = lua_pcall(L, lua_gettop(L) - 1, LUA_MULTRET, 0);
+   getSerializedMethodMutex().unlock();
+
+   if(error)
+      return lua_error(L);
+
+   return lua_gettop(L);
+}
+
+
+// Swaps every method that isn't known to be thread safe, in every class's metatable, for a deferredMethod() or
+// serializedMethod() wrapped around it
+void BotWorkerPool::wrapMethods(lua_State *L)
+{
+   lua_getfield(L, LUA_REGISTRYINDEX, LUAW_WRAPPER_KEY);    // -- LuaWrapper
+   lua_getfield(L, -1, LUAW_CACHE_KEY);                     // -- LuaWrapper, cache; keyed by class name
+
+   for(lua_pushnil(L); lua_next(L, -2); lua_pop(L, 1))      // -- LuaWrapper, cache, className, classCache
+   {
+      if(lua_type(L, -2) != LUA_TSTRING)
+         continue;
+
+      luaL_getmetatable(L, lua_tostring(L, -2));            // -- LuaWrapper, cache, className, classCache, mt
+
+      if(lua_istable(L, -1))
+      {
+         // Replacing the values of keys we've already got is allowed while traversing a table
+         for(lua_pushnil(L); lua_next(L, -2); lua_pop(L, 1))  // -- ..., mt, methodName, method
+         {
+            if(lua_type(L, -2) != LUA_TSTRING || !lua_iscfunction(L, -1))
+               continue;
+
+            const char *name = lua_tostring(L, -2);
+
+            if(!strncmp(name, "__", 2) || isListed(name, threadSafeMethods, ARRAYSIZE(threadSafeMethods)))
+               continue;
+
+            bool serialized = isListed(name, serializedMethods, ARRAYSIZE(serializedMethods));
+
+            lua_pushvalue(L, -2);                           // -- ..., mt, methodName, method, methodName
+            lua_pushvalue(L, -2);                           // -- ..., mt, methodName, method, methodName, method
+            lua_pushcclosure(L, serialized ? serializedMethod : deferredMethod, 1);  // -- ..., methodName, wrapped
+            lua_rawset(L, -5);                              // -- ..., mt, methodName, method
+         }
+      }
+
+      lua_pop(L, 1);                                        // -- LuaWrapper, cache, className, classCache
+   }
+
+   lua_pop(L, 2);
+}
+
+
+bool BotWorkerPool::isWorkerThread()
+{
+   return getCurrentWorkers().get() != NULL;
+}
+
+
+BotRandom *BotWorkerPool::getRandom()
+{
+   Job *job = static_cast<Job *>(getCurrentJobs().get());
+   return job ? job->random : NULL;
+}
+
+
+// An error in a robot's script on a worker thread; we'll deal with it when the main thread has the robot back
+void BotWorkerPool::deferScriptError(LuaScriptRunner *script, const string &error, bool dumpedStack)
+{
+   Job *job = static_cast<Job *>(getCurrentJobs().get());
+
+   TNLAssert(job && job->script == script, "Not thinking about this script!");
+
+   if(!job || job->failed)
+      return;
+
+   job->failed = true;
+   job->error = error;
+   job->dumpedStack = dumpedStack;
+}
+
+
+};
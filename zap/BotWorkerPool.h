@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_WORKER_POOL_H_
+#define _BOT_WORKER_POOL_H_
+
+#include "BfObject.h"      // For BfObject::IdBlock
+#include "LuaBase.h"       // For ScriptContext
+#include "gridDB.h"        // For GridDatabase::QueryContext
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlThread.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class LuaScriptRunner;
+class Robot;
+
+
+// Random numbers for one robot.  Each robot has its own, so its script sees the same numbers whichever thread it
+// thinks on, and however the other robots' thinking is interleaved with its own.
+class BotRandom
+{
+private:
+   U64 mState;
+
+public:
+   explicit BotRandom(U64 seed = 0);      // Constructor
+
+   U32 readU32();
+   F32 readF();                           // Between 0 and 1, never 1
+   S32 readI(S32 min, S32 max);           // Between min and max, inclusive
+};
+
+
+// Runs robots' TickEvent handlers on a handful of threads.  Each thread has a Lua state of its own, and the robots handed
+// to the pool are spread among them; a robot's script lives in its thread's state for as long as the robot does.
+//
+// The game doesn't move while robots think: the main thread waits in think() until every robot is done.  So robots can
+// look at anything they like, but a call that could change the game (any method not on our list of known read-only ones,
+// like setThrust() or sendData()) is saved, and made on the main thread once everyone has finished, in the order robots
+// were subscribed, so the outcome never depends on which thread got where first.  Those calls return nil to the script,
+// whatever they would have returned on the main thread.  Constructors, and the few getters that create things the first
+// time they're called, run straight away, but only on one thread at a time; each robot takes the ids for objects it
+// creates from its own IdBlock, so they come out the same however the threads are interleaved.
+//
+// Everything else about a robot's script -- its timers, and events other than TickEvent -- still runs on the main thread,
+// in the robot's own Lua state.
+class BotWorkerPool
+{
+public:
+   struct Thinker
+   {
+      LuaScriptRunner *script;
+      ScriptContext context;
+   };
+
+private:
+   struct Member
+   {
+      LuaScriptRunner *script;
+      BotRandom random;
+   };
+
+   struct Job
+   {
+      LuaScriptRunner *script;
+      ScriptContext context;
+      BotRandom *random;
+      BfObject::IdBlock ids;
+      S32 callsRef;              // Registry reference to the table of calls saved for later, in the worker's Lua state
+
+      bool failed;               // Script raised an error, which will kill it once we're back on the main thread
+      string error;
+      bool dumpedStack;
+   };
+
+   struct Worker
+   {
+      lua_State *L;
+      Vector<Member *> members;
+      Vector<S32> jobs;          // Indices into mJobs, for this think
+
+      GridDatabase::QueryContext queryContext;
+
+      Semaphore wakeup;
+      Semaphore done;
+      bool stopping;             // Only changed while the worker is waiting to be woken
+   };
+
+   class WorkerThread;
+
+   Vector<Worker *> mWorkers;
+   Vector<Job> mJobs;
+   U32 mDeltaT;
+   BotRandom mSeeds;          // Seeds for robots' random numbers
+
+   static void wrapMethods(lua_State *L);
+   static int deferredMethod(lua_State *L);
+   static int serializedMethod(lua_State *L);
+
+   void runJobs(Worker *worker);
+   void runDeferredCalls(Job &job, lua_State *L);
+
+   Worker *findWorker(lua_State *L) const;
+   Member *findMember(LuaScriptRunner *script, Worker *&worker) const;
+
+public:
+   BotWorkerPool(S32 threadCount, U32 seed);    // Constructor; seed 0 picks one at random
+   virtual ~BotWorkerPool();
+
+   S32 getWorkerCount() const;
+   S32 getRobotCount() const;
+
+   void setSeed(U64 seed);
+   void addRobot(Robot *robot);           // Call before the robot's script is started
+   void removeRobot(Robot *robot);
+
+   // Runs the thinkers' TickEvent handlers, then makes the calls they saved; returns when everything is done
+   void think(const Vector<Thinker> &thinkers, U32 deltaT);
+
+   static bool isWorkerThread();
+   static BotRandom *getRandom();         // Random numbers for the robot thinking on this thread, or NULL
+   static void deferScriptError(LuaScriptRunner *script, const string &error, bool dumpedStack);
+};
+
+
+};
+
+#endif
@@ -0,0 +1,266 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotZoneCache.h"
+
+#include "BotNavMeshZone.h"
+#include "game.h"          // For Game::md5
+#include "PackingUtils.h"
+
+#include "stringUtils.h"
+
+#include "tnlBitStream.h"
+#include "tnlLog.h"
+
+#include <zlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Zap
+{
+
+static const U8 ZoneFormatVersion = 1;    // Change this when the format, or the way zones are built, changes
+static const S32 ChecksumSize = 4;        // crc32 of the blob, on the end of the file
+static const S32 MaxFileSize = 16 * 1024 * 1024;
+static const char *ZoneExtension = "zones";
+
+
+// Constructor
+BotZoneCache::BotZoneCache(const string &folder)
+{
+   mFolder = folder;
+}
+
+
+// Destructor
+BotZoneCache::~BotZoneCache()
+{
+   // Do nothing
+}
+
+
+string BotZoneCache::getFilename(const string &key) const
+{
+   return joindir(mFolder, key + "." + ZoneExtension);
+}
+
+
+// Reads the zones stored under key into mesh; returns false if we don't have them, or if what we have is damaged
+bool BotZoneCache::load(const string &key, BotZoneMesh &mesh) const
+{
+   if(mFolder == "" || key == "" || !safeFilename(key.c_str()))
+      return false;
+
+   FILE *file = fopen(getFilename(key).c_str(), "rb");
+   if(!file)
+      return false;
+
+   fseek(file, 0, SEEK_END);
+   S32 size = (S32)ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   Vector<U8> blob;
+   bool ok = size > ChecksumSize && size <= MaxFileSize;
+
+   if(ok)
+   {
+      blob.resize(size);
+      ok = fread(blob.address(), 1, size, file) == (size_t)size;
+   }
+
+   fclose(file);
+
+   if(!ok)
+      return false;
+
+   size -= ChecksumSize;
+
+   const U8 *checksum = blob.address() + size;
+   U32 crc = (U32(checksum[0]) << 24) | (U32(checksum[1]) << 16) | (U32(checksum[2]) << 8) | U32(checksum[3]);
+
+   if(crc32(crc32(0, Z_NULL, 0), blob.address(), size) != crc)
+      return false;
+
+   blob.resize(size);
+   return unpackMesh(blob, mesh);
+}
+
+
+bool BotZoneCache::save(const string &key, const BotZoneMesh &mesh) const
+{
+   if(mFolder == "" || key == "" || !safeFilename(key.c_str()) || !makeSureFolderExists(mFolder))
+      return false;
+
+   Vector<U8> blob;
+   packMesh(mesh, blob);
+
+   if(blob.size() + ChecksumSize > MaxFileSize)
+      return false;
+
+   U32 crc = crc32(crc32(0, Z_NULL, 0), blob.address(), blob.size());
+
+   blob.push_back(U8(crc >> 24));
+   blob.push_back(U8(crc >> 16));
+   blob.push_back(U8(crc >> 8));
+   blob.push_back(U8(crc));
+
+   FILE *file = fopen(getFilename(key).c_str(), "wb");
+   if(!file)
+   {
+      logprintf(LogConsumer::LogWarning, "Could not write bot zones to %s", getFilename(key).c_str());
+      return false;
+   }
+
+   bool ok = fwrite(blob.address(), 1, blob.size(), file) == (size_t)blob.size();
+   fclose(file);
+
+   prune();
+
+   return ok;
+}
+
+
+// Delete the oldest zone files until we're back under MaxCachedLevels
+void BotZoneCache::prune() const
+{
+   deleteOldestFiles(mFolder, ZoneExtension, MaxCachedLevels);
+}
+
+
+void BotZoneCache::packMesh(const BotZoneMesh &mesh, Vector<U8> &blob)
+{
+   TNLAssert(mesh.neighbors.size() == mesh.zones.size(), "Every zone needs a list of neighbors, even if it is empty!");
+
+   BitStream stream;
+
+   stream.writeInt(ZoneFormatVersion, 8);
+   stream.write(mesh.bounds.min.x);
+   stream.write(mesh.bounds.min.y);
+   stream.write(mesh.bounds.max.x);
+   stream.write(mesh.bounds.max.y);
+
+   writeCount(stream, mesh.zones.size());
+
+   Point prev;
+
+   for(S32 i = 0; i < mesh.zones.size(); i++)
+   {
+      writeCount(stream, mesh.zones[i].size());
+
+      for(S32 j = 0; j < mesh.zones[i].size(); j++)
+         writePoint(stream, mesh.zones[i][j], prev);
+   }
+
+   for(S32 i = 0; i < mesh.neighbors.size(); i++)
+   {
+      const Vector<NeighboringZone> &neighbors = mesh.neighbors[i];
+
+      writeCount(stream, neighbors.size());
+
+      for(S32 j = 0; j < neighbors.size(); j++)
+      {
+         stream.writeInt(neighbors[j].zoneID, 16);
+
+         writePoint(stream, neighbors[j].borderStart,  prev);
+         writePoint(stream, neighbors[j].borderEnd,    prev);
+         writePoint(stream, neighbors[j].borderCenter, prev);
+         writePoint(stream, neighbors[j].center,       prev);
+
+         if(!stream.writeFlag(neighbors[j].distTo == 0))
+            stream.write(neighbors[j].distTo);
+      }
+   }
+
+   stream.zeroToByteBoundary();
+
+   blob.resize(stream.getBytePosition());
+   memcpy(blob.address(), stream.getBuffer(), blob.size());
+}
+
+
+// Returns false if blob is damaged, or in a format we don't know
+bool BotZoneCache::unpackMesh(const Vector<U8> &blob, BotZoneMesh &mesh)
+{
+   BitStream stream(const_cast<U8 *>(blob.address()), blob.size());
+
+   if(stream.readInt(8) != ZoneFormatVersion)
+      return false;
+
+   stream.read(&mesh.bounds.min.x);
+   stream.read(&mesh.bounds.min.y);
+   stream.read(&mesh.bounds.max.x);
+   stream.read(&mesh.bounds.max.y);
+
+   U32 zoneCount = readCount(stream);
+
+   // Every zone and vertex takes at least a bit, so anything bigger than this is garbage, and not worth allocating for
+   if(zoneCount > stream.getMaxReadBitPosition())
+      return false;
+
+   mesh.zones.resize(zoneCount);
+   mesh.neighbors.resize(zoneCount);
+   mesh.speedZoneStartId = -1;      // Connections are all in the neighbor lists already
+
+   Point prev;
+
+   for(U32 i = 0; i < zoneCount && stream.isValid(); i++)
+   {
+      U32 vertCount = readCount(stream);
+      if(vertCount > stream.getMaxReadBitPosition())
+         return false;
+
+      mesh.zones[i].resize(vertCount);
+
+      for(U32 j = 0; j < vertCount; j++)
+         mesh.zones[i][j] = readPoint(stream, prev);
+   }
+
+   for(U32 i = 0; i < zoneCount && stream.isValid(); i++)
+   {
+      U32 neighborCount = readCount(stream);
+      if(neighborCount > stream.getMaxReadBitPosition())
+         return false;
+
+      Vector<NeighboringZone> &neighbors = mesh.neighbors[i];
+      neighbors.resize(neighborCount);
+
+      for(U32 j = 0; j < neighborCount; j++)
+      {
+         neighbors[j].zoneID = U16(stream.readInt(16));
+
+         // Robots index straight into the zone list with these
+         if(neighbors[j].zoneID >= zoneCount)
+            return false;
+
+         neighbors[j].borderStart  = readPoint(stream, prev);
+         neighbors[j].borderEnd    = readPoint(stream, prev);
+         neighbors[j].borderCenter = readPoint(stream, prev);
+         neighbors[j].center       = readPoint(stream, prev);
+
+         if(stream.readFlag())
+            neighbors[j].distTo = 0;
+         else
+            stream.read(&neighbors[j].distTo);
+      }
+   }
+
+   return stream.isValid();
+}
+
+
+// Anything that changes the zones built for a level must go into the key, or we'll load zones built the old way
+string BotZoneCache::getKey(const string &levelFileHash)
+{
+   string params = itos(ZoneFormatVersion)                  + " " +
+                   itos(BotNavMeshZone::BufferRadius)       + " " +
+                   itos(BotNavMeshZone::LevelZoneBuffer)    + " " +
+                   ftos(BotNavMeshZone::CoreTraversalCost)  + " " +
+                   levelFileHash;
+
+   return Game::md5.getHashFromString(params);
+}
+
+
+};
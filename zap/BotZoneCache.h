@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_ZONE_CACHE_H_
+#define _BOT_ZONE_CACHE_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+struct BotZoneMesh;
+
+// Bot zones the server has already built, kept on disk so they needn't be built again the next time the level comes
+// around.  Files are named by a key made from the level file's hash and everything else that goes into building zones,
+// so editing a level, or changing how zones are built, leaves the old file unused until it is pruned.
+class BotZoneCache
+{
+private:
+   string mFolder;
+
+   string getFilename(const string &key) const;
+   void prune() const;
+
+public:
+   enum {
+      MaxCachedLevels = 200,     // Oldest zone files are deleted beyond this
+   };
+
+   explicit BotZoneCache(const string &folder);    // Constructor
+   virtual ~BotZoneCache();
+
+   bool load(const string &key, BotZoneMesh &mesh) const;
+   bool save(const string &key, const BotZoneMesh &mesh) const;
+
+   static void packMesh(const BotZoneMesh &mesh, Vector<U8> &blob);
+   static bool unpackMesh(const Vector<U8> &blob, BotZoneMesh &mesh);
+   static string getKey(const string &levelFileHash);
+};
+
+
+};
+
+#endif
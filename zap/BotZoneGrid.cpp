@@ -0,0 +1,379 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotZoneGrid.h"
+
+#include "BotNavMeshZone.h"
+#include "GeomUtils.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace Zap
+{
+
+// Constructor
+BotZoneGrid::BotZoneGrid(const Vector<BotNavMeshZone *> *zones)
+{
+   mZones = zones;
+   mHolding = false;
+   reset();
+}
+
+
+// Destructor
+BotZoneGrid::~BotZoneGrid()
+{
+   // Do nothing
+}
+
+
+S32 BotZoneGrid::getCell(S32 col, S32 row) const
+{
+   return row * mCols + col;
+}
+
+
+void BotZoneGrid::reset()
+{
+   mCellSize = MinCellSize;
+   mCols = 0;
+   mRows = 0;
+
+   mCellOwners.clear();
+   mCellStarts.clear();
+   mCellZones.clear();
+
+   mMutex.lock();
+   mClosestZones.clear();
+   mHeldClosestZones.clear();
+   mMutex.unlock();
+
+   if(mZones->size() == 0)
+      return;
+
+   mBounds = mZones->get(0)->getExtent();
+   for(S32 i = 1; i < mZones->size(); i++)
+      mBounds.unionRect(mZones->get(i)->getExtent());
+
+   F32 width  = max(mBounds.getWidth(),  1.0f);
+   F32 height = max(mBounds.getHeight(), 1.0f);
+
+   mCellSize = max((F32)MinCellSize, sqrt(width * height / MaxCells));
+   mCols = (S32)ceil(width  / mCellSize);
+   mRows = (S32)ceil(height / mCellSize);
+
+   // Count how many zones cross each cell, so each cell's list can go in one array
+   Vector<S32> firstCols(mZones->size()), lastCols(mZones->size()), firstRows(mZones->size()), lastRows(mZones->size());
+   Vector<S32> counts(mCols * mRows);
+   counts.resize(mCols * mRows);
+
+   for(S32 i = 0; i < counts.size(); i++)
+      counts[i] = 0;
+
+   for(S32 i = 0; i < mZones->size(); i++)
+   {
+      Rect extent = mZones->get(i)->getExtent();
+
+      firstCols.push_back(max(0,         (S32)floor((extent.min.x - mBounds.min.x) / mCellSize)));
+      lastCols.push_back (min(mCols - 1, (S32)floor((extent.max.x - mBounds.min.x) / mCellSize)));
+      firstRows.push_back(max(0,         (S32)floor((extent.min.y - mBounds.min.y) / mCellSize)));
+      lastRows.push_back (min(mRows - 1, (S32)floor((extent.max.y - mBounds.min.y) / mCellSize)));
+
+      for(S32 row = firstRows[i]; row <= lastRows[i]; row++)
+         for(S32 col = firstCols[i]; col <= lastCols[i]; col++)
+            counts[getCell(col, row)]++;
+   }
+
+   mCellStarts.resize(counts.size() + 1);
+   mCellStarts[0] = 0;
+
+   for(S32 i = 0; i < counts.size(); i++)
+   {
+      mCellStarts[i + 1] = mCellStarts[i] + counts[i];
+      counts[i] = mCellStarts[i];      // Now where the next zone for this cell goes
+   }
+
+   mCellZones.resize(mCellStarts.last());
+
+   for(S32 i = 0; i < mZones->size(); i++)
+      for(S32 row = firstRows[i]; row <= lastRows[i]; row++)
+         for(S32 col = firstCols[i]; col <= lastCols[i]; col++)
+            mCellZones[counts[getCell(col, row)]++] = U16(i);
+
+   // A cell with all four corners in a convex zone is wholly inside it
+   Vector<U8> convex(mZones->size());
+   for(S32 i = 0; i < mZones->size(); i++)
+      convex.push_back(isConvex(mZones->get(i)->getOutline()));
+
+   mCellOwners.resize(counts.size());
+
+   for(S32 row = 0; row < mRows; row++)
+      for(S32 col = 0; col < mCols; col++)
+      {
+         S32 cell = getCell(col, row);
+         mCellOwners[cell] = U16_MAX;
+
+         Point corner = mBounds.min + Point(col * mCellSize, row * mCellSize);
+         Point corners[4] = { corner, corner + Point(mCellSize, 0), corner + Point(0, mCellSize), corner + Point(mCellSize, mCellSize) };
+
+         for(S32 i = mCellStarts[cell]; i < mCellStarts[cell + 1] && mCellOwners[cell] == U16_MAX; i++)
+         {
+            U16 zoneId = mCellZones[i];
+            if(!convex[zoneId])
+               continue;
+
+            const Vector<Point> *outline = mZones->get(zoneId)->getOutline();
+
+            bool inside = true;
+            for(S32 j = 0; j < 4 && inside; j++)
+               inside = polygonContainsPoint(outline->address(), outline->size(), corners[j]);
+
+            if(inside)
+               mCellOwners[cell] = zoneId;
+         }
+      }
+}
+
+
+// Returns U16_MAX if point isn't in any zone
+U16 BotZoneGrid::findZoneContaining(const Point &point) const
+{
+   if(mCols == 0)
+      return U16_MAX;
+
+   S32 col = (S32)floor((point.x - mBounds.min.x) / mCellSize);
+   S32 row = (S32)floor((point.y - mBounds.min.y) / mCellSize);
+
+   if(col < 0 || col >= mCols || row < 0 || row >= mRows)
+      return U16_MAX;
+
+   S32 cell = getCell(col, row);
+
+   if(mCellOwners[cell] != U16_MAX)
+      return mCellOwners[cell];
+
+   for(S32 i = mCellStarts[cell]; i < mCellStarts[cell + 1]; i++)
+   {
+      BotNavMeshZone *zone = mZones->get(mCellZones[i]);
+
+      if(zone->getExtent().contains(point) &&
+            polygonContainsPoint(zone->getOutline()->address(), zone->getOutline()->size(), point))
+         return mCellZones[i];
+   }
+
+   return U16_MAX;
+}
+
+
+pair<S32, S32> BotZoneGrid::getClosestZoneKey(const Point &point) const
+{
+   return pair<S32, S32>((S32)floor(point.x / ClosestZoneQuantum), (S32)floor(point.y / ClosestZoneQuantum));
+}
+
+
+// Returns false if we haven't been told the closest zone to anywhere near point
+bool BotZoneGrid::getClosestZone(const Point &point, U16 &zone)
+{
+   mMutex.lock();
+
+   map<pair<S32, S32>, U16>::iterator it = mClosestZones.find(getClosestZoneKey(point));
+   bool found = it != mClosestZones.end();
+
+   if(found)
+      zone = it->second;
+
+   mMutex.unlock();
+
+   return found;
+}
+
+
+void BotZoneGrid::setClosestZone(const Point &point, U16 zone)
+{
+   mMutex.lock();
+
+   if(mHolding)
+   {
+      // Points sharing a key could have different answers; keep the lowest, so it doesn't matter who asked first
+      pair<map<pair<S32, S32>, U16>::iterator, bool> inserted = mHeldClosestZones.insert(make_pair(getClosestZoneKey(point), zone));
+      if(!inserted.second && zone < inserted.first->second)
+         inserted.first->second = zone;
+   }
+   else
+   {
+      if(mClosestZones.size() >= MaxClosestZones)
+         mClosestZones.clear();
+
+      mClosestZones[getClosestZoneKey(point)] = zone;
+   }
+
+   mMutex.unlock();
+}
+
+
+void BotZoneGrid::holdClosestZones()
+{
+   mMutex.lock();
+   mHolding = true;
+   mMutex.unlock();
+}
+
+
+void BotZoneGrid::releaseClosestZones()
+{
+   mMutex.lock();
+
+   for(map<pair<S32, S32>, U16>::iterator it = mHeldClosestZones.begin(); it != mHeldClosestZones.end(); it++)
+   {
+      if(mClosestZones.size() >= MaxClosestZones)
+         mClosestZones.clear();
+
+      mClosestZones[it->first] = it->second;
+   }
+
+   mHeldClosestZones.clear();
+   mHolding = false;
+
+   mMutex.unlock();
+}
+
+
+S32 BotZoneGrid::getCellCount() const
+{
+   return mCellOwners.size();
+}
+
+
+S32 BotZoneGrid::getOwnedCellCount() const
+{
+   S32 count = 0;
+
+   for(S32 i = 0; i < mCellOwners.size(); i++)
+      if(mCellOwners[i] != U16_MAX)
+         count++;
+
+   return count;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+BotSightMemo::BotSightMemo()
+{
+   mActive = false;
+   mExact = false;
+}
+
+
+// Destructor
+BotSightMemo::~BotSightMemo()
+{
+   // Do nothing
+}
+
+
+bool BotSightMemo::Key::operator<(const Key &other) const
+{
+   for(S32 i = 0; i < 5; i++)
+      if(coords[i] != other.coords[i])
+         return coords[i] < other.coords[i];
+
+   return wallsOnly < other.wallsOnly;
+}
+
+
+BotSightMemo::Key BotSightMemo::getKey(const Point &from, const Point &to, F32 radius, bool wallsOnly) const
+{
+   Key key;
+   key.wallsOnly = wallsOnly;
+
+   if(mExact)
+   {
+      F32 coords[5] = { from.x, from.y, to.x, to.y, radius };
+      memcpy(key.coords, coords, sizeof(key.coords));
+      return key;
+   }
+
+   key.coords[0] = (S32)floor(from.x / Quantum + 0.5f);
+   key.coords[1] = (S32)floor(from.y / Quantum + 0.5f);
+   key.coords[2] = (S32)floor(to.x   / Quantum + 0.5f);
+   key.coords[3] = (S32)floor(to.y   / Quantum + 0.5f);
+   key.coords[4] = (S32)floor(radius / Quantum + 0.5f);
+
+   return key;
+}
+
+
+void BotSightMemo::begin(bool exact)
+{
+   mMutex.lock();
+   mResults.clear();
+   mActive = true;
+   mExact = exact;
+   mMutex.unlock();
+}
+
+
+void BotSightMemo::end()
+{
+   mMutex.lock();
+   mResults.clear();
+   mActive = false;
+   mMutex.unlock();
+}
+
+
+// Returns false if we don't know, or it's not a bot tick, when nothing we remembered would be any good
+bool BotSightMemo::lookup(const Point &from, const Point &to, F32 radius, bool wallsOnly, bool &canSee)
+{
+   mMutex.lock();
+
+   bool found = false;
+
+   if(mActive)
+   {
+      map<Key, bool>::iterator it = mResults.find(getKey(from, to, radius, wallsOnly));
+      found = it != mResults.end();
+
+      if(found)
+         canSee = it->second;
+   }
+
+   mMutex.unlock();
+
+   return found;
+}
+
+
+void BotSightMemo::store(const Point &from, const Point &to, F32 radius, bool wallsOnly, bool canSee)
+{
+   mMutex.lock();
+
+   if(mActive)
+   {
+      if(mResults.size() >= MaxResults)
+         mResults.clear();
+
+      mResults[getKey(from, to, radius, wallsOnly)] = canSee;
+   }
+
+   mMutex.unlock();
+}
+
+
+S32 BotSightMemo::getResultCount()
+{
+   mMutex.lock();
+   S32 count = (S32)mResults.size();
+   mMutex.unlock();
+
+   return count;
+}
+
+
+};
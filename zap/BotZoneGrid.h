@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_ZONE_GRID_H_
+#define _BOT_ZONE_GRID_H_
+
+#include "Point.h"
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlThread.h"
+
+#include <map>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class BotNavMeshZone;
+
+// The bot zones laid out on a grid, so robots can find the zone a point is in with a table lookup rather than a database
+// search.  Cells lying wholly inside one zone know it straight off; the rest keep a short list of the zones crossing them.
+//
+// Also remembers which zone findClosestZone() settled on for points off the zone map, as that takes a raycast per
+// candidate zone, and robots tend to ask about the same few places over and over.
+class BotZoneGrid
+{
+private:
+   const Vector<BotNavMeshZone *> *mZones;
+
+   Rect mBounds;
+   F32 mCellSize;
+   S32 mCols;
+   S32 mRows;
+
+   Vector<U16> mCellOwners;      // Zone covering the whole cell, or U16_MAX
+   Vector<S32> mCellStarts;      // Where each cell's zones start in mCellZones, with one extra on the end
+   Vector<U16> mCellZones;
+
+   Mutex mMutex;                                   // Guards mClosestZones and everything below
+   map<pair<S32, S32>, U16> mClosestZones;         // Keyed on point, in ClosestZoneQuantum units
+   map<pair<S32, S32>, U16> mHeldClosestZones;     // Answers found while held, kept out of sight until release()
+   bool mHolding;
+
+   S32 getCell(S32 col, S32 row) const;
+   pair<S32, S32> getClosestZoneKey(const Point &point) const;
+
+public:
+   enum {
+      MinCellSize = 32,
+      MaxCells = 256 * 1024,           // Cells grow beyond MinCellSize on big levels to stay within this
+      ClosestZoneQuantum = 8,          // Points this close together share a closest zone
+      MaxClosestZones = 16 * 1024,     // Forget them all when we've remembered this many
+   };
+
+   explicit BotZoneGrid(const Vector<BotNavMeshZone *> *zones);    // Constructor
+   virtual ~BotZoneGrid();
+
+   void reset();                       // Call whenever the zones change; not while anyone is looking!
+
+   U16 findZoneContaining(const Point &point) const;
+
+   bool getClosestZone(const Point &point, U16 &zone);
+   void setClosestZone(const Point &point, U16 zone);
+
+   // While held, closest zones found aren't shared until release(), so robots thinking at the same time on different
+   // threads get the same answers whichever of them asks first
+   void holdClosestZones();
+   void releaseClosestZones();
+
+   S32 getCellCount() const;
+   S32 getOwnedCellCount() const;
+};
+
+
+// Results of robots' line of sight checks, kept for the length of one bot tick.  Nothing moves while robots are thinking,
+// so for that long, anything seen from one spot will still be seen from there.
+class BotSightMemo
+{
+private:
+   struct Key
+   {
+      S32 coords[5];       // From, to, and how wide a path we're checking, rounded to Quantum
+      bool wallsOnly;
+
+      bool operator<(const Key &other) const;
+   };
+
+   Mutex mMutex;
+   map<Key, bool> mResults;
+   bool mActive;
+   bool mExact;         // Only share results for exactly the same check
+
+   Key getKey(const Point &from, const Point &to, F32 radius, bool wallsOnly) const;
+
+public:
+   enum {
+      Quantum = 1,
+      MaxResults = 8 * 1024,
+   };
+
+   BotSightMemo();      // Constructor
+   virtual ~BotSightMemo();
+
+   void begin(bool exact = false);     // Bot tick is starting; exact when robots think on several threads at once
+   void end();                         // Bot tick is over, and things are about to move
+
+   bool lookup(const Point &from, const Point &to, F32 radius, bool wallsOnly, bool &canSee);
+   void store(const Point &from, const Point &to, F32 radius, bool wallsOnly, bool canSee);
+
+   S32 getResultCount();
+};
+
+
+};
+
+#endif
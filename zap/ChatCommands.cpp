@@ -905,6 +905,15 @@ void setMaxBotsHandler(ClientGame *game, const Vector<string> &words)
 }
 
 
+// /scriptstats ==> Show how much CPU time each robot and levelgen has been using
+void scriptStatsHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permission to see script stats"))
+      if(game->getGameType())
+         game->getGameType()->c2sShowScriptStats();
+}
+
+
 void shuffleTeams(ClientGame *game, const Vector<string> &words)
 {
    if(game->hasAdmin("!!! Need admin permissions to shuffle the teams"))
@@ -120,6 +120,7 @@ void kickBotHandler            (ClientGame *game, const Vector<string> &args);
 void kickBotsHandler           (ClientGame *game, const Vector<string> &args);
 void showBotsHandler           (ClientGame *game, const Vector<string> &args);
 void setMaxBotsHandler         (ClientGame *game, const Vector<string> &args);
+void scriptStatsHandler        (ClientGame *game, const Vector<string> &args);
 void banPlayerHandler          (ClientGame *game, const Vector<string> &args);
 void banIpHandler              (ClientGame *game, const Vector<string> &args);
 void renamePlayerHandler       (ClientGame *game, const Vector<string> &args);
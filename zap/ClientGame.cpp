@@ -268,6 +268,7 @@ void ClientGame::startLoadingLevel(bool engineerEnabled)
 void ClientGame::doneLoadingLevel()
 {
    computeWorldObjectExtents();              // Make sure our world extents reflect all the objects we've loaded
+   getGameObjDatabase()->resizeGrid(*getWorldExtents());    // And size our spatial database to match
    Barrier::prepareRenderingGeometry(this);  // Get walls ready to render
 
    getUIManager()->doneLoadingLevel();
@@ -39,11 +39,8 @@ Console::~Console()
    if(mConsole)
       quit();
 
-   if(L)
-   {
-      lua_close(L);
-      L = NULL;
-   }
+   shutdown();    // Close the main Lua state, if nobody else has
+   L = NULL;
 }
 
 
@@ -5,6 +5,7 @@
 
 #include "EventManager.h"
 
+#include "BotWorkerPool.h"
 #include "CoreGame.h"
 #include "playerInfo.h"          // For RobotPlayerInfo constructor
 #include "robot.h"
@@ -107,7 +108,7 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    if(isSubscribed(subscriber, eventType) || isPendingSubscribed(subscriber, eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   lua_State *L = subscriber->getLuaState();
 
    // Make sure the script has the proper event listener
    bool ok = LuaScriptRunner::loadFunction(L, subscriber->getScriptId(), eventDefs[eventType].function);     // -- function
@@ -250,12 +251,12 @@ void EventManager::fireEvent(EventType eventType)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 0, subscriptions[eventType][i].context);
          
       // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
@@ -279,12 +280,12 @@ void EventManager::fireEvent(EventType eventType, U32 deltaT)
    if(eventType == TickEvent)
       mStepCount--;   
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, deltaT);   // -- deltaT
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
          
@@ -300,18 +301,64 @@ void EventManager::fireEvent(EventType eventType, U32 deltaT)
 }
 
 
+// onTick, for when robots in pool's Lua states think on its threads.  Scripts in the main Lua state go first, one by one,
+// as usual; then the pool's robots think all at once.
+void EventManager::fireEvent(EventType eventType, U32 deltaT, BotWorkerPool *pool)
+{
+   if(suppressEvents(eventType))   
+      return;
+
+   if(eventType == TickEvent)
+      mStepCount--;   
+
+   lua_State *mainL = LuaScriptRunner::getL();
+
+   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   {
+      if(subscriptions[eventType][i].subscriber->getLuaState() != mainL)
+         continue;
+
+      TNLAssert(lua_gettop(mainL) == 0 || dumpStack(mainL), "Stack dirty!");
+
+      lua_pushinteger(mainL, deltaT);   // -- deltaT
+      bool error = fire(mainL, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
+         
+      // If an error occurred, the subscriber is gone, and the next one we need to handle is at index i
+      if(error)
+      {
+         clearStack(mainL);
+         i--;
+      }
+   }
+
+   Vector<BotWorkerPool::Thinker> thinkers;
+
+   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+      if(subscriptions[eventType][i].subscriber->getLuaState() != mainL)
+      {
+         BotWorkerPool::Thinker thinker;
+         thinker.script = subscriptions[eventType][i].subscriber;
+         thinker.context = subscriptions[eventType][i].context;
+
+         thinkers.push_back(thinker);
+      }
+
+   pool->think(thinkers, deltaT);
+}
+
+
 // onCoreDestroyed
 void EventManager::fireEvent(EventType eventType, CoreItem *core)
 {
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       core->push(L);                // -- core
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
          
@@ -333,12 +380,12 @@ void EventManager::fireEvent(EventType eventType, Ship *ship)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
          
@@ -360,12 +407,12 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
 
       if(damagingObject)
@@ -400,12 +447,12 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       if(sender == subscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
          continue;
 
@@ -429,23 +476,113 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
          i--;
       }
    }
+}
+
+
+// Pushes a copy of the value at index in from onto to's stack, for data sent between scripts running in different Lua
+// states.  Game objects and players arrive as themselves, tables are copied, and things that can't cross (like functions)
+// arrive as nil.
+static void copyLuaValue(lua_State *from, S32 index, lua_State *to, S32 depth)
+{
+   if(index < 0)
+      index = lua_gettop(from) + index + 1;     // Relative indices will move as we push things
+
+   switch(lua_type(from, index))
+   {
+      case LUA_TBOOLEAN:
+         lua_pushboolean(to, lua_toboolean(from, index));
+         return;
+
+      case LUA_TNUMBER:
+         lua_pushnumber(to, lua_tonumber(from, index));
+         return;
+
+      case LUA_TSTRING:
+      {
+         size_t len;
+         const char *str = lua_tolstring(from, index, &len);
+         lua_pushlstring(to, str, len);
+         return;
+      }
+
+      case LUA_TTABLE:
+         if(depth >= 16)         // Deeper than any sane data, and keeps us out of trouble with tables that contain themselves
+            break;
+
+         if(lua_getmetatable(from, index))
+         {
+            lua_pop(from, 1);
+
+            if(luaIsPoint(from, index))   // Points are the only tables we make with metatables
+            {
+               lua_getfield(from, index, "x");
+               lua_getfield(from, index, "y");
+
+               lua_getglobal(to, "point");                  // -- point
+               lua_getfield(to, -1, "new");                 // -- point, new
+               lua_pushnumber(to, lua_tonumber(from, -2));  // -- point, new, x
+               lua_pushnumber(to, lua_tonumber(from, -1));  // -- point, new, x, y
+               lua_call(to, 2, 1);                          // -- point, pt
+               lua_remove(to, -2);                          // -- pt
+
+               lua_pop(from, 2);
+               return;
+            }
+         }
+
+         lua_newtable(to);
+         lua_pushnil(from);
+
+         while(lua_next(from, index))                       // -- key, value
+         {
+            copyLuaValue(from, -2, to, depth + 1);
+            copyLuaValue(from, -1, to, depth + 1);
+
+            if(lua_isnil(to, -2))
+               lua_pop(to, 2);
+            else
+               lua_rawset(to, -3);
+
+            lua_pop(from, 1);                               // -- key
+         }
+         return;
+
+      case LUA_TUSERDATA:
+      {
+         BfObject *obj = luaW_to<BfObject>(from, index);
+         if(obj)
+         {
+            obj->push(to);
+            return;
+         }
+
+         LuaPlayerInfo *playerInfo = luaW_to<LuaPlayerInfo>(from, index);
+         if(playerInfo)
+         {
+            playerInfo->push(to);
+            return;
+         }
+
+         break;
+      }
+   }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   lua_pushnil(to);
 }
 
 
 // onDataReceived
 void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType)
 {
-   lua_State *L = LuaScriptRunner::getL();
+   lua_State *senderL = sender->getLuaState();
 
    if(suppressEvents(eventType))
    {
-      clearStack(L);
+      clearStack(senderL);
       return;
    }
 
-   S32 argCount = lua_gettop(L);
+   S32 argCount = lua_gettop(senderL);
 
    // Because we're going to call this function repeatedly, and because each call removes these items from the stack,
    // we need to make a copy of them first so we can add them back for subsequent calls.
@@ -457,10 +594,14 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType)
          continue;
 
       Subscription subscription = subscriptions[eventType][i];
+      lua_State *L = subscription.subscriber->getLuaState();
 
-      // Duplicate the first argCount items on the stack
+      // Duplicate the first argCount items on the stack, or copy them over if the subscriber lives in another Lua state
       for(S32 j = 1; j <= argCount; j++)
-         lua_pushvalue(L, j);
+         if(L == senderL)
+            lua_pushvalue(L, j);
+         else
+            copyLuaValue(senderL, j, L, 0);
 
       bool error = fire(L, subscription.subscriber, eventDefs[eventType].function, argCount, subscription.context);
 
@@ -473,14 +614,14 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType)
          // But we can't do both.
          // subscription.subscriber is getting deleted in the bowels of fire()
          //unsubscribeImmediate(subscription.subscriber, eventType);  /// <===== WHy does this break tests????
-         lua_settop(L, argCount);
+         lua_settop(L, L == senderL ? argCount : 0);
          i--;
       }
 
-      TNLAssert(lua_gettop(L) == argCount, "Expect args to still be on the stack!");
+      TNLAssert(lua_gettop(senderL) == argCount, "Expect args to still be on the stack!");
    }
 
-   clearStack(L);    // Get rid of final copy of args
+   clearStack(senderL);    // Get rid of final copy of args
 }
 
 
@@ -490,12 +631,12 @@ void EventManager::fireEvent(LuaScriptRunner *player, EventType eventType, LuaPl
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       if(player == subscriptions[eventType][i].subscriber)    // Don't trouble player with own joinage or leavage!
          continue;
 
@@ -520,12 +661,12 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       // Passing ship, zone, zoneType, zoneId
       ship->push(L);                                     // -- ship
       zone->push(L);                                     // -- ship, zone   
@@ -552,12 +693,12 @@ void EventManager::fireEvent(EventType eventType, MoveObject *object, Zone *zone
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       // Passing object, zone, zoneType, zoneId
       object->push(L);                                   // -- object
       zone->push(L);                                     // -- object, zone   
@@ -584,12 +725,12 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 team, LuaPlayer
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();    // Robots can each have their own
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, score);   // -- score
       lua_pushinteger(L, team);    // -- score, team
 
@@ -17,6 +17,7 @@ using namespace TNL;
 namespace Zap
 {
 
+class BotWorkerPool;
 class CoreItem;
 class LuaPlayerInfo;
 class LuaScriptRunner;
@@ -113,6 +114,7 @@ public:
    // We'll have several different signatures for this one...
    void fireEvent(EventType eventType);
    void fireEvent(EventType eventType, U32 deltaT);      // Tick
+   void fireEvent(EventType eventType, U32 deltaT, BotWorkerPool *pool);   // Tick, with some robots thinking in pool
    void fireEvent(EventType eventType, CoreItem *core);  // CoreDestroyed
    void fireEvent(EventType eventType, Ship *ship);      // ShipSpawned
    void fireEvent(EventType eventType, Ship *ship, BfObject *damagingObject, BfObject *shooter);  // ShipKilled
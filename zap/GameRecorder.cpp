@@ -18,99 +18,359 @@
 
 #include "version.h"
 
+#include <zlib.h>
+
 #include <algorithm>
+#include <atomic>
 
 namespace Zap
 {
 
 
 
-// fwrite might have multiple 1-second freeze on VPS server or heavy disk access
-// Having fwrite in separate thread might fix the game from freezing/lagging
-// if run in VPS server or with heavy disk access
+static const char KeyframeTag[] = "KeyF";
+static const char IndexTag[] = "BfIx";
+static const U32 TagSize = 4;
+
+
+static void writeU32(U8 *dest, U32 value)
+{
+   dest[0] = U8(value);
+   dest[1] = U8(value >> 8);
+   dest[2] = U8(value >> 16);
+   dest[3] = U8(value >> 24);
+}
+
+
+static U32 readU32(const U8 *src)
+{
+   return U32(src[0]) | (U32(src[1]) << 8) | (U32(src[2]) << 16) | (U32(src[3]) << 24);
+}
 
+
+// Writers that have been started and haven't finished their files yet; see GameRecorderServer::waitForWriters()
+static std::atomic<S32> gLiveWriters(0);
+
+
+// fwrite might have multiple 1-second freeze on VPS server or heavy disk access, so records are compressed and
+// written out on a thread of their own.  The game fills blocks in a fixed ring and hands them over without locking; the
+// writer sleeps until it's given something to do.  If the disk falls so far behind that every block is waiting, we
+// drop records rather than wait, and the recording starts again from the next keyframe.  Without threads, blocks are
+// written as soon as they're handed over, and the file is finished off in finish().
 class WriteBufferThread : public Thread
 {
 private:
-   FILE *f;
-   U32 lastPos;
-   U32 currPos;
-   U8 buffer[1024*128];
-   TNL::Semaphore sem1;
-   U32 threadPos;
-   bool exitNow;
+   struct Block
+   {
+      U8 data[GameRecorderServer::MaxBlockSize];
+      U32 size;
+      U32 time;
+      U8 flags;
+   };
+
+   enum {
+      QueueLength = GameRecorderServer::BlockQueueLength,
+   };
+
+   FILE *mFile;
+   Block mBlocks[QueueLength];
+   std::atomic<U32> mHead;          // Blocks handed to the writer; only the game changes this
+   std::atomic<U32> mTail;          // Blocks written; only the writer changes this
+   std::atomic<bool> mFinishing;
+   TNL::Semaphore mWakeup;
+
+   // Only touched by the game
+   bool mFilling;                   // Block mHead is being filled
+   bool mDropped;                   // Records were dropped since the last block was started
+   U8 mNextFlags;
+   U32 mTotalTime;                  // Set before mFinishing, for the index
+
+   // Only touched by the writer
+   z_stream mStream;
+   bool mStreamReady;
+   Vector<U8> mCompressed;
+   U32 mFileOffset;
+   Vector<RecordingKeyframe> mKeyframes;
+
+   void writeBlock(const Block &block);
+   void writeIndex();
+   void writeQueuedBlocks();
+   void close();
+
 public:
+   explicit WriteBufferThread(FILE *file);
+   ~WriteBufferThread();
+
+   void writeHeader(const U8 *header, U32 size);     // Before start()
+
+   // Game thread
+   U8 *getBuffer(U32 size, U32 time);
+   void addBuffer(U32 size);
+   void startBlock(U8 flags);
+   void endBlock();
+   U32 getFreeBlocks() const;
+   void finish(U32 totalTime);
+
+   // Writer thread
+   bool start();
+   U32 run();
+};
+
+
+WriteBufferThread::WriteBufferThread(FILE *file) : mHead(0), mTail(0), mFinishing(false)
+{
+   TNLAssert(file != 0, "Must have a file handle");
+   mFile = file;
+   mFilling = false;
+   mDropped = false;
+   mNextFlags = 0;
+   mTotalTime = 0;
+   mFileOffset = 0;
+
+   memset(&mStream, 0, sizeof(mStream));
+   mStreamReady = deflateInit(&mStream, Z_BEST_SPEED) == Z_OK;
+   mCompressed.resize(compressBound(GameRecorderServer::MaxBlockSize));
+}
+
+
+// Only deleted directly if the thread never started; otherwise it deletes itself when it's done
+WriteBufferThread::~WriteBufferThread()
+{
+   if(mStreamReady)
+      deflateEnd(&mStream);
 
-   WriteBufferThread(FILE *file)
+   if(mFile)
+      fclose(mFile);
+}
+
+
+// The header goes in the file as it is, ahead of the first block
+void WriteBufferThread::writeHeader(const U8 *header, U32 size)
+{
+   fwrite(header, 1, size, mFile);
+   mFileOffset += size;
+}
+
+
+// Returns room for size bytes of records, starting at time, or NULL if the writer is too far behind to take them
+U8 *WriteBufferThread::getBuffer(U32 size, U32 time)
+{
+   TNLAssert(size <= GameRecorderServer::MaxBlockSize, "Record too big for a block!");
+
+   if(mFilling && mBlocks[mHead % QueueLength].size + size > GameRecorderServer::MaxBlockSize)
+      endBlock();
+
+   if(!mFilling)
    {
-      TNLAssert(file != 0, "Must have a file handle");
-      lastPos = 0;
-      currPos = 0;
-      threadPos = 0;
-      exitNow = false;
-      f = file;
-      if(!start())
+      if(getFreeBlocks() == 0)
       {
-         logprintf(LogConsumer::LogWarning, "Failed to create thread for recorder, games may not record");
-         fclose(f);
-			f = NULL;
+         mDropped = true;
+         return NULL;
       }
+
+      Block &block = mBlocks[mHead % QueueLength];
+      block.size = 0;
+      block.time = time;
+      block.flags = mNextFlags | (mDropped ? GameRecorderServer::ResyncBlock : 0);
+
+      mNextFlags = 0;
+      mDropped = false;
+      mFilling = true;
    }
-   ~WriteBufferThread()
-   {
-      exitNow = true;
-      sem1.increment();
-      while(f != 0)         // Wait until the other thread is done
-         Platform::sleep(1);
-   }
+
+   Block &block = mBlocks[mHead % QueueLength];
+   return &block.data[block.size];
+}
+
+
+void WriteBufferThread::addBuffer(U32 size)
+{
+   TNLAssert(mFilling, "Call getBuffer() first!");
+   mBlocks[mHead % QueueLength].size += size;
+}
+
+
+// The next record will start a new block, with flags
+void WriteBufferThread::startBlock(U8 flags)
+{
+   endBlock();
+   mNextFlags = flags;
+}
+
+
+// Hands the block we're filling to the writer
+void WriteBufferThread::endBlock()
+{
+   if(!mFilling)
+      return;
+
+   mFilling = false;
+
+   U32 head = mHead;
+   mHead = head + 1;
+
+#ifdef TNL_NO_THREADS
+   writeQueuedBlocks();
+#else
+   // The writer only sleeps once it has caught up, so there's only a need to wake it if it had
+   if(mTail == head)
+      mWakeup.increment();
+#endif
+}
+
+
+U32 WriteBufferThread::getFreeBlocks() const
+{
+   return QueueLength - (mHead - mTail);
+}
+
+
+// Writes out whatever is left, then the end of the recording and its index.  The writer deletes itself when it's
+// done, so don't touch it again.
+void WriteBufferThread::finish(U32 totalTime)
+{
+   endBlock();
+   mTotalTime = totalTime;
+   mFinishing = true;
+
+#ifdef TNL_NO_THREADS
+   close();
+#else
+   mWakeup.increment();
+#endif
+}
+
+
+// Without threads, Thread::start() would run the writer loop there and then, and it would never return
+bool WriteBufferThread::start()
+{
+#ifdef TNL_NO_THREADS
+   return true;
+#else
+   gLiveWriters++;
+
+   if(Thread::start())
+      return true;
+
+   gLiveWriters--;
+   return false;
+#endif
+}
 
 
-   U8 *getBuffer(U32 size)
+U32 WriteBufferThread::run()
+{
+   while(true)
    {
-      if(currPos + size > sizeof(buffer))
-      {
-         lastPos = currPos;
-         currPos = 0;
-      }
-      U32 t = threadPos;
-      while(t > currPos && t < currPos + size) // Buffer too full, waiting...
+      // Look at this before the queue, so we can't miss a block handed over just before the end
+      bool finishing = mFinishing;
+
+      if(mTail == mHead)
       {
-         Platform::sleep(1);
-         t = threadPos;
+         if(finishing)
+            break;
+
+         mWakeup.wait();
+         continue;
       }
-      return &buffer[currPos];
+
+      writeQueuedBlocks();
    }
-   void addBuffer(U32 size)
+
+   close();
+
+   gLiveWriters--;      // Nothing of ours is touched after this, so waitForWriters() can let the process go
+   return 0;
+}
+
+
+void WriteBufferThread::writeQueuedBlocks()
+{
+   for(U32 tail = mTail; tail != mHead; tail = mTail)
    {
-      currPos += size;
-      sem1.increment();
+      writeBlock(mBlocks[tail % QueueLength]);
+      mTail = tail + 1;
    }
+}
+
+
+// Ends the file and deletes the writer
+void WriteBufferThread::close()
+{
+   writeIndex();
+
+   fclose(mFile);
+   mFile = NULL;
 
-   U32 run()
+   delete this;
+}
+
+
+void WriteBufferThread::writeBlock(const Block &block)
+{
+   U32 storedSize = block.size;
+   U8 flags = block.flags;
+
+   if(mStreamReady && deflateReset(&mStream) == Z_OK)
    {
-      U32 currPos1 = currPos; // currPos could change anytime by other thread
-      while(!exitNow || currPos1 != threadPos)
-      {
-         if(currPos1 < threadPos)
-         {
-
-            fwrite(&buffer[threadPos], 1, lastPos - threadPos, f);
-            threadPos = 0;
-         }
-         else if(currPos1 > threadPos)
-         {
-            fwrite(&buffer[threadPos], 1, currPos1 - threadPos, f);
-            threadPos = currPos1;
-         }
-         else
-            sem1.wait();  // Waits until sem1.increment
-         currPos1 = currPos;
-      }
-      fclose(f);
-      f = 0;
-      return 0;
+      mStream.next_in = const_cast<U8 *>(block.data);
+      mStream.avail_in = block.size;
+      mStream.next_out = mCompressed.address();
+      mStream.avail_out = mCompressed.size();
+
+      if(deflate(&mStream, Z_FINISH) == Z_STREAM_END && mStream.total_out < block.size)
+         storedSize = mStream.total_out;
    }
-};
+
+   if(storedSize == block.size)
+      flags |= GameRecorderServer::UncompressedBlock;
+
+   U8 header[GameRecorderServer::BlockHeaderSize];
+   writeU32(&header[0], storedSize);
+   writeU32(&header[4], block.size | (U32(flags) << 24));
+   writeU32(&header[8], block.time);
+   writeU32(&header[12], crc32(crc32(0, Z_NULL, 0), block.data, block.size));
+
+   if(flags & GameRecorderServer::KeyframeBlock)
+   {
+      RecordingKeyframe keyframe;
+      keyframe.time = block.time;
+      keyframe.offset = mFileOffset;
+      mKeyframes.push_back(keyframe);
+   }
+
+   fwrite(header, 1, sizeof(header), mFile);
+   fwrite((flags & GameRecorderServer::UncompressedBlock) ? block.data : mCompressed.address(), 1, storedSize, mFile);
+   mFileOffset += sizeof(header) + storedSize;
+}
+
+
+// Ends the recording with a block holding just the end record, so it's there even if we were dropping data, then adds
+// the index of keyframes after it, where older players won't look
+void WriteBufferThread::writeIndex()
+{
+   Block &end = mBlocks[0];      // Everything's written, so we can have any of them
+   memset(end.data, 0, GameRecorderServer::RecordHeaderSize);
+   end.size = GameRecorderServer::RecordHeaderSize;
+   end.time = mTotalTime;
+   end.flags = 0;
+   writeBlock(end);
+
+   for(S32 i = 0; i < mKeyframes.size(); i++)
+   {
+      U8 entry[8];
+      writeU32(&entry[0], mKeyframes[i].time);
+      writeU32(&entry[4], mKeyframes[i].offset);
+      fwrite(entry, 1, sizeof(entry), mFile);
+   }
+
+   U8 footer[GameRecorderServer::IndexFooterSize];
+   writeU32(&footer[0], mTotalTime);
+   writeU32(&footer[4], mKeyframes.size());
+   memcpy(&footer[8], IndexTag, TagSize);
+   fwrite(footer, 1, sizeof(footer), mFile);
+}
+
 
 static void gameRecorderScoping(GameRecorderServer *conn, Game *game)
 {
@@ -168,6 +428,9 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
    mWriter = NULL;
    mGame = game;
    mMilliSeconds = 0;
+   mTotalMilliSeconds = 0;
+   mLastKeyframeTime = 0;
+   mDropping = false;
    mWriteMaxBitSize = U32_MAX;
    mPackUnpackShipEnergyMeter = true;
 
@@ -195,12 +458,24 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
       mConnectionParameters.mIsInitiator = false;
       mConnectionParameters.mDebugObjectSizes = false;
 
-      U8 *data = mWriter->getBuffer(4);
-      data[0] = CS_PROTOCOL_VERSION;
-      data[1] = U8(mGhostClassCount);
-      data[2] = U8(mEventClassCount);
-      data[3] = U8(mEventClassCount >> 8) | 0x10;
-      mWriter->addBuffer(4);
+      mDropBuffer.resize(RecordHeaderSize + MaxRecordSize);
+
+      U8 header[4];
+      U32 eventClassCount = mEventClassCount | HeaderEnergyFlag | HeaderBlocksFlag;
+      header[0] = CS_PROTOCOL_VERSION;
+      header[1] = U8(mGhostClassCount);
+      header[2] = U8(eventClassCount);
+      header[3] = U8(eventClassCount >> 8);
+      mWriter->writeHeader(header, sizeof(header));
+
+      if(!mWriter->start())
+      {
+         logprintf(LogConsumer::LogWarning, "Failed to create thread for recorder, games may not record");
+         delete mWriter;
+         mWriter = NULL;
+         return;
+      }
+
       gameRecorderScoping(this, game);
 
       s2cSetServerName(game->getSettings()->getHostName());
@@ -210,8 +485,29 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
 // Destructor
 GameRecorderServer::~GameRecorderServer()
 {
+   // The writer finishes up on its own time, and cleans up after itself; see waitForWriters()
    if(mWriter)
-      delete mWriter;
+      mWriter->finish(mTotalMilliSeconds);
+}
+
+
+// static method
+bool GameRecorderServer::waitForWriters(U32 timeoutMs)
+{
+   U32 start = Platform::getRealMilliseconds();
+
+   while(gLiveWriters > 0)
+   {
+      if(Platform::getRealMilliseconds() - start >= timeoutMs)
+      {
+         logprintf(LogConsumer::LogWarning, "Gave up waiting for %d game recording(s) to be written out", S32(gLiveWriters));
+         return false;
+      }
+
+      Platform::sleep(5);
+   }
+
+   return true;
 }
 
 
@@ -243,8 +539,19 @@ void GameRecorderServer::idle(U32 MilliSeconds)
    GhostPacketNotify notify;
    mNotifyQueueTail = &notify;
 
-   U8 *data = mWriter->getBuffer(16383 + 3);
-   BitStream bstream(&data[3], 16383);
+   U8 *data = mDropping ? NULL : mWriter->getBuffer(RecordHeaderSize + MaxRecordSize, mTotalMilliSeconds);
+
+   // Still write the packet when we're dropping them, so everything carries on as though it went out
+   if(!data)
+   {
+      if(!mDropping)
+         logprintf(LogConsumer::LogWarning, "Recording %s has fallen behind, dropping data until it catches up", mFileName.c_str());
+
+      mDropping = true;
+      data = mDropBuffer.address();
+   }
+
+   BitStream bstream(&data[RecordHeaderSize], MaxRecordSize);
 
    prepareWritePacket();
    GhostConnection::writePacket(&bstream, &notify);
@@ -259,7 +566,306 @@ void GameRecorderServer::idle(U32 MilliSeconds)
    data[0] = U8(size);
    data[1] = U8((size >> 8) & 63) | U8((ms >> 8) << 6);
    data[2] = U8(ms);
-   mWriter->addBuffer(bstream.getBytePosition() + 3);
+
+   if(!mDropping)
+      mWriter->addBuffer(size + RecordHeaderSize);
+
+   mTotalMilliSeconds += ms;
+
+   // Once we've dropped data, the next thing players need is a keyframe, which we only try once there's room for it
+   if(mDropping ? mWriter->getFreeBlocks() >= BlockQueueLength / 2 : mTotalMilliSeconds - mLastKeyframeTime >= KeyframeInterval)
+      writeKeyframe();
+}
+
+
+// Snapshots the game, so players can start from here.  Keyframes take no time, so they go out between packets.
+void GameRecorderServer::writeKeyframe()
+{
+   BitStream snapshot;
+
+   // Won't work while ordered events are queued; we'll try again after the next packet
+   if(!writeSnapshot(&snapshot))
+      return;
+
+   mWriter->startBlock(KeyframeBlock);     // So players can seek straight to it
+
+   const U8 *snapshotData = snapshot.getBuffer();
+   U32 snapshotSize = snapshot.getBytePosition();
+
+   for(U32 pos = 0; pos < snapshotSize; )
+   {
+      U32 chunkSize = min(snapshotSize - pos, U32(MaxRecordSize - KeyframeHeaderSize));
+      U32 size = chunkSize + KeyframeHeaderSize;
+
+      U8 *data = mWriter->getBuffer(size + RecordHeaderSize, mTotalMilliSeconds);
+      if(!data)
+      {
+         mDropping = true;
+         return;
+      }
+
+      data[0] = U8(size);
+      data[1] = U8((size >> 8) & 63);     // No time passes
+      data[2] = 0;
+
+      data[3] = 0;                        // An empty packet, to anyone who doesn't know better
+      memcpy(&data[4], KeyframeTag, TagSize);
+      data[8] = U8((pos == 0 ? FirstKeyframeRecord : 0) | (pos + chunkSize == snapshotSize ? LastKeyframeRecord : 0));
+      memcpy(&data[RecordHeaderSize + KeyframeHeaderSize], &snapshotData[pos], chunkSize);
+
+      mWriter->addBuffer(size + RecordHeaderSize);
+      pos += chunkSize;
+   }
+
+   mLastKeyframeTime = mTotalMilliSeconds;
+   mDropping = false;
+}
+
+
+S32 GameRecorderServer::getKeyframeFlags(const U8 *record, U32 size)
+{
+   if(size < KeyframeHeaderSize || record[0] != 0 || memcmp(&record[1], KeyframeTag, TagSize) != 0)
+      return -1;
+
+   return record[5];
+}
+
+
+// Leaves the file somewhere in the index; seek back before reading any packets
+bool GameRecorderServer::readIndex(FILE *file, U32 &totalTime, Vector<RecordingKeyframe> &keyframes)
+{
+   U8 footer[IndexFooterSize];
+
+   if(fseek(file, -S32(IndexFooterSize), SEEK_END) != 0 || fread(footer, 1, IndexFooterSize, file) != IndexFooterSize ||
+      memcmp(&footer[8], IndexTag, TagSize) != 0)
+      return false;
+
+   U32 count = readU32(&footer[4]);
+   S32 indexStart = S32(ftell(file)) - IndexFooterSize - S32(count * 8);
+
+   // Header and end record, at least, come before the index
+   if(count > U32(S32_MAX / 8) || indexStart < 4 + RecordHeaderSize || fseek(file, indexStart, SEEK_SET) != 0)
+      return false;
+
+   keyframes.resize(count);
+   for(U32 i = 0; i < count; i++)
+   {
+      U8 entry[8];
+      if(fread(entry, 1, 8, file) != 8)
+         return false;
+
+      keyframes[i].time = readU32(&entry[0]);
+      keyframes[i].offset = readU32(&entry[4]);
+
+      if(keyframes[i].offset >= U32(indexStart) || (i > 0 && keyframes[i].time < keyframes[i - 1].time))
+         return false;
+   }
+
+   totalTime = readU32(&footer[0]);
+   return true;
+}
+
+
+// Constructor
+RecordingReader::RecordingReader()
+{
+   mFile = NULL;
+   mBlocks = false;
+   mBlockPos = 0;
+   mBlockOffset = 0;
+   mBlockTime = 0;
+   mBlockFlags = 0;
+   mRecordOffset = 0;
+   mFirstInBlock = false;
+}
+
+
+// Destructor
+RecordingReader::~RecordingReader()
+{
+   close();
+}
+
+
+bool RecordingReader::open(const char *filename, U8 *header)
+{
+   close();
+
+   mFile = fopen(filename, "rb");
+   if(!mFile)
+      return false;
+
+   if(fread(header, 1, 4, mFile) != 4)
+   {
+      close();
+      return false;
+   }
+
+   mBlocks = ((U32(header[3]) << 8) & GameRecorderServer::HeaderBlocksFlag) != 0;
+   return rewind();
+}
+
+
+void RecordingReader::close()
+{
+   if(mFile)
+      fclose(mFile);
+
+   mFile = NULL;
+   mBlock.clear();
+   mBlockPos = 0;
+}
+
+
+bool RecordingReader::isOpen() const
+{
+   return mFile != NULL;
+}
+
+
+// Leaves us where we were
+bool RecordingReader::readIndex(U32 &totalTime, Vector<RecordingKeyframe> &keyframes)
+{
+   if(!mFile)
+      return false;
+
+   S32 filepos = ftell(mFile);
+   bool found = GameRecorderServer::readIndex(mFile, totalTime, keyframes);
+   fseek(mFile, filepos, SEEK_SET);
+
+   return found;
+}
+
+
+bool RecordingReader::readBlock()
+{
+   mBlock.clear();
+   mBlockPos = 0;
+   mBlockOffset = U32(ftell(mFile));
+
+   U8 header[GameRecorderServer::BlockHeaderSize];
+   if(fread(header, 1, sizeof(header), mFile) != sizeof(header))
+      return false;
+
+   U32 storedSize = readU32(&header[0]);
+   U32 size = readU32(&header[4]) & 0xFFFFFF;
+   mBlockFlags = header[7];
+   mBlockTime = readU32(&header[8]);
+   U32 crc = readU32(&header[12]);
+
+   bool uncompressed = (mBlockFlags & GameRecorderServer::UncompressedBlock) != 0;
+
+   if(size == 0 || size > GameRecorderServer::MaxBlockSize || (uncompressed ? storedSize != size : storedSize >= size))
+      return false;
+
+   mCompressed.resize(storedSize);
+   if(fread(mCompressed.address(), 1, storedSize, mFile) != storedSize)
+      return false;
+
+   mBlock.resize(size);
+
+   if(uncompressed)
+      memcpy(mBlock.address(), mCompressed.address(), size);
+   else
+   {
+      uLongf uncompressedSize = size;
+      if(uncompress(mBlock.address(), &uncompressedSize, mCompressed.address(), storedSize) != Z_OK || uncompressedSize != size)
+      {
+         mBlock.clear();
+         return false;
+      }
+   }
+
+   if(crc32(crc32(0, Z_NULL, 0), mBlock.address(), size) != crc)
+   {
+      logprintf(LogConsumer::LogWarning, "Recording is damaged at offset %d", mBlockOffset);
+      mBlock.clear();
+      return false;
+   }
+
+   return true;
+}
+
+
+bool RecordingReader::readRecord(U8 *data, U32 &size, U32 &milliseconds)
+{
+   if(!mFile)
+      return false;
+
+   const U32 HeaderSize = GameRecorderServer::RecordHeaderSize;
+   U8 header[HeaderSize];
+
+   if(mBlocks)
+   {
+      mFirstInBlock = mBlockPos >= U32(mBlock.size());
+      if(mFirstInBlock && !readBlock())
+         return false;
+
+      if(mBlockPos + HeaderSize > U32(mBlock.size()))
+         return false;
+
+      memcpy(header, mBlock.address() + mBlockPos, HeaderSize);
+   }
+   else
+   {
+      mRecordOffset = U32(ftell(mFile));
+      if(fread(header, 1, HeaderSize, mFile) != HeaderSize)
+         return false;
+   }
+
+   size = (U32(header[1] & 63) << 8) + header[0];
+   milliseconds = (U32(header[1] >> 6) << 8) + header[2];
+
+   if(size == 0 || size > GameRecorderServer::MaxRecordSize)    // End of the recording
+      return false;
+
+   if(mBlocks)
+   {
+      if(mBlockPos + HeaderSize + size > U32(mBlock.size()))
+         return false;
+
+      memcpy(data, mBlock.address() + mBlockPos + HeaderSize, size);
+      mBlockPos += HeaderSize + size;
+      return true;
+   }
+
+   return fread(data, 1, size, mFile) == size;
+}
+
+
+bool RecordingReader::seek(U32 offset)
+{
+   if(!mFile)
+      return false;
+
+   mBlock.clear();
+   mBlockPos = 0;
+
+   return fseek(mFile, offset, SEEK_SET) == 0;
+}
+
+
+bool RecordingReader::rewind()
+{
+   return seek(4);
+}
+
+
+U32 RecordingReader::getRecordOffset() const
+{
+   return mBlocks ? mBlockOffset : mRecordOffset;
+}
+
+
+bool RecordingReader::isResync() const
+{
+   return mBlocks && mFirstInBlock && (mBlockFlags & GameRecorderServer::ResyncBlock);
+}
+
+
+U32 RecordingReader::getBlockTime() const
+{
+   return mBlockTime;
 }
 
 
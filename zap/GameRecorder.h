@@ -17,6 +17,24 @@ namespace Zap {
 class ServerGame;
 class WriteBufferThread;
 
+// Where a recording can be played from without playing what came before
+struct RecordingKeyframe
+{
+   U32 time;      // Milliseconds from the start of the recording
+   U32 offset;    // Position in the file of the keyframe's first record
+};
+
+
+// A recording is a 4 byte header, then a record for each packet: 3 bytes of packet size and milliseconds since the
+// last one, then the packet.  A record of size 0 ends it.
+//
+// Every KeyframeInterval we also write a keyframe, a snapshot of the game that can be played from.  These are split
+// over records that begin with an empty packet, which players that don't know about keyframes read and move past.
+// A recording that was finished properly ends with an index of its keyframes, after the end record.
+//
+// Recordings with HeaderBlocksFlag set keep their records in compressed blocks, each with a BlockHeaderSize header:
+// stored size, raw size and BlockFlags, milliseconds from the start of the recording, and a CRC of the raw records.
+// Records never span blocks, and keyframes always start one, so the index points at blocks.
 class GameRecorderServer : public GameConnection
 {
    typedef GhostConnection Parent;
@@ -27,16 +45,100 @@ private:
    TNL::NetObject mNetObj;
    U32 mMilliSeconds;
 
+   U32 mTotalMilliSeconds;          // Length of the recording so far
+   U32 mLastKeyframeTime;
+   bool mDropping;                  // mWriter fell behind, so we're throwing packets away until the next keyframe
+   Vector<U8> mDropBuffer;
+
+   void writeKeyframe();
+
 public:
+   enum {
+      RecordHeaderSize = 3,
+      MaxRecordSize = 16382,        // Sizes are 14 bits, and players take anything bigger than this as the end
+      KeyframeHeaderSize = 6,       // Empty packet, tag and flags at the start of each keyframe record
+      KeyframeInterval = 10000,     // Milliseconds
+      IndexFooterSize = 12,
+
+      HeaderEnergyFlag = 0x1000,    // Set in the header's event class count
+      HeaderBlocksFlag = 0x2000,    // Older players see a count they can't have, and refuse the file
+
+      BlockHeaderSize = 16,
+      MaxBlockSize = 65536,         // Uncompressed
+      BlockQueueLength = 32,        // Blocks waiting for the disk before we start dropping data
+   };
+
+   enum KeyframeFlags {
+      FirstKeyframeRecord = BIT(0),
+      LastKeyframeRecord = BIT(1),
+   };
+
+   enum BlockFlags {
+      KeyframeBlock = BIT(0),       // Starts with a keyframe
+      ResyncBlock = BIT(1),         // Data was dropped before this block; play on from the keyframe it starts with
+      UncompressedBlock = BIT(2),   // Didn't compress, so it was stored as it was
+   };
+
    string mFileName;
 
    static string buildGameRecorderExtension();
 
+   // Returns the KeyframeFlags of a keyframe record, or -1 if the record is an ordinary packet
+   static S32 getKeyframeFlags(const U8 *record, U32 size);
+
+   // Reads the index from the end of a recording, if it has one
+   static bool readIndex(FILE *file, U32 &totalTime, Vector<RecordingKeyframe> &keyframes);
+
+   // Recordings are finished off on threads of their own after the recorder is deleted; this waits for all of them
+   // to be written out.  Returns false if some were still going when we gave up.
+   static bool waitForWriters(U32 timeoutMs);
+
    GameRecorderServer(ServerGame *game);
    ~GameRecorderServer();
 
    void idle(TNL::U32 MilliSeconds);
 };
 
+
+// Reads the records of a recording back, in either format
+class RecordingReader
+{
+private:
+   FILE *mFile;
+   bool mBlocks;              // Records are in compressed blocks
+
+   Vector<U8> mBlock;         // Records of the current block
+   Vector<U8> mCompressed;
+   U32 mBlockPos;
+   U32 mBlockOffset;          // Where the current block starts in the file
+   U32 mBlockTime;
+   U32 mBlockFlags;
+   U32 mRecordOffset;         // Where the last record read starts in the file, for recordings without blocks
+   bool mFirstInBlock;        // Last record read was the first of its block
+
+   bool readBlock();
+
+public:
+   RecordingReader();
+   virtual ~RecordingReader();
+
+   bool open(const char *filename, U8 *header);    // Fills header with the recording's first 4 bytes
+   void close();
+   bool isOpen() const;
+
+   bool readIndex(U32 &totalTime, Vector<RecordingKeyframe> &keyframes);
+
+   // Reads the next record into data, which needs room for MaxRecordSize bytes.  Returns false at the end, or where
+   // the recording is damaged.
+   bool readRecord(U8 *data, U32 &size, U32 &milliseconds);
+
+   bool seek(U32 offset);     // To a keyframe's offset
+   bool rewind();             // To the first record
+
+   U32 getRecordOffset() const;     // Where to seek() to read the last record again, if it started a keyframe
+   bool isResync() const;           // Last record read was the first after data was dropped
+   U32 getBlockTime() const;
+};
+
 }
 #endif
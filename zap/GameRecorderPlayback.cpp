@@ -72,35 +72,31 @@ static void resetRenderState(ClientGame *game)
 
 GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filename) : GameConnection(game, false)
 {
-   mFile = NULL;
    mGame = game;
    mMilliSeconds = 0;
    mSizeToRead = 0;
    mCurrentTime = 0;
    mTotalTime = 0;
    mIsButtonHeldDown = false;
+   mRecord.resize(GameRecorderServer::MaxRecordSize);
 
-   if(!mFile)
-      mFile = fopen(filename, "rb");
-
-   if(mFile)
+   U8 data[4];
+   if(mReader.open(filename, data))
    {
-      U8 data[4];
-      data[0] = 0;
-      fread(data, 1, 4, mFile);
       mGhostClassCount = data[1];
       mEventClassCount = U32(data[2]) | (U32(data[3]) << 8);
-      if(mEventClassCount & 0x1000)
+      if(mEventClassCount & GameRecorderServer::HeaderEnergyFlag)
       {
          mPackUnpackShipEnergyMeter = true;
-         mEventClassCount &= ~0x1000;
+         mEventClassCount &= ~GameRecorderServer::HeaderEnergyFlag;
       }
+      mEventClassCount &= ~GameRecorderServer::HeaderBlocksFlag;     // Reader takes care of that
+
       if(data[0] != CS_PROTOCOL_VERSION || 
          mEventClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeEvent) || 
          mGhostClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeObject))
       {
-         fclose(mFile); // Wrong version, warn about this problem?
-         mFile = NULL;
+         mReader.close(); // Wrong version, warn about this problem?
       }
 
       setGhostFrom(false);
@@ -113,34 +109,52 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
    mConnectionParameters.mDebugObjectSizes = false;
 
 
-   if(mFile)
+   if(mReader.isOpen())
+   {
+      // Recordings that weren't finished properly, or that predate keyframes, have no index, so we find our own way
+      if(!mReader.readIndex(mTotalTime, mKeyframes))
+      {
+         mTotalTime = 0;
+         mKeyframes.clear();
+         findKeyframes();
+      }
+
+      mReader.rewind();
+   }
+}
+
+
+// Reads through the whole file for its length and keyframes
+void GameRecorderPlayback::findKeyframes()
+{
+   U32 size, milli;
+
+   while(mReader.readRecord(mRecord.address(), size, milli))
    {
-      S32 filepos = ftell(mFile);
-      while(true)
+      if(mReader.isResync())
+         mTotalTime = mReader.getBlockTime();
+
+      mTotalTime += milli;
+
+      S32 flags = GameRecorderServer::getKeyframeFlags(mRecord.address(), size);
+      if(milli == 0 && flags != -1 && (flags & GameRecorderServer::FirstKeyframeRecord))
       {
-         U8 data[3];
-         if(fread(data, 1, 3, mFile) != 3)
-            break;
-         U32 size = (U32(data[1] & 63) << 8) + data[0];
-         U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
-         if(size == 0)
-            break;
-         mTotalTime += milli;
-         fseek(mFile, size, SEEK_CUR);
+         RecordingKeyframe keyframe;
+         keyframe.time = mTotalTime;
+         keyframe.offset = mReader.getRecordOffset();
+         mKeyframes.push_back(keyframe);
       }
-      fseek(mFile, filepos, SEEK_SET);
    }
 }
 
 
 GameRecorderPlayback::~GameRecorderPlayback()
 {
-   if(mFile)
-      fclose(mFile);
+   // Do nothing
 }
 
 
-bool GameRecorderPlayback::isValid()     { return mFile != NULL; }
+bool GameRecorderPlayback::isValid()     { return mReader.isOpen(); }
 bool GameRecorderPlayback::lostContact() { return false; }
 
 
@@ -203,7 +217,7 @@ void GameRecorderPlayback::updateSpectate()
 
 void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
 {
-   if(!mFile)
+   if(!mReader.isOpen())
    {
       //disconnect(ReasonShutdown, "");
       return;
@@ -212,8 +226,6 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
    if(mSizeToRead != 0)
       idleObjects(mGame, MilliSeconds);
 
-   U8 data[16384 - 1];  // 16 KB on stack memory (no memory allocation/deallocation speed cost)
-
    if(mGame->getGameType())
       mGame->getGameType()->idle(BfObject::ClientIdlingNotLocalShip, MilliSeconds < U32(mMilliSeconds) ? MilliSeconds : U32(mMilliSeconds));
 
@@ -228,28 +240,24 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mPacketRecvBytesTotal += mSizeToRead;
          mPacketRecvCount++;
 
-         if(fread(data, 1, mSizeToRead, mFile) == mSizeToRead)
-         {
-            BitStream bstream(data, mSizeToRead);
-            GhostConnection::readPacket(&bstream);
-         }
+         BitStream bstream(mRecord.address(), mSizeToRead);
+         GhostConnection::readPacket(&bstream);
          mSizeToRead = 0;
       }
 
-      if(fread(data, 1, 3, mFile) != 3)
-         break; // Could not read 3 bytes
-
-      U32 size = (U32(data[1] & 63) << 8) + data[0];
-      U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
-      mCurrentTime += milli;
-      mMilliSeconds += milli;
-
-      if(size == 0 || size >= sizeof(data)) // End of file?
+      U32 size, milli;
+      if(!mReader.readRecord(mRecord.address(), size, milli)) // End of file?
       {
          mMilliSeconds = S32_MAX;
          break;
       }
 
+      if(resync())
+         continue;
+
+      mCurrentTime += milli;
+      mMilliSeconds += milli;
+
       mSizeToRead = size;
 
       if(mGame->getGameType())
@@ -260,6 +268,51 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
 }
 
 
+// Plays the next packet straight away, without idling anything or waiting for its time to come, for getting through
+// recordings as fast as they can be read.  size is 0 for records that aren't packets.  Returns false at the end.
+bool GameRecorderPlayback::playNextPacket(U32 &size)
+{
+   U32 milli;
+   if(!mReader.isOpen() || !mReader.readRecord(mRecord.address(), size, milli))
+      return false;
+
+   if(resync() || GameRecorderServer::getKeyframeFlags(mRecord.address(), size) != -1)
+   {
+      size = 0;
+      return true;
+   }
+
+   mCurrentTime += milli;
+
+   mPacketRecvBytesLast = size;
+   mPacketRecvBytesTotal += size;
+   mPacketRecvCount++;
+
+   BitStream bstream(mRecord.address(), size);
+   GhostConnection::readPacket(&bstream);
+
+   mGame->processDeleteList(milli);
+
+   return true;
+}
+
+
+// Some of the game was dropped while it was being recorded, so we pick it up again from the keyframe after.  Returns
+// true if the record just read was that keyframe.
+bool GameRecorderPlayback::resync()
+{
+   if(!mReader.isResync())
+      return false;
+
+   RecordingKeyframe keyframe;
+   keyframe.time = mReader.getBlockTime();
+   keyframe.offset = mReader.getRecordOffset();
+
+   loadKeyframe(keyframe);
+   return true;
+}
+
+
 void GameRecorderPlayback::restart()
 {
    deleteLocalGhosts();
@@ -269,8 +322,72 @@ void GameRecorderPlayback::restart()
    clearRecvEvents();
    mGame->clearClientList();
 
-   if(mFile)
-      fseek(mFile, 4, SEEK_SET);
+   mReader.rewind();
+}
+
+
+// Replaces everything we've played so far with the game as it was at keyframe, leaving us ready to play on from there
+bool GameRecorderPlayback::loadKeyframe(const RecordingKeyframe &keyframe)
+{
+   if(!mReader.seek(keyframe.offset))
+      return false;
+
+   Vector<U8> snapshot;
+   U8 *data = mRecord.address();
+
+   while(true)
+   {
+      U32 size, milli;
+      if(!mReader.readRecord(data, size, milli))
+         return false;
+
+      S32 flags = GameRecorderServer::getKeyframeFlags(data, size);
+      if(flags == -1 || (snapshot.size() == 0) != ((flags & GameRecorderServer::FirstKeyframeRecord) != 0))
+         return false;
+
+      U32 chunkSize = size - GameRecorderServer::KeyframeHeaderSize;
+      snapshot.resize(snapshot.size() + chunkSize);
+      memcpy(snapshot.address() + snapshot.size() - chunkSize, &data[GameRecorderServer::KeyframeHeaderSize], chunkSize);
+
+      if(flags & GameRecorderServer::LastKeyframeRecord)
+         break;
+   }
+
+   deleteLocalGhosts();
+   mGame->clearClientList();
+
+   BitStream bstream(snapshot.address(), snapshot.size());
+   if(!readSnapshot(&bstream))
+      return false;
+
+   mMilliSeconds = 0;
+   mSizeToRead = 0;
+   mCurrentTime = keyframe.time;
+
+   return true;
+}
+
+
+// Plays on to time, starting over from the last keyframe before it if that will get us there quicker
+void GameRecorderPlayback::seek(U32 time)
+{
+   S32 keyframe = -1;
+   for(S32 i = 0; i < mKeyframes.size() && mKeyframes[i].time <= time; i++)
+      keyframe = i;
+
+   if(keyframe != -1 && (time < mCurrentTime || mKeyframes[keyframe].time > mCurrentTime))
+   {
+      // Keyframes cut short by data dropped while recording won't load, but the one before might
+      while(keyframe != -1 && !loadKeyframe(mKeyframes[keyframe]))
+         keyframe--;
+
+      if(keyframe == -1)
+         restart();
+   }
+   else if(time < mCurrentTime)
+      restart();
+
+   processMoreData(time - mCurrentTime);
 }
 
 // --------
@@ -427,6 +544,7 @@ PlaybackGameUserInterface::PlaybackGameUserInterface(ClientGame *game) : UserInt
    mSpeed = 0;
    mSpeedRemainder = 0;
    mVisible = true;
+   mScrubbing = false;
    mDisableMouseTimer.setPeriod(DISABLE_MOUSE_TIME);
 }
 
@@ -438,6 +556,7 @@ void PlaybackGameUserInterface::onActivate()
    mSpeed = 2;
    mSpeedRemainder = 0;
    mVisible = true;
+   mScrubbing = false;
 
    // Clear out any lingering server or chat messages
    mGameInterface->clearDisplayers();
@@ -526,23 +645,26 @@ bool PlaybackGameUserInterface::onKeyDown(InputCode inputCode)
       }
       else if(y >= playbackBar_y && y <= playbackBar_y + playbackBar_h)
       {
-         F32 x2 = (x - playbackBar_x) / playbackBar_w;
-         if(x2 < 0)
-            x2 = 0;
-         if(x2 > 1)
-            x2 = 1;
-
-         U32 time = U32(x2 * mPlaybackConnection->mTotalTime);
+         mScrubbing = true;
+         seekToMouse();
+         return true;
+      }
+   }
 
-         // TODO: maybe we need to seek more efficiency by avoiding having to start all over from the beginning
-         if(time < mPlaybackConnection->mCurrentTime)
-            mPlaybackConnection->restart();
+   // Skip back or forward a keyframe's worth
+   if(inputCode == KEY_LEFT || inputCode == KEY_RIGHT)
+   {
+      U32 time = mPlaybackConnection->mCurrentTime;
+      const U32 step = GameRecorderServer::KeyframeInterval;
 
-         mPlaybackConnection->processMoreData(time - mPlaybackConnection->mCurrentTime);
-         resetRenderState(getGame());
+      if(inputCode == KEY_LEFT)
+         time = time > step ? time - step : 0;
+      else
+         time = min(time + step, mPlaybackConnection->mTotalTime);
 
-         return true;
-      }
+      mPlaybackConnection->seek(time);
+      resetRenderState(getGame());
+      return true;
    }
 
    // Next player
@@ -587,7 +709,15 @@ bool PlaybackGameUserInterface::onKeyDown(InputCode inputCode)
 }
 
 
-void PlaybackGameUserInterface::onKeyUp(InputCode inputCode) { mGameInterface->onKeyUp(inputCode); }
+void PlaybackGameUserInterface::onKeyUp(InputCode inputCode)
+{
+   if(inputCode == MOUSE_LEFT)
+      mScrubbing = false;
+
+   mGameInterface->onKeyUp(inputCode);
+}
+
+
 void PlaybackGameUserInterface::onTextInput(char ascii)      { mGameInterface->onTextInput(ascii); }
 
 
@@ -599,6 +729,25 @@ void PlaybackGameUserInterface::onMouseMoved()
 
    // Show playback controls if mouse moves
    mVisible = true;
+
+   if(mScrubbing)
+      seekToMouse();
+}
+
+
+// Jumps to the time under the mouse on the playback bar
+void PlaybackGameUserInterface::seekToMouse()
+{
+   F32 x = DisplayManager::getScreenInfo()->getMousePos()->x;
+
+   F32 x2 = (x - playbackBar_x) / playbackBar_w;
+   if(x2 < 0)
+      x2 = 0;
+   if(x2 > 1)
+      x2 = 1;
+
+   mPlaybackConnection->seek(U32(x2 * mPlaybackConnection->mTotalTime));
+   resetRenderState(getGame());
 }
 
 
@@ -10,6 +10,7 @@
 #include "tnlGhostConnection.h"
 #include "tnlNetObject.h"
 #include "gameConnection.h"
+#include "GameRecorder.h"
 
 #include "UIMenus.h"
 
@@ -23,11 +24,17 @@ class Timer;
 class GameRecorderPlayback : public GameConnection
 {
    typedef GameConnection Parent;
-   FILE *mFile;
+   RecordingReader mReader;
    ClientGame *mGame;
    S32 mMilliSeconds;
    U32 mSizeToRead;
+   Vector<U8> mRecord;           // Waiting to be played, once mMilliSeconds have passed
    SafePtr<ClientInfo> mClientInfoSpectating;
+   Vector<RecordingKeyframe> mKeyframes;
+
+   void findKeyframes();
+   bool loadKeyframe(const RecordingKeyframe &keyframe);
+   bool resync();
 public:
    StringTableEntry mClientInfoSpectatingName;
    bool mIsButtonHeldDown;
@@ -45,7 +52,9 @@ public:
 
    void updateSpectate();
    void processMoreData(TNL::U32 MilliSeconds);
+   bool playNextPacket(U32 &size);
    void restart();
+   void seek(U32 time);
 };
 
 
@@ -80,6 +89,9 @@ private:
    U32 mSpeed;
    U32 mSpeedRemainder;
    bool mVisible;
+   bool mScrubbing;     // Mouse went down on the playback bar and is still down
+
+   void seekToMouse();
    Timer mDisableMouseTimer;
 
 public:
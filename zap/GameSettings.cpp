@@ -11,6 +11,7 @@
 #include "stringUtils.h"      // For itos
 #include "LuaWrapper.h"       // For printing Lua class hiearchy
 #include "LevelSource.h"
+#include "ServerGame.h"       // For building bot zones
 
 #include "tnlTypes.h"         // For TNL_OS_WIN32 def
 #include "tnlLog.h"           // For logprintf
@@ -103,6 +104,7 @@ ParamInfo paramDefs[] = {
 { "plugindir",             ONE_REQUIRED,   PLUGIN_DIR,            3, "<path>",                "Folder where editor plugins are stored",     "You must specify your plugins folder with the -plugindir option" },
 { "fontsdir",              ONE_REQUIRED,   FONTS_DIR,             3, "<path>",                "Folder where fonts are stored",              "You must specify your fonts folder with the -fontsdir option" },
 { "recorddir",             ONE_REQUIRED,   RECORD_DIR,            3, "<path>",                "Folder where recording gameplay are stored", "You must specify your recorded gameplay folder with the -recorddir option" },
+{ "cachedir",              ONE_REQUIRED,   CACHE_DIR,             3, "<path>",                "Folder where level geometry from servers, and bot zones, are kept", "You must specify your cache folder with the -cachedir option" },
 
 // Developer-oriented options
 { "loss",                  ONE_REQUIRED,   SIMULATED_LOSS,        4, "<float>",   "Simulate the specified amount of packet loss, from 0 (no loss) to 1 (all packets lost) Note: Client only!", "You must specify a loss rate between 0 and 1 with the -loss option" },
@@ -133,9 +135,11 @@ DirectiveInfo directiveDefs[] = {
 // Advanced server management options
 { "getres",  FOUR_REQUIRED,  SEND_RESOURCE, 5, GameSettings::getRes,    "<server address> <admin password> <resource name> <LEVEL|LEVELGEN|BOT>", "Send a resource to a remote server. Address must be specified in the form IP:nnn.nnn.nnn.nnn:port. The server must be running, have an admin password set, and have resource management enabled ([Host] section in the bitfighter.ini file).", "Usage: bitfighter getres <server address> <admin password> <resource name> <LEVEL|LEVELGEN|BOT>" },
 { "sendres", FOUR_REQUIRED,  GET_RESOURCE,  5, GameSettings::sendRes,   "<server address> <admin password> <resource name> <LEVEL|LEVELGEN|BOT>", "Retrieve a resource from a remote server, with same requirements as -sendres.",                                                                                                                                                                "Usage: bitfighter sendres <server address> <admin password> <resource name> <LEVEL|LEVELGEN|BOT>" },
+{ "buildzones", NO_PARAMETERS, BUILD_BOT_ZONES, 5, GameSettings::buildBotZones, "", "Build bot zones for all the levels the server would play (see -leveldir, -levels, and -playlist), and keep them in the cache folder, so the server won't have to build them as each level loads. Levels with levelgens are skipped.", "" },
 
 // Other commands
 { "rules",   NO_PARAMETERS,  SHOW_RULES,        6, GameSettings::showRules,      "",  "Print a list of \"rules of the game\" and other possibly useful data", "" },
+{ "analyze", ALL_REMAINING,  ANALYZE_RECORDINGS, 6, GameSettings::analyzeRecordings, "<csv|json> <recording or folder 1> [recording or folder 2]...", "Play recorded games through as fast as possible, without showing them, and write out object counts for every packet, update bandwidth for each object class, and kill and flag events.  Results go next to each recording.  Note that all remaining items on the command line will be interpreted as recordings, so this must be the last parameter.", "Usage: bitfighter -analyze <csv|json> <recording or folder 1> [recording or folder 2]..." },
 { "help",    NO_PARAMETERS,  HELP,              6, GameSettings::showHelp,       "",  "Display this message", "" },
 { "version", NO_PARAMETERS,  VERSION,           6, GameSettings::showVersion,    "",  "Print version information", "" },
 
@@ -364,7 +368,8 @@ FolderManager GameSettings::getCmdLineFolderManager()
                           getString(ROOT_DATA_DIR),
                           getString(PLUGIN_DIR),
                           getString(FONTS_DIR),
-                          getString(RECORD_DIR));
+                          getString(RECORD_DIR),
+                          getString(CACHE_DIR));
 }
 
 
@@ -1041,6 +1046,37 @@ void GameSettings::showRules(GameSettings *settings, const Vector<string> &words
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+// Precompute bot zones with the -buildzones option
+
+void GameSettings::buildBotZones(GameSettings *settings, const Vector<string> &words)
+{
+   writeToConsole();
+   exitToOs(ServerGame::buildBotZoneCache(settings) ? 0 : 1);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+// Analyze recorded games with the -analyze option
+
+#ifndef ZAP_DEDICATED
+extern void analyzeRecordings(GameSettings *settings, const Vector<string> &words);
+#endif
+
+void GameSettings::analyzeRecordings(GameSettings *settings, const Vector<string> &words)
+{
+#ifdef ZAP_DEDICATED
+   writeToConsole();
+   printf("Recorded games can only be analyzed by the full game, not the dedicated server\n");
+   exitToOs(1);
+#else
+   Zap::analyzeRecordings(settings, words);
+#endif
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 // Print help message with -help
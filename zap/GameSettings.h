@@ -65,6 +65,7 @@ enum ParamId {
    MUSIC_DIR,
    FONTS_DIR,
    RECORD_DIR,
+   CACHE_DIR,
 
    SIMULATED_LOSS,
    SIMULATED_LAG,
@@ -73,8 +74,10 @@ enum ParamId {
 
    SEND_RESOURCE,
    GET_RESOURCE,
+   BUILD_BOT_ZONES,
    SHOW_RULES,
    SHOW_LUA_CLASSES,
+   ANALYZE_RECORDINGS,
    HELP,
    VERSION,
 
@@ -281,7 +284,9 @@ public:
 
    static void getRes(GameSettings *settings, const Vector<string> &words);
    static void sendRes(GameSettings *settings, const Vector<string> &words);
+   static void buildBotZones(GameSettings *settings, const Vector<string> &words);
    static void showRules(GameSettings *settings, const Vector<string> &words);
+   static void analyzeRecordings(GameSettings *settings, const Vector<string> &words);
    static void showHelp(GameSettings *settings, const Vector<string> &words);
    static void showVersion(GameSettings *settings, const Vector<string> &words);
 
@@ -42,6 +42,13 @@
 #include <math.h>
 #include <deque>
 
+// The packed polygon routines only vectorize where the scalar float math is also done in SSE registers;
+// with x87 math the scalar versions round differently and the two would no longer agree bit for bit
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || (defined(__SSE2__) && defined(__SSE2_MATH__))
+#  define BF_PACKED_POLYGON_SSE2
+#  include <emmintrin.h>
+#endif
+
 using namespace TNL;
 using namespace ClipperLib;
 
@@ -219,37 +226,32 @@ bool triangulatedFillContains(const Vector<Point> *triangulatedFillPoints, const
 }
 
 
-//// Based on http://www.opengl.org/discussion_boards/ubbthreads.php?ubb=showflat&Number=248453
-//// No idea if this is optimal or not, but it is only used in the editor, and works fine for our purposes.
-//bool isConvex(const Vector<Point> *verts)
-//{
-//  Point v1, v2;
-//  double det_value, cur_det_value;
-//  int num_vertices = verts->size();
-//  
-//  if(num_vertices < 3)
-//     return true;
-//  
-//  v1 = verts->get(0) - verts->get(num_vertices-1);
-//  v2 = verts->get(1) - verts->get(0);
-//  det_value = v1.determinant(v2);
-//  
-//  for(S32 i = 1 ; i < num_vertices-1 ; i++)
-//  {
-//    v1 = v2;
-//    v2 = verts->get(i+1) - verts->get(i);
-//    cur_det_value = v1.determinant(v2);
-//    
-//    if( (cur_det_value * det_value) < 0.0 )
-//      return false;
-//  }
-//  
-//  v1 = v2;
-//  v2 = verts->get(0) - verts->get(num_vertices-1);
-//  cur_det_value = v1.determinant(v2);
-//  
-//  return  (cur_det_value * det_value) >= 0.0;
-//}
+// Returns true if every turn going around the polygon is the same way; straight runs don't count either way
+bool isConvex(const Vector<Point> *verts)
+{
+   S32 vertCount = verts->size();
+
+   if(vertCount < 3)
+      return true;
+
+   F32 lastTurn = 0;
+
+   for(S32 i = 0; i < vertCount; i++)
+   {
+      Point v1 = verts->get(i) - verts->get(i == 0 ? vertCount - 1 : i - 1);
+      Point v2 = verts->get(i == vertCount - 1 ? 0 : i + 1) - verts->get(i);
+
+      F32 turn = v1.determinant(v2);
+
+      if(turn * lastTurn < 0)
+         return false;
+
+      if(turn != 0)
+         lastTurn = turn;
+   }
+
+   return true;
+}
 
 
 // If the sum of the radii is greater than the distance between the center points,
@@ -265,6 +267,47 @@ bool circleCircleIntersect(const Point &center1, F32 radius1, const Point &cente
 }
 
 
+// Closest point test of a circle against the polygon edge running from v1 back to v2.  This is the body
+// of polygonCircleIntersect(), shared with the packed version so both make exactly the same decisions.
+static inline void circleEdgeIntersect(const Point &v1, const Point &v2, const Point &inCenter, F32 &inRadiusSq,
+                                       Point &outPoint, const Point *ignoreVelocityEpsilon, bool &collision)
+{
+   // Get fraction where the closest point to this edge occurs
+   Point v1_v2 = v2 - v1;
+   Point v1_center = inCenter - v1;
+   F32 fraction = v1_center.dot(v1_v2);
+   if (fraction < 0.0f)
+   {
+      // Closest point is v1
+      F32 dist_sq = v1_center.lenSquared();
+      if (dist_sq <= inRadiusSq)
+         if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(v1 - inCenter) > 0)
+         {
+            collision = true;
+            outPoint = v1;
+            inRadiusSq = dist_sq;
+         }
+   }
+   else
+   {
+      F32 v1_v2_len_sq = v1_v2.lenSquared();
+      if (fraction <= v1_v2_len_sq)
+      {
+         // Closest point is on line segment
+         Point point = v1 + v1_v2 * (fraction / v1_v2_len_sq);
+         F32 dist_sq = (point - inCenter).lenSquared();
+         if (dist_sq <= inRadiusSq)
+            if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(point - inCenter) > 0)
+            {
+               collision = true;
+               outPoint = point;
+               inRadiusSq = dist_sq;
+            }
+      }
+   }
+}
+
+
 // Check if circle at inCenter with radius^2 = inRadiusSq intersects with a polygon.
 // Function returns true when it does and the intersection point is in outPoint
 // Works only for convex hulls.. maybe no longer true... may work for all polys now
@@ -280,41 +323,7 @@ bool polygonCircleIntersect(const Point *inVertices, int inNumVertices, const Po
    // Loop through edges
    bool collision = false;
    for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
-   {
-      // Get fraction where the closest point to this edge occurs
-      Point v1_v2 = *v2 - *v1;
-      Point v1_center = inCenter - *v1;
-      F32 fraction = v1_center.dot(v1_v2);
-      if (fraction < 0.0f)
-      {
-         // Closest point is v1
-         F32 dist_sq = v1_center.lenSquared();
-         if (dist_sq <= inRadiusSq)
-            if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot((*v1) - inCenter) > 0)
-            {
-               collision = true;
-               outPoint = *v1;
-               inRadiusSq = dist_sq;
-            }
-      }
-      else
-      {
-         F32 v1_v2_len_sq = v1_v2.lenSquared();
-         if (fraction <= v1_v2_len_sq)
-         {
-            // Closest point is on line segment
-            Point point = *v1 + v1_v2 * (fraction / v1_v2_len_sq);
-            F32 dist_sq = (point - inCenter).lenSquared();
-            if (dist_sq <= inRadiusSq)
-               if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(point - inCenter) > 0)
-               {
-                  collision = true;
-                  outPoint = point;
-                  inRadiusSq = dist_sq;
-               }
-         }
-      }
-   }
+      circleEdgeIntersect(*v1, *v2, inCenter, inRadiusSq, outPoint, ignoreVelocityEpsilon, collision);
 
    return collision;
 }
@@ -660,56 +669,64 @@ bool zonesTouch(const Vector<Point> *zone1, const Vector<Point> *zone2, F32 scal
 }
 
 
-// Checks intersection between a polygon an moving circle at inBegin + t * inDelta with radius^2 = inA * t^2 + inB * t + inC, t in [0, 1]
-// Returns true when it does and returns the intersection position in outPoint and the intersection fraction (value for t) in outFraction
-bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+// Checks the moving circle against vertex v1 and the edge running from v1 back to v2, tightening upperBound
+// when it finds an earlier hit.  This is the loop body of SweptCircleEdgeVertexIntersect(), shared with
+// the packed version so both make exactly the same decisions.
+static inline void sweptCircleEdgeVertexIntersect(const Point &v1, const Point &v2, const Point &inBegin, const Point &inDelta,
+                                                  F32 inA, F32 inB, F32 inC, F32 &upperBound, Point &outPoint, bool &collision)
 {
-   // Loop through edges
-   F32 upper_bound = 1.0f;
-   bool collision = false;
-   for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
-   {
-      F32 t;
+   F32 t;
 
-      // Check if circle hits the vertex
-      Point bv1 = *v1 - inBegin;
-      F32 a1 = inA - inDelta.lenSquared();
-      F32 b1 = inB + 2.0f * inDelta.dot(bv1);
-      F32 c1 = inC - bv1.lenSquared();
-      if (findLowestRootInInterval(a1, b1, c1, upper_bound, t))
-         if(inDelta.dot((*v1) - inBegin) > 0)
-         {
-            // We have a collision
-            collision = true;
-            upper_bound = t;
-            outPoint = *v1;
-         }
+   // Check if circle hits the vertex
+   Point bv1 = v1 - inBegin;
+   F32 a1 = inA - inDelta.lenSquared();
+   F32 b1 = inB + 2.0f * inDelta.dot(bv1);
+   F32 c1 = inC - bv1.lenSquared();
+   if (findLowestRootInInterval(a1, b1, c1, upperBound, t))
+      if(inDelta.dot(v1 - inBegin) > 0)
+      {
+         // We have a collision
+         collision = true;
+         upperBound = t;
+         outPoint = v1;
+      }
 
-      // Check if circle hits the edge
-      Point v1v2 = *v2 - *v1;
-      F32 v1v2_dot_delta = v1v2.dot(inDelta);
-      F32 v1v2_dot_bv1 = v1v2.dot(bv1);
-      F32 v1v2_len_sq = v1v2.lenSquared();
-      F32 a2 = v1v2_len_sq * a1 + v1v2_dot_delta * v1v2_dot_delta;
-      F32 b2 = v1v2_len_sq * b1 - 2.0f * v1v2_dot_bv1 * v1v2_dot_delta;
-      F32 c2 = v1v2_len_sq * c1 + v1v2_dot_bv1 * v1v2_dot_bv1;
-      if (findLowestRootInInterval(a2, b2, c2, upper_bound, t))
+   // Check if circle hits the edge
+   Point v1v2 = v2 - v1;
+   F32 v1v2_dot_delta = v1v2.dot(inDelta);
+   F32 v1v2_dot_bv1 = v1v2.dot(bv1);
+   F32 v1v2_len_sq = v1v2.lenSquared();
+   F32 a2 = v1v2_len_sq * a1 + v1v2_dot_delta * v1v2_dot_delta;
+   F32 b2 = v1v2_len_sq * b1 - 2.0f * v1v2_dot_bv1 * v1v2_dot_delta;
+   F32 c2 = v1v2_len_sq * c1 + v1v2_dot_bv1 * v1v2_dot_bv1;
+   if (findLowestRootInInterval(a2, b2, c2, upperBound, t))
+   {
+      // Check if the intersection point is on the edge
+      F32 f = t * v1v2_dot_delta - v1v2_dot_bv1;
+      if (f >= 0.0f && f <= v1v2_len_sq)
       {
-         // Check if the intersection point is on the edge
-         F32 f = t * v1v2_dot_delta - v1v2_dot_bv1;
-         if (f >= 0.0f && f <= v1v2_len_sq)
+         Point p(v1 + v1v2 * (f / v1v2_len_sq));
+         if(inDelta.dot(p - inBegin) > 0)
          {
-            Point p(*v1 + v1v2 * (f / v1v2_len_sq));
-            if(inDelta.dot(p - inBegin) > 0)
-            {
-               // We have a collision
-               collision = true;
-               upper_bound = t;
-               outPoint = p;
-            }
+            // We have a collision
+            collision = true;
+            upperBound = t;
+            outPoint = p;
          }
       }
    }
+}
+
+
+// Checks intersection between a polygon an moving circle at inBegin + t * inDelta with radius^2 = inA * t^2 + inB * t + inC, t in [0, 1]
+// Returns true when it does and returns the intersection position in outPoint and the intersection fraction (value for t) in outFraction
+bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+{
+   // Loop through edges
+   F32 upper_bound = 1.0f;
+   bool collision = false;
+   for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
+      sweptCircleEdgeVertexIntersect(*v1, *v2, inBegin, inDelta, inA, inB, inC, upper_bound, outPoint, collision);
 
    // Check if we had a collision
    if (!collision)
@@ -737,6 +754,307 @@ bool PolygonSweptCircleIntersect(const Point *inVertices, int inNumVertices, con
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+PackedPolygon::PackedPolygon()
+{
+   mPaddedEdgeCount = 0;
+}
+
+
+PackedPolygon::PackedPolygon(const Vector<Point> &vertices)
+{
+   set(vertices);
+}
+
+
+void PackedPolygon::set(const Vector<Point> &vertices)
+{
+   mVertices = vertices;
+   mPaddedEdgeCount = roundUp(vertices.size(), LaneCount);
+
+   // Padding lanes hold NaNs, which fail every comparison the packed tests make
+   mEdgeData.resize(mPaddedEdgeCount * 4);
+   for(S32 i = 0; i < mEdgeData.size(); i++)
+      mEdgeData[i] = NAN;
+
+   F32 *v1x = mEdgeData.address();
+   F32 *v1y = v1x + mPaddedEdgeCount;
+   F32 *v2x = v1y + mPaddedEdgeCount;
+   F32 *v2y = v2x + mPaddedEdgeCount;
+
+   for(S32 i = 0; i < vertices.size(); i++)
+   {
+      const Point &v1 = vertices[i];
+      const Point &v2 = vertices[i == 0 ? vertices.size() - 1 : i - 1];
+
+      v1x[i] = v1.x;
+      v1y[i] = v1.y;
+      v2x[i] = v2.x;
+      v2y[i] = v2.y;
+   }
+}
+
+
+const Vector<Point> &PackedPolygon::getVertices() const
+{
+   return mVertices;
+}
+
+
+S32 PackedPolygon::getEdgeCount() const
+{
+   return mVertices.size();
+}
+
+
+S32 PackedPolygon::getPaddedEdgeCount() const
+{
+   return mPaddedEdgeCount;
+}
+
+
+const F32 *PackedPolygon::getV1x() const { return mEdgeData.address(); }
+const F32 *PackedPolygon::getV1y() const { return mEdgeData.address() + mPaddedEdgeCount; }
+const F32 *PackedPolygon::getV2x() const { return mEdgeData.address() + mPaddedEdgeCount * 2; }
+const F32 *PackedPolygon::getV2y() const { return mEdgeData.address() + mPaddedEdgeCount * 3; }
+
+
+#ifdef BF_PACKED_POLYGON_SSE2
+
+// Lane-wise mask ? a : b
+static inline __m128 selectLanes(__m128 mask, __m128 a, __m128 b)
+{
+   return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+
+// Lane-wise findLowestRootInInterval(): set in each lane where that function would find a root in
+// [0, upperBound].  Mirrors its arithmetic step for step, including taking the square root in double
+// precision, so no lane is dropped that the scalar code would accept.
+static inline __m128 hasRootInInterval(__m128 a, __m128 b, __m128 c, __m128 upperBound)
+{
+   const __m128 zero = _mm_setzero_ps();
+
+   __m128 determinant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.0f), a), c));
+   __m128 sign = selectLanes(_mm_cmplt_ps(b, zero), _mm_set1_ps(-1.0f), _mm_set1_ps(1.0f));
+
+   // q = -0.5 * (b + sign * sqrt(determinant)), two lanes at a time in double
+   const __m128d minusHalf = _mm_set1_pd(-0.5);
+   __m128d qLo = _mm_mul_pd(minusHalf, _mm_add_pd(_mm_cvtps_pd(b),
+                                       _mm_mul_pd(_mm_cvtps_pd(sign), _mm_sqrt_pd(_mm_cvtps_pd(determinant)))));
+   __m128d qHi = _mm_mul_pd(minusHalf, _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(b, b)),
+                                       _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(sign, sign)),
+                                                  _mm_sqrt_pd(_mm_cvtps_pd(_mm_movehl_ps(determinant, determinant))))));
+   __m128 q = _mm_movelh_ps(_mm_cvtpd_ps(qLo), _mm_cvtpd_ps(qHi));
+
+   __m128 x1 = _mm_div_ps(q, a);
+   __m128 x2 = _mm_div_ps(c, q);
+
+   __m128 swapped = _mm_cmplt_ps(x2, x1);
+   __m128 lo = selectLanes(swapped, x2, x1);
+   __m128 hi = selectLanes(swapped, x1, x2);
+
+   __m128 loOk = _mm_and_ps(_mm_cmpge_ps(lo, zero), _mm_cmple_ps(lo, upperBound));
+   __m128 hiOk = _mm_and_ps(_mm_cmpge_ps(hi, zero), _mm_cmple_ps(hi, upperBound));
+
+   return _mm_andnot_ps(_mm_cmplt_ps(determinant, zero), _mm_or_ps(loOk, hiOk));
+}
+
+
+// Same winding number test as polygonContainsPoint(const Point *, ...), four edges at a time
+bool polygonContainsPoint(const PackedPolygon &polygon, const Point &point)
+{
+   const F32 *v1x = polygon.getV1x();
+   const F32 *v1y = polygon.getV1y();
+   const F32 *v2x = polygon.getV2x();
+   const F32 *v2y = polygon.getV2y();
+
+   const __m128 px = _mm_set1_ps(point.x);
+   const __m128 py = _mm_set1_ps(point.y);
+   const __m128i zero = _mm_setzero_si128();
+
+   __m128i counter = zero;
+
+   for(S32 i = 0; i < polygon.getPaddedEdgeCount(); i += PackedPolygon::LaneCount)
+   {
+      // Packed edges run backwards, so the scalar routine's edge from vertex i - 1 to i is (v2, v1) here
+      __m128 ax = _mm_loadu_ps(v2x + i);
+      __m128 ay = _mm_loadu_ps(v2y + i);
+      __m128 bx = _mm_loadu_ps(v1x + i);
+      __m128 by = _mm_loadu_ps(v1y + i);
+
+      __m128i left = _mm_cvttps_epi32(_mm_sub_ps(_mm_mul_ps(_mm_sub_ps(bx, ax), _mm_sub_ps(py, ay)),
+                                                 _mm_mul_ps(_mm_sub_ps(px, ax), _mm_sub_ps(by, ay))));
+
+      __m128 startBelow = _mm_cmple_ps(ay, py);
+      __m128i up   = _mm_and_si128(_mm_castps_si128(_mm_and_ps(startBelow, _mm_cmpgt_ps(by, py))),
+                                   _mm_cmpgt_epi32(left, zero));
+      __m128i down = _mm_and_si128(_mm_castps_si128(_mm_andnot_ps(startBelow, _mm_cmple_ps(by, py))),
+                                   _mm_cmplt_epi32(left, zero));
+
+      // Masks are -1 where set
+      counter = _mm_add_epi32(_mm_sub_epi32(counter, up), down);
+   }
+
+   S32 counts[PackedPolygon::LaneCount];
+   _mm_storeu_si128((__m128i *)counts, counter);
+
+   return counts[0] + counts[1] + counts[2] + counts[3] != 0;
+}
+
+
+bool polygonCircleIntersect(const PackedPolygon &inPolygon, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon)
+{
+   if(polygonContainsPoint(inPolygon, inCenter))
+   {
+      outPoint = inCenter;
+      return true;
+   }
+
+   const F32 *v1x = inPolygon.getV1x();
+   const F32 *v1y = inPolygon.getV1y();
+   const F32 *v2x = inPolygon.getV2x();
+   const F32 *v2y = inPolygon.getV2y();
+
+   const __m128 cx = _mm_set1_ps(inCenter.x);
+   const __m128 cy = _mm_set1_ps(inCenter.y);
+   const __m128 zero = _mm_setzero_ps();
+
+   bool collision = false;
+
+   for(S32 i = 0; i < inPolygon.getPaddedEdgeCount(); i += PackedPolygon::LaneCount)
+   {
+      __m128 x1 = _mm_loadu_ps(v1x + i);
+      __m128 y1 = _mm_loadu_ps(v1y + i);
+      __m128 dx = _mm_sub_ps(_mm_loadu_ps(v2x + i), x1);
+      __m128 dy = _mm_sub_ps(_mm_loadu_ps(v2y + i), y1);
+      __m128 ex = _mm_sub_ps(cx, x1);
+      __m128 ey = _mm_sub_ps(cy, y1);
+
+      __m128 fraction = _mm_add_ps(_mm_mul_ps(ex, dx), _mm_mul_ps(ey, dy));
+      __m128 lenSq    = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      __m128 scale    = _mm_div_ps(fraction, lenSq);
+      __m128 qx = _mm_sub_ps(_mm_add_ps(x1, _mm_mul_ps(dx, scale)), cx);
+      __m128 qy = _mm_sub_ps(_mm_add_ps(y1, _mm_mul_ps(dy, scale)), cy);
+
+      __m128 vertexDistSq = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+      __m128 edgeDistSq   = _mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy));
+
+      // inRadiusSq only shrinks as hits are found, so testing against the current value never drops a hit
+      __m128 radiusSq = _mm_set1_ps(inRadiusSq);
+      __m128 beforeV1 = _mm_cmplt_ps(fraction, zero);
+      __m128 hit = _mm_or_ps(_mm_and_ps(beforeV1, _mm_cmple_ps(vertexDistSq, radiusSq)),
+                             _mm_andnot_ps(beforeV1, _mm_and_ps(_mm_cmple_ps(fraction, lenSq),
+                                                                _mm_cmple_ps(edgeDistSq, radiusSq))));
+      S32 mask = _mm_movemask_ps(hit);
+
+      // Let the scalar test settle candidate edges, in edge order
+      for(S32 j = 0; mask != 0; j++, mask >>= 1)
+         if(mask & 1)
+            circleEdgeIntersect(Point(v1x[i + j], v1y[i + j]), Point(v2x[i + j], v2y[i + j]),
+                                inCenter, inRadiusSq, outPoint, ignoreVelocityEpsilon, collision);
+   }
+
+   return collision;
+}
+
+
+static bool SweptCircleEdgeVertexIntersect(const PackedPolygon &inPolygon, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+{
+   const F32 *v1x = inPolygon.getV1x();
+   const F32 *v1y = inPolygon.getV1y();
+   const F32 *v2x = inPolygon.getV2x();
+   const F32 *v2y = inPolygon.getV2y();
+
+   const __m128 beginX = _mm_set1_ps(inBegin.x);
+   const __m128 beginY = _mm_set1_ps(inBegin.y);
+   const __m128 deltaX = _mm_set1_ps(inDelta.x);
+   const __m128 deltaY = _mm_set1_ps(inDelta.y);
+   const __m128 two = _mm_set1_ps(2.0f);
+   const __m128 a1 = _mm_set1_ps(inA - inDelta.lenSquared());
+   const __m128 b = _mm_set1_ps(inB);
+   const __m128 c = _mm_set1_ps(inC);
+
+   F32 upper_bound = 1.0f;
+   bool collision = false;
+
+   for(S32 i = 0; i < inPolygon.getPaddedEdgeCount(); i += PackedPolygon::LaneCount)
+   {
+      __m128 x1 = _mm_loadu_ps(v1x + i);
+      __m128 y1 = _mm_loadu_ps(v1y + i);
+
+      // Vertex coefficients
+      __m128 bx = _mm_sub_ps(x1, beginX);
+      __m128 by = _mm_sub_ps(y1, beginY);
+      __m128 b1 = _mm_add_ps(b, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(deltaX, bx), _mm_mul_ps(deltaY, by))));
+      __m128 c1 = _mm_sub_ps(c, _mm_add_ps(_mm_mul_ps(bx, bx), _mm_mul_ps(by, by)));
+
+      // Edge coefficients
+      __m128 ex = _mm_sub_ps(_mm_loadu_ps(v2x + i), x1);
+      __m128 ey = _mm_sub_ps(_mm_loadu_ps(v2y + i), y1);
+      __m128 dotDelta = _mm_add_ps(_mm_mul_ps(ex, deltaX), _mm_mul_ps(ey, deltaY));
+      __m128 dotBv1   = _mm_add_ps(_mm_mul_ps(ex, bx), _mm_mul_ps(ey, by));
+      __m128 lenSq    = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+      __m128 a2 = _mm_add_ps(_mm_mul_ps(lenSq, a1), _mm_mul_ps(dotDelta, dotDelta));
+      __m128 b2 = _mm_sub_ps(_mm_mul_ps(lenSq, b1), _mm_mul_ps(_mm_mul_ps(two, dotBv1), dotDelta));
+      __m128 c2 = _mm_add_ps(_mm_mul_ps(lenSq, c1), _mm_mul_ps(dotBv1, dotBv1));
+
+      // upper_bound only shrinks as hits are found, so testing against the current value never drops a hit
+      __m128 upperBound = _mm_set1_ps(upper_bound);
+      S32 mask = _mm_movemask_ps(_mm_or_ps(hasRootInInterval(a1, b1, c1, upperBound),
+                                           hasRootInInterval(a2, b2, c2, upperBound)));
+
+      // Let the scalar test settle candidate edges, in edge order
+      for(S32 j = 0; mask != 0; j++, mask >>= 1)
+         if(mask & 1)
+            sweptCircleEdgeVertexIntersect(Point(v1x[i + j], v1y[i + j]), Point(v2x[i + j], v2y[i + j]),
+                                           inBegin, inDelta, inA, inB, inC, upper_bound, outPoint, collision);
+   }
+
+   if (!collision)
+      return false;
+   outFraction = upper_bound;
+   return true;
+}
+
+#else    // No SSE2, use the scalar routines directly
+
+bool polygonContainsPoint(const PackedPolygon &polygon, const Point &point)
+{
+   return polygonContainsPoint(polygon.getVertices().address(), polygon.getEdgeCount(), point);
+}
+
+
+bool polygonCircleIntersect(const PackedPolygon &inPolygon, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon)
+{
+   return polygonCircleIntersect(inPolygon.getVertices().address(), inPolygon.getEdgeCount(), inCenter, inRadiusSq, outPoint, ignoreVelocityEpsilon);
+}
+
+
+static bool SweptCircleEdgeVertexIntersect(const PackedPolygon &inPolygon, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+{
+   return SweptCircleEdgeVertexIntersect(inPolygon.getVertices().address(), inPolygon.getEdgeCount(), inBegin, inDelta, inA, inB, inC, outPoint, outFraction);
+}
+
+#endif
+
+
+bool PolygonSweptCircleIntersect(const PackedPolygon &inPolygon, const Point &inBegin, const Point &inDelta, F32 inRadius, Point &outPoint, F32 &outFraction)
+{
+   // Test if circle intersects at t = 0
+   if(polygonCircleIntersect(inPolygon, inBegin, inRadius * inRadius, outPoint, (Point *)&inDelta))
+   {
+      outFraction = 0;
+      return true;
+   }
+
+   // Test if sphere intersects with one of the edges or vertices
+   return SweptCircleEdgeVertexIntersect(inPolygon, inBegin, inDelta, 0, 0, inRadius * inRadius, outPoint, outFraction);
+}
+
+
 static const float EPSILON=0.0000000001f;
 
 F32 area(const Vector<Point> &contour)
@@ -36,6 +36,7 @@
 #include <vector>
 
 #include "tnlTypes.h"
+#include "tnlVector.h"
 #include <clipper.hpp>
 
 struct rcPolyMesh;
@@ -53,6 +54,41 @@ using ClipperLib::JoinType;
 class Point;
 class Rect;
 
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Copy of a polygon's edges laid out as structure-of-arrays, so the collision routines below can test
+// four edges at a time with SSE2.  Edge i runs from vertex i back to vertex i - 1, the same order the
+// scalar routines walk a polygon in, and each array is padded with NaNs to a multiple of four lanes.
+// Results are bit-for-bit identical to the Point * versions; vectorized lanes only decide which edges
+// are worth handing to the scalar per-edge test.
+class PackedPolygon
+{
+private:
+   Vector<Point> mVertices;   // Original outline, for the scalar fallback
+   Vector<F32> mEdgeData;     // v1x, v1y, v2x, v2y arrays, each getPaddedEdgeCount() long
+   S32 mPaddedEdgeCount;
+
+public:
+   static const S32 LaneCount = 4;
+
+   PackedPolygon();
+   explicit PackedPolygon(const Vector<Point> &vertices);
+
+   void set(const Vector<Point> &vertices);
+
+   const Vector<Point> &getVertices() const;
+   S32 getEdgeCount() const;
+   S32 getPaddedEdgeCount() const;
+
+   const F32 *getV1x() const;
+   const F32 *getV1y() const;
+   const F32 *getV2x() const;
+   const F32 *getV2y() const;
+};
+
+
 /**
  * @luaenum ClipType(1, 2)
  * Supported operations for clipPolygon. For a description of the operations,
@@ -77,12 +113,15 @@ class Rect;
 //bool PolygonSweptEllipsoidIntersect(const Plane &inPlane, const Vector2 *inVertices, int inNumVertices, const Vector3 &inBegin, const Vector3 &inDelta, const Vector3 &inAxis1, const Vector3 &inAxis2, const Vector3 &inAxis3, Vector3 &outPoint, float &outFraction);
 
 bool PolygonSweptCircleIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inRadius, Point &outPoint, F32 &outFraction);
+bool PolygonSweptCircleIntersect(const PackedPolygon &inPolygon, const Point &inBegin, const Point &inDelta, F32 inRadius, Point &outPoint, F32 &outFraction);
 bool polygonContainsPoint(const Point *vertices, S32 vertexCount, const Point &point);
 bool segmentsColinear(const Point &p1, const Point &p2, const Point &p3, const Point &p4, F32 scaleFact);
 bool segsOverlap(const Point &p1, const Point &p2, const Point &p3, const Point &p4, Point &overlapStart, Point &overlapEnd);
 bool zonesTouch(const Vector<Point> *zone1, const Vector<Point> *zone2, F32 scaleFact, Point &overlapStart, Point &overlapEnd);
 bool pointOnSegment(const Point &c, const Point &a, const Point &b, F32 closeEnough);
 bool polygonCircleIntersect(const Point *inVertices, int inNumVertices, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon = NULL);
+bool polygonCircleIntersect(const PackedPolygon &inPolygon, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon = NULL);
+bool polygonContainsPoint(const PackedPolygon &polygon, const Point &point);
 bool circleCircleIntersect(const Point &center1, F32 radius1, const Point &center2, F32 radius2);
 
 bool polygonsIntersect(const Vector<Point> &p1, const Vector<Point> &p2);
@@ -0,0 +1,225 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelGeometryCache.h"
+
+#include "barrier.h"       // For WallRec def
+#include "game.h"          // For Game::md5
+#include "PackingUtils.h"
+
+#include "stringUtils.h"
+
+#include "tnlBitStream.h"
+#include "tnlLog.h"
+
+#include <zlib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Zap
+{
+
+static const U8 GeometryFormatVersion = 2;      // Change this when the format changes, and old blobs will be refetched
+static const U32 HeaderSize = 5;                // Format version, then size of the walls before deflating
+static const U32 MaxUnpackedSize = 16 * 1024 * 1024;     // More than any level has walls for; keeps garbage from
+                                                         // making us allocate the earth
+static const char *GeometryExtension = "geom";
+
+
+// Constructor
+LevelGeometryCache::LevelGeometryCache(const string &folder)
+{
+   mFolder = folder;
+}
+
+
+// Destructor
+LevelGeometryCache::~LevelGeometryCache()
+{
+   // Do nothing
+}
+
+
+string LevelGeometryCache::getFilename(const string &hash) const
+{
+   return joindir(mFolder, hash + "." + GeometryExtension);
+}
+
+
+// Reads the blob named hash into blob; returns false if we don't have it, or if what we have is damaged
+bool LevelGeometryCache::load(const string &hash, Vector<U8> &blob) const
+{
+   if(mFolder == "" || !safeFilename(hash.c_str()))
+      return false;
+
+   FILE *file = fopen(getFilename(hash).c_str(), "rb");
+   if(!file)
+      return false;
+
+   fseek(file, 0, SEEK_END);
+   S32 size = (S32)ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   bool ok = size > 0 && size <= MaxBlobSize;
+
+   if(ok)
+   {
+      blob.resize(size);
+      ok = fread(blob.address(), 1, size, file) == (size_t)size;
+   }
+
+   fclose(file);
+
+   return ok && getHash(blob) == hash;
+}
+
+
+bool LevelGeometryCache::save(const string &hash, const Vector<U8> &blob) const
+{
+   if(mFolder == "" || !safeFilename(hash.c_str()) || !makeSureFolderExists(mFolder))
+      return false;
+
+   FILE *file = fopen(getFilename(hash).c_str(), "wb");
+   if(!file)
+   {
+      logprintf(LogConsumer::LogWarning, "Could not write level geometry to %s", getFilename(hash).c_str());
+      return false;
+   }
+
+   bool ok = fwrite(blob.address(), 1, blob.size(), file) == (size_t)blob.size();
+   fclose(file);
+
+   prune();
+
+   return ok;
+}
+
+
+// Delete the oldest blobs until we're back under MaxCachedLevels
+void LevelGeometryCache::prune() const
+{
+   deleteOldestFiles(mFolder, GeometryExtension, MaxCachedLevels);
+}
+
+
+// Level coordinates are mostly whole numbers, and each vertex is usually close to the one before it, so writeCoord()
+// gets most vertices down to around half their size, and deflating the result shrinks it further still, as levels are
+// full of walls of the same width running the same distances.
+void LevelGeometryCache::packWalls(const Vector<WallRec> &walls, Vector<U8> &blob)
+{
+   BitStream stream;
+
+   writeCount(stream, walls.size());
+
+   F32 prev[2] = { 0, 0 };
+
+   for(S32 i = 0; i < walls.size(); i++)
+   {
+      const WallRec &wall = walls[i];
+
+      stream.writeFlag(wall.solid);
+      stream.write(wall.width);
+      writeCount(stream, wall.verts.size());
+
+      for(S32 j = 0; j < wall.verts.size(); j++)
+         writeCoord(stream, wall.verts[j], prev[j % 2]);
+   }
+
+   stream.zeroToByteBoundary();     // Same walls must always give the same bytes, or they won't hash the same
+
+   U32 size = stream.getBytePosition();
+   uLongf compressedSize = compressBound(size);
+
+   blob.resize(HeaderSize + compressedSize);
+   blob[0] = GeometryFormatVersion;
+   for(U32 i = 0; i < 4; i++)
+      blob[1 + i] = U8(size >> (i * 8));
+
+   if(compress(blob.address() + HeaderSize, &compressedSize, stream.getBuffer(), size) != Z_OK)
+   {
+      TNLAssert(false, "Could not deflate level geometry");    // Only happens if we run out of memory
+      blob.clear();
+      return;
+   }
+
+   blob.resize(HeaderSize + compressedSize);
+}
+
+
+// How many bits there are still to read from stream
+static U32 getBitsLeft(const BitStream &stream)
+{
+   U32 position = stream.getBitPosition();
+   return stream.getMaxReadBitPosition() > position ? stream.getMaxReadBitPosition() - position : 0;
+}
+
+
+// Returns false if blob is damaged, or in a format we don't know
+bool LevelGeometryCache::unpackWalls(const Vector<U8> &blob, Vector<WallRec> &walls)
+{
+   if((U32)blob.size() <= HeaderSize || blob[0] != GeometryFormatVersion)
+      return false;
+
+   U32 size = 0;
+   for(U32 i = 0; i < 4; i++)
+      size |= U32(blob[1 + i]) << (i * 8);
+
+   if(size == 0 || size > MaxUnpackedSize)
+      return false;
+
+   Vector<U8> packed;
+   packed.resize(size);
+   uLongf unpackedSize = size;
+
+   if(uncompress(packed.address(), &unpackedSize, blob.address() + HeaderSize, blob.size() - HeaderSize) != Z_OK ||
+         unpackedSize != size)
+      return false;
+
+   BitStream stream(packed.address(), size);
+
+   U32 wallCount = readCount(stream);
+
+   // Every wall and vertex takes at least a bit, so a count bigger than the bits left is garbage, and not worth
+   // allocating for
+   if(wallCount > getBitsLeft(stream))
+      return false;
+
+   walls.clear();
+   walls.reserve(wallCount);
+
+   F32 prev[2] = { 0, 0 };
+   Vector<F32> verts;
+
+   for(U32 i = 0; i < wallCount && stream.isValid(); i++)
+   {
+      bool solid = stream.readFlag();
+
+      F32 width;
+      stream.read(&width);
+
+      U32 vertCount = readCount(stream);
+      if(vertCount > getBitsLeft(stream))
+         return false;
+
+      verts.resize(vertCount);
+
+      for(U32 j = 0; j < vertCount; j++)
+         verts[j] = readCoord(stream, prev[j % 2]);
+
+      walls.push_back(WallRec(width, solid, verts));
+   }
+
+   return stream.isValid();
+}
+
+
+string LevelGeometryCache::getHash(const Vector<U8> &blob)
+{
+   return Game::md5.getHashFromString(string((const char *)blob.address(), blob.size()));
+}
+
+
+};
@@ -0,0 +1,54 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_GEOMETRY_CACHE_H_
+#define _LEVEL_GEOMETRY_CACHE_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+struct WallRec;
+
+// A level's walls, packed and deflated into a single blob that the server can send in one go and the client can keep
+// on disk.  Blobs are named by the MD5 hash of their contents, so a client that has played a level before can rebuild
+// its walls without the server sending them again.  Levels with identical walls share a blob, whatever their files
+// look like.
+class LevelGeometryCache
+{
+private:
+   string mFolder;
+
+   string getFilename(const string &hash) const;
+   void prune() const;
+
+public:
+   enum {
+      MaxCachedLevels = 100,     // Oldest blobs are deleted beyond this
+      MaxBlobSize = 65535,       // Larger levels get their walls the old fashioned way
+   };
+
+   explicit LevelGeometryCache(const string &folder);    // Constructor
+   virtual ~LevelGeometryCache();
+
+   bool load(const string &hash, Vector<U8> &blob) const;
+   bool save(const string &hash, const Vector<U8> &blob) const;
+
+   static void packWalls(const Vector<WallRec> &walls, Vector<U8> &blob);
+   static bool unpackWalls(const Vector<U8> &blob, Vector<WallRec> &walls);
+   static string getHash(const Vector<U8> &blob);
+};
+
+
+};
+
+#endif
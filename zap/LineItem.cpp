@@ -259,14 +259,21 @@ void LineItem::unpackUpdate(GhostConnection *connection, BitStream *stream)
 
 
 F32 LineItem::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips)
+{
+   return Parent::getUpdatePriority(connection, updateMask, updateSkips) + getUpdatePriorityAdjustment(this);
+}
+
+
+// Shared with BfObject::computeUpdatePriorities()
+F32 LineItem::getUpdatePriorityAdjustment(BfObject *item)
 {
    // Lower priority for initial update.  This is to work around network-heavy loading of levels
    // with many LineItems, which will stall the client and prevent you from moving your ship
-   if(isInitialUpdate())
-      return Parent::getUpdatePriority(connection, updateMask, updateSkips) - 1000.f;
+   if(static_cast<LineItem *>(item)->isInitialUpdate())
+      return -1000.f;
 
    // Normal priority otherwise so Geom changes are immediately visible to all clients
-   return Parent::getUpdatePriority(connection, updateMask, updateSkips);
+   return 0;
 }
 
 
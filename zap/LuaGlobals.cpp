@@ -9,6 +9,7 @@
 #include "GameSettings.h"
 #include "Console.h"
 #include "version.h"
+#include "BotWorkerPool.h"    // For BotRandom
 
 #include <tnl.h>
 #include <tnlLog.h>
@@ -114,14 +115,17 @@ S32 lua_getRandomNumber(lua_State *L)
 {
    S32 args = lua_gettop(L);
 
+   // Robots thinking on a worker thread have numbers of their own, so they come out the same whatever the other threads do
+   BotRandom *random = BotWorkerPool::getRandom();
+
    if(args == 0)
-      return returnFloat(L, TNL::Random::readF());
+      return returnFloat(L, random ? random->readF() : TNL::Random::readF());
 
    if(args == 1)
    {
       S32 max = luaL_checkint(L, 1);
       luaL_argcheck(L, 1 <= max, 1, "interval is empty");
-      return returnInt(L, TNL::Random::readI(1, max));
+      return returnInt(L, random ? random->readI(1, max) : TNL::Random::readI(1, max));
    }
 
    if(args == 2)
@@ -129,7 +133,7 @@ S32 lua_getRandomNumber(lua_State *L)
       int min = luaL_checkint(L, 1);
       int max = luaL_checkint(L, 2);
       luaL_argcheck(L, min <= max, 2, "interval is empty");
-      return returnInt(L, TNL::Random::readI(min, max));
+      return returnInt(L, random ? random->readI(min, max) : TNL::Random::readI(min, max));
    }
 
    else
@@ -19,13 +19,19 @@
 #include "config.h"
 #include "GameSettings.h"
 #include "Console.h"           // For gConsole
+#include "BotWorkerPool.h"
 
 #include "stringUtils.h"
 
 #include <clipper.hpp>
 
+extern "C" {
+#include <luajit.h>            // For luaJIT_setmode
+}
+
 #include "tnlLog.h"            // For logprintf
 #include "tnlRandom.h"
+#include "tnlPlatform.h"       // For getHighPrecisionTimerValue
 
 #include <iostream>            // For enum code
 #include <sstream>             // For enum code
@@ -39,16 +45,22 @@ namespace Zap
 ////////////////////////////////////////
 
 // Declare and Initialize statics:
-lua_State *LuaScriptRunner::L = NULL;
+lua_State *LuaScriptRunner::mMainL = NULL;
 string LuaScriptRunner::mScriptingDir;
 
-deque<string> LuaScriptRunner::mCachedScripts;
+deque<string> LuaScriptRunner::mCachedScripts;     // Compiled scripts, in the main Lua state
+
+U32 LuaScriptRunner::mCpuBudget = 0;
+U32 LuaScriptRunner::mTickCount = 0;
+
+// Script whose call is running on this thread, for the CPU budget hook
+static thread_local LuaScriptRunner *runningScript = NULL;
 
 void LuaScriptRunner::clearScriptCache()
 {
 	while(mCachedScripts.size() != 0)
 	{
-		deleteScript(mCachedScripts.front().c_str());
+		deleteScript(mMainL, mCachedScripts.front().c_str());
 		mCachedScripts.pop_front();
 	}
 }
@@ -61,6 +73,8 @@ LuaScriptRunner::LuaScriptRunner()
    mLuaGame = NULL;
    mLuaGridDatabase = NULL;
 
+   L = mMainL;
+
    static U32 mNextScriptId = 0;
 
    // Initialize all subscriptions to unsubscribed -- bits will automatically subscribe to onTick later
@@ -70,6 +84,19 @@ LuaScriptRunner::LuaScriptRunner()
    mScriptId = "script" + itos(mNextScriptId++);
    mScriptType = ScriptTypeInvalid;
 
+   mCpuStats.totalMs = 0;
+   mCpuStats.periodMs = 0;
+   mCpuStats.peakTickMs = 0;
+   mCpuStats.calls = 0;
+   mCpuStats.overruns = 0;
+
+   mTickMs = 0;
+   mTick = 0;
+   mSuspendedUntil = 0;
+   mCallStart = 0;
+   mBudgeted = false;
+   mOverBudget = false;
+
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
 }
 
@@ -87,7 +114,7 @@ LuaScriptRunner::~LuaScriptRunner()
    // with bf:addItem()
 
    // And delete the script's environment table from the Lua instance
-   deleteScript(getScriptId());
+   deleteScript(L, getScriptId());
 
    LUAW_DESTRUCTOR_CLEANUP;
 }
@@ -98,18 +125,33 @@ const char *LuaScriptRunner::getErrorMessagePrefix() { return "SCRIPT"; }
 
 lua_State *LuaScriptRunner::getL()
 {
-   TNLAssert(L, "L not yet instantiated!");
-   return L;
+   TNLAssert(mMainL, "L not yet instantiated!");
+   return mMainL;
 }
 
 
 void LuaScriptRunner::shutdown()
 {
-   if(L)
+   if(mMainL)
    {
-      lua_close(L);
-      L = NULL;
+      lua_close(mMainL);
+      mMainL = NULL;
    }
+
+   mCachedScripts.clear();       // They went with the state
+}
+
+
+lua_State *LuaScriptRunner::getLuaState()
+{
+   return L;
+}
+
+
+// Robots can run in a Lua state of their own worker thread's; see BotWorkerPool
+void LuaScriptRunner::setLuaState(lua_State *state)
+{
+   L = state;
 }
 
 
@@ -201,7 +243,7 @@ void LuaScriptRunner::pushStackTracer()
 // environment.  This loaded script will be cleared when the parent script terminates
 bool LuaScriptRunner::loadCompileRunEnvironmentScript(const string &scriptName) {
    // The timer is loaded in each script
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileScript(L, joindir(mScriptingDir, scriptName).c_str());
    setEnvironment();
 
    S32 err = lua_pcall(L, 0, 0, 0);
@@ -238,8 +280,9 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
    {
       pushStackTracer();            // -- _stackTracer
 
-      if(!cacheScript)
-         loadCompileScript(mScriptName.c_str());
+      // The cache lives in the main Lua state; scripts running anywhere else are compiled afresh
+      if(!cacheScript || L != mMainL)
+         loadCompileScript(L, mScriptName.c_str());
       else  
       {
          bool found = false;
@@ -259,12 +302,12 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
             if(cacheSize > MAX_CACHE_SIZE)
             {
                // Remove oldest script from the cache
-               deleteScript(mCachedScripts.front().c_str());
+               deleteScript(L, mCachedScripts.front().c_str());
                mCachedScripts.pop_front();
             }
 
             // Load new script into cache using full name as registry key
-            loadCompileSaveScript(mScriptName.c_str(), mScriptName.c_str());
+            loadCompileSaveScript(L, mScriptName.c_str(), mScriptName.c_str());
             mCachedScripts.push_back(mScriptName);
          }
 
@@ -383,6 +426,17 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
 {
    S32 stackDepth = lua_gettop(L);
 
+   // A script that went over its CPU budget sits out for a while; as far as the caller can tell, it ran and did nothing
+   if(isSuspended())
+   {
+      lua_settop(L, stackDepth - argCount);
+
+      for(S32 i = 0; i < returnValueCount; i++)
+         lua_pushnil(L);
+
+      return false;
+   }
+
    // argCount args are already on the stack... we'll refer to these as collectively as <<args>>
    pushStackTracer();                                       // -- <<whatever>>, <<args>>, _stackTracer
 
@@ -407,7 +461,8 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
          // we never copy them into C++ land; we just duplicate them from the stack as needed.  For other
          // functions, we have the arguments in C++, so we can just push them onto the stack multiple times
          // for firing an event for multiple listeners.
-         TNLAssert((!strcmp(function, "onDataReceived") && top == (argCount + 1)) || (strcmp(function, "onDataReceived") && top == 1), \
+         // (Data sent from a script in another Lua state gets copied over for each subscriber, so is never duplicated.)
+         TNLAssert((!strcmp(function, "onDataReceived") && (top == (argCount + 1) || top == 1)) || (strcmp(function, "onDataReceived") && top == 1), \
             "Unexpected number of items on stack!");
          lua_insert(L, top);                                // -- <<whatever>>, function, <<args>>, _stackTracer
          lua_insert(L, top);                                // -- <<whatever>>, _stackTracer, function, <<args>>
@@ -419,9 +474,67 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
       //    LUA_ERRRUN: a runtime error. (2)
       //    LUA_ERRMEM : memory allocation error.For such errors, Lua does not call the error handler function. (4)
       //    LUA_ERRERR : error while running the error handler function.  (5)
+      // Robots and levelgens are held to the CPU budget, except in main(), which can take a while building a level.
+      // Scripts can call other scripts (with sendData(), say); the caller's clock stops while they run.
+      LuaScriptRunner *caller = runningScript;
+      S64 callerStart = mCallStart;
+      bool callerBudgeted = mBudgeted;
+
+      runningScript = this;
+      mBudgeted = mCpuBudget > 0 && (mScriptType == ScriptTypeRobot || mScriptType == ScriptTypeLevelgen) && strcmp(function, "main");
+      mOverBudget = false;
+
+      S64 start = Platform::getHighPrecisionTimerValue();
+      mCallStart = start;
+
+      if(mBudgeted)
+         lua_sethook(L, cpuBudgetHook, LUA_MASKCOUNT, CpuHookInstructions);
+
       error = lua_pcall(L, argCount, returnValueCount, -2 - argCount);  // -- <<whatever>>, _stackTracer, <<return values>>
       //dumpStack(L, "after pcall");
 
+      S64 now = Platform::getHighPrecisionTimerValue();
+      F64 ms = Platform::getHighPrecisionMilliseconds(now - mCallStart);
+      bool budgeted = mBudgeted;
+
+      mTickMs = getTickMs() + ms;
+      mCpuStats.totalMs += ms;
+      mCpuStats.periodMs += ms;
+      mCpuStats.peakTickMs = max(mCpuStats.peakTickMs, mTickMs);
+      mCpuStats.calls++;
+
+      if(caller == this)
+      {
+         mCallStart = callerStart;
+         mBudgeted = callerBudgeted;
+      }
+
+      runningScript = caller;
+
+      if(caller && caller->L == L && caller->mBudgeted)
+      {
+         caller->mCallStart += now - start;
+         lua_sethook(L, cpuBudgetHook, LUA_MASKCOUNT, CpuHookInstructions);
+      }
+      else if(budgeted)
+         lua_sethook(L, NULL, 0, 0);
+
+      // Went over budget; it's the script that pays, not the server
+      if(budgeted && (mOverBudget || mTickMs > mCpuBudget))
+      {
+         overBudget(function);
+
+         if(error)
+         {
+            lua_settop(L, stackDepth - argCount);     // Toss the error, and everything else           -- <<whatever>>
+
+            for(S32 i = 0; i < returnValueCount; i++)
+               lua_pushnil(L);
+
+            return false;
+         }
+      }
+
    }
    else
       error = -1;
@@ -443,14 +556,15 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
    }
 
    // There was an error... handle it!l
+   string text;
+   bool dumpedStack = false;
 
    if(error == -1)         // Handler was removed after subscription
    {
       // The only way this can get triggered is if the handler function has been deleted by the time 
       // we get here (we check for its existence when a script subscribes).  In practice, this has 
       // probably never happened.  
-      string text = "Cannot find Lua function " + string(function) + "()!\n";
-      logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), text.c_str());
+      text = "Cannot find Lua function " + string(function) + "()!\n";
    }
    else                    // A "normal" error occurred (i.e. error in the code)
    {
@@ -458,48 +572,157 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
       lua_pop(L, 1);       // Remove the message from the stack, so it won't appear in our stack dump
 
       improveErrorMessages(msg);    // Modifies msg
-      string text = "In method " + string(function) + "():\n" + msg;
-
-      logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), text.c_str());
-      logprintf(LogConsumer::LogError, "Dump of Lua/C++ stack:");
+      text = "In method " + string(function) + "():\n" + msg;
+      dumpedStack = true;
    }
 
-   logprintf(LogConsumer::LogError, "Terminating script");
+   // Robots thinking on a worker thread can't be killed until the main thread has them back
+   if(BotWorkerPool::isWorkerThread())
+      BotWorkerPool::deferScriptError(this, text, dumpedStack);
+   else
+      terminateScript(text, dumpedStack);
 
-   killScript();
    lua_settop(L, stackDepth - argCount);   // Remove <<args>> and other cruft     -- <<whatever>>
 
    return true;
 }
 
 
+// Stops a call that has run too long.  Only robots' and levelgens' Lua code is checked, so a script stuck in one long C++
+// call (a big findAllObjects(), say) will only be caught once it's back.
+void LuaScriptRunner::cpuBudgetHook(lua_State *L, lua_Debug *ar)
+{
+   LuaScriptRunner *script = runningScript;
+
+   if(!script || !script->mBudgeted)
+      return;
+
+   S64 now = Platform::getHighPrecisionTimerValue();
+
+   if(script->mOverBudget || script->getTickMs() + Platform::getHighPrecisionMilliseconds(now - script->mCallStart) > mCpuBudget)
+   {
+      // From now on, fail at every instruction, so a script that catches the error can't get far before the next one
+      script->mOverBudget = true;
+      lua_sethook(L, cpuBudgetHook, LUA_MASKCOUNT, 1);
+
+      luaL_error(L, "Script used more than its %d ms of CPU time this tick", mCpuBudget);
+   }
+}
+
+
+// CPU time used in this tick by calls that have finished
+F64 LuaScriptRunner::getTickMs()
+{
+   if(mTick != mTickCount)
+   {
+      mTick = mTickCount;
+      mTickMs = 0;
+   }
+
+   return mTickMs;
+}
+
+
+// Suspends the script for a while, longer each time it happens
+void LuaScriptRunner::overBudget(const char *function)
+{
+   mCpuStats.overruns++;
+
+   U32 ticks = U32(SuspendTicks) << min(mCpuStats.overruns - 1, (U32)MaxSuspendShift);
+   mSuspendedUntil = mTickCount + ticks;
+
+   logprintf(LogConsumer::LogWarning, "%s\nScript used %.1f ms of CPU time in %s(), over its budget of %d ms; suspending it for %d ticks",
+             getErrorMessagePrefix(), mTickMs, function, mCpuBudget, ticks);
+}
+
+
+// Lua states created from here on get the right JIT mode; setCpuBudget(0) once the game's done to get the JIT back
+void LuaScriptRunner::setCpuBudget(U32 ms)
+{
+   mCpuBudget = ms;
+
+   if(mMainL)
+      setJitMode(mMainL);
+}
+
+
+// LuaJIT doesn't run hooks in compiled code, so a tight enough loop would never be stopped; while scripts are held to a
+// budget, they run in the interpreter.  Robots and levelgens spend most of their time in our C++ code anyway.
+void LuaScriptRunner::setJitMode(lua_State *L)
+{
+   luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | (mCpuBudget > 0 ? LUAJIT_MODE_OFF : LUAJIT_MODE_ON));
+}
+
+
+U32 LuaScriptRunner::getCpuBudget()
+{
+   return mCpuBudget;
+}
+
+
+void LuaScriptRunner::beginTick()
+{
+   mTickCount++;
+}
+
+
+const ScriptCpuStats &LuaScriptRunner::getCpuStats() const
+{
+   return mCpuStats;
+}
+
+
+void LuaScriptRunner::resetCpuStatsPeriod()
+{
+   mCpuStats.periodMs = 0;
+   mCpuStats.peakTickMs = 0;
+}
+
+
+bool LuaScriptRunner::isSuspended() const
+{
+   return mTickCount < mSuspendedUntil;
+}
+
+
+void LuaScriptRunner::terminateScript(const string &message, bool dumpedStack)
+{
+   logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), message.c_str());
+
+   if(dumpedStack)
+      logprintf(LogConsumer::LogError, "Dump of Lua/C++ stack:");
+
+   logprintf(LogConsumer::LogError, "Terminating script");
+
+   killScript();
+}
+
+
 // Start Lua and get everything configured
 bool LuaScriptRunner::startLua(const string &scriptingDir)
 {
-   TNLAssert(!L, "L should not have been created yet!");
+   TNLAssert(!mMainL, "L should not have been created yet!");
 
    mScriptingDir = scriptingDir;
 
    // Prepare the Lua global environment
-   L = lua_open();               // Create a new Lua interpreter; will be shutdown in the destructor
+   mMainL = lua_open();          // Create a new Lua interpreter; will be shutdown in the destructor
 
    // Failure here is likely to be something systemic, something bad.  Like smallpox.
-   if(!L)
+   if(!mMainL)
    {
       string msg = "Could not instantiate the Lua interpreter.";
 
       // Lua just isn't going to work out for this session.
       logprintf(LogConsumer::LogError, "=====FATAL LUA ERROR=====\n%s\n=========================", msg.c_str());
-      lua_close(L);
-      L = NULL;
       return false;
    }
 
-   if(!configureNewLuaInstance(L))
+   if(!configureNewLuaInstance(mMainL))
    {
       // An error message will have been printed by configureNewLuaInstance()
-      lua_close(L);
-      L = NULL;
+      lua_close(mMainL);
+      mMainL = NULL;
       return false;
    }
 
@@ -521,10 +744,10 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       luaL_openlibs(L);    // Load the standard libraries
 
       // This allows the safe use of 'require' in our scripts
-      setModulePath();
+      setModulePath(L);
 
       // Register all our classes in the global namespace... they will be copied below when we copy the environment
-      registerClasses();            // Perform class and global function registration once per lua_State
+      registerClasses(L);           // Perform class and global function registration once per lua_State
       registerLooseFunctions(L);    // Register some functions not associated with a particular class
 
       // Set scads of global vars in the Lua instance that mimic the use of the enums we use everywhere.
@@ -533,19 +756,21 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       setGlobalObjectArrays(L);
 
       // Immediately execute the lua helper functions (these are global and need to be loaded before sandboxing)
-      loadCompileRunHelper("lua_helper_functions.lua");
+      loadCompileRunHelper(L, "lua_helper_functions.lua");
 
       // Load our vector library
-      loadCompileRunHelper("luavec.lua");
+      loadCompileRunHelper(L, "luavec.lua");
 
       // Load our helper functions and store copies of the compiled code in the registry where we can use them for starting new scripts
-      loadCompileSaveHelper("robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
-      loadCompileSaveHelper("levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
-      loadCompileSaveHelper("timer.lua",                     SCRIPT_TIMER_KEY);
+      loadCompileSaveHelper(L, "robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
+      loadCompileSaveHelper(L, "levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
+      loadCompileSaveHelper(L, "timer.lua",                     SCRIPT_TIMER_KEY);
 
       // Perform sandboxing now
       // Only code executed before this point can access dangerous functions
-      loadCompileRunHelper("sandbox.lua");
+      loadCompileRunHelper(L, "sandbox.lua");
+
+      setJitMode(L);
 
       return true;
    }
@@ -557,17 +782,17 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
 }
 
 
-void LuaScriptRunner::loadCompileSaveHelper(const string &scriptName, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey)
 {
-   loadCompileSaveScript(joindir(mScriptingDir, scriptName).c_str(), registryKey);
+   loadCompileSaveScript(L, joindir(mScriptingDir, scriptName).c_str(), registryKey);
 }
 
 
 // Load a script from the scripting directory by basename (e.g. "my_script.lua").
 // Throws LuaException when there's an error compiling or running the script.
-void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
+void LuaScriptRunner::loadCompileRunHelper(lua_State *L, const string &scriptName)
 {
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileScript(L, joindir(mScriptingDir, scriptName).c_str());
    if(lua_pcall(L, 0, 0, 0))
       throw LuaException("Error running " + scriptName + ": " + string(lua_tostring(L, -1)));
 }
@@ -575,16 +800,16 @@ void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
 
 // Load script from specified file, compile it, and store it in the registry.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileSaveScript(const char *filename, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey)
 {
-   loadCompileScript(filename);                       // Throws if there is an error
+   loadCompileScript(L, filename);                    // Throws if there is an error
    lua_setfield(L, LUA_REGISTRYINDEX, registryKey);   // Save compiled code in registry
 }
 
 
 // Load script and place on top of the stack.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileScript(const char *filename)
+void LuaScriptRunner::loadCompileScript(lua_State *L, const char *filename)
 {
    // luaL_loadfile: Loads a file as a Lua chunk. This function uses lua_load to load the chunk in the file named filename. 
    // If filename is NULL, then it loads from the standard input. The first line in the file is ignored if it starts with a #.
@@ -599,7 +824,7 @@ void LuaScriptRunner::loadCompileScript(const char *filename)
 
 
 // Delete script's environment from the registry -- actually set the registry entry to nil so the table can be collected
-void LuaScriptRunner::deleteScript(const char *name)
+void LuaScriptRunner::deleteScript(lua_State *L, const char *name)
 {
    // If a script is not found, or there is some other problem with the bot (or levelgen), we might get here before our L has been
    // set up.  If L hasn't been defined, there's no point in mucking with the registry, right?
@@ -613,6 +838,9 @@ void LuaScriptRunner::deleteScript(const char *name)
 
 bool LuaScriptRunner::prepareEnvironment()              
 {
+   if(!L)
+      L = mMainL;    // We were created before Lua was started
+
    if(!L)
    {
       logprintf(LogConsumer::LogError, "%s %s.", getErrorMessagePrefix(), 
@@ -679,7 +907,7 @@ static string getStackTraceLine(lua_State *L, S32 level)
 */
 
 // Register classes needed by all script runners
-void LuaScriptRunner::registerClasses()
+void LuaScriptRunner::registerClasses(lua_State *L)
 {
    LuaW_Registrar::registerClasses(L);    // Register all objects that use our automatic registration scheme
 }
@@ -728,7 +956,7 @@ void LuaScriptRunner::setLuaArgs(const Vector<string> &args)
 
 
 // Set up paths so that we can use require to load code in our scripts 
-void LuaScriptRunner::setModulePath()   
+void LuaScriptRunner::setModulePath(lua_State *L)
 {
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
@@ -1235,10 +1463,9 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
 
    TNLAssert(mLuaGridDatabase != NULL, "Grid Database must not be NULL!");
 
-   fillVector.clear();
-   static Vector<U8> types;
-
-   types.clear();    // Needed because types is a reusable static vector, and we need to clear out any residuals
+   // Not the shared fillVector; robots on worker threads may be searching at the same time
+   Vector<DatabaseObject *> foundObjects;
+   Vector<U8> types;
 
    // We expect the stack to look like this: -- objType1, objType2, ...
    // or this, if using the deprecated fill table option -- [fillTable], objType1, objType2, ...
@@ -1255,7 +1482,7 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
       if(typenum != BotNavMeshZoneTypeNumber)
          types.push_back(typenum);
       else
-         mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, fillVector);
+         mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, foundObjects);
 
       lua_pop(L, 1);
    }
@@ -1266,8 +1493,8 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
       results = mLuaGridDatabase->findObjects_fast();
    else
    {
-      mLuaGridDatabase->findObjects(types, fillVector);
-      results = &fillVector;
+      mLuaGridDatabase->findObjects(types, foundObjects);
+      results = &foundObjects;
    }
 
    // This will guarantee a table at the top of the stack to return our found objects
@@ -1322,10 +1549,8 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
 
    TNLAssert(mLuaGridDatabase != NULL, "Grid Database must not be NULL!");
 
-   static Vector<U8> types;
-
-   types.clear();
-   fillVector.clear();
+   Vector<DatabaseObject *> foundObjects;
+   Vector<U8> types;
 
    bool hasBotZoneType = false;
 
@@ -1353,16 +1578,16 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
    Rect searchArea = Rect(p1, p2);
 
    if(hasBotZoneType)
-      mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, fillVector, searchArea);
+      mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, foundObjects, searchArea);
 
-   mLuaGridDatabase->findObjects(types, fillVector, searchArea);
+   mLuaGridDatabase->findObjects(types, foundObjects, searchArea);
 
    // This will guarantee a table at the top of the stack to return our found objects
    if(!lua_istable(L, -1))
    {
       TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
 
-      lua_createtable(L, fillVector.size(), 0);    // Create a table, with enough slots pre-allocated for our data
+      lua_createtable(L, foundObjects.size(), 0);  // Create a table, with enough slots pre-allocated for our data
    }
    else
       logprintf(LogConsumer::LuaScriptMessage, "Usage of a fill table with findAllObjectsInArea() "
@@ -1370,9 +1595,9 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
 
    S32 pushed = 0;      // Count of items we put into our table
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < foundObjects.size(); i++)
    {
-      static_cast<BfObject *>(fillVector[i])->push(L);
+      static_cast<BfObject *>(foundObjects[i])->push(L);
       pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
       lua_rawseti(L, 1, pushed);
    }
@@ -43,21 +43,56 @@ class MenuItem;
 #define LEVELGEN_HELPER_FUNCTIONS_KEY "levelgen_helper_functions"
 #define SCRIPT_TIMER_KEY "script_timer"
 
+// How much CPU time a script has been using, for /scriptstats and the stats log
+struct ScriptCpuStats
+{
+   F64 totalMs;         // Since the script was started
+   F64 periodMs;        // Since the stats were last logged
+   F64 peakTickMs;      // Most used in any one tick
+   U32 calls;
+   U32 overruns;        // Times the script went over budget, and was suspended for it
+};
+
+
 class LuaScriptRunner
 {
 
 private:
    static deque<string> mCachedScripts;
 
+   static U32 mCpuBudget;        // Ms of CPU time a script may use in one tick; 0 for no limit
+   static U32 mTickCount;        // Ticks since the server started; a script's use is counted afresh each one
+
+   ScriptCpuStats mCpuStats;
+   F64 mTickMs;                  // Used so far in mTick
+   U32 mTick;
+   U32 mSuspendedUntil;          // Tick when a script over budget may run again
+   S64 mCallStart;               // When the running call started, less time spent in other scripts it called
+   bool mBudgeted;               // Running call is held to mCpuBudget
+   bool mOverBudget;             // Set by the count hook when the running call has gone on too long
+
+   enum {
+      CpuHookInstructions = 1000,   // How often the count hook checks the clock
+      SuspendTicks = 32,            // First time over budget; doubles each time after that...
+      MaxSuspendShift = 6,          // ...up to 64 times as long
+   };
+
+   static void cpuBudgetHook(lua_State *L, lua_Debug *ar);
+   static void setJitMode(lua_State *L);
+   F64 getTickMs();
+   void overBudget(const char *function);
+
    static string mScriptingDir;
 
+   static lua_State *mMainL;     // Lua state shared by all scripts, except robots handed to a BotWorkerPool
+
    void setLuaArgs(const Vector<string> &args);
-   static void setModulePath();
+   static void setModulePath(lua_State *L);
 
-   static void loadCompileSaveHelper(const string &scriptName, const char *registryKey);
-   static void loadCompileRunHelper(const string &scriptName);
-   static void loadCompileSaveScript(const char *filename, const char *registryKey);
-   static void loadCompileScript(const char *filename);
+   static void loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey);
+   static void loadCompileRunHelper(lua_State *L, const string &scriptName);
+   static void loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey);
+   static void loadCompileScript(lua_State *L, const char *filename);
 
    void pushStackTracer();      // Put error handler function onto the stack
 
@@ -79,7 +114,7 @@ protected:
                                     // ClientGame depending on where the script is called from
    GridDatabase *mLuaGridDatabase;  // Pointer to our current grid database with objects to manipulate
 
-   static lua_State *L;          // Main Lua state variable
+   lua_State *L;                 // Lua state this script runs in; usually mMainL
    string mScriptName;           // Fully qualified script name, with path and everything
    Vector<string> mScriptArgs;   // List of arguments passed to the script
 
@@ -92,12 +127,12 @@ protected:
    virtual bool prepareEnvironment();
 
    static int luaPanicked(lua_State *L);  // Handle a total freakout by Lua
-   static void registerClasses();
+   static void registerClasses(lua_State *L);
    void setEnvironment();                 // Sets the environment for the function on the top of the stack to that associated with name
 
    bool loadCompileRunEnvironmentScript(const string &scriptName);
 
-   static void deleteScript(const char *name);  // Remove saved script from the Lua registry
+   static void deleteScript(lua_State *L, const char *name);  // Remove saved script from the Lua registry
 
    static void registerLooseFunctions(lua_State *L);   // Register some functions not associated with a particular class
 
@@ -133,12 +168,17 @@ public:
 
    virtual const char *getErrorMessagePrefix();
 
-   static lua_State *getL();
-   static bool startLua(const string &scriptingDir);  // Create L
-   static void shutdown();                            // Delete L
+   static lua_State *getL();                          // The main Lua state
+   static bool startLua(const string &scriptingDir);  // Create the main Lua state
+   static void shutdown();                            // Delete it
 
    static bool configureNewLuaInstance(lua_State *L); // Prepare a new Lua environment for use
 
+   lua_State *getLuaState();
+   void setLuaState(lua_State *state);                // Only before the script is started
+
+   void terminateScript(const string &message, bool dumpedStack);    // Log why the script failed, then kill it
+
    bool runString(const string &code);
    bool runMain();                                    // Run a script's main() function
    bool runMain(const Vector<string> &args);          // Run a script's main() function, putting args into Lua's arg table
@@ -148,6 +188,14 @@ public:
 
    bool runCmd(const char *function, S32 argCount, S32 returnValueCount);
 
+   static void setCpuBudget(U32 ms);
+   static U32 getCpuBudget();
+   static void beginTick();                     // Call once per game tick, before any scripts run
+
+   const ScriptCpuStats &getCpuStats() const;
+   void resetCpuStatsPeriod();
+   bool isSuspended() const;
+
    const char *getScriptId();
    static bool loadFunction(lua_State *L, const char *scriptId, const char *functionName);
    bool loadAndRunGlobalFunction(lua_State *L, const char *key, ScriptContext context);
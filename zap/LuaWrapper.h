@@ -53,6 +53,8 @@ extern "C"
 #include "LuaBase.h"   
 #include "LuaException.h"   
 
+#include "tnlThread.h"
+
 #include <string>
 #include <vector>
 #include <map>
@@ -84,6 +86,14 @@ inline int luaW_correctindex(lua_State* L, int index, int correction)
 template <class T> class LuaProxy;
 
 
+// Guards LuaProxy reference counts, and objects' pointers to their proxies, which are shared by all Lua states
+inline TNL::Mutex &luaW_proxyMutex()
+{
+   static TNL::Mutex mutex;
+   return mutex;
+}
+
+
 // Here we will specify whether to use our proxy system for objects managed in LuaW
 // or use (mostly) upstream behavior
 inline bool luaW_shouldCreateProxy(lua_State* L)
@@ -386,8 +396,12 @@ void luaW_push(lua_State* L, T* obj)
    // Should we be using proxies for our objects?
    if(luaW_shouldCreateProxy(L))
    {
+      // One proxy serves every Lua state the object is pushed into, and those states may be running on different threads
+      luaW_proxyMutex().lock();
+
       // Get the object's proxy, or create one if it doesn't yet exist
       LuaProxy<T> *proxy = obj->getLuaProxy();
+      bool cached = false;
 
       if(proxy)         // Retrieve the userdata for this proxy from our cache table
       {
@@ -399,18 +413,22 @@ void luaW_push(lua_State* L, T* obj)
          // Here: retrieves and pushes cache_table[id]
          lua_gettable(L, -2);                            // -- cache_table, userdata
 
-         TNLAssert(lua_isuserdata(L, -1) ||
-               dumpStack(L, "Expect table, userdata") || dumpTable(L, -2, "Cached Userdatas"),
-               "Expected userdata!");
-         TNLAssert(proxy == luaW_toProxy<T>(L, -1), "Cached object is not the one we expect!");
-
          // Clean up the stack
          lua_remove(L, -2);                              // -- userdata
+
+         // This state may not have seen the object before, even though another has, or it may still be holding
+         // on to the userdata of an older object that lived at the same address.  Either way, it needs a new one.
+         cached = lua_isuserdata(L, -1) && luaW_toProxy<T>(L, -1) == proxy;
+
+         if(!cached)
+            lua_pop(L, 1);                               // -- <<empty>>
       }
       else
+         proxy = new LuaProxy<T>(obj);    // Create a new proxy
+
+      if(!cached)
       {
-         // Create a new proxy
-         proxy = new LuaProxy<T>(obj);
+         proxy->addRef();
 
          // Add a new entry to our cache table (a weak table; more about those here: http://lua-users.org/wiki/WeakTablesTutorial).
          // Note that from here on down, we'll fall back on the normal LuaW push code, except for the bit at the end where
@@ -441,6 +459,8 @@ void luaW_push(lua_State* L, T* obj)
          luaW_setUsingProxy(L, obj, true);
          luaW_hold<T>(L, obj);     // Tell luaW to collect the proxy when it's done with it
       }
+
+      luaW_proxyMutex().unlock();
    }  // useLuaProxy
 
    // No proxy: Use upstream behavior
@@ -674,8 +694,13 @@ int luaW_gc(lua_State* L)
       LuaProxy<T>* proxy = luaW_toProxy<T>(L, 1);
       TNLAssert(proxy, "Expected a proxy!");
 
-      if(proxy)
+      // Other Lua states may still have userdata of their own for this proxy
+      luaW_proxyMutex().lock();
+
+      if(proxy && proxy->release() == 0)
          delete proxy;
+
+      luaW_proxyMutex().unlock();
    }
 
    // Else we're not using proxies, handle the object with the upstream code.
@@ -1161,6 +1186,7 @@ class LuaProxy
 private:
     bool mDefunct;
     T *mProxiedObject;
+    S32 mRefCount;      // Userdata pointing at us; each Lua state the object has been pushed into has its own
 
 public:
     // Default constructor
@@ -1172,6 +1198,7 @@ public:
       mProxiedObject = obj;
       obj->setLuaProxy(this);
       mDefunct = false;
+      mRefCount = 0;
     }
 
    // Destructor
@@ -1185,6 +1212,10 @@ public:
    T   *getProxiedObject() { return mProxiedObject; }
    bool isDefunct()        { return mDefunct;       }
 
+   // Call with luaW_proxyMutex() held
+   void addRef()           { mRefCount++;           }
+   S32 release()           { return --mRefCount;    }
+
    void setDefunct(bool isDefunct) { mDefunct = isDefunct; }
 };
 
@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "PackingUtils.h"
+
+#include "tnlBitStream.h"
+
+#include <math.h>
+
+namespace Zap
+{
+
+static const U8 DeltaBits = 16;     // Most coordinates are within this many bits, signed, of the one before
+
+
+void writeCount(BitStream &stream, U32 count)
+{
+   if(stream.writeFlag(count < 256))
+      stream.writeInt(count, 8);
+   else
+      stream.writeInt(count, 32);
+}
+
+
+U32 readCount(BitStream &stream)
+{
+   return stream.readFlag() ? stream.readInt(8) : stream.readInt(32);
+}
+
+
+void writeCoord(BitStream &stream, F32 coord, F32 &prev)
+{
+   F32 delta = coord - prev;
+
+   // Converting a float that's out of range, or NaN, to an int is undefined, so check first; NaN fails the check
+   bool inRange = fabs(delta) < (1 << (DeltaBits - 1));
+   S32 intDelta = inRange ? (S32)delta : 0;
+
+   if(stream.writeFlag(inRange && intDelta == delta && prev + F32(intDelta) == coord))
+      stream.writeSignedInt(intDelta, DeltaBits);
+   else
+      stream.write(coord);
+
+   prev = coord;
+}
+
+
+F32 readCoord(BitStream &stream, F32 &prev)
+{
+   if(stream.readFlag())
+      prev += F32(stream.readSignedInt(DeltaBits));
+   else
+      stream.read(&prev);
+
+   return prev;
+}
+
+
+void writePoint(BitStream &stream, const Point &point, Point &prev)
+{
+   writeCoord(stream, point.x, prev.x);
+   writeCoord(stream, point.y, prev.y);
+}
+
+
+Point readPoint(BitStream &stream, Point &prev)
+{
+   readCoord(stream, prev.x);
+   readCoord(stream, prev.y);
+
+   return prev;
+}
+
+
+};
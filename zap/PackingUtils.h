@@ -0,0 +1,39 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _PACKING_UTILS_H_
+#define _PACKING_UTILS_H_
+
+#include "Point.h"
+
+#include "tnlTypes.h"
+
+namespace TNL {
+   class BitStream;
+};
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// Compact encodings shared by the blobs LevelGeometryCache and BotZoneCache write: counts, which are nearly always
+// small, and coordinates, which are mostly whole numbers not far from the one before.  Changing any of these changes
+// both blob formats, so bump both format versions if you do.
+
+void writeCount(BitStream &stream, U32 count);
+U32 readCount(BitStream &stream);
+
+// Coordinates are written as the difference from prev where that gets the same value back exactly, and as the raw
+// float otherwise; prev is updated to the coordinate either way
+void writeCoord(BitStream &stream, F32 coord, F32 &prev);
+F32 readCoord(BitStream &stream, F32 &prev);
+
+void writePoint(BitStream &stream, const Point &point, Point &prev);
+Point readPoint(BitStream &stream, Point &prev);
+
+};
+
+#endif
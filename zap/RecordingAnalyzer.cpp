@@ -0,0 +1,472 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "RecordingAnalyzer.h"
+
+#include "ClientGame.h"
+#include "UIManager.h"
+#include "FontManager.h"
+#include "GameSettings.h"
+#include "teamInfo.h"
+#include "SoundSystemEnums.h"
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+
+#ifndef TNL_OS_WIN32
+#  include <unistd.h>
+#  include <sys/wait.h>
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+
+namespace Zap {
+
+
+RecordingAnalyzer::RecordingAnalyzer(ClientGame *game, const char *filename) : Parent(game, filename)
+{
+   mFilename = filename;
+
+   // NetClassRep counts what's sent by default; we want what's been read
+   setCountReceivedUpdates(true);
+
+   mUsage.resize(mGhostClassCount);
+   mClassSeen.resize(mGhostClassCount);
+   for(S32 i = 0; i < mUsage.size(); i++)
+   {
+      mClassSeen[i] = false;
+
+      NetClassRep *classRep = NetClassRep::getClass(getNetClassGroup(), NetClassTypeObject, i);
+      mUsage[i].initialCount = classRep->getInitialUpdateCount();
+      mUsage[i].initialBits  = classRep->getInitialUpdateBits();
+      mUsage[i].partialCount = classRep->getPartialUpdateCount();
+      mUsage[i].partialBits  = classRep->getPartialUpdateBits();
+   }
+}
+
+
+RecordingAnalyzer::~RecordingAnalyzer()
+{
+   // Do nothing
+}
+
+
+// Plays the whole recording, one packet at a time
+void RecordingAnalyzer::analyze()
+{
+   U32 size;
+   while(playNextPacket(size))
+   {
+      if(size == 0)     // Keyframes aren't packets, and don't count as ticks
+         continue;
+
+      mTickTimes.push_back(mCurrentTime);
+      mTickBytes.push_back(size);
+      countGhosts();
+   }
+
+   // The counters are shared by every connection, so we keep only what was added while we were playing
+   for(S32 i = 0; i < mUsage.size(); i++)
+   {
+      NetClassRep *classRep = NetClassRep::getClass(getNetClassGroup(), NetClassTypeObject, i);
+      mUsage[i].initialCount = classRep->getInitialUpdateCount() - mUsage[i].initialCount;
+      mUsage[i].initialBits  = classRep->getInitialUpdateBits()  - mUsage[i].initialBits;
+      mUsage[i].partialCount = classRep->getPartialUpdateCount() - mUsage[i].partialCount;
+      mUsage[i].partialBits  = classRep->getPartialUpdateBits()  - mUsage[i].partialBits;
+   }
+}
+
+
+void RecordingAnalyzer::countGhosts()
+{
+   S32 first = mTickCounts.size();
+   mTickCounts.resize(first + mGhostClassCount);
+
+   U16 *counts = mTickCounts.address() + first;
+   for(U32 i = 0; i < mGhostClassCount; i++)
+      counts[i] = 0;
+
+   for(S32 i = 0; i < mLocalGhosts.size(); i++)
+      if(mLocalGhosts[i])
+      {
+         U32 classId = mLocalGhosts[i]->getClassId(getNetClassGroup());
+         counts[classId]++;
+         mClassSeen[classId] = true;
+      }
+}
+
+
+void RecordingAnalyzer::addEvent(const string &type, const string &player, const string &other, const string &detail)
+{
+   Event event;
+   event.time = mCurrentTime;
+   event.type = type;
+   event.player = player;
+   event.other = other;
+   event.detail = detail;
+
+   mEvents.push_back(event);
+}
+
+
+// Flag messages are all broadcast with their own sound, which is the easiest way to tell them apart
+void RecordingAnalyzer::displayMessage(U32 colorIndex, U32 sfxEnum, const char *message)
+{
+   switch(sfxEnum)
+   {
+      case SFXFlagCapture:
+         addEvent("flag capture", "", "", message);
+         break;
+      case SFXFlagDrop:
+         addEvent("flag drop", "", "", message);
+         break;
+      case SFXFlagReturn:
+         addEvent("flag return", "", "", message);
+         break;
+      case SFXFlagSnatch:
+         addEvent("flag snatch", "", "", message);
+         break;
+      default:
+         break;
+   }
+}
+
+
+void RecordingAnalyzer::onKillMessage(StringTableEntry victim, StringTableEntry killer, StringTableEntry killerDescr)
+{
+   addEvent("kill", victim.getString(), killer.getString(), killerDescr.getString());
+}
+
+
+static string csvEscape(const string &str)
+{
+   if(str.find_first_of(",\"\r\n") == string::npos)
+      return str;
+
+   return "\"" + replaceString(str, "\"", "\"\"") + "\"";
+}
+
+
+static string jsonEscape(const string &str)
+{
+   string escaped;
+
+   for(U32 i = 0; i < str.length(); i++)
+   {
+      char c = str[i];
+
+      if(c == '"' || c == '\\')
+      {
+         escaped += '\\';
+         escaped += c;
+      }
+      else if(U8(c) < 0x20)
+      {
+         char hex[7];
+         dSprintf(hex, sizeof(hex), "\\u%04x", U8(c));
+         escaped += hex;
+      }
+      else
+         escaped += c;
+   }
+
+   return "\"" + escaped + "\"";
+}
+
+
+static const char *getGhostClassName(NetClassGroup group, U32 index)
+{
+   return NetClassRep::getClass(group, NetClassTypeObject, index)->getClassName();
+}
+
+
+// Writes <recording>.ticks.csv, <recording>.classes.csv and <recording>.events.csv
+bool RecordingAnalyzer::writeCsv() const
+{
+   // Only the classes that turned up get a column
+   Vector<U32> columns;
+   for(U32 i = 0; i < mGhostClassCount; i++)
+      if(mClassSeen[i])
+         columns.push_back(i);
+
+   FILE *file = fopen((mFilename + ".ticks.csv").c_str(), "w");
+   if(!file)
+      return false;
+
+   fprintf(file, "time,bytes,ghosts");
+   for(S32 i = 0; i < columns.size(); i++)
+      fprintf(file, ",%s", getGhostClassName(getNetClassGroup(), columns[i]));
+   fprintf(file, "\n");
+
+   for(S32 i = 0; i < mTickTimes.size(); i++)
+   {
+      const U16 *counts = mTickCounts.address() + i * mGhostClassCount;
+
+      U32 ghosts = 0;
+      for(U32 j = 0; j < mGhostClassCount; j++)
+         ghosts += counts[j];
+
+      fprintf(file, "%u,%u,%u", mTickTimes[i], mTickBytes[i], ghosts);
+      for(S32 j = 0; j < columns.size(); j++)
+         fprintf(file, ",%u", counts[columns[j]]);
+      fprintf(file, "\n");
+   }
+
+   fclose(file);
+
+   file = fopen((mFilename + ".classes.csv").c_str(), "w");
+   if(!file)
+      return false;
+
+   fprintf(file, "class,initial updates,initial bits,partial updates,partial bits\n");
+   for(S32 i = 0; i < columns.size(); i++)
+   {
+      const ClassUsage &usage = mUsage[columns[i]];
+      fprintf(file, "%s,%u,%u,%u,%u\n", getGhostClassName(getNetClassGroup(), columns[i]),
+              usage.initialCount, usage.initialBits, usage.partialCount, usage.partialBits);
+   }
+
+   fclose(file);
+
+   file = fopen((mFilename + ".events.csv").c_str(), "w");
+   if(!file)
+      return false;
+
+   fprintf(file, "time,event,player,other,detail\n");
+   for(S32 i = 0; i < mEvents.size(); i++)
+      fprintf(file, "%u,%s,%s,%s,%s\n", mEvents[i].time, mEvents[i].type.c_str(), csvEscape(mEvents[i].player).c_str(),
+              csvEscape(mEvents[i].other).c_str(), csvEscape(mEvents[i].detail).c_str());
+
+   fclose(file);
+
+   return true;
+}
+
+
+// Writes everything to <recording>.json
+bool RecordingAnalyzer::writeJson() const
+{
+   FILE *file = fopen((mFilename + ".json").c_str(), "w");
+   if(!file)
+      return false;
+
+   fprintf(file, "{\n  \"recording\": %s,\n  \"totalTime\": %u,\n", jsonEscape(mFilename).c_str(), mTotalTime);
+
+   fprintf(file, "  \"classes\": [");
+   bool first = true;
+   for(U32 i = 0; i < mGhostClassCount; i++)
+   {
+      const ClassUsage &usage = mUsage[i];
+      if(!mClassSeen[i])
+         continue;
+
+      fprintf(file, "%s\n    {\"class\": \"%s\", \"initialUpdates\": %u, \"initialBits\": %u, \"partialUpdates\": %u, \"partialBits\": %u}",
+              first ? "" : ",", getGhostClassName(getNetClassGroup(), i),
+              usage.initialCount, usage.initialBits, usage.partialCount, usage.partialBits);
+      first = false;
+   }
+   fprintf(file, "\n  ],\n");
+
+   // Counts are keyed by class, leaving out the ones with none, which is most of them
+   fprintf(file, "  \"ticks\": [");
+   for(S32 i = 0; i < mTickTimes.size(); i++)
+   {
+      const U16 *counts = mTickCounts.address() + i * mGhostClassCount;
+
+      fprintf(file, "%s\n    {\"time\": %u, \"bytes\": %u, \"counts\": {", i == 0 ? "" : ",", mTickTimes[i], mTickBytes[i]);
+
+      first = true;
+      for(U32 j = 0; j < mGhostClassCount; j++)
+         if(counts[j] > 0)
+         {
+            fprintf(file, "%s\"%s\": %u", first ? "" : ", ", getGhostClassName(getNetClassGroup(), j), counts[j]);
+            first = false;
+         }
+
+      fprintf(file, "}}");
+   }
+   fprintf(file, "\n  ],\n");
+
+   fprintf(file, "  \"events\": [");
+   for(S32 i = 0; i < mEvents.size(); i++)
+      fprintf(file, "%s\n    {\"time\": %u, \"event\": \"%s\", \"player\": %s, \"other\": %s, \"detail\": %s}", i == 0 ? "" : ",",
+              mEvents[i].time, mEvents[i].type.c_str(), jsonEscape(mEvents[i].player).c_str(),
+              jsonEscape(mEvents[i].other).c_str(), jsonEscape(mEvents[i].detail).c_str());
+   fprintf(file, "\n  ]\n}\n");
+
+   fclose(file);
+
+   return true;
+}
+
+
+bool RecordingAnalyzer::write(OutputFormat format) const
+{
+   return format == JsonFormat ? writeJson() : writeCsv();
+}
+
+
+// Each recording gets a game of its own, with no UI and no sound, which is thrown away when we're done
+bool RecordingAnalyzer::analyzeFile(const string &filename, OutputFormat format)
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   ClientGame *game = new ClientGame(Address(), settings, new UIManager());    // ClientGame destructor will clean up UIManager
+   game->addTeam(new Team());
+
+   RecordingAnalyzer *analyzer = new RecordingAnalyzer(game, filename.c_str());
+
+   bool ok = analyzer->isValid();
+   if(ok)
+   {
+      game->setConnectionToServer(analyzer);       // Game deletes it from here on
+      analyzer->analyze();
+      ok = analyzer->write(format);
+
+      if(!ok)
+         printf("Could not write results for %s\n", filename.c_str());
+   }
+   else
+   {
+      printf("%s is not a recording this version can play\n", filename.c_str());
+      delete analyzer;
+   }
+
+   delete game;
+
+   return ok;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+// Handle -analyze command
+
+extern bool writeToConsole();
+extern void exitToOs(S32 errcode);
+
+
+// Returns the number of recordings that could not be analyzed
+static S32 analyzeFiles(const Vector<string> &files, S32 first, S32 step, RecordingAnalyzer::OutputFormat format)
+{
+   S32 failures = 0;
+
+   for(S32 i = first; i < files.size(); i += step)
+   {
+      U32 start = Platform::getRealMilliseconds();
+
+      if(RecordingAnalyzer::analyzeFile(files[i], format))
+         printf("Analyzed %s in %d ms\n", files[i].c_str(), Platform::getRealMilliseconds() - start);
+      else
+         failures++;
+   }
+
+   return failures;
+}
+
+
+// Recordings are analyzed in separate processes rather than threads; a game keeps too much of its state in statics
+// for two to be played at once in one process.  Windows has no fork(), so there they are analyzed one at a time.
+void analyzeRecordings(GameSettings *settings, const Vector<string> &words)
+{
+   writeToConsole();
+
+   RecordingAnalyzer::OutputFormat format;
+   if(lcase(words[0]) == "csv")
+      format = RecordingAnalyzer::CsvFormat;
+   else if(lcase(words[0]) == "json")
+      format = RecordingAnalyzer::JsonFormat;
+   else
+   {
+      printf("Usage: bitfighter -analyze <csv|json> <recording or folder 1> [recording or folder 2]...\n");
+      exitToOs(1);
+      return;
+   }
+
+   // Folders stand for every recording in them
+   const string extList[] = { GameRecorderServer::buildGameRecorderExtension() };
+
+   Vector<string> files;
+   for(S32 i = 1; i < words.size(); i++)
+   {
+      Vector<string> folderFiles;
+      if(getFilesFromFolder(words[i], folderFiles, extList, ARRAYSIZE(extList)))
+      {
+         folderFiles.sort(alphaNumberSort);
+         for(S32 j = 0; j < folderFiles.size(); j++)
+            files.push_back(joindir(words[i], folderFiles[j]));
+      }
+      else
+         files.push_back(words[i]);
+   }
+
+   if(files.size() == 0)
+   {
+      printf("No recordings to analyze\n");
+      exitToOs(1);
+      return;
+   }
+
+   FontManager::initialize(settings, false);    // ClientGame needs fonts, but not external ones
+
+   S32 failures = 0;
+
+#ifdef TNL_OS_WIN32
+   failures = analyzeFiles(files, 0, 1, format);
+#else
+   S32 workers = S32(sysconf(_SC_NPROCESSORS_ONLN));
+   if(workers > files.size())
+      workers = files.size();
+
+   if(workers <= 1)
+      failures = analyzeFiles(files, 0, 1, format);
+   else
+   {
+      Vector<pid_t> pids;
+
+      for(S32 i = 0; i < workers; i++)
+      {
+         pid_t pid = fork();
+
+         if(pid < 0)
+         {
+            logprintf(LogConsumer::LogError, "Could not fork process to analyze recordings; errno: %d", errno);
+            break;
+         }
+
+         if(pid == 0)      // Worker process: take every workers-th file, and report how many failed
+         {
+            S32 workerFailures = analyzeFiles(files, i, workers, format);
+            fflush(stdout);
+            _exit(workerFailures > 0 ? 1 : 0);
+         }
+
+         pids.push_back(pid);
+      }
+
+      // Anything a missing worker would have done, we do ourselves
+      for(S32 i = pids.size(); i < workers; i++)
+         failures += analyzeFiles(files, i, workers, format);
+
+      for(S32 i = 0; i < pids.size(); i++)
+      {
+         S32 status;
+         if(waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failures++;
+      }
+   }
+#endif
+
+   FontManager::cleanup();
+
+   if(failures > 0)
+      printf("Some recordings could not be analyzed\n");
+
+   exitToOs(failures > 0 ? 1 : 0);
+}
+
+
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _RECORDINGANALYZER_H_
+#define _RECORDINGANALYZER_H_
+
+#include "GameRecorderPlayback.h"
+
+#include <string>
+
+namespace Zap {
+
+
+class GameSettings;
+
+// Plays a recording through as fast as it can be read, with nothing drawn and nothing idled, keeping track of what was
+// in it: how many objects of each class there were after every packet, how many bits each class took up, and who
+// killed whom and what happened to the flags.
+class RecordingAnalyzer : public GameRecorderPlayback
+{
+   typedef GameRecorderPlayback Parent;
+
+public:
+   enum OutputFormat {
+      CsvFormat,
+      JsonFormat
+   };
+
+private:
+   struct Event
+   {
+      U32 time;
+      string type;
+      string player;
+      string other;
+      string detail;
+   };
+
+   struct ClassUsage
+   {
+      U32 initialCount;
+      U32 initialBits;
+      U32 partialCount;
+      U32 partialBits;
+   };
+
+   string mFilename;
+
+   Vector<U32> mTickTimes;
+   Vector<U32> mTickBytes;
+   Vector<U16> mTickCounts;         // mGhostClassCount per tick, for every ghost class
+   Vector<ClassUsage> mUsage;       // Per ghost class
+   Vector<bool> mClassSeen;         // Per ghost class, whether there was ever one about
+   Vector<Event> mEvents;
+
+   void countGhosts();
+   void addEvent(const string &type, const string &player, const string &other, const string &detail);
+
+   bool writeCsv() const;
+   bool writeJson() const;
+
+public:
+   RecordingAnalyzer(ClientGame *game, const char *filename);
+   virtual ~RecordingAnalyzer();
+
+   void analyze();
+   bool write(OutputFormat format) const;
+
+   void displayMessage(U32 colorIndex, U32 sfxEnum, const char *message);
+   void onKillMessage(StringTableEntry victim, StringTableEntry killer, StringTableEntry killerDescr);
+
+   static bool analyzeFile(const string &filename, OutputFormat format);
+};
+
+
+}
+#endif
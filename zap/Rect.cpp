@@ -174,14 +174,14 @@ void Rect::unionRect(const Rect &r)
 }
 
 // Does rect interset rect r?
-bool Rect::intersects(const Rect &r)
+bool Rect::intersects(const Rect &r) const
 {
    return min.x < r.max.x && min.y < r.max.y &&
          max.x > r.min.x && max.y > r.min.y;
 }
 
 // Does rect interset or border on rect r?
-bool Rect::intersectsOrBorders(const Rect &r)
+bool Rect::intersectsOrBorders(const Rect &r) const
 {
    F32 littleBit = 0.001f;
    return min.x <= r.max.x + littleBit && min.y <= r.max.y + littleBit &&
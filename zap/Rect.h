@@ -72,10 +72,10 @@ public:
    void unionRect(const Rect &r);
 
    // Does rect interset rect r?
-   bool intersects(const Rect &r);
+   bool intersects(const Rect &r) const;
    
    // Does rect interset or border on rect r?
-   bool intersectsOrBorders(const Rect &r);
+   bool intersectsOrBorders(const Rect &r) const;
 
    // Does rect intersect line defined by p1 and p2?
    bool intersects(const Point &p1, const Point &p2) const;
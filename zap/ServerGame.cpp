@@ -16,6 +16,11 @@
 #include "Teleporter.h"
 #include "BanList.h"             // For banList kick duration
 #include "BotNavMeshZone.h"      // For zone clearing code
+#include "BotZoneCache.h"
+#include "BotPathPlanner.h"
+#include "BotZoneGrid.h"
+#include "BotWorkerPool.h"
+#include "TickScheduler.h"
 #include "LevelSource.h"
 #include "LevelDatabase.h"
 
@@ -27,6 +32,8 @@
 
 #include "IniFile.h"
 
+#include "../master/DatabaseAccessThread.h"
+
 
 using namespace TNL;
 
@@ -36,6 +43,8 @@ namespace Zap
 
 static bool instantiated;           // Just a little something to keep us from creating multiple ServerGames...
 
+static const U32 RecordingShutdownTimeout = 10000;      // Longest we'll hold up shutting down for a recording's last blocks
+
 
 // Constructor -- be sure to see Game constructor too!  Lots going on there!
 ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicated, bool hostOnServer) : 
@@ -74,6 +83,18 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    mCurrentLevelIndex = 0;
 
    mBotZoneDatabase = new GridDatabase();    // Deleted in destructor
+   mBotPathPlanner = new BotPathPlanner(&mAllZones);     // Deleted in destructor
+   mBotZoneGrid = new BotZoneGrid(&mAllZones);           // Deleted in destructor
+   mBotSightMemo = new BotSightMemo();                   // Deleted in destructor
+
+   LuaScriptRunner::setCpuBudget(settings->getIniSettings()->scriptCpuBudget);   // Before the pool makes its Lua states
+
+   S32 botWorkerThreads = settings->getIniSettings()->botWorkerThreads;
+   mBotWorkerPool = botWorkerThreads > 0 ?                                                 // Deleted in destructor
+         new BotWorkerPool(botWorkerThreads, settings->getIniSettings()->botRandomSeed) : NULL;
+
+   mScriptStatsTimer.reset(ScriptStatsLogTime);
+   mBotZoneBuildId = 0;
 
    if(testMode)
       mInfoFlags |= TestModeFlag;
@@ -96,6 +117,7 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    mTestMode = testMode;
 
    mNetInterface->setAllowsConnections(true);
+   mTickScheduler = NULL;
    mMasterUpdateTimer.reset(UpdateServerStatusTime);
 
    mSuspendor = NULL;
@@ -138,12 +160,18 @@ ServerGame::~ServerGame()
    instantiated = false;
 
    delete mGameInfo;
+   delete mBotWorkerPool;        // After cleanUp(), which gets rid of the robots
+   delete mTickScheduler;
+   delete mBotSightMemo;
+   delete mBotZoneGrid;
+   delete mBotPathPlanner;
    delete mBotZoneDatabase;
 
+   LuaScriptRunner::setCpuBudget(0);      // No more robots or levelgens to hold to it
+
    GameManager::setHostingModePhase(GameManager::NotHosting);
 
-   if(mGameRecorderServer)
-      delete mGameRecorderServer;
+   finishRecording();
 }
 
 
@@ -642,28 +670,19 @@ void ServerGame::cycleLevel(S32 nextLevel)
 
    computeWorldObjectExtents();                       // Compute world Extents nice and early
 
+   // Now that we know how big the level is, size our spatial database to fit it, and index the geometry that won't be moving
+   getGameObjDatabase()->resizeGrid(*getWorldExtents(), GridDatabase::getBucketWidthBitShift(getSettings()->getIniSettings()->gridCellSize));
+   getGameObjDatabase()->buildStaticIndex();
+
    if(!mGameRecorderServer && !mShuttingDown && getSettings()->getIniSettings()->enableGameRecording)
       mGameRecorderServer = new GameRecorderServer(this);
 
 
    // Bot zone time
-   bool triangulate;
-
-   // Try and load Bot Zones for this level, set flag if failed
-   // We need to run buildBotMeshZones in order to set mAllZones properly, which is why I (sort of) disabled the use of hand-built zones in level files
-#ifdef ZAP_DEDICATED
-   triangulate = false;
-#else
-   triangulate = !isDedicated();
-#endif
-
-   mGameType->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mBotZoneDatabase, getGameObjDatabase(), &mAllZones,
-                                                                          getWorldExtents(), triangulate);
-   if(mGameType->mBotZoneCreationFailed)
-   {
-      for(int i = 0; i < getClientCount(); i++)
-         getClientInfo(i)->getConnection()->s2cDisplayConsoleMessage("Zone creation failed for level; bots disabled.");
-   }
+   // Try and load Bot Zones for this level, set flag if failed.  If they're not in the cache, they'll be built in the background.
+   // We need to build zones in order to set mAllZones properly, which is why I (sort of) disabled the use of hand-built zones in level files
+   if(!prepareBotZones(true))
+      onBotZoneCreationFailed();
 
    // Clear team info for all clients
    resetAllClientTeams();
@@ -1233,6 +1252,9 @@ string ServerGame::addBot(const Vector<const char *> &args, ClientInfo::ClientCl
 void ServerGame::addBot(Robot *robot)
 {
    mRobotManager.addBot(robot);
+
+   if(mBotWorkerPool)
+      mBotWorkerPool->addRobot(robot);
 }
 
 
@@ -1263,6 +1285,9 @@ Robot *ServerGame::findBot(const char *id)
 void ServerGame::removeBot(Robot *robot)
 {
    mRobotManager.removeBot(robot);
+
+   if(mBotWorkerPool)
+      mBotWorkerPool->removeRobot(robot);
 }
 
 
@@ -1412,7 +1437,7 @@ void ServerGame::idle(U32 timeDelta)
 
    // If we have a data transfer going on, process it
    if(!dataSender.isDone())
-      dataSender.sendNextLine();
+      dataSender.sendPendingData();
 
    // Play any sounds server might have made... (this is only for special alerts such as player joined or left)
    if(isDedicated())   // Non-dedicated servers will process sound in client side
@@ -1430,6 +1455,15 @@ void ServerGame::idle(U32 timeDelta)
 
    mCurrentTime += timeDelta;
 
+   LuaScriptRunner::beginTick();       // Scripts' CPU budgets start afresh
+
+   if(mScriptStatsTimer.update(timeDelta))
+   {
+      logScriptCpuStats();
+      logTickStats();
+      mScriptStatsTimer.reset();
+   }
+
    for(S32 i = 0; i < getClientCount(); i++)
    {
       ClientInfo *clientInfo = getClientInfo(i);
@@ -1455,9 +1489,9 @@ void ServerGame::idle(U32 timeDelta)
          mLevelGens.deleteAndErase_fast(index);
    }
 
-   // Compute new world extents -- these might change if a ship flies far away, for example...
-   // In practice, we could probably just set it and forget it when we load a level.
-   // Compute it here to save recomputing it for every robot and other method that relies on it.
+   // Refresh world extents -- these might change if a ship flies far away, for example...
+   // The database keeps track of them as objects move, so this is cheap; we grab a copy here for every robot and
+   // other method that relies on it.
    computeWorldObjectExtents();
 
    U32 botControlTickElapsed = botControlTickTimer.getElapsed();
@@ -1467,8 +1501,22 @@ void ServerGame::idle(U32 timeDelta)
       // Clear all old bot moves, so that if the bot does nothing, it doesn't just continue with what it was doing before
       mRobotManager.clearMoves();
 
-      // Fire TickEvent, in case anyone is listening
-      EventManager::get()->fireEvent(EventManager::TickEvent, botControlTickElapsed + timeDelta);
+      // Fire TickEvent, in case anyone is listening.  Nothing moves until robots are done, so they can share what they see.
+      if(mBotWorkerPool)
+      {
+         // Robots thinking at the same time mustn't see anything that depends on which of them got there first
+         mBotSightMemo->begin(true);
+         mBotZoneGrid->holdClosestZones();
+         EventManager::get()->fireEvent(EventManager::TickEvent, botControlTickElapsed + timeDelta, mBotWorkerPool);
+         mBotZoneGrid->releaseClosestZones();
+      }
+      else
+      {
+         mBotSightMemo->begin();
+         EventManager::get()->fireEvent(EventManager::TickEvent, botControlTickElapsed + timeDelta);
+      }
+
+      mBotSightMemo->end();
 
       botControlTickTimer.reset();
    }
@@ -1949,26 +1997,368 @@ const Vector<BotNavMeshZone *> *ServerGame::getBotZones() const
 }
 
 
+BotPathPlanner *ServerGame::getBotPathPlanner() const
+{
+   return mBotPathPlanner;
+}
+
+
+BotSightMemo *ServerGame::getBotSightMemo() const
+{
+   return mBotSightMemo;
+}
+
+
+BotWorkerPool *ServerGame::getBotWorkerPool() const
+{
+   return mBotWorkerPool;
+}
+
+
+static string getCpuStatsLine(const string &name, LuaScriptRunner *script)
+{
+   const ScriptCpuStats &stats = script->getCpuStats();
+
+   char line[256];
+   dSprintf(line, sizeof(line), "%s: %.1f ms in %d calls (%.1f ms lately, peak %.1f ms/tick), %d overruns%s",
+            name.c_str(), stats.totalMs, stats.calls, stats.periodMs, stats.peakTickMs, stats.overruns,
+            script->isSuspended() ? ", suspended" : "");
+
+   return line;
+}
+
+
+Vector<string> ServerGame::getScriptCpuReport()
+{
+   Vector<string> lines;
+
+   for(S32 i = 0; i < mLevelGens.size(); i++)
+      lines.push_back(getCpuStatsLine("Levelgen " + extractFilename(mLevelGens[i]->getScriptName()), mLevelGens[i]));
+
+   for(S32 i = 0; i < getBotCount(); i++)
+   {
+      Robot *robot = getBot(i);
+      string name = robot->getClientInfo() ? robot->getClientInfo()->getName().getString() : "?";
+
+      lines.push_back(getCpuStatsLine("Robot " + name + " (" + extractFilename(robot->getScriptName()) + ")", robot));
+   }
+
+   return lines;
+}
+
+
+void ServerGame::logScriptCpuStats()
+{
+   Vector<string> lines = getScriptCpuReport();
+
+   for(S32 i = 0; i < lines.size(); i++)
+      logprintf(LogConsumer::StatisticsFilter, "Script CPU: %s", lines[i].c_str());
+
+   for(S32 i = 0; i < mLevelGens.size(); i++)
+      mLevelGens[i]->resetCpuStatsPeriod();
+
+   for(S32 i = 0; i < getBotCount(); i++)
+      getBot(i)->resetCpuStatsPeriod();
+}
+
+
+// Only the dedicated server's main loop asks for this, so client-hosted and test games never open the epoll and
+// timer descriptors behind it
+TickScheduler *ServerGame::getTickScheduler()
+{
+   TNLAssert(mDedicated, "Only dedicated servers are paced by the scheduler!");
+
+   if(!mTickScheduler)
+      mTickScheduler = new TickScheduler();
+
+   return mTickScheduler;
+}
+
+
+void ServerGame::logTickStats()
+{
+   if(!mTickScheduler)     // Not paced by the scheduler; not a dedicated server, say
+      return;
+
+   const TickStats &stats = mTickScheduler->getPeriodStats();
+
+   if(stats.ticks == 0)
+      return;
+
+   logprintf(LogConsumer::StatisticsFilter, "Ticks: %d at %d/s, %d skipped, %d early wakeups for packets, "
+             "jitter %.2f ms mean, %.2f ms peak", stats.ticks, mTickScheduler->getTickRate(), stats.skippedTicks,
+             stats.packetWakeups, stats.getMeanJitterUs() / 1000.0f, stats.peakJitterUs / 1000.0f);
+
+   mTickScheduler->resetPeriodStats();
+}
+
+
 // Returns ID of zone containing specified point
 U16 ServerGame::findZoneContaining(const Point &p) const
 {
-   fillVector.clear();
-   mBotZoneDatabase->findObjects(BotNavMeshZoneTypeNumber, fillVector,
-                                Rect(p - Point(0.1f, 0.1f), p + Point(0.1f, 0.1f)));  // Slightly extend Rect, it can be on the edge of zone
+   return mBotZoneGrid->findZoneContaining(p);
+}
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+
+// Returns id of closest zone to a given point, used when robots, or what they're after, get off the map
+U16 ServerGame::findClosestZone(GridDatabase::QueryContext &context, const Point &point)
+{
+   U16 closestZone = U16_MAX;
+
+   // Working this out takes a raycast for each zone we try, so we remember what we found for next time
+   if(mBotZoneGrid->getClosestZone(point, closestZone))
+      return closestZone;
+
+   // First, do a quick search for zone based on the buffer; should be 99% of the cases
+
+   // Search radius is just slightly larger than twice the zone buffers added to objects like barriers
+   S32 searchRadius = 2 * BotNavMeshZone::BufferRadius + 1;
+
+   Vector<DatabaseObject*> objects;
+   Rect rect = Rect(point.x + searchRadius, point.y + searchRadius, point.x - searchRadius, point.y - searchRadius);
+
+   mBotZoneDatabase->findObjects(context, BotNavMeshZoneTypeNumber, objects, rect);
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(objects[i]);
+      Point center = zone->getCenter();
+
+      if(getGameObjDatabase()->pointCanSeePoint(context, center, point))  // This is an expensive test
+      {
+         closestZone = zone->getZoneId();
+         break;
+      }
+   }
+
+   // Target must be outside extents of the map, find nearest zone if a straight line was drawn
+   if(closestZone == U16_MAX)
+   {
+      Point extentsCenter = getWorldExtents()->getCenter();
+
+      F32 collisionTimeIgnore;
+      Point surfaceNormalIgnore;
+
+      DatabaseObject* object = mBotZoneDatabase->findObjectLOS(context, BotNavMeshZoneTypeNumber,
+            ActualState, true, point, extentsCenter, collisionTimeIgnore, surfaceNormalIgnore);
+
+      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(object);
+
+      if (zone != NULL)
+         closestZone = zone->getZoneId();
+   }
+
+   mBotZoneGrid->setClosestZone(point, closestZone);
+
+   return closestZone;
+}
+
+
+// Builds a level's bot zones on the secondary thread, and hands them back to the game when they're done
+class BotZoneBuildThread : public Master::ThreadEntry
+{
+private:
+   ServerGame *mGame;
+   U32 mBuildId;
+   BotZoneInput mInput;
+   BotZoneMesh mMesh;
+   string mCacheKey;
+   string mError;
+   Vector<string> mMessages;
+
+public:
+   BotZoneBuildThread(ServerGame *game, U32 buildId, const BotZoneInput &input, const string &cacheKey)
+   {
+      mGame = game;
+      mBuildId = buildId;
+      mInput = input;
+      mCacheKey = cacheKey;
+   }
+
+   void run()
+   {
+      if(!BotNavMeshZone::buildBotZoneMesh(mInput, mMesh, mError, mMessages) && mError == "")
+         mError = "Bot zones could not be built!";
+   }
+
+   void finish()
+   {
+      mGame->onBotZonesBuilt(mBuildId, mMesh, mCacheKey, mError, mMessages);
+   }
+};
+
+
+// Triangulation is only needed to draw zones on a local client
+bool ServerGame::triangulateBotZones() const
+{
+#ifdef ZAP_DEDICATED
+   return false;
+#else
+   return !isDedicated();
+#endif
+}
+
+
+// Paths and lookups made for the old zones are no good for the new ones
+void ServerGame::onBotZonesChanged()
+{
+   mBotPathPlanner->reset();
+   mBotZoneGrid->reset();
+}
+
+
+// Puts zones from the cache into play straight away.  Otherwise builds them, on the secondary thread if buildInBackground,
+// in which case robots will find no zones, and so get no waypoints, until they're ready.  Returns false if we know already
+// that zones can't be built for this level.
+bool ServerGame::prepareBotZones(bool buildInBackground)
+{
+   mAllZones.deleteAndClear();      // Also clears mBotZoneDatabase
+   onBotZonesChanged();
+   mBotZoneBuildId++;               // Anything still being built for the last level is no use to us now
+
+   // Levelgens can put anything anywhere, so there's no telling their zones from the level file
+   string cacheKey;
+   if(mLevelFileHash != "" && mLevelGens.size() == 0)
+      cacheKey = BotZoneCache::getKey(mLevelFileHash);
+
+   BotZoneMesh mesh;
+
+   if(BotZoneCache(mSettings->getFolderManager()->cacheDir).load(cacheKey, mesh))
+   {
+      BotNavMeshZone::addBotZones(mesh, mBotZoneDatabase, &mAllZones, triangulateBotZones());
+      onBotZonesChanged();
+      return true;
+   }
+
+   BotZoneInput input;
+   if(!BotNavMeshZone::gatherBotZoneInput(getGameObjDatabase(), getWorldExtents(), input))
+      return false;
+
+   if(buildInBackground)
+   {
+      getSecondaryThread()->addEntry(new BotZoneBuildThread(this, mBotZoneBuildId, input, cacheKey));
+      return true;
+   }
+
+   string error;
+   Vector<string> messages;
+
+   bool built = BotNavMeshZone::buildBotZoneMesh(input, mesh, error, messages);
+
+   for(S32 i = 0; i < messages.size(); i++)
+      logprintf("%s", messages[i].c_str());
+
+   if(!built)
+   {
+      logprintf(LogConsumer::LogLevelError, "%s", error.c_str());
+      return false;
+   }
+
+   installBotZones(mesh, cacheKey);
+   return true;
+}
+
+
+// Teleporter and speedzone connections can only be made once the zones are in the database; once they are, the zones are
+// complete, and can be cached
+void ServerGame::installBotZones(BotZoneMesh &mesh, const string &cacheKey)
+{
+   BotNavMeshZone::addBotZones(mesh, mBotZoneDatabase, &mAllZones, triangulateBotZones());
+   BotNavMeshZone::linkBotZones(mBotZoneDatabase, getGameObjDatabase(), &mAllZones, mesh.speedZoneStartId);
+   onBotZonesChanged();
+
+   if(cacheKey == "")
+      return;
+
+   BotNavMeshZone::getBotZoneNeighbors(&mAllZones, mesh);
+   BotZoneCache(mSettings->getFolderManager()->cacheDir).save(cacheKey, mesh);
+}
+
+
+// Called from the secondary thread's finish(), on the main thread; error is empty if the zones were built, and messages
+// are whatever the build wanted logged
+void ServerGame::onBotZonesBuilt(U32 buildId, BotZoneMesh &mesh, const string &cacheKey, const string &error,
+                                 const Vector<string> &messages)
+{
+   for(S32 i = 0; i < messages.size(); i++)
+      logprintf("%s", messages[i].c_str());
+
+   if(buildId != mBotZoneBuildId)      // Level has changed since we started
+      return;
+
+   if(error == "")
+   {
+      installBotZones(mesh, cacheKey);
+      return;
+   }
+
+   logprintf(LogConsumer::LogLevelError, "%s", error.c_str());
+   onBotZoneCreationFailed();
+}
+
+
+void ServerGame::onBotZoneCreationFailed()
+{
+   if(getGameType())
+      getGameType()->mBotZoneCreationFailed = true;
+
+   for(S32 i = 0; i < getClientCount(); i++)
+   {
+      GameConnection *conn = getClientInfo(i)->getConnection();
+      if(conn)
+         conn->s2cDisplayConsoleMessage("Zone creation failed for level; bots disabled.");
+   }
+}
+
+
+static void doNotDeleteSettings(GameSettings *settings)
+{
+   // Settings belong to whoever passed them to buildBotZoneCache()
+}
+
+
+// Load each level the server would play, and build its bot zones into the cache, so they're ready when the level comes up.
+// Returns false if any level's zones couldn't be built.
+bool ServerGame::buildBotZoneCache(GameSettings *settings)
+{
+   GameSettingsPtr settingsPtr = GameSettingsPtr(settings, doNotDeleteSettings);
+   LevelSourcePtr levelSource = LevelSourcePtr(settings->chooseLevelSource(NULL));
+
+   ServerGame game(Address(), settingsPtr, levelSource, false, true);
+
+   bool ok = true;
+
+   for(S32 i = 0; i < levelSource->getLevelCount(); i++)
    {
-      // First a quick, crude elimination check then more comprehensive one
-      // Since our zones are convex, we can use the faster method!  Yay!
-      // Actually, we can't, as it is not reliable... reverting to more comprehensive (and working) version.
-      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(fillVector[i]);
-
-      if(zone->getExtent().contains(p) &&
-            (polygonContainsPoint(zone->getOutline()->address(), zone->getOutline()->size(), p)))
-         return zone->getZoneId();
+      game.cleanUp();
+      game.mCurrentLevelIndex = i;
+
+      string descriptor = levelSource->getLevelFileDescriptor(i);
+
+      if(!game.loadLevel())
+      {
+         printf("Could not load %s\n", descriptor.c_str());
+         ok = false;
+         continue;
+      }
+
+      game.computeWorldObjectExtents();
+      game.getGameObjDatabase()->resizeGrid(*game.getWorldExtents(),
+                                            GridDatabase::getBucketWidthBitShift(settings->getIniSettings()->gridCellSize));
+      game.getGameObjDatabase()->buildStaticIndex();
+
+      if(game.mLevelGens.size() > 0)
+         printf("Skipping %s, as it has a levelgen\n", descriptor.c_str());
+      else if(game.prepareBotZones(false))
+         printf("Built %d zones for %s\n", game.mAllZones.size(), descriptor.c_str());
+      else
+      {
+         printf("Could not build zones for %s\n", descriptor.c_str());
+         ok = false;
+      }
    }
 
-   return U16_MAX;
+   return ok;
 }
 
 
@@ -1999,5 +2389,16 @@ GameRecorderServer *ServerGame::getGameRecorder()
 }
 
 
+// Close out any recording in progress, and wait for it (and any from earlier levels) to reach the disk, so the
+// process doesn't end partway through writing one out
+void ServerGame::finishRecording()
+{
+   delete mGameRecorderServer;
+   mGameRecorderServer = NULL;
+
+   GameRecorderServer::waitForWriters(RecordingShutdownTimeout);
+}
+
+
 };
 
@@ -30,6 +30,12 @@ class ItemSpawn;
 struct LevelInfo;
 
 class GameRecorderServer;
+struct BotZoneMesh;
+class BotPathPlanner;
+class BotZoneGrid;
+class BotSightMemo;
+class BotWorkerPool;
+class TickScheduler;
 
 static const string UploadPrefix = "upload_";
 static const string DownloadPrefix = "download_";
@@ -44,6 +50,7 @@ private:
       UpdateServerWhenHostGoesEmpty = FOUR_SECONDS, // How many seconds when host on server when server goes empty or not empty
       CheckServerStatusTime = FIVE_SECONDS,       // If it did not send updates, recheck after ms
       BotControlTickInterval = 33,                // Interval for how often should we let bots fire the onTick event (ms)
+      ScriptStatsLogTime = TEN_MINUTES,           // How often we log how much CPU time scripts have been using (ms)
    };
 
    bool mTestMode;                        // True if being tested from editor
@@ -55,6 +62,7 @@ private:
    U32 mCurrentLevelIndex;                // Index of level currently being played
    Timer mLevelSwitchTimer;               // Track how long after game has ended before we actually switch levels
    Timer mMasterUpdateTimer;              // Periodically let the master know how we're doing
+   Timer mScriptStatsTimer;               // Periodically log scripts' CPU use
 
    bool mShuttingDown;
    string mShutdownReason;                // Message to local user about why we're shutting down, optional
@@ -86,6 +94,7 @@ private:
    U32 mAccumulatedSleepTime;
 
    RobotManager mRobotManager;
+   TickScheduler *mTickScheduler;         // Paces the dedicated server's main loop; created on first use
 
    Vector<LuaLevelGenerator *> mLevelGens;
    Vector<LuaLevelGenerator *> mLevelGenDeleteList;
@@ -96,6 +105,8 @@ private:
    void updateStatusOnMaster();           // Give master a status report for this server
    void processVoting(U32 timeDelta);     // Manage any ongoing votes
    void processSimulatedStutter(U32 timeDelta);
+   void logScriptCpuStats();              // Log scripts' CPU use, and start counting afresh
+   void logTickStats();                   // Log how well we've kept time, and start counting afresh
 
    //string getLevelFileNameFromIndex(S32 indx);
 
@@ -119,6 +130,17 @@ private:
 
    GridDatabase *mBotZoneDatabase;
    Vector<BotNavMeshZone *> mAllZones;
+   BotPathPlanner *mBotPathPlanner;                   // Paths between mAllZones, for all our robots
+   BotZoneGrid *mBotZoneGrid;                         // Which of mAllZones is where
+   BotSightMemo *mBotSightMemo;                       // What robots have seen this bot tick
+   BotWorkerPool *mBotWorkerPool;                     // Threads our robots think on, or NULL if they think on ours
+   U32 mBotZoneBuildId;                               // Bumped every level, so zones built for an old level can be ignored
+
+   bool triangulateBotZones() const;
+   void onBotZonesChanged();
+   bool prepareBotZones(bool buildInBackground);      // Load zones from the cache, or build them
+   void installBotZones(BotZoneMesh &mesh, const string &cacheKey);
+   void onBotZoneCreationFailed();
    
 public:
    ServerGame(const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicated, bool hostOnServer = false);    // Constructor
@@ -264,12 +286,23 @@ public:
    // BotNavMeshZone management
    GridDatabase *getBotZoneDatabase() const;
    const Vector<BotNavMeshZone *> *getBotZones() const;
+   BotPathPlanner *getBotPathPlanner() const;
+   BotSightMemo *getBotSightMemo() const;
+   BotWorkerPool *getBotWorkerPool() const;
+   TickScheduler *getTickScheduler();
+   Vector<string> getScriptCpuReport();               // A line for each robot and levelgen
    U16 findZoneContaining(const Point &p) const;
+   U16 findClosestZone(GridDatabase::QueryContext &context, const Point &point);
+   void onBotZonesBuilt(U32 buildId, BotZoneMesh &mesh, const string &cacheKey, const string &error,
+                        const Vector<string> &messages);
+
+   static bool buildBotZoneCache(GameSettings *settings);    // For -buildzones
 
    void setGameType(GameType *gameType);
    void onObjectAdded(BfObject *obj);
    void onObjectRemoved(BfObject *obj);
    GameRecorderServer *getGameRecorder();
+   void finishRecording();
 
    friend class ObjectTest;
 };
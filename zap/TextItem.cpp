@@ -376,14 +376,21 @@ void TextItem::unpackUpdate(GhostConnection *connection, BitStream *stream)
 
 
 F32 TextItem::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips)
+{
+   return Parent::getUpdatePriority(connection, updateMask, updateSkips) + getUpdatePriorityAdjustment(this);
+}
+
+
+// Shared with BfObject::computeUpdatePriorities()
+F32 TextItem::getUpdatePriorityAdjustment(BfObject *item)
 {
    // Lower priority for initial update.  This is to work around network-heavy loading of levels
    // with many TextItems, which will stall the client and prevent you from moving your ship
-   if(isInitialUpdate())
-      return Parent::getUpdatePriority(connection, updateMask, updateSkips) - 1000.f;
+   if(static_cast<TextItem *>(item)->isInitialUpdate())
+      return -1000.f;
 
    // Normal priority otherwise so Geom changes are immediately visible to all clients
-   return Parent::getUpdatePriority(connection, updateMask, updateSkips);
+   return 0;
 }
 
 
@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TickScheduler.h"
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+
+#ifdef TNL_OS_LINUX
+#  include <sys/epoll.h>
+#  include <sys/timerfd.h>
+#  include <errno.h>
+#  include <string.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+namespace Zap
+{
+
+// Constructor
+TickStats::TickStats()
+{
+   ticks = 0;
+   skippedTicks = 0;
+   tickWakeups = 0;
+   packetWakeups = 0;
+   totalJitterUs = 0;
+   peakJitterUs = 0;
+}
+
+
+U32 TickStats::getMeanJitterUs() const
+{
+   return tickWakeups ? U32(totalJitterUs / tickWakeups) : 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+TickScheduler::TickScheduler()
+{
+   mTickRate = 0;
+   mTickLength = 0;
+   mNextTick = 0;
+   mUnspentUs = 0;
+   mSocket = -1;
+
+#ifdef TNL_OS_LINUX
+   mEpoll = epoll_create1(EPOLL_CLOEXEC);
+   mTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+   epoll_event event;
+   memset(&event, 0, sizeof(event));
+   event.events = EPOLLIN;
+   event.data.fd = mTimer;
+
+   if(mEpoll < 0 || mTimer < 0 || epoll_ctl(mEpoll, EPOLL_CTL_ADD, mTimer, &event) != 0)
+   {
+      logprintf(LogConsumer::LogWarning, "Could not set up tick timer (%s); server will sleep between ticks instead",
+                strerror(errno));
+
+      if(mEpoll >= 0)
+         close(mEpoll);
+      if(mTimer >= 0)
+         close(mTimer);
+
+      mEpoll = -1;
+      mTimer = -1;
+   }
+#endif
+
+   setTickRate(100);
+}
+
+
+// Destructor
+TickScheduler::~TickScheduler()
+{
+#ifdef TNL_OS_LINUX
+   if(mEpoll >= 0)
+      close(mEpoll);
+   if(mTimer >= 0)
+      close(mTimer);
+#endif
+}
+
+
+U64 TickScheduler::getMicroseconds()
+{
+#ifdef TNL_OS_LINUX
+   // Same clock as the timerfd
+   timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return U64(now.tv_sec) * 1000000 + U64(now.tv_nsec) / 1000;
+#else
+   return U64(Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue()) * 1000);
+#endif
+}
+
+
+// Only restarts the clock if the rate has changed, so it's fine to call this every time round the loop
+void TickScheduler::setTickRate(U32 ticksPerSecond)
+{
+   if(ticksPerSecond == 0)
+      ticksPerSecond = 1;
+
+   if(ticksPerSecond == mTickRate)
+      return;
+
+   mTickRate = ticksPerSecond;
+   mTickLength = 1000000 / ticksPerSecond;
+   mNextTick = getMicroseconds() + mTickLength;
+
+#ifdef TNL_OS_LINUX
+   armTimer();
+#endif
+}
+
+
+U32 TickScheduler::getTickRate() const
+{
+   return mTickRate;
+}
+
+
+U32 TickScheduler::getTickLength() const
+{
+   return U32(mTickLength / 1000);
+}
+
+
+#ifdef TNL_OS_LINUX
+void TickScheduler::armTimer()
+{
+   if(mTimer < 0)
+      return;
+
+   itimerspec spec;
+   spec.it_interval.tv_sec  = time_t(mTickLength / 1000000);
+   spec.it_interval.tv_nsec = long(mTickLength % 1000000) * 1000;
+   spec.it_value = spec.it_interval;
+
+   timerfd_settime(mTimer, 0, &spec, NULL);
+}
+#endif
+
+
+void TickScheduler::setSocket(S32 socket)
+{
+   if(socket == mSocket)
+      return;
+
+#ifdef TNL_OS_LINUX
+   if(mEpoll >= 0)
+   {
+      if(mSocket >= 0)
+         epoll_ctl(mEpoll, EPOLL_CTL_DEL, mSocket, NULL);
+
+      if(socket >= 0)
+      {
+         epoll_event event;
+         memset(&event, 0, sizeof(event));
+         event.events = EPOLLIN;
+         event.data.fd = socket;
+
+         epoll_ctl(mEpoll, EPOLL_CTL_ADD, socket, &event);
+      }
+   }
+#endif
+
+   mSocket = socket;
+}
+
+
+S32 TickScheduler::wait()
+{
+#ifdef TNL_OS_LINUX
+   while(mEpoll >= 0)
+   {
+      epoll_event events[2];
+      S32 count = epoll_wait(mEpoll, events, ARRAYSIZE(events), -1);
+
+      if(count < 0)
+      {
+         if(errno == EINTR)
+            continue;
+
+         logprintf(LogConsumer::LogWarning, "Waiting for tick failed (%s); server will sleep between ticks instead",
+                   strerror(errno));
+         close(mEpoll);
+         mEpoll = -1;
+         break;
+      }
+
+      bool packet = false;
+      bool tick = false;
+
+      for(S32 i = 0; i < count; i++)
+         if(events[i].data.fd == mTimer)
+            tick = true;
+         else
+            packet = true;
+
+      // Ticks come first: the game's idle reads the socket anyway
+      if(tick)
+      {
+         U64 expirations;
+         if(read(mTimer, &expirations, sizeof(expirations)) == sizeof(expirations) && expirations > 0)
+            return countTicks(expirations, getMicroseconds());
+      }
+
+      if(packet)
+      {
+         mStats.packetWakeups++;
+         mPeriodStats.packetWakeups++;
+         return 0;
+      }
+   }
+#endif
+
+   return sleepUntilTick();
+}
+
+
+// For when there's no timer to wait on; packets wait for the tick
+S32 TickScheduler::sleepUntilTick()
+{
+   U64 now = getMicroseconds();
+
+   while(now < mNextTick)
+   {
+      Platform::sleep(U32((mNextTick - now + 999) / 1000));
+      now = getMicroseconds();
+   }
+
+   return countTicks((now - mNextTick) / mTickLength + 1, now);
+}
+
+
+// Works out how many of the due ticks to run, and keeps score
+S32 TickScheduler::countTicks(U64 dueTicks, U64 now)
+{
+   U64 lastDue = mNextTick + (dueTicks - 1) * mTickLength;
+   U32 jitter = now > lastDue ? U32(now - lastDue) : 0;
+
+   mNextTick += dueTicks * mTickLength;
+
+   // If the clock has drifted from the timer, believe the timer
+   if(mNextTick < now || mNextTick > now + mTickLength)
+      mNextTick = now + mTickLength;
+
+   S32 ticks = dueTicks > MaxCatchUpTicks ? MaxCatchUpTicks : S32(dueTicks);
+   U32 skipped = U32(dueTicks - ticks);
+
+   TickStats *stats[] = { &mStats, &mPeriodStats };
+
+   for(U32 i = 0; i < ARRAYSIZE(stats); i++)
+   {
+      stats[i]->ticks += ticks;
+      stats[i]->skippedTicks += skipped;
+      stats[i]->tickWakeups++;
+      stats[i]->totalJitterUs += jitter;
+      stats[i]->peakJitterUs = getMax(stats[i]->peakJitterUs, jitter);
+   }
+
+   return ticks;
+}
+
+
+U32 TickScheduler::takeTickTime()
+{
+   mUnspentUs += mTickLength;
+
+   U32 ms = U32(mUnspentUs / 1000);
+   mUnspentUs -= U64(ms) * 1000;
+
+   return ms;
+}
+
+
+const TickStats &TickScheduler::getStats() const
+{
+   return mStats;
+}
+
+
+const TickStats &TickScheduler::getPeriodStats() const
+{
+   return mPeriodStats;
+}
+
+
+void TickScheduler::resetPeriodStats()
+{
+   mPeriodStats = TickStats();
+}
+
+
+};
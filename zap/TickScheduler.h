@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _TICK_SCHEDULER_H_
+#define _TICK_SCHEDULER_H_
+
+#include "tnlTypes.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+struct TickStats
+{
+   U32 ticks;              // Ticks run
+   U32 skippedTicks;       // Ticks dropped because we'd fallen too far behind to catch up
+   U32 tickWakeups;        // Times we woke to run ticks
+   U32 packetWakeups;      // Times we woke early because a packet came in
+   U64 totalJitterUs;      // How late we woke for ticks, added up...
+   U32 peakJitterUs;       // ...and the latest we ever were
+
+   TickStats();            // Constructor
+   U32 getMeanJitterUs() const;
+};
+
+
+// Paces the dedicated server: runs the game at a fixed rate, and wakes it as soon as a packet arrives in between, so
+// the server neither sleeps through input nor spins waiting for it.
+//
+// On Linux this waits in epoll on the game's socket and a timerfd that fires once a tick.  Elsewhere we just sleep
+// until the next tick, and packets wait for it.
+class TickScheduler
+{
+private:
+   enum {
+      MaxCatchUpTicks = 5,    // Most ticks we'll run back to back when we've fallen behind; the rest are dropped
+   };
+
+   U32 mTickRate;
+   U64 mTickLength;           // Us
+   U64 mNextTick;             // Us, when the next tick is due
+   U64 mUnspentUs;            // Game time owed by ticks so far that hasn't made up a whole ms yet
+   S32 mSocket;
+
+   TickStats mStats;
+   TickStats mPeriodStats;
+
+#ifdef TNL_OS_LINUX
+   S32 mEpoll;
+   S32 mTimer;
+
+   void armTimer();
+#endif
+
+   S32 sleepUntilTick();
+   S32 countTicks(U64 dueTicks, U64 now);
+
+public:
+   TickScheduler();           // Constructor
+   virtual ~TickScheduler();  // Destructor
+
+   static U64 getMicroseconds();
+
+   void setTickRate(U32 ticksPerSecond);
+   U32 getTickRate() const;
+   U32 getTickLength() const;       // Ms
+
+   void setSocket(S32 socket);      // Platform socket to watch for packets, or -1 for none
+
+   // Waits until the next tick is due, or a packet arrives.  Returns how many ticks to run now: 0 if it was a packet
+   // that woke us, more than 1 if we're catching up.
+   S32 wait();
+
+   // Ms of game time to run a tick for; usually getTickLength(), but every so often a ms more to make up for the
+   // fractions that don't divide evenly, so the game clock keeps up with the real one
+   U32 takeTickTime();
+
+   const TickStats &getStats() const;
+   const TickStats &getPeriodStats() const;
+   void resetPeriodStats();
+};
+
+
+};
+
+#endif
@@ -157,6 +157,8 @@ namespace Zap
       // Set geometry object
       GeomObject::setGeom(mPoints);
 
+      mPackedOutline.set(mOutline);
+
       // Set GridDatabase extents as the collision polygon
       Rect extent(mOutline);
       setExtent(extent);
@@ -209,6 +211,12 @@ namespace Zap
    }
 
 
+   const PackedPolygon *Barrier::getPackedCollisionPoly() const
+   {
+      return &mPackedOutline;
+   }
+
+
    bool Barrier::collide(BfObject *otherObject)
    {
       return true;
@@ -8,6 +8,7 @@
 
 #include "BfObject.h"
 #include "polygon.h"       // For PolygonObject def
+#include "GeomUtils.h"     // For PackedPolygon def
 #include "LineItem.h"   
 
 #include "Point.h"
@@ -38,6 +39,7 @@ public:
 
    Vector<Point> mPoints;  // The points of the barrier, might represent outline of a Polywall or the spine of an old-style BarrierMaker
    Vector<Point> mOutline; // The collision/rendering outline of the Barrier
+   PackedPolygon mPackedOutline;    // mOutline packed for the vectorized collision tests; barriers never move
 
    bool mSolid;            // True if this represents a polywall
 
@@ -62,6 +64,7 @@ public:
 
    // Returns the collision polygon of this barrier, which is the boundary extruded from the start,end line segment
    const Vector<Point> *getCollisionPoly() const;
+   const PackedPolygon *getPackedCollisionPoly() const;
 
    // Collide always returns true for Barrier objects
    bool collide(BfObject *otherObject);
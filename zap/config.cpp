@@ -106,6 +106,7 @@ IniSettings::IniSettings()
    enableServerVoiceChat = true;
    allowTeamChanging = true;
    kickIdlePlayers = true;
+   gridCellSize = 256;
    serverPassword = "";               // Passwords empty by default
    ownerPassword = "";
    adminPassword = "";
@@ -130,6 +131,9 @@ IniSettings::IniSettings()
    allowLevelgenUpload = true;
 
    enableGameRecording = false;
+   botWorkerThreads = 0;
+   botRandomSeed = 0;
+   scriptCpuBudget = 0;
 
    voteEnable = false;     // Voting disabled by default
    voteLength = 12;
@@ -178,6 +182,9 @@ IniSettings::IniSettings()
 
    logStats = false;          // Log statistics into local sqlite database
 
+   logRotateSize = 0;
+   logRotateHours = 0;
+
    version = BUILD_VERSION;   // Default to current version to avoid triggering upgrade checks on fresh install
 }
 
@@ -525,6 +532,9 @@ static void loadDiagnostics(CIniFile *ini, IniSettings *iniSettings)
    iniSettings->logLuaObjectLifecycle = ini->GetValueYN(section, "LogLuaObjectLifecycle", iniSettings->logLuaObjectLifecycle);
    iniSettings->luaScriptMessage      = ini->GetValueYN(section, "LuaScriptMessage",      iniSettings->luaScriptMessage);
    iniSettings->serverFilter          = ini->GetValueYN(section, "ServerFilter",          iniSettings->serverFilter);
+
+   iniSettings->logRotateSize         = (U32)max(0, ini->GetValueI(section, "LogRotateSize",  iniSettings->logRotateSize));
+   iniSettings->logRotateHours        = (U32)max(0, ini->GetValueI(section, "LogRotateHours", iniSettings->logRotateHours));
 }
 
 
@@ -633,6 +643,7 @@ static void loadHostConfiguration(CIniFile *ini, IniSettings *iniSettings)
    iniSettings->minBalancedPlayers     = ini->GetValueI (section, "MinBalancedPlayers", iniSettings->minBalancedPlayers);
    iniSettings->enableServerVoiceChat  = ini->GetValueYN (section, "EnableServerVoiceChat", iniSettings->enableServerVoiceChat);
    iniSettings->kickIdlePlayers        = ini->GetValueYN (section, "KickIdlePlayers", iniSettings->kickIdlePlayers);
+   iniSettings->gridCellSize           = (U32) ini->GetValueI (section, "GridCellSize", S32(iniSettings->gridCellSize));
 
    iniSettings->alertsVolLevel       = (F32) ini->GetValueI(section, "AlertsVolume", (S32) (iniSettings->alertsVolLevel * 10)) / 10.0f;
    iniSettings->allowGetMap          = ini->GetValueYN (section, "AllowGetMap", iniSettings->allowGetMap);
@@ -684,6 +695,12 @@ static void loadHostConfiguration(CIniFile *ini, IniSettings *iniSettings)
    iniSettings->globalLevelScript  = ini->GetValue(section, "GlobalLevelScript", iniSettings->globalLevelScript);
 
    iniSettings->enableGameRecording = ini->GetValueYN(section, "GameRecording", iniSettings->enableGameRecording);
+
+   iniSettings->botWorkerThreads = ini->GetValueI(section, "BotWorkerThreads", iniSettings->botWorkerThreads);
+   iniSettings->botWorkerThreads = max(0, min(iniSettings->botWorkerThreads, (S32)IniSettings::MaxBotWorkerThreads));
+   iniSettings->botRandomSeed = (U32)ini->GetValueI(section, "BotRandomSeed", iniSettings->botRandomSeed);
+
+   iniSettings->scriptCpuBudget = (U32)max(0, ini->GetValueI(section, "ScriptCpuBudget", iniSettings->scriptCpuBudget));
 }
 
 
@@ -1561,6 +1578,8 @@ static void writeDiagnostics(CIniFile *ini, IniSettings *iniSettings)
       ini->sectionComment(section, " LuaScriptMessage - Message from scripts (Yes/No)");
       ini->sectionComment(section, " ServerFilter - For logging messages specific to hosting games (Yes/No)");
       ini->sectionComment(section, "                (Note: these messages will go to bitfighter_server.log regardless of this setting) ");
+      ini->sectionComment(section, " LogRotateSize - Start a new log once it's this many MB; old logs are kept as .1, .2, etc. (0 = never)");
+      ini->sectionComment(section, " LogRotateHours - Start a new log once it's this many hours old (0 = never)");
       ini->sectionComment(section, "----------------");
    }
 
@@ -1584,6 +1603,9 @@ static void writeDiagnostics(CIniFile *ini, IniSettings *iniSettings)
    ini->setValueYN(section, "LogLuaObjectLifecycle", iniSettings->logLuaObjectLifecycle);
    ini->setValueYN(section, "LuaScriptMessage",      iniSettings->luaScriptMessage);
    ini->setValueYN(section, "ServerFilter",          iniSettings->serverFilter);
+
+   ini->SetValueI (section, "LogRotateSize",         iniSettings->logRotateSize);
+   ini->SetValueI (section, "LogRotateHours",        iniSettings->logRotateHours);
 }
 
 
@@ -1769,8 +1791,9 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
       addComment(" MinBalancedPlayers - The minimum number of players ensured in each map.  Bots will be added up to this number.");
       addComment(" EnableServerVoiceChat - If false, prevents any voice chat in a server.");
       addComment(" KickIdlePlayers - If true, the server will kick players that are considered idle.");
+      addComment(" GridCellSize - Size, in pixels, of the cells used to index objects on the level; rounded up to a power of 2 (default = 256).");
       addComment(" AlertsVolume - Volume of audio alerts when players join or leave game from 0 (mute) to 10 (full bore).");
-      addComment(" MaxFPS - Maximum FPS the dedicaetd server will run at.  Higher values use more CPU, lower may increase lag (default = 100).");
+      addComment(" MaxFPS - Ticks per second the dedicated server runs the game at; packets are read as soon as they arrive in between.  Higher values use more CPU, lower may increase lag (default = 100).");
       addComment(" RandomLevels - When current level ends, this can enable randomly switching to any available levels.");
       addComment(" SkipUploads - When current level ends, enables skipping all uploaded levels.");
       addComment(" AllowGetMap - When getmap is allowed, anyone can download the current level using the /getmap command.");
@@ -1784,6 +1807,13 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
       addComment(" VoteLength - number of seconds the voting will last, zero will disable voting.");
       addComment(" VoteRetryLength - When vote fail, the vote caller is unable to vote until after this number of seconds.");
       addComment(" Vote Strengths - Vote will pass when sum of all vote strengths is bigger then zero.");
+      addComment(" BotWorkerThreads - Run robot scripts' onTick() on this many threads, alongside the game (0 = run them on the main thread).");
+      addComment("                    Calls robots make there that change the game are held until every robot is done, and return nil.");
+      addComment(" BotRandomSeed - Seed for robots' random numbers when they run on BotWorkerThreads; the same seed, robots, and level");
+      addComment("                 make the same game (0 = a new seed every game, which is logged)");
+      addComment(" ScriptCpuBudget - Milliseconds a robot or levelgen script may run in one game tick before it is suspended for a while,");
+      addComment("                   so one slow script can't stall the server (0 = no limit).  Scripts held to a budget run without");
+      addComment("                   LuaJIT's compiler, which makes them slower; only set this if you run scripts you don't trust.");
       addComment("----------------");
    }
 
@@ -1802,6 +1832,7 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
    ini->SetValueI (section, "MinBalancedPlayers", iniSettings->minBalancedPlayers);
    ini->setValueYN(section, "EnableServerVoiceChat", iniSettings->enableServerVoiceChat);
    ini->setValueYN(section, "KickIdlePlayers", iniSettings->kickIdlePlayers);
+   ini->SetValueI (section, "GridCellSize", iniSettings->gridCellSize);
    ini->setValueYN(section, "AllowTeamChanging", iniSettings->allowTeamChanging);
    ini->SetValueI (section, "AlertsVolume", (S32) (iniSettings->alertsVolLevel * 10));
    ini->setValueYN(section, "AllowGetMap", iniSettings->allowGetMap);
@@ -1829,6 +1860,9 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
    ini->SetValue  (section, "GlobalLevelScript", iniSettings->globalLevelScript);
 
    ini->setValueYN(section, "GameRecording", iniSettings->enableGameRecording);
+   ini->SetValueI (section, "BotWorkerThreads", iniSettings->botWorkerThreads);
+   ini->SetValueI (section, "BotRandomSeed", iniSettings->botRandomSeed);
+   ini->SetValueI (section, "ScriptCpuBudget", iniSettings->scriptCpuBudget);
 #ifdef BF_WRITE_TO_MYSQL
    if(iniSettings->mySqlStatsDatabaseServer == "" && iniSettings->mySqlStatsDatabaseName == "" && iniSettings->mySqlStatsDatabaseUser == "" && iniSettings->mySqlStatsDatabasePassword == "")
       ini->SetValue  (section, "MySqlStatsDatabaseCredentials", "server, dbname, login, password");
@@ -2024,7 +2058,7 @@ FolderManager::FolderManager()
 FolderManager::FolderManager(const string &levelDir, const string &robotDir,    const string &shaderDir, const string &sfxDir,
                              const string &musicDir, const string &iniDir,      const string &logDir,    const string &screenshotDir,
                              const string &luaDir,   const string &rootDataDir, const string &pluginDir, const string &fontsDir,
-                             const string &recordDir) :
+                             const string &recordDir, const string &cacheDir) :
                levelDir      (levelDir),
                robotDir      (robotDir),
                shaderDir     (shaderDir),
@@ -2037,7 +2071,8 @@ FolderManager::FolderManager(const string &levelDir, const string &robotDir,
                rootDataDir   (rootDataDir),
                pluginDir     (pluginDir),
                fontsDir      (fontsDir),
-               recordDir     (recordDir)
+               recordDir     (recordDir),
+               cacheDir      (cacheDir)
 {
    // Do nothing (more)
 }
@@ -2086,6 +2121,7 @@ void FolderManager::resolveDirs(GameSettings *settings)
    folderManager->screenshotDir = resolutionHelper(cmdLineDirs.screenshotDir, rootDataDir, "screenshots");
    folderManager->musicDir      = resolutionHelper(cmdLineDirs.musicDir,      rootDataDir, "music");
    folderManager->recordDir     = resolutionHelper(cmdLineDirs.recordDir,     rootDataDir, "record");
+   folderManager->cacheDir      = resolutionHelper(cmdLineDirs.cacheDir,      rootDataDir, "cache");
 
    // rootDataDir not used for these folders
    folderManager->sfxDir        = resolutionHelper(cmdLineDirs.sfxDir,        "", "sfx");
@@ -2109,6 +2145,7 @@ void FolderManager::resolveDirs(const string &root)
    screenshotDir = joindir(root, "screenshots");
    musicDir      = joindir(root, "music");
    recordDir     = joindir(root, "record");
+   cacheDir      = joindir(root, "cache");
 
    // root not used for these folders
    sfxDir        = joindir("", "sfx");
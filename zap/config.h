@@ -48,7 +48,7 @@ struct FolderManager
    FolderManager(const string &levelDir, const string &robotDir,    const string &shaderDir, const string &sfxDir,
                  const string &musicDir, const string &iniDir,      const string &logDir,    const string &screenshotDir,
                  const string &luaDir,   const string &rootDataDir, const string &pluginDir, const string &fontsDir,
-                 const string &recordDir);
+                 const string &recordDir, const string &cacheDir);
 
    string levelDir;
    string robotDir;
@@ -63,6 +63,7 @@ struct FolderManager
    string pluginDir;
    string fontsDir;
    string recordDir;
+   string cacheDir;        // Level geometry we've downloaded from servers, and bot zones we've built
 
    void resolveDirs(GameSettings *settings);                                  
    void resolveDirs(const string &root);
@@ -176,6 +177,10 @@ private:
    F32 musicVolLevel;   // Use getter/setter!
 
 public:
+   enum {
+      MaxBotWorkerThreads = 16
+   };
+
    IniSettings();       // Constructor
    virtual ~IniSettings();
 
@@ -227,7 +232,11 @@ public:
    bool enableServerVoiceChat;      // No voice chat allowed in server if disabled
    bool allowTeamChanging;
    bool enableGameRecording;
+   S32 botWorkerThreads;            // Threads to run robot scripts on; 0 runs them on the main thread
+   U32 botRandomSeed;               // Seeds robots' random numbers on those threads, so games can be replayed; 0 for a new seed each game
+   U32 scriptCpuBudget;             // Ms of CPU a script may use in one tick before it is suspended for a while; 0 for no limit
    bool kickIdlePlayers;
+   U32 gridCellSize;                // Size of the buckets in our spatial database, in pixels; rounded up to a power of 2
 
    S32 connectionSpeed;
 
@@ -290,6 +299,9 @@ public:
    bool serverFilter;  
    bool logStats;
 
+   U32 logRotateSize;         // In MB; 0 to let logs grow forever
+   U32 logRotateHours;        // 0 to keep using the same log
+
    string mySqlStatsDatabaseServer;
    string mySqlStatsDatabaseName;
    string mySqlStatsDatabaseUser;
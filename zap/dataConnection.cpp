@@ -9,6 +9,8 @@
 
 #include "stringUtils.h"
 
+#include <zlib.h>
+
 using namespace TNL;
 
 
@@ -62,6 +64,16 @@ static string getOutputFolder(FolderManager *folderManager, FileType filetype)
 }
 
 
+// Running checksum of the blocks of a transfer, so the receiver can tell if it arrived intact
+static U32 updateChecksum(U32 checksum, const U8 *data, U32 size)
+{
+   return ByteBuffer(const_cast<U8 *>(data), size).calculateCRC(0, size, checksum);
+}
+
+
+static const U32 InitialChecksum = 0xFFFFFFFF;
+
+
 extern bool writeToConsole();
 extern void exitToOs(S32 errcode);
 
@@ -102,7 +114,7 @@ void transferResource(GameSettings *settings, const string &addr, const string &
       if(dataConn && dataConn->isEstablished())
       {
          if(!dataConn->mDataSender.isDone())
-            dataConn->mDataSender.sendNextLine();
+            dataConn->mDataSender.sendPendingData();
 
          started = true;
       }
@@ -146,7 +158,9 @@ DataSendable::~DataSendable()
 DataSender::DataSender()
 {
    mDone = true;
+   mSendBlocks = false;
    mLineCtr = 0;
+   mChecksum = InitialChecksum;
    mFileType = INVALID_RESOURCE_TYPE;
 }
 
@@ -229,14 +243,22 @@ SenderStatus DataSender::initialize(DataSendable *connection, FolderManager *fol
    mFileType = fileType;
    mDone = false;
    mLineCtr = 0;
+   mChecksum = InitialChecksum;
+
+   // Older hosts only understand one line at a time
+   EventConnection *eventConnection = dynamic_cast<EventConnection *>(connection);
+   RefPtr<NetEvent> probe = connection->s2rSendBlock_construct(0, 0, 0, Vector<U8>());
+   mSendBlocks = eventConnection && eventConnection->isEventSupported(probe);
+
    return STATUS_OK;
 }
 
 #undef MAX_CHUNK_LEN
 
 
-// Send next line of our file
-void DataSender::sendNextLine()
+// Send the next part of our file -- as many blocks as the connection will take, or a single line if the remote
+// host doesn't understand blocks
+void DataSender::sendPendingData()
 {
    DataSendable *connection = dynamic_cast<DataSendable *>(mConnection.getPointer());
    if(!connection)
@@ -245,7 +267,10 @@ void DataSender::sendNextLine()
    if(mDone)
       return;
 
-   if(mLineCtr < mLines.size())
+   if(mSendBlocks)
+      sendNextBlocks(connection, dynamic_cast<EventConnection *>(connection));
+
+   else if(mLineCtr < mLines.size())
    {
       connection->s2rSendLine(mLines[mLineCtr].c_str());
       mLineCtr++;
@@ -259,10 +284,57 @@ void DataSender::sendNextLine()
 }
 
 
+// Keep enough blocks queued to fill every packet, but no more -- TNL resends any that are dropped, and anything
+// we haven't queued yet can wait for the acknowledgements to catch up.  Levels and scripts are text, so deflating
+// each block shrinks it several times over; a block that doesn't shrink is sent as it is.
+void DataSender::sendNextBlocks(DataSendable *connection, EventConnection *eventConnection)
+{
+   while(mLineCtr < mLines.size() && eventConnection->getPendingOrderedEventCount() < MaxPendingEvents)
+   {
+      S32 firstLine = mLineCtr;
+      string block;
+
+      for(; mLineCtr < mLines.size() && mLineCtr - firstLine < LinesPerBlock; mLineCtr++)
+         block += mLines[mLineCtr];
+
+      const U8 *blockData = (const U8 *)block.c_str();
+      U32 size = (U32)block.size();
+
+      mChecksum = updateChecksum(mChecksum, blockData, size);
+
+      Vector<U8> data;
+      uLongf compressedSize = compressBound(size);
+      data.resize(compressedSize);
+
+      if(compress(data.address(), &compressedSize, blockData, size) == Z_OK && compressedSize < size)
+         data.resize(compressedSize);
+      else
+      {
+         data.resize(size);
+         memcpy(data.address(), blockData, size);
+      }
+
+      connection->s2rSendBlock(firstLine, mLineCtr - firstLine, size, data);
+   }
+
+   if(mLineCtr == mLines.size())
+   {
+      connection->s2rBlocksComplete(mLines.size(), mChecksum);
+      mDone = true;
+      mLines.clear();      // Liberate some memory
+   }
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
 
+// These connections exist only to move a file, so let them use as much bandwidth as a fast game connection would
+static const U32 TransferPacketPeriod = 20;
+static const U32 TransferBandwidth = 65535;     // Max TNL allows
+
+
 DataConnection::DataConnection(GameSettings *settings, ActionType action, string password, string filename, FileType fileType)
 {
    mSettings = settings;
@@ -272,6 +344,10 @@ DataConnection::DataConnection(GameSettings *settings, ActionType action, string
    mPassword = password;
 
    mOutputFile = NULL;
+   mReceivedLineCount = 0;
+   mReceivedChecksum = InitialChecksum;
+
+   setFixedRateParameters(TransferPacketPeriod, TransferPacketPeriod, TransferBandwidth, TransferBandwidth);
 }
 
 
@@ -283,6 +359,10 @@ DataConnection::DataConnection(GameSettings *settings, const Nonce &clientId)
    mAction = REQUEST_CURRENT_LEVEL;
    mFileType = INVALID_RESOURCE_TYPE;
    mOutputFile = NULL;
+   mReceivedLineCount = 0;
+   mReceivedChecksum = InitialChecksum;
+
+   setFixedRateParameters(TransferPacketPeriod, TransferPacketPeriod, TransferBandwidth, TransferBandwidth);
 }
 
 // Destructor
@@ -292,6 +372,29 @@ DataConnection::~DataConnection()
 }
 
 
+bool DataConnection::openOutputFile(const string &filename)
+{
+   closeOutputFile();
+
+   mOutputFile = fopen(filename.c_str(), "w");
+   mOutputFilename = filename;
+   mReceivedLineCount = 0;
+   mReceivedChecksum = InitialChecksum;
+
+   return mOutputFile != NULL;
+}
+
+
+void DataConnection::closeOutputFile()
+{
+   if(mOutputFile)
+   {
+      fclose(mOutputFile);
+      mOutputFile = NULL;
+   }
+}
+
+
 // static method
 string DataConnection::getErrorMessage(SenderStatus stat, const string &filename)
 {
@@ -375,12 +478,7 @@ TNL_IMPLEMENT_RPC(DataConnection, c2sSendOrRequestFile,
          return;
       }
 
-      if(mOutputFile) 
-         fclose((FILE*)mOutputFile);
-
-      mOutputFile = fopen(strictjoindir(folder, filename.getString()).c_str(), "w");
-
-      if(!mOutputFile)
+      if(!openOutputFile(strictjoindir(folder, filename.getString())))
       {
          logprintf("Problem opening file %s for writing", strictjoindir(folder, filename.getString()).c_str());
          disconnect(ReasonError, "Problem writing to file");
@@ -417,6 +515,8 @@ TNL_IMPLEMENT_RPC(DataConnection, s2rSendLine, (StringPtr line), (line),
       fwrite(line.getString(), 1, strlen(line.getString()), mOutputFile);
       //mOutputFile.write(line.getString(), strlen(line.getString()));
    // else... what?
+
+   r2sDataReceived();
 }
 
 
@@ -427,11 +527,88 @@ TNL_IMPLEMENT_RPC(DataConnection, s2rCommandComplete, (RangedU32<0,SENDER_STATUS
 {
    disconnect(ReasonNone, "done");     // Terminate connection... should probably send different message depending on status
 
-   if(mOutputFile)
+   closeOutputFile();
+}
+
+
+// << DataSendable >>
+// Several chunks of the file at once -- this gets run on the receiving end.  Each block is as big as several packets,
+// and TNL takes care of splitting it up and resending any pieces that get dropped.  data is deflated, unless it's
+// the same size as the block, in which case it's the block as it is.
+TNL_IMPLEMENT_RPC(DataConnection, s2rSendBlock, (U32 firstLine, U32 lineCount, U32 size, Vector<U8> data), 
+                  (firstLine, lineCount, size, data), 
+                  NetClassGroupGameMask, RPCGuaranteedOrderedBigData, RPCDirAny, 4)
+{
+   if(!mOutputFile)
+      return;
+
+   if(firstLine != mReceivedLineCount)    // Ordered delivery should make this impossible
    {
-      fclose(mOutputFile);
-      mOutputFile = NULL;
+      logprintf("Received data out of order!");
+      disconnect(ReasonError, "Data received out of order");
+      return;
+   }
+
+   if(lineCount > DataSender::LinesPerBlock || size > DataSender::MaxBlockSize || (U32)data.size() > size)
+   {
+      logprintf("Received a block bigger than any sender would make!");
+      disconnect(ReasonError, "Bad block");
+      return;
+   }
+
+   const U8 *blockData = data.address();
+   Vector<U8> block;
+
+   if((U32)data.size() < size)
+   {
+      block.resize(size);
+      uLongf uncompressedSize = size;
+
+      if(uncompress(block.address(), &uncompressedSize, data.address(), data.size()) != Z_OK || uncompressedSize != size)
+      {
+         logprintf("Received a block that could not be inflated!");
+         disconnect(ReasonError, "Bad block");
+         return;
+      }
+
+      blockData = block.address();
+   }
+
+   fwrite(blockData, 1, size, mOutputFile);
+   mReceivedChecksum = updateChecksum(mReceivedChecksum, blockData, size);
+   mReceivedLineCount += lineCount;
+
+   r2sDataReceived();
+}
+
+
+// Sent by the receiver for everything it gets.  A receiving connection otherwise has nothing of its own to send, so
+// it would never tell the sender which packets arrived, and the sender would stall waiting to hear.  Older hosts
+// don't know this one, and TNL won't send it to them.
+TNL_IMPLEMENT_RPC(DataConnection, r2sDataReceived, (), (), 
+                  NetClassGroupGameMask, RPCUnguaranteed, RPCDirAny, 4)
+{
+   // Do nothing
+}
+
+
+// << DataSendable >>
+// Sent after the last block, so we can check that we got what was sent before calling it done
+TNL_IMPLEMENT_RPC(DataConnection, s2rBlocksComplete, (U32 lineCount, U32 checksum), (lineCount, checksum), 
+                  NetClassGroupGameMask, RPCGuaranteedOrdered, RPCDirAny, 4)
+{
+   bool wasReceiving = (mOutputFile != NULL);
+   closeOutputFile();
+
+   if(wasReceiving && (lineCount != mReceivedLineCount || checksum != mReceivedChecksum))
+   {
+      logprintf("Received file %s was damaged in transit; discarding it", mOutputFilename.c_str());
+      remove(mOutputFilename.c_str());
+      disconnect(ReasonError, "Checksum mismatch");
+      return;
    }
+
+   disconnect(ReasonNone, "done");
 }
 
 
@@ -455,11 +632,7 @@ void DataConnection::onConnectionEstablished()
          if(folder == "")     // filetype was bogus; should never happen
             logprintf("Error resolving folder!");      // But... we can save files without needing folder, so log and cary on
 
-         //mOutputFile.open(strictjoindir(folder, mFilename).c_str());
-         if(mOutputFile) 
-            fclose(mOutputFile);
-         mOutputFile = fopen(strictjoindir(folder, mFilename).c_str(), "w");
-         if(!mOutputFile)
+         if(!openOutputFile(strictjoindir(folder, mFilename)))
          {
             logprintf("Problem opening file %s for writing", strictjoindir(folder, mFilename).c_str());
             disconnect(ReasonError, "done");
@@ -475,11 +648,7 @@ void DataConnection::onConnectionEstablished()
 // Make sure things are cleaned up -- will run on both client and server
 void DataConnection::onConnectionTerminated(NetConnection::TerminationReason reason, const char *reasonMsg)
 {
-   if(mOutputFile)
-   {
-      fclose((FILE*)mOutputFile);
-      mOutputFile = NULL;
-   }
+   closeOutputFile();
 
    if(isInitiator())    // i.e. client
    {
@@ -56,6 +56,10 @@ public:
 
    TNL_DECLARE_RPC_INTERFACE(s2rSendLine, (StringPtr line));      // Send a chunk of data
    TNL_DECLARE_RPC_INTERFACE(s2rCommandComplete, (RangedU32<0,SENDER_STATUS_COUNT> status));   // Signal that data has been sent
+
+   // Newer hosts send many chunks per RPC, deflated, and finish with a checksum of the whole transfer
+   TNL_DECLARE_RPC_INTERFACE(s2rSendBlock, (U32 firstLine, U32 lineCount, U32 size, Vector<U8> data));
+   TNL_DECLARE_RPC_INTERFACE(s2rBlocksComplete, (U32 lineCount, U32 checksum));
 };
 
 
@@ -69,19 +73,31 @@ class DataSender
 {
 private:
    bool mDone;
+   bool mSendBlocks;                // True if the remote host understands s2rSendBlock
    S32 mLineCtr;
+   U32 mChecksum;                   // Running checksum of the lines sent so far
    Vector<string> mLines;           // Store strings because storing char * will cause problems when source string is gone
    SafePtr<Object> mConnection;     // need to use SafePtr, as it is possible that a player disconnect making it no longer valid
    FileType mFileType;
 
+   void sendNextBlocks(DataSendable *connection, EventConnection *eventConnection);
+
 public:
+   enum {
+      LinesPerBlock = 16,           // ~4K of file per s2rSendBlock, which TNL splits over as many packets as it needs
+      MaxBlockSize = LinesPerBlock * HuffmanStringProcessor::MAX_SENDABLE_LINE_LENGTH,    // Before deflating
+      MaxPendingEvents = 64,        // Stop queueing blocks while this many events are unacknowledged; TNL stalls at 126
+   };
+
    DataSender();        // Constructor
    virtual ~DataSender();
 
    SenderStatus initialize(DataSendable *connection, FolderManager *folderManager, string filename, FileType fileType);   
 
    bool isDone();
-   void sendNextLine();
+   void sendPendingData();
+
+   friend class DataConnectionTest;
 };
 
 
@@ -97,6 +113,12 @@ private:
    string mFilename;          
    string mPassword;          // Password supplied by user
    FILE *mOutputFile;         // Where we'll save any incoming data
+   string mOutputFilename;    // ...and its name, so we can remove it if the data arrives damaged
+   U32 mReceivedLineCount;    // Lines received by s2rSendBlock so far
+   U32 mReceivedChecksum;     // ...and their checksum
+
+   bool openOutputFile(const string &filename);
+   void closeOutputFile();
 
    Nonce mClientId;           // When called from an active connection, client ID can be used to deterimine if player
                               // has sufficient permissions
@@ -120,11 +142,16 @@ public:
    // These from the DataSendable interface class
    TNL_DECLARE_RPC(s2rSendLine, (StringPtr line));
    TNL_DECLARE_RPC(s2rCommandComplete, (RangedU32<0,SENDER_STATUS_COUNT> status));
+   TNL_DECLARE_RPC(s2rSendBlock, (U32 firstLine, U32 lineCount, U32 size, Vector<U8> data));
+   TNL_DECLARE_RPC(s2rBlocksComplete, (U32 lineCount, U32 checksum));
+   TNL_DECLARE_RPC(r2sDataReceived, ());
 
    TNL_DECLARE_RPC(s2cOkToSend, ());
 
    TNL_DECLARE_RPC(c2sSendOrRequestFile, (StringPtr password, RangedU32<0,(U32)FILE_TYPES> filetype, bool isRequest, StringPtr name));
    TNL_DECLARE_NETCONNECTION(DataConnection);
+
+   friend class DataConnectionTest;
 };
 
 
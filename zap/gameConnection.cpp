@@ -33,7 +33,11 @@ namespace Zap
 
 TNL_IMPLEMENT_NETCONNECTION(GameConnection, NetClassGroupGame, true);
 
-const U8 GameConnection::CONNECT_VERSION = 1;  // GameConnection's version, for possible future use with changes on compatible versions
+// GameConnection's version, for changes on compatible versions
+// 1: Client can host levels from server
+// 2: Client keeps level geometry on disk (see GameType::s2cUseLevelGeometry)
+const U8 GameConnection::CONNECT_VERSION = 2;
+static const U8 LevelGeometryCacheVersion = 2;
 
 // Constructor -- used on Server by TNL, not called directly, used when a new client connects to the server
 GameConnection::GameConnection()
@@ -107,6 +111,7 @@ void GameConnection::initialize()
    mVote = 0;
    mVoteTime = 0;
    mLevelSource = NULL;
+   mConnectionVersion = 0;
    mLevelUploadIndex = -1;
 
    resetConnectionStatus();
@@ -1113,6 +1118,14 @@ void GameConnection::displayMessage(U32 colorIndex, U32 sfxEnum, const char *mes
 }
 
 
+// Client side, when the server reports a kill; killer is empty when nobody gets the credit.  The message itself is
+// shown by GameType, so there's nothing to do here -- this is for connections that want to keep track of kills.
+void GameConnection::onKillMessage(StringTableEntry victim, StringTableEntry killer, StringTableEntry killerDescr)
+{
+   // Do nothing
+}
+
+
 TNL_IMPLEMENT_RPC(GameConnection, s2cDisplayMessageESI,
                   (RangedU32<0, GameConnection::ColorCount> color, RangedU32<0, NumSFXBuffers> sfx, StringTableEntry formatString,
                   Vector<StringTableEntry> e, Vector<StringPtr> s, Vector<S32> i),
@@ -2176,6 +2189,14 @@ bool GameConnection::readConnectRequest(BitStream *stream, NetConnection::Termin
 }
 
 
+// Server only -- can we send this client s2cUseLevelGeometry rather than the walls themselves?  Local clients don't
+// gain anything from it, and we'd only fill their cache with every version of the level they're editing.
+bool GameConnection::canCacheLevelGeometry()
+{
+   return mConnectionVersion >= LevelGeometryCacheVersion && !isLocalConnection();
+}
+
+
 // Server side writes ConnectAccept
 void GameConnection::writeConnectAccept(BitStream *stream)
 {
@@ -2568,6 +2589,13 @@ void GameConnection::setWantsScoreboardUpdates(bool wantsUpdates)
 }
 
 
+// Server only -- rank every pending ghost update in one pass, rather than one virtual call apiece
+void GameConnection::computeUpdatePriorities(GhostInfo **ghosts, S32 count)
+{
+   BfObject::computeUpdatePriorities(this, ghosts, count, getControlObject());
+}
+
+
 // Gets run when game is just beginning, before objects are sent to client.
 // Some keywords to help find this function again: start, onGameStart, onGameBegin
 // Client only
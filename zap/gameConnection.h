@@ -74,7 +74,7 @@ private:
    Timer mAuthenticationTimer;
    S32 mAuthenticationCounter;
 
-   void displayMessage(U32 colorIndex, U32 sfxEnum, const char *message);    // Helper function
+   virtual void displayMessage(U32 colorIndex, U32 sfxEnum, const char *message);    // Helper function
    void displayWelcomeMessage();
 
 
@@ -182,6 +182,8 @@ public:
    bool wantsScoreboardUpdates();
    void setWantsScoreboardUpdates(bool wantsUpdates);
 
+   void computeUpdatePriorities(GhostInfo **ghosts, S32 count);
+
    virtual void onStartGhosting();  // Gets run when game starts
    virtual void onEndGhosting();    // Gets run when game is over
 
@@ -330,10 +332,13 @@ public:
    virtual void updateTimers(U32 timeDelta);
 
    void displayMessageE(U32 color, U32 sfx, StringTableEntry formatString, Vector<StringTableEntry> e);
+   virtual void onKillMessage(StringTableEntry victim, StringTableEntry killer, StringTableEntry killerDescr);
 
    static const U8 CONNECT_VERSION;  // may be useful in future version with same CS protocol number
    U8 mConnectionVersion;  // the CONNECT_VERSION of the other side of this connection
 
+   bool canCacheLevelGeometry();
+
    void writeConnectRequest(BitStream *stream);
    bool readConnectRequest(BitStream *stream, NetConnection::TerminationReason &reason, string &reasonStr);
    void writeConnectAccept(BitStream *stream);
@@ -17,6 +17,7 @@
 #include "robot.h"
 #include "Spawn.h"
 #include "loadoutZone.h"      // For LoadoutZone
+#include "LevelGeometryCache.h"
 #include "LineEditorFilterEnum.h"
 #include "game.h"
 #include "GameRecorder.h"
@@ -82,6 +83,11 @@ GameType::GameType(S32 winningScore) : mScoreboardUpdateTimer(THREE_SECONDS), mG
    mLevelHasPredeployedFlags = false;
    mLevelHasFlagSpawns = false;
    mShowAllBots = false;
+   mWaitingForLevelGeometry = false;
+   mSyncMessagesDeferred = false;
+   mDeferredSyncSequence = 0;
+   mSharedScopesCurrent = false;
+   mSharedScopeChangeCount = 0;
    mHaveSoccer = false;
    mBotZoneCreationFailed = false;
 
@@ -539,6 +545,8 @@ void GameType::idle_server(U32 deltaT)
 {
    queryItemsOfInterest();
 
+   mSharedScopesCurrent = false;    // Ships may have changed loadouts or teams; find shared scopes afresh
+
    bool needsScoreboardUpdate = mScoreboardUpdateTimer.update(deltaT);
 
    if(needsScoreboardUpdate)
@@ -1122,6 +1130,7 @@ bool GameType::isTeamGame() const
 bool GameType::addWall(const WallRec &wall, Game *game)
 {
    mWalls.push_back(wall);              // Add wall to our list of walls
+   mWallGeometryHash = "";              // Geometry blob is out of date
    return wall.constructWalls(game);    // Build it!
 }
 
@@ -1331,6 +1340,17 @@ static void markAllMountedItemsAsBeingInScope(Ship *ship, GameConnection *conn)
 }
 
 
+static void markAllObjectsAsBeingInScope(const Vector<DatabaseObject *> &objects, GameConnection *conn)
+{
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      conn->objectInScope(static_cast<BfObject *>(objects[i]));
+      if(isShipType(objects[i]->getObjectTypeNumber()))
+         markAllMountedItemsAsBeingInScope(static_cast<Ship *>(objects[i]), conn);
+   }
+}
+
+
 // Runs only on server, I think
 void GameType::performScopeQuery(GhostConnection *connection)
 {
@@ -1362,42 +1382,15 @@ void GameType::performScopeQuery(GhostConnection *connection)
       conn->objectInScope(co);            // Put controlObject in scope ==> This is where the update mask gets set to 0xFFFFFFFF
    }
 
-   // What does the spy bug see?
-   bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
-
+   // What does the spy bug see?  Everyone who can see a given spy bug sees the same things through it.
    const Vector<DatabaseObject *> *spyBugs = mGame->getGameObjDatabase()->findObjects_fast(SpyBugTypeNumber);
-   const Point scopeRange(SpyBug::SPY_BUG_RADIUS, SpyBug::SPY_BUG_RADIUS * FloatSqrt3Half);  // Bounding box of hexagon
 
    for(S32 i = spyBugs->size()-1; i >= 0; i--)
    {
       SpyBug *sb = static_cast<SpyBug *>(spyBugs->get(i));
-//      shared_ptr<SpyBug> sb = shared_ptr<SpyBug>(sb);
 
       if(sb->isVisibleToPlayer(clientInfo, isTeamGame()))
-      {
-         Point pos = sb->getActualPos();
-         Rect queryRect(pos, pos);
-
-         queryRect.expand(scopeRange);
-
-         fillVector.clear();
-         mGame->getGameObjDatabase()->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect, sameQuery);
-         sameQuery = true;
-
-         for(S32 j = 0; j < fillVector.size(); j++)
-         {
-            // Some objects don't have geometry (ForceFields).  Is this a bug?
-            if(!fillVector[j]->hasGeometry())
-               continue;
-
-            if(!pointInHexagon(fillVector[j]->getPos(), pos, SpyBug::SPY_BUG_RADIUS))
-               continue;
-
-            connection->objectInScope(static_cast<BfObject *>(fillVector[j]));
-            if(isShipType(fillVector[j]->getObjectTypeNumber()))
-               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(fillVector[j]), conn);
-         }
-      }
+         markAllObjectsAsBeingInScope(getSpyBugScope(i), conn);
    }
 }
 
@@ -1430,37 +1423,23 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
    GameConnection *connection = clientInfo->getConnection();
    TNLAssert(connection, "NULL gameConnection!");
 
+   GridDatabase::QueryContext queryContext;
+   Vector<DatabaseObject *> foundObjects;
+
    if(isTeamGame() && connection->isInCommanderMap())
    {
-      S32 teamId = clientInfo->getTeamIndex();
-      fillVector.clear();
-      bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
-
-      for(S32 i = 0; i < mGame->getClientCount(); i++)
-      {
-         ClientInfo *clientInfo = mGame->getClientInfo(i);
+      // Everyone on the team sees what their teammates show on the commander's map, so that is found once and shared
+      markAllObjectsAsBeingInScope(getTeamCmdrScope(clientInfo->getTeamIndex()), connection);
 
-         if(clientInfo->getTeamIndex() != teamId)      // Wrong team
-            continue;
-
-         Ship *ship = clientInfo->getShip();
-         if(!ship)       // Can happen!
-            continue;
+      // Our own ship sees everything within its scope range, not just what shows on the commander's map
+      Ship *ship = clientInfo->getShip();
 
+      if(ship && ship == scopeObject)
+      {
          Rect queryRect(ship->getActualPos(), ship->getActualPos());
          queryRect.expand(mGame->getScopeRange(ship->hasModule(ModuleSensor)));
 
-         TestFunc testFunc;
-         if(scopeObject == ship)    
-            testFunc = &isAnyObjectType;
-         else
-            if(ship && ship->hasModule(ModuleSensor))
-               testFunc = &isVisibleOnCmdrsMapWithSensorType;
-            else     // No sensor
-               testFunc = &isVisibleOnCmdrsMapType;
-
-         mGame->getGameObjDatabase()->findObjects(testFunc, fillVector, queryRect, sameQuery);
-         sameQuery = true;
+         mGame->getGameObjDatabase()->findObjects(queryContext, (TestFunc)isAnyObjectType, foundObjects, queryRect);
       }
    }
    else     // Not a team game OR not in commander's map -- Do a simple query of the objects within scope range of the ship
@@ -1473,17 +1452,11 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
       Rect queryRect(pos, pos);
       queryRect.expand( mGame->getScopeRange(co->hasModule(ModuleSensor)) );
 
-      fillVector.clear();
-      mGame->getGameObjDatabase()->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect);
+      mGame->getGameObjDatabase()->findObjects(queryContext, (TestFunc)isAnyObjectType, foundObjects, queryRect);
    }
 
    // Set object-in-scope for all objects found above
-   for(S32 i = 0; i < fillVector.size(); i++)
-   {
-      connection->objectInScope(static_cast<BfObject *>(fillVector[i]));
-      if(isShipType(fillVector[i]->getObjectTypeNumber()))
-         markAllMountedItemsAsBeingInScope(static_cast<Ship *>(fillVector[i]), connection);
-   }
+   markAllObjectsAsBeingInScope(foundObjects, connection);
 
    // Make bots visible if showAllBots has been activated
    if(mShowAllBots && connection->isInCommanderMap())
@@ -1492,6 +1465,122 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
 }
 
 
+GameType::SharedScope::SharedScope()
+{
+   current = false;
+}
+
+
+// Server only -- throw away shared scopes if the game has moved on since they were found
+void GameType::refreshSharedScopes()
+{
+   GridDatabase *database = mGame->getGameObjDatabase();
+
+   if(mSharedScopesCurrent && database->getChangeCount() == mSharedScopeChangeCount)
+      return;
+
+   mTeamCmdrScopes.resize(mGame->getTeamCount());
+   for(S32 i = 0; i < mTeamCmdrScopes.size(); i++)
+      mTeamCmdrScopes[i].current = false;
+
+   mSpyBugScopes.resize(database->getObjectCount(SpyBugTypeNumber));
+   for(S32 i = 0; i < mSpyBugScopes.size(); i++)
+      mSpyBugScopes[i].current = false;
+
+   mSharedScopesCurrent = true;
+   mSharedScopeChangeCount = database->getChangeCount();
+}
+
+
+// Server only -- everything the team's ships show on the commander's map
+const Vector<DatabaseObject *> &GameType::getTeamCmdrScope(S32 teamIndex)
+{
+   refreshSharedScopes();
+
+   TNLAssert(teamIndex >= 0 && teamIndex < mTeamCmdrScopes.size(), "Team index out of range!");
+   if(teamIndex < 0 || teamIndex >= mTeamCmdrScopes.size())
+   {
+      static const Vector<DatabaseObject *> noObjects;
+      return noObjects;
+   }
+
+   SharedScope &scope = mTeamCmdrScopes[teamIndex];
+
+   if(scope.current)
+      return scope.objects;
+
+   GridDatabase::QueryContext queryContext;
+   bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
+
+   scope.objects.clear();
+
+   for(S32 i = 0; i < mGame->getClientCount(); i++)
+   {
+      ClientInfo *clientInfo = mGame->getClientInfo(i);
+
+      if(clientInfo->getTeamIndex() != teamIndex)      // Wrong team
+         continue;
+
+      Ship *ship = clientInfo->getShip();
+      if(!ship)       // Can happen!
+         continue;
+
+      Rect queryRect(ship->getActualPos(), ship->getActualPos());
+      queryRect.expand(mGame->getScopeRange(ship->hasModule(ModuleSensor)));
+
+      TestFunc testFunc = ship->hasModule(ModuleSensor) ? &isVisibleOnCmdrsMapWithSensorType : &isVisibleOnCmdrsMapType;
+
+      mGame->getGameObjDatabase()->findObjects(queryContext, testFunc, scope.objects, queryRect, sameQuery);
+      sameQuery = true;
+   }
+
+   scope.current = true;
+   return scope.objects;
+}
+
+
+// Server only -- everything within the hexagon of the spy bug at spyBugIndex in the database's list of spy bugs
+const Vector<DatabaseObject *> &GameType::getSpyBugScope(S32 spyBugIndex)
+{
+   refreshSharedScopes();
+
+   TNLAssert(spyBugIndex >= 0 && spyBugIndex < mSpyBugScopes.size(), "Spy bug index out of range!");
+   SharedScope &scope = mSpyBugScopes[spyBugIndex];
+
+   if(scope.current)
+      return scope.objects;
+
+   const Vector<DatabaseObject *> *spyBugs = mGame->getGameObjDatabase()->findObjects_fast(SpyBugTypeNumber);
+   Point pos = static_cast<SpyBug *>(spyBugs->get(spyBugIndex))->getActualPos();
+
+   const Point scopeRange(SpyBug::SPY_BUG_RADIUS, SpyBug::SPY_BUG_RADIUS * FloatSqrt3Half);  // Bounding box of hexagon
+   Rect queryRect(pos, pos);
+   queryRect.expand(scopeRange);
+
+   GridDatabase::QueryContext queryContext;
+   scope.objects.clear();
+   mGame->getGameObjDatabase()->findObjects(queryContext, (TestFunc)isAnyObjectType, scope.objects, queryRect);
+
+   // Keep only what is actually inside the hexagon
+   S32 count = 0;
+   for(S32 i = 0; i < scope.objects.size(); i++)
+   {
+      // Some objects don't have geometry (ForceFields).  Is this a bug?
+      if(!scope.objects[i]->hasGeometry())
+         continue;
+
+      if(!pointInHexagon(scope.objects[i]->getPos(), pos, SpyBug::SPY_BUG_RADIUS))
+         continue;
+
+      scope.objects[count++] = scope.objects[i];
+   }
+   scope.objects.resize(count);
+
+   scope.current = true;
+   return scope.objects;
+}
+
+
 // Server only
 void GameType::addItemOfInterest(MoveItem *item)
 {
@@ -2599,17 +2688,25 @@ void GameType::onGhostAvailable(GhostConnection *theConnection)
    //   s2cClientJoinedTeam(Robot::robots[i]->getName(), Robot::robots[i]->getTeam());
    //}
 
-   // Sending an empty list clears the barriers
-   // FIXME:  Why is this the chosen mechanism to do this?
-   Vector<F32> v;
-   s2cAddWalls(v, 0, false);
+   GameConnection *gameConnection = static_cast<GameConnection *>(theConnection);
 
-   for(S32 i = 0; i < mWalls.size(); i++)
+   // Clients that keep level geometry on disk only need to know which walls to use; they'll ask if they don't have them
+   if(gameConnection->canCacheLevelGeometry() && getWallGeometryHash() != "")
+      s2cUseLevelGeometry(mWallGeometryHash.c_str());
+   else
    {
-      // If players somehow create 0-point walls, don't send them to the client
-      // or it will remove all walls previously added
-      if(mWalls[i].verts.size() != 0)
-         s2cAddWalls(mWalls[i].verts, mWalls[i].width, mWalls[i].solid);
+      // Sending an empty list clears the barriers
+      // FIXME:  Why is this the chosen mechanism to do this?
+      Vector<F32> v;
+      s2cAddWalls(v, 0, false);
+
+      for(S32 i = 0; i < mWalls.size(); i++)
+      {
+         // If players somehow create 0-point walls, don't send them to the client
+         // or it will remove all walls previously added
+         if(mWalls[i].verts.size() != 0)
+            s2cAddWalls(mWalls[i].verts, mWalls[i].width, mWalls[i].solid);
+      }
    }
 
    broadcastNewRemainingTime();
@@ -2621,6 +2718,21 @@ void GameType::onGhostAvailable(GhostConnection *theConnection)
 
 
 GAMETYPE_RPC_S2C(GameType, s2cSyncMessagesComplete, (U32 sequence), (sequence))
+{
+   // Can't start without walls!  We'll finish up when they arrive.
+   if(mWaitingForLevelGeometry)
+   {
+      mSyncMessagesDeferred = true;
+      mDeferredSyncSequence = sequence;
+      return;
+   }
+
+   onSyncMessagesComplete(sequence);
+}
+
+
+// Client only
+void GameType::onSyncMessagesComplete(U32 sequence)
 {
 #ifndef ZAP_DEDICATED
    // Now we know the game is ready to begin...
@@ -2666,6 +2778,101 @@ TNL_IMPLEMENT_NETOBJECT_RPC(GameType, s2cAddWalls, (Vector<F32> verts, F32 width
 }
 
 
+// Server only -- returns "" if there's too much geometry to send in one go
+const string &GameType::getWallGeometryHash()
+{
+   if(mWallGeometryHash == "")
+   {
+      LevelGeometryCache::packWalls(mWalls, mWallGeometry);
+
+      if(mWallGeometry.size() <= LevelGeometryCache::MaxBlobSize)
+         mWallGeometryHash = LevelGeometryCache::getHash(mWallGeometry);
+   }
+
+   return mWallGeometryHash;
+}
+
+
+// Client only -- replaces any walls we have with those in geometry; returns false if geometry is damaged
+bool GameType::constructWallsFromGeometry(const Vector<U8> &geometry)
+{
+   Vector<WallRec> walls;
+   if(!LevelGeometryCache::unpackWalls(geometry, walls))
+      return false;
+
+   mGame->deleteObjects((TestFunc)isWallType);
+
+   for(S32 i = 0; i < walls.size(); i++)
+      walls[i].constructWalls(mGame);
+
+   return true;
+}
+
+
+// Server tells us which walls this level has, in place of sending them with s2cAddWalls.  If we've had them before,
+// we can build them straight from our cache.
+TNL_IMPLEMENT_NETOBJECT_RPC(GameType, s2cUseLevelGeometry, (StringPtr hash), (hash), 
+                            NetClassGroupGameMask, RPCGuaranteedOrdered, RPCToGhost, 4)
+{
+   LevelGeometryCache cache(mGame->getSettings()->getFolderManager()->cacheDir);
+   Vector<U8> geometry;
+
+   if(cache.load(hash.getString(), geometry) && constructWallsFromGeometry(geometry))
+      return;
+
+   mGame->deleteObjects((TestFunc)isWallType);     // Don't leave the last level's walls lying around while we wait
+   mWaitingForLevelGeometry = true;
+   c2sRequestLevelGeometry(hash);
+}
+
+
+// Client doesn't have the walls for this level
+TNL_IMPLEMENT_NETOBJECT_RPC(GameType, c2sRequestLevelGeometry, (StringPtr hash), (hash), 
+                            NetClassGroupGameMask, RPCGuaranteedOrdered, RPCToGhostParent, 4)
+{
+   if(getWallGeometryHash() != hash.getString())      // Level has changed since, and the new one will take care of itself
+      return;
+
+   NetObject::setRPCDestConnection(getRPCSourceConnection());
+   s2cSetLevelGeometry(hash, mWallGeometry);
+   NetObject::setRPCDestConnection(NULL);
+}
+
+
+// Walls we asked for with c2sRequestLevelGeometry.  Keep them for next time, and finish loading the level.
+TNL_IMPLEMENT_NETOBJECT_RPC(GameType, s2cSetLevelGeometry, (StringPtr hash, Vector<U8> geometry), (hash, geometry), 
+                            NetClassGroupGameMask, RPCGuaranteedOrderedBigData, RPCToGhost, 4)
+{
+   if(!mWaitingForLevelGeometry)
+      return;
+
+   mWaitingForLevelGeometry = false;
+
+   if(LevelGeometryCache::getHash(geometry) != hash.getString() || !constructWallsFromGeometry(geometry))
+   {
+      // The level can't be played without its walls, and asking again would only get us the same thing
+      logprintf(LogConsumer::LogError, "Received damaged level geometry from server; disconnecting");
+      mSyncMessagesDeferred = false;
+
+#ifndef ZAP_DEDICATED
+      // Ends the game, and this GameType with it, so don't touch anything after this
+      static_cast<ClientGame *>(mGame)->closeConnectionToGameServer(
+            "The server sent walls for this level that could not be read.");
+#endif
+      return;
+   }
+
+   LevelGeometryCache cache(mGame->getSettings()->getFolderManager()->cacheDir);
+   cache.save(hash.getString(), geometry);
+
+   if(mSyncMessagesDeferred)
+   {
+      mSyncMessagesDeferred = false;
+      onSyncMessagesComplete(mDeferredSyncSequence);
+   }
+}
+
+
 extern void writeServerBanList(CIniFile *ini, BanList *banList);
 
 // Runs the server side commands, which the client may or may not know about
@@ -3196,6 +3403,32 @@ GAMETYPE_RPC_C2S(GameType, c2sClearScriptCache, (), ())
 }
 
 
+TNL_IMPLEMENT_NETOBJECT_RPC(GameType, c2sShowScriptStats, (), (),
+                            NetClassGroupGameMask, RPCGuaranteedOrdered, RPCToGhostParent, 4)
+{
+   GameConnection *source = (GameConnection *) getRPCSourceConnection();
+   ClientInfo *clientInfo = source->getClientInfo();
+
+   if(!clientInfo->isAdmin())    // Error message handled client-side
+      return;
+
+   Vector<string> lines = static_cast<ServerGame *>(getGame())->getScriptCpuReport();
+
+   if(lines.size() == 0)
+   {
+      source->s2cDisplayErrorMessage("!!! There are no scripts running");
+      return;
+   }
+
+   messageVals.clear();
+   messageVals.push_back(itos(LuaScriptRunner::getCpuBudget()));
+   source->s2cDisplayMessageE(GameConnection::ColorInfo, SFXNone, "Script CPU use (budget %e0 ms/tick; 0 = none):", messageVals);
+
+   for(S32 i = 0; i < lines.size(); i++)
+      source->s2cDisplayMessage(GameConnection::ColorInfo, SFXNone, lines[i].c_str());
+}
+
+
 
 GAMETYPE_RPC_C2S(GameType, c2sTriggerTeamChange, (StringTableEntry playerName, S32 teamIndex), (playerName, teamIndex))
 {
@@ -3640,6 +3873,10 @@ TNL_IMPLEMENT_NETOBJECT_RPC(GameType, s2cScoreboardUpdate,
 
 GAMETYPE_RPC_S2C(GameType, s2cKillMessage, (StringTableEntry victim, StringTableEntry killer, StringTableEntry killerDescr), (victim, killer, killerDescr))
 {
+   GameConnection *source = (GameConnection *) getRPCSourceConnection();
+   if(source)
+      source->onKillMessage(victim, killer, killerDescr);
+
    if(killer)  // Known killer, was self, robot, or another player
    {
       if(killer == victim)
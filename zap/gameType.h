@@ -64,6 +64,18 @@ private:
 
    Vector<WallRec> mWalls;
 
+   // mWalls packed up for clients that keep level geometry on disk; built when first needed (server only)
+   Vector<U8> mWallGeometry;
+   string mWallGeometryHash;
+
+   bool mWaitingForLevelGeometry;   // Client has asked the server for walls it didn't have cached...
+   bool mSyncMessagesDeferred;      // ...and got s2cSyncMessagesComplete before they arrived
+   U32 mDeferredSyncSequence;
+
+   const string &getWallGeometryHash();
+   bool constructWallsFromGeometry(const Vector<U8> &geometry);
+   void onSyncMessagesComplete(U32 sequence);
+
    S32 mWinningScore;               // Game over when team (or player in individual games) gets this score
    S32 mLeadingTeam;                // Team with highest score
    S32 mLeadingTeamScore;           // Score of mLeadingTeam
@@ -93,6 +105,27 @@ private:
 
    Vector<SafePtr<MoveItem> > mCacheResendItem;  // Speed up c2sResendItemStatus
 
+   // Scope query results that are the same for every client who asks.  Each is found the first time a client needs
+   // it, then shared until the next tick or until anything in the game database is added, removed or moved.
+   struct SharedScope
+   {
+      bool current;
+      Vector<DatabaseObject *> objects;
+
+      SharedScope();
+   };
+
+   Vector<SharedScope> mTeamCmdrScopes;      // What each team's ships show on the commander's map, indexed by team
+   Vector<SharedScope> mSpyBugScopes;        // What each spy bug sees, in the order the database lists spy bugs
+   bool mSharedScopesCurrent;
+   U32 mSharedScopeChangeCount;              // Database change count when shared scopes were last validated
+
+   void refreshSharedScopes();
+   const Vector<DatabaseObject *> &getTeamCmdrScope(S32 teamIndex);
+   const Vector<DatabaseObject *> &getSpyBugScope(S32 spyBugIndex);
+
+   friend class GameTypeTest;
+
    void idle_client(U32 deltaT);
    void idle_server(U32 deltaT);
 
@@ -388,6 +421,9 @@ public:
                                      StringTableEntry levelCreds, S32 objectCount, 
                                      bool levelHasLoadoutZone, bool engineerEnabled, bool engineerAbuseEnabled, U32 levelDatabaseId));
    TNL_DECLARE_RPC(s2cAddWalls, (Vector<F32> barrier, F32 width, bool solid));
+   TNL_DECLARE_RPC(s2cUseLevelGeometry, (StringPtr hash));
+   TNL_DECLARE_RPC(c2sRequestLevelGeometry, (StringPtr hash));
+   TNL_DECLARE_RPC(s2cSetLevelGeometry, (StringPtr hash, Vector<U8> geometry));
    TNL_DECLARE_RPC(s2cAddTeam, (StringTableEntry teamName, F32 r, F32 g, F32 b, U32 score, bool firstTeam));
    TNL_DECLARE_RPC(s2cAddClient, (StringTableEntry clientName, bool isAuthenticated, Int<BADGE_COUNT> badges, 
                                   U16 gamesPlayed, RangedU32<0, ClientInfo::MaxKillStreakLength> killStreak,
@@ -489,6 +525,7 @@ public:
    TNL_DECLARE_RPC(c2sRenamePlayer, (StringTableEntry playerName, StringTableEntry newName));
    TNL_DECLARE_RPC(c2sGlobalMutePlayer, (StringTableEntry playerName));
    TNL_DECLARE_RPC(c2sClearScriptCache, ());
+   TNL_DECLARE_RPC(c2sShowScriptStats, ());
    TNL_DECLARE_RPC(c2sTriggerTeamChange, (StringTableEntry playerName, S32 teamIndex));
    TNL_DECLARE_RPC(c2sKickPlayer, (StringTableEntry playerName));
 
@@ -512,8 +549,6 @@ public:
    bool addBotFromClient(Vector<StringTableEntry> args);
 
    void displayAnnouncement(const string &message) const;
-
-   map <pair<U16,U16>, Vector<Point> > cachedBotFlightPlans;  // cache of zone-to-zone flight plans, shared for all bots
 };
 
 #define GAMETYPE_RPC_S2C(className, methodName, args, argNames) \
@@ -7,13 +7,17 @@
 #include "moveObject.h"    // For def of ActualState
 #include "WallSegmentManager.h"
 #include "GeomUtils.h"
+#include "MathUtils.h"
 
 #include "tnlLog.h"
+#include "tnlThread.h"
+
+#include <math.h>
+#include <algorithm>
 
 namespace Zap
 {
 
-U32 GridDatabase::mQueryId = 0;
 ClassChunker<DatabaseBucketEntry> *GridDatabase::mChunker = NULL;
 U32 GridDatabase::mCountGridDatabase = 0;
 
@@ -31,9 +35,21 @@ GridDatabase::GridDatabase(bool createWallSegmentManager)
 
    mCountGridDatabase++;
 
-   for(U32 i = 0; i < BucketRowCount; i++)
-      for(U32 j = 0; j < BucketRowCount; j++)
-         mBuckets[i][j].nextInBucket = NULL;
+   // Start out with a grid centered on the origin; resizeGrid() will adapt it to the level once we know how big that is
+   mBucketWidthBitShift = DefaultBucketWidthBitShift;
+   mGridMinX = -DefaultBucketRowCount / 2;
+   mGridMinY = -DefaultBucketRowCount / 2;
+   mGridWidth  = DefaultBucketRowCount;
+   mGridHeight = DefaultBucketRowCount;
+
+   mBuckets.resize(mGridWidth * mGridHeight);
+   for(S32 i = 0; i < mBuckets.size(); i++)
+      mBuckets[i].nextInBucket = NULL;
+
+   mTypeLists.resize(TypesNumbers);
+   mKeepObjectOrder = false;
+   mExtentsDirty = false;
+   mChangeCount = 0;
 
    if(createWallSegmentManager)
       mWallSegmentManager = new WallSegmentManager();    // Gets deleted in destructor
@@ -102,15 +118,20 @@ void GridDatabase::copyObjects(const GridDatabase *source)
 {
    // Preallocate some memory to make copying a little more efficient
    mAllObjects.reserve(source->mAllObjects.size());
-   mGoalZones .reserve(source->mGoalZones.size());
-   mFlags     .reserve(source->mFlags.size());
-   mSpyBugs   .reserve(source->mSpyBugs.size());
+   for(S32 i = 0; i < mTypeLists.size(); i++)
+      mTypeLists[i].reserve(source->mTypeLists[i].size());
 
 
    for(S32 i = 0; i < source->mAllObjects.size(); i++)
       addToDatabase(source->mAllObjects[i]->clone());
 
    sortObjects(mAllObjects);
+
+   // Sorting moved everything around, so objects need to learn their new positions
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      mAllObjects[i]->mAllObjectsIndex = i;
+
+   mKeepObjectOrder = true;      // The order we just sorted into matters, so preserve it from now on
 }
 
 
@@ -127,34 +148,17 @@ void GridDatabase::addToDatabase(DatabaseObject *theObject)
 
    theObject->mDatabase = this;
 
-   static IntRect bins;
-   fillBins(theObject->getExtent(), bins);
-
-   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
-      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
-      {
-         DatabaseBucketEntry *be = mChunker->alloc();
-         DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
-         be->theObject = theObject;
-         if(base->nextInBucket)
-            base->nextInBucket->prevInBucket = be;
-         be->nextInBucket = base->nextInBucket;
-         be->prevInBucket = base;
-         base->nextInBucket = be;
-         be->nextInBucketForThisObject = theObject->mBucketList;
-         theObject->mBucketList = be;
-      }
+   addToBuckets(theObject);
 
    // Add the object to our non-spatial "database" as well
-   mAllObjects.push_back(theObject);
-
    U8 type = theObject->getObjectTypeNumber();
-   if(type == GoalZoneTypeNumber)
-      mGoalZones.push_back(theObject);
-   else if(type == FlagTypeNumber)
-      mFlags.push_back(theObject);
-   else if(type == SpyBugTypeNumber)
-      mSpyBugs.push_back(theObject);
+   theObject->mTypeListNumber = type;
+
+   addToList(mAllObjects, theObject, theObject->mAllObjectsIndex);
+   addToList(mTypeLists[type], theObject, theObject->mTypeListIndex);
+
+   addToExtents(theObject->mExtent);
+   mChangeCount++;
    
    //sortObjects(mAllObjects);  // problem: Barriers in-game don't have mGeometry (it is NULL)
 }
@@ -170,43 +174,59 @@ void GridDatabase::addToDatabase(const Vector<DatabaseObject *> &objects)
 
 void GridDatabase::removeEverythingFromDatabase()
 {
-   for(S32 x = 0; x < BucketRowCount; x++)
+   clearStaticIndex(false);      // Everything's going, so no point putting static objects back in the grid first
+
+   for(S32 i = 0; i < mBuckets.size(); i++)
    {
-      for(S32 y = 0; y < BucketRowCount; y++)
+      for(DatabaseBucketEntry *walk = mBuckets[i].nextInBucket; walk; )
       {
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; )
-         {
-            DatabaseBucketEntry *rem = walk;
-            walk->theObject->mDatabase = NULL;  // make sure object don't point to this database anymore
-            walk->theObject->mBucketList = NULL;
-            walk = rem->nextInBucket;
-            mChunker->free(rem);
-         }
-         mBuckets[x & BucketMask][y & BucketMask].nextInBucket = NULL;
+         DatabaseBucketEntry *rem = walk;
+         walk->theObject->mDatabase = NULL;  // make sure object don't point to this database anymore
+         walk->theObject->mBucketList = NULL;
+         walk = rem->nextInBucket;
+         mChunker->free(rem);
       }
+      mBuckets[i].nextInBucket = NULL;
    }
 
-   // Clear out our specialty lists -- since objects are also in mAllObjects, they'll be deleted below
-   mGoalZones.clear();
-   mFlags.clear();
-   mSpyBugs.clear();
+   // Clear out our type lists -- since objects are also in mAllObjects, they'll be deleted below
+   for(S32 i = 0; i < mTypeLists.size(); i++)
+      mTypeLists[i].clear();
 
    mAllObjects.deleteAndClear();
+   mExtentsDirty = false;
+   mChangeCount++;
    
    if(mWallSegmentManager)
       mWallSegmentManager->clear();
 }
 
 
-// Don't use this with a sorted list!
-static void eraseObject_fast(Vector<DatabaseObject *> *objects, DatabaseObject *objectToDelete)
+// Append object to list, and tell the object where it went
+void GridDatabase::addToList(Vector<DatabaseObject *> &list, DatabaseObject *object, S32 &index)
 {
-   for(S32 i = 0; i < objects->size(); i++)
-      if(objects->get(i) == objectToDelete)
-      {
-         objects->erase_fast(i);     
-         return;
-      }
+   index = list.size();
+   list.push_back(object);
+}
+
+
+// Remove the object at index from one of our lists, and tell any objects that got moved about their new positions
+void GridDatabase::removeFromList(Vector<DatabaseObject *> &list, S32 index, bool isTypeList)
+{
+   if(mKeepObjectOrder)
+   {
+      list.erase(index);
+
+      for(S32 i = index; i < list.size(); i++)
+         (isTypeList ? list[i]->mTypeListIndex : list[i]->mAllObjectsIndex) = i;
+   }
+   else
+   {
+      list.erase_fast(index);    // Moves our last object into the hole
+
+      if(index < list.size())
+         (isTypeList ? list[index]->mTypeListIndex : list[index]->mAllObjectsIndex) = index;
+   }
 }
 
 
@@ -216,41 +236,25 @@ void GridDatabase::removeFromDatabase(DatabaseObject *object, bool deleteObject)
    if(object->mDatabase != this)
       return;
 
-   const Rect &extents = object->mExtent;
    object->mDatabase = NULL;
 
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   while(object->mBucketList)
-   {
-      DatabaseBucketEntry *b = object->mBucketList;
-      TNLAssert(b->theObject == object, "Object mismatch");
-      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-      if(b->nextInBucket)
-         b->nextInBucket->prevInBucket = b->prevInBucket;
-      b->prevInBucket->nextInBucket = b->nextInBucket;
-      object->mBucketList = b->nextInBucketForThisObject;
-      mChunker->free(b);
-   }
+   if(object->isInStaticIndex())
+      removeFromStaticIndex(object);
+   else
+      removeFromBuckets(object);
 
-   // Find and delete object from our non-spatial databases
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(mAllObjects[i] == object)
-      {
-         mAllObjects.erase(i);            // mAllObjects is sorted, so we can't use erase_fast
-         break;
-      }
+   // Delete object from our non-spatial databases; it knows where it is in each of them
+   TNLAssert(mAllObjects[object->mAllObjectsIndex] == object, "Object's index is out of date!");
+   TNLAssert(mTypeLists[object->mTypeListNumber][object->mTypeListIndex] == object, "Object's type list index is out of date!");
 
+   removeFromList(mAllObjects, object->mAllObjectsIndex, false);
+   removeFromList(mTypeLists[object->mTypeListNumber], object->mTypeListIndex, true);
 
-   U8 type = object->getObjectTypeNumber();
+   object->mAllObjectsIndex = -1;
+   object->mTypeListIndex = -1;
 
-   if(type == GoalZoneTypeNumber)
-      eraseObject_fast(&mGoalZones, object);
-   else if(type == FlagTypeNumber)
-      eraseObject_fast(&mFlags, object);
-   else if(type == SpyBugTypeNumber)
-      eraseObject_fast(&mSpyBugs, object);
+   removeFromExtents(object->mExtent);
+   mChangeCount++;
 
    if(deleteObject)
       delete object;      
@@ -273,163 +277,459 @@ const Vector<DatabaseObject *> *GridDatabase::findObjects_fast() const
 }
 
 
-// Faster than above, but results can't be modified, and only works with selected types at the moment
+// Faster than above, but results can't be modified.  Note that objects are listed under the type they had when they were
+// added, so deleted objects will still show up here until they are actually removed from the database.
 const Vector<DatabaseObject *> *GridDatabase::findObjects_fast(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return &mGoalZones;
+   return &mTypeLists[typeNumber];
+}
 
-   if(typeNumber == FlagTypeNumber)
-      return &mFlags;
 
-   if(typeNumber == SpyBugTypeNumber)
-      return &mSpyBugs;
+// Decides whether an object belongs in the results of a query.  Objects found by earlier searches in a sameQuery chain
+// are rejected here; objects appearing in several buckets are dealt with by the bucket walk itself.
+struct GridDatabase::QueryMatcher
+{
+   TestFunc testFunc;               // Use either testFunc...
+   const Vector<U8> *types;         // ...or a list of types...
+   U8 typeNumber;                   // ...or, if neither of those is set, a single type
+   const Vector<QueryContext::PriorSearch> *priorSearches;
 
-   TNLAssert(false, "This type not currently supported!  Sorry dude!");
-   return NULL;  // this line gets rid of compile warning "Not all control paths return a value"
-}
+   QueryMatcher(TestFunc testFunc, const Vector<U8> *types, U8 typeNumber, const Vector<QueryContext::PriorSearch> *priorSearches) :
+         testFunc(testFunc), types(types), typeNumber(typeNumber), priorSearches(priorSearches) { }
 
+   bool typeMatches(U8 objectType) const
+   {
+      if(testFunc)
+         return testFunc(objectType);
 
-void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
-{
-   static Vector<U8> types;
-   types.resize(1);
+      if(types)
+      {
+         for(S32 i = 0; i < types->size(); i++)
+            if(types->get(i) == objectType)
+               return true;
+         return false;
+      }
 
-   types[0] = typeNumber;
+      return objectType == typeNumber;
+   }
 
-   findObjects(types, fillVector, extents, bins);
-}
+   bool operator()(DatabaseObject *theObject) const
+   {
+      U8 objectType = theObject->getObjectTypeNumber();
+
+      if(!typeMatches(objectType))
+         return false;
 
+      // A prior search in our chain would have found this object if it overlapped that search's extents and passed its test
+      if(priorSearches)
+         for(S32 i = 0; i < priorSearches->size(); i++)
+         {
+            const QueryContext::PriorSearch &prior = priorSearches->get(i);
+            if(prior.testFunc(objectType) && theObject->mExtent.intersects(prior.extents))
+               return false;
+         }
 
-void GridDatabase::findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
+      return true;
+   }
+};
+
+
+// Look for objects in our static trees first, then in the bins of our grid.  Static barriers come back ahead of everything else.
+// Nothing here writes to the database or its objects, so searches using different contexts don't get in each other's way.
+template <class T>
+void GridDatabase::findMatchingObjects(QueryContext &context, const T &matches, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   mQueryId++;    // Used to prevent the same item from being found in multiple buckets
+   QueryStats &stats = context.mStats;
+   stats.queryCount++;
+
+   mStaticBarriers.findObjects(matches, &extents, fillVector, stats.staticNodesVisited);
+   mStaticOther.findObjects(matches, &extents, fillVector, stats.staticNodesVisited);
 
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
+   IntRect bins;
+   fillBins(extents, bins);
+
+   for(S32 y = bins.miny; y <= bins.maxy; y++)
+      for(S32 x = bins.minx; x <= bins.maxx; x++)
+      {
+         stats.bucketsVisited++;
+
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
          {
             DatabaseObject *theObject = walk->theObject;
+            stats.entriesVisited++;
 
-            if(theObject->mLastQueryId != mQueryId &&                         // Object hasn't been queried; and
-               testTypes(typeNumbers, theObject->getObjectTypeNumber()) &&    // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )        // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
+            // An object spanning several of our buckets is only considered in the first of them that we visit, the one
+            // whose coordinates are the larger of the object's and the search's minimums on each axis
+            const IntRect &objBins = theObject->mBins;
+            if(x != MAX(objBins.minx, bins.minx) || y != MAX(objBins.miny, bins.miny))
+               continue;
+
+            if(theObject->mExtent.intersects(extents) &&     // Object overlaps our extents; and
+               matches(theObject))                           // is of the right type, and wasn't found by a prior search
+               fillVector.push_back(theObject);              // So save it as a found item
          }
+      }
+}
+
+
+void GridDatabase::findObjects(QueryContext &context, U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
+{
+   findMatchingObjects(context, QueryMatcher(NULL, NULL, typeNumber, NULL), fillVector, extents);
+}
+
+
+void GridDatabase::findObjects(QueryContext &context, const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
+{
+   findMatchingObjects(context, QueryMatcher(NULL, &types, 0, NULL), fillVector, extents);
+}
+
+
+// If sameQuery is true, objects found by searches run with this context since the last one with sameQuery false will be skipped
+void GridDatabase::findObjects(QueryContext &context, TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, 
+                               bool sameQuery) const
+{
+   if(!sameQuery)
+      context.mPriorSearches.clear();
+
+   findMatchingObjects(context, QueryMatcher(testFunc, NULL, 0, sameQuery ? &context.mPriorSearches : NULL), fillVector, extents);
+
+   QueryContext::PriorSearch search;
+   search.extents = extents;
+   search.testFunc = testFunc;
+   context.mPriorSearches.push_back(search);
 }
 
 
 // Find all objects in database of type typeNumber
 void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const
 {
-   // If the user is looking for a type we maintain a list for, it will be faster to use that list than to cycle through the general item list.
-   TNLAssert(typeNumber != FlagTypeNumber && typeNumber != SpyBugTypeNumber, 
-             "Can use findObjects_fast()?  If not, uncomment the appropriate block below; it will perform better!");
+   const Vector<DatabaseObject *> &list = mTypeLists[typeNumber];
 
-   if(typeNumber == GoalZoneTypeNumber)
-   {
-      for(S32 i = 0; i < mGoalZones.size(); i++)
-         fillVector.push_back(mGoalZones[i]);
-      return;
-   }
+   for(S32 i = 0; i < list.size(); i++)
+      if(list[i]->getObjectTypeNumber() == typeNumber)     // Skip deleted objects
+         fillVector.push_back(list[i]);
+}
 
-   //if(typeNumber == FlagTypeNumber)
-   //{
-   //   for(S32 i = 0; i < mFlags.size(); i++)
-   //      fillVector.push_back(mFlags[i]);
-   //   return;
-   //}
 
-   //if(typeNumber == SpyBugTypeNumber)
-   //{
-   //   for(S32 i = 0; i < mSpyBugs.size(); i++)
-   //      fillVector.push_back(mSpyBugs[i]);
-   //   return;
-   //}
+// Translates a single coordinate into a bin index on our grid, clamping to the edges of the grid
+S32 GridDatabase::getBin(F32 coord, S32 gridMin, S32 gridSize) const
+{
+   // Keep things within S32 range before converting -- some callers use F32_MAX to mean "everything"
+   const F32 limit = F32(1 << 30);
+   if(coord > limit)
+      coord = limit;
+   else if(coord < -limit)
+      coord = -limit;
 
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
-         fillVector.push_back(mAllObjects[i]);
+   S32 bin = (S32(floor(coord)) >> mBucketWidthBitShift) - gridMin;
+
+   if(bin < 0)
+      return 0;
+   if(bin >= gridSize)
+      return gridSize - 1;
+
+   return bin;
 }
 
 
 // Translates extents into bins to search
 void GridDatabase::fillBins(const Rect &extents, IntRect &bins) const
 {
-   bins.minx = S32(extents.min.x) >> BucketWidthBitShift;
-   bins.miny = S32(extents.min.y) >> BucketWidthBitShift;
-   bins.maxx = S32(extents.max.x) >> BucketWidthBitShift;
-   bins.maxy = S32(extents.max.y) >> BucketWidthBitShift;
+   bins.minx = getBin(extents.min.x, mGridMinX, mGridWidth);
+   bins.miny = getBin(extents.min.y, mGridMinY, mGridHeight);
+   bins.maxx = getBin(extents.max.x, mGridMinX, mGridWidth);
+   bins.maxy = getBin(extents.max.y, mGridMinY, mGridHeight);
+}
 
-   if(U32(bins.maxx - bins.minx) >= BucketRowCount)
-      bins.maxx = bins.minx + BucketRowCount - 1;
 
-   if(U32(bins.maxy - bins.miny) >= BucketRowCount)
-      bins.maxy = bins.miny + BucketRowCount - 1;
+DatabaseBucketEntryBase *GridDatabase::getBucket(S32 x, S32 y)
+{
+   return &mBuckets[y * mGridWidth + x];
 }
 
 
-// Find all objects in &extents that are of type typeNumber
-void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
+const DatabaseBucketEntryBase *GridDatabase::getBucket(S32 x, S32 y) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
+   return &mBuckets[y * mGridWidth + x];
+}
+
+
+// Link object into every bucket its extent touches
+void GridDatabase::addToBuckets(DatabaseObject *theObject)
+{
+   TNLAssert(!theObject->mBucketList, "BucketList must be NULL");
+
+   IntRect &bins = theObject->mBins;
+   fillBins(theObject->mExtent, bins);
 
-   findObjects(typeNumber, fillVector, &extents, &bins);
+   for(S32 x = bins.minx; x <= bins.maxx; x++)
+      for(S32 y = bins.miny; y <= bins.maxy; y++)
+      {
+         DatabaseBucketEntry *be = mChunker->alloc();
+         DatabaseBucketEntryBase *base = getBucket(x, y);
+         be->theObject = theObject;
+         if(base->nextInBucket)
+            base->nextInBucket->prevInBucket = be;
+         be->nextInBucket = base->nextInBucket;
+         be->prevInBucket = base;
+         base->nextInBucket = be;
+         be->nextInBucketForThisObject = theObject->mBucketList;
+         theObject->mBucketList = be;
+      }
 }
 
 
-void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery) const
+// Unlink object from all of its buckets
+void GridDatabase::removeFromBuckets(DatabaseObject *theObject)
 {
-   TNLAssert(this, "findObjects 'this' is NULL");
-   if(!sameQuery)
-      mQueryId++;    // Used to prevent the same item from being found in multiple buckets
+   while(theObject->mBucketList)
+   {
+      DatabaseBucketEntry *b = theObject->mBucketList;
+      TNLAssert(b->theObject == theObject, "Object mismatch");
+      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
+      if(b->nextInBucket)
+         b->nextInBucket->prevInBucket = b->prevInBucket;
+      b->prevInBucket->nextInBucket = b->nextInBucket;
+      theObject->mBucketList = b->nextInBucketForThisObject;
+      mChunker->free(b);
+   }
+}
+
+
+// Convert a bucket width in pixels into a bit shift, rounding up to the next power of 2 and keeping within our limits
+U32 GridDatabase::getBucketWidthBitShift(U32 bucketWidth)
+{
+   U32 shift = MinBucketWidthBitShift;
+
+   while(shift < MaxBucketWidthBitShift && (1u << shift) < bucketWidth)
+      shift++;
+
+   return shift;
+}
+
+
+// Rebuild our grid so that it covers extents (plus a bucket of slop all around) with buckets of 2 ^ bucketWidthBitShift
+// pixels.  If that would need more than MaxBucketRowCount buckets in either direction, buckets are made larger until
+// it doesn't.  Objects already in the database are rebucketed.  Call this once the level is loaded and its size is known.
+void GridDatabase::resizeGrid(const Rect &extents, U32 bucketWidthBitShift)
+{
+   if(bucketWidthBitShift < MinBucketWidthBitShift)
+      bucketWidthBitShift = MinBucketWidthBitShift;
+
+   // Pull everything out of the old grid...
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      if(!mAllObjects[i]->isInStaticIndex())
+         removeFromBuckets(mAllObjects[i]);
+
+   // ...figure out the new one...
+   const F32 limit = F32(1 << 30);
+   S32 minx = S32(floor(max(extents.min.x, -limit)));
+   S32 miny = S32(floor(max(extents.min.y, -limit)));
+   S32 maxx = S32(floor(min(extents.max.x,  limit)));
+   S32 maxy = S32(floor(min(extents.max.y,  limit)));
+
+   mBucketWidthBitShift = bucketWidthBitShift;
+
+   while(true)
+   {
+      mGridMinX = (minx >> mBucketWidthBitShift) - 1;
+      mGridMinY = (miny >> mBucketWidthBitShift) - 1;
+      mGridWidth  = (maxx >> mBucketWidthBitShift) - mGridMinX + 2;
+      mGridHeight = (maxy >> mBucketWidthBitShift) - mGridMinY + 2;
+
+      if((mGridWidth <= MaxBucketRowCount && mGridHeight <= MaxBucketRowCount) || mBucketWidthBitShift >= MaxBucketWidthBitShift)
+         break;
+
+      mBucketWidthBitShift++;
+   }
+
+   mGridWidth  = min(mGridWidth,  (S32)MaxBucketRowCount);
+   mGridHeight = min(mGridHeight, (S32)MaxBucketRowCount);
+
+   mBuckets.resize(mGridWidth * mGridHeight);
+   for(S32 i = 0; i < mBuckets.size(); i++)
+      mBuckets[i].nextInBucket = NULL;
+
+   // ...and put everything back
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      if(!mAllObjects[i]->isInStaticIndex())
+         addToBuckets(mAllObjects[i]);
+}
+
+
+// Walls, zones, and forcefield projectors don't move once the level has been loaded.  Projectors can be destroyed, and
+// scripts can move zones around, but both are rare enough that we can handle them by pulling the object from the index.
+bool GridDatabase::isStaticType(U8 typeNumber)
+{
+   return
+         typeNumber == BarrierTypeNumber     || typeNumber == PolyWallTypeNumber   || typeNumber == ForceFieldProjectorTypeNumber ||
+         typeNumber == LoadoutZoneTypeNumber || typeNumber == GoalZoneTypeNumber   || typeNumber == NexusTypeNumber               ||
+         typeNumber == ZoneTypeNumber        || typeNumber == SlipZoneTypeNumber   || typeNumber == SpeedZoneTypeNumber;
+}
+
+
+// Move every static object currently in the database out of the grid and into our static trees.  Objects added later
+// go into the grid as usual.  Call this once the level has been loaded.
+void GridDatabase::buildStaticIndex()
+{
+   clearStaticIndex(true);
+
+   Vector<DatabaseObject *> barriers, others;
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+   {
+      DatabaseObject *obj = mAllObjects[i];
+      U8 typeNumber = obj->getObjectTypeNumber();
 
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
+      if(!isStaticType(typeNumber))
+         continue;
+
+      removeFromBuckets(obj);
+
+      // Only Barriers, not PolyWalls, so that sortBarriersFirst() has nothing to do
+      if(typeNumber == BarrierTypeNumber)
+         barriers.push_back(obj);
+      else
+         others.push_back(obj);
+   }
+
+   mStaticBarriers.build(barriers);
+   mStaticOther.build(others);
+}
+
+
+// Forget about our trees.  Unless the caller is about to empty the database anyway, static objects go back into the grid;
+// otherwise they're cut loose from the database, as the grid's objects are.
+void GridDatabase::clearStaticIndex(bool putBackInGrid)
+{
+   const Vector<DatabaseObject *> *lists[] = { &mStaticBarriers.getObjects(), &mStaticOther.getObjects() };
+
+   for(U32 i = 0; i < ARRAYSIZE(lists); i++)
+      for(S32 j = 0; j < lists[i]->size(); j++)
+      {
+         DatabaseObject *obj = lists[i]->get(j);
+
+         if(obj)
          {
-            DatabaseObject *theObject = walk->theObject;
+            obj->mStaticIndex = -1;
 
-            if(theObject->mLastQueryId != mQueryId &&                      // Object hasn't been queried; and
-               (testFunc(theObject->getObjectTypeNumber())) &&             // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )     // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
+            if(putBackInGrid)
+               addToBuckets(obj);
+            else
+               obj->mDatabase = NULL;
          }
+      }
+
+   mStaticBarriers.clear();
+   mStaticOther.clear();
+}
+
+
+void GridDatabase::removeFromStaticIndex(DatabaseObject *theObject)
+{
+   mStaticBarriers.remove(theObject);
+   mStaticOther.remove(theObject);
+
+   theObject->mStaticIndex = -1;
+}
+
+
+S32 GridDatabase::getStaticObjectCount() const
+{
+   return mStaticBarriers.getObjectCount() + mStaticOther.getObjectCount();
+}
+
+
+S32 GridDatabase::getBucketWidth() const
+{
+   return 1 << mBucketWidthBitShift;
+}
+
+
+S32 GridDatabase::getGridWidth() const
+{
+   return mGridWidth;
+}
+
+
+S32 GridDatabase::getGridHeight() const
+{
+   return mGridHeight;
+}
+
+
+const GridDatabase::QueryStats &GridDatabase::getQueryStats() const
+{
+   return mQueryContext.getStats();
+}
+
+
+void GridDatabase::resetQueryStats()
+{
+   mQueryContext.resetStats();
+}
+
+
+// Find all objects in &extents that are of type typeNumber
+void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
+{
+   findObjects(getDefaultContext(), typeNumber, fillVector, extents);
 }
 
 
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector) const
 {
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(testFunc(mAllObjects[i]->getObjectTypeNumber()))
-         fillVector.push_back(mAllObjects[i]);
+   // If our order matters, results need to come back in that order
+   if(mKeepObjectOrder)
+   {
+      for(S32 i = 0; i < mAllObjects.size(); i++)
+         if(testFunc(mAllObjects[i]->getObjectTypeNumber()))
+            fillVector.push_back(mAllObjects[i]);
+      return;
+   }
+
+   for(S32 type = 0; type < mTypeLists.size(); type++)
+   {
+      if(!testFunc(type))
+         continue;
+
+      const Vector<DatabaseObject *> &list = mTypeLists[type];
+
+      for(S32 i = 0; i < list.size(); i++)
+         if(testFunc(list[i]->getObjectTypeNumber()))     // Type may have changed if object was deleted
+            fillVector.push_back(list[i]);
+   }
 }
 
 
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   findObjects(types, fillVector, &extents, &bins);
+   findObjects(getDefaultContext(), types, fillVector, extents);
 }
 
 
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const
 {
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(testTypes(types, mAllObjects[i]->getObjectTypeNumber()))
-         fillVector.push_back(mAllObjects[i]);
+   if(mKeepObjectOrder)
+   {
+      for(S32 i = 0; i < mAllObjects.size(); i++)
+         if(testTypes(types, mAllObjects[i]->getObjectTypeNumber()))
+            fillVector.push_back(mAllObjects[i]);
+      return;
+   }
+
+   for(S32 i = 0; i < types.size(); i++)
+   {
+      bool seenBefore = false;
+      for(S32 j = 0; j < i && !seenBefore; j++)
+         seenBefore = (types[j] == types[i]);
+
+      if(!seenBefore)
+         findObjects(types[i], fillVector);
+   }
 }
 
 
@@ -461,18 +761,15 @@ bool GridDatabase::testTypes(const Vector<U8> &types, U8 objectType) const
 // Find all objects in &extents derived type test function
 void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, bool sameQuery) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   findObjects(testFunc, fillVector, &extents, &bins, sameQuery);
+   findObjects(getDefaultContext(), testFunc, fillVector, extents, sameQuery);
 }
 
 
 void GridDatabase::dumpObjects()
 {
-   for(S32 x = 0; x < BucketRowCount; x++)
-      for(S32 y = 0; y < BucketRowCount; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
+   for(S32 x = 0; x < mGridWidth; x++)
+      for(S32 y = 0; y < mGridHeight; y++)
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
          {
             DatabaseObject *theObject = walk->theObject;
             logprintf("Found object in (%d,%d) with extents %s", x, y, theObject->getExtent().toString().c_str());
@@ -481,49 +778,110 @@ void GridDatabase::dumpObjects()
 }
 
 
-// Get the extents of every object in the database
-Rect GridDatabase::getExtents()
+// Get the extents of every object in the database; cheap unless an object defining one of the edges has recently moved
+// inward or been removed
+Rect GridDatabase::getExtents() const
 {
    if(mAllObjects.size() == 0)     // No objects ==> no extents!
       return Rect();
 
-   Rect rect;
+   if(mExtentsDirty)
+      rebuildExtents();
 
-   // Think we can delete from HERE...   inserted this comment 27-Jan-2012  #########################################
+   return mExtents;
+}
 
-   // All this rigamarole is to make world extent correct for levels that do not overlap (0,0)
-   // The problem is that the GameType is treated as an object, and has the extent (0,0), and
-   // a mask of UnknownType.  Fortunately, the GameType tends to be first, so what we do is skip
-   // all objects until we find an UnknownType object, then start creating our extent from there.
-   // We have to assign theRect to an extent object initially to avoid getting the default coords
-   // of (0,0) that are assigned by the constructor.
 
+// Moves edge outward to value if value lies beyond it; counts the objects that touch the edge
+static void growEdge(F32 &edge, S32 &count, F32 value, bool isMinEdge)
+{
+   if(value == edge)
+      count++;
+   else if(isMinEdge ? value < edge : value > edge)
+   {
+      edge = value;
+      count = 1;
+   }
+}
 
-   S32 first = -1;
 
-   // Look for first non-UnknownType object
-   for(S32 i = 0; i < mAllObjects.size() && first == -1; i++)
-      if(mAllObjects[i]->getObjectTypeNumber() != UnknownTypeNumber)
-      {
-         rect = mAllObjects[i]->getExtent();
-         first = i;
-      }
+// Returns false if extents was the last thing touching the edge, meaning the edge may now need to move inward
+static bool shrinkEdge(F32 edge, S32 &count, F32 value)
+{
+   if(value != edge)
+      return true;
+
+   count--;
+   return count > 0;
+}
 
-   TNLAssert(first == 0, "I think this should never happen -- how would an object with UnknownTypeNumber get in the database?? \
-                          if it does, please document it and remove this assert, along withthe rect = line below -Wat");
 
-   if(first == -1)      // No suitable objects found, return empty extents
-      return Rect();
+// Account for a new (or newly moved) object in our overall extents
+void GridDatabase::addToExtents(const Rect &extents)
+{
+   if(mExtentsDirty)       // Will get picked up when we rebuild
+      return;
+
+   if(mAllObjects.size() == 1)      // First object in the database defines all of our edges
+   {
+      mExtents = extents;
+      for(S32 i = 0; i < 4; i++)
+         mExtentEdgeCounts[i] = 1;
+      return;
+   }
+
+   growEdge(mExtents.min.x, mExtentEdgeCounts[0], extents.min.x, true);
+   growEdge(mExtents.min.y, mExtentEdgeCounts[1], extents.min.y, true);
+   growEdge(mExtents.max.x, mExtentEdgeCounts[2], extents.max.x, false);
+   growEdge(mExtents.max.y, mExtentEdgeCounts[3], extents.max.y, false);
+}
+
+
+// Account for an object leaving (or moving away from) its old extents
+void GridDatabase::removeFromExtents(const Rect &extents)
+{
+   if(mExtentsDirty)
+      return;
+
+   // Use non-short-circuiting & so every edge gets its count updated
+   bool stillValid = shrinkEdge(mExtents.min.x, mExtentEdgeCounts[0], extents.min.x) &
+                     shrinkEdge(mExtents.min.y, mExtentEdgeCounts[1], extents.min.y) &
+                     shrinkEdge(mExtents.max.x, mExtentEdgeCounts[2], extents.max.x) &
+                     shrinkEdge(mExtents.max.y, mExtentEdgeCounts[3], extents.max.y);
+
+   if(!stillValid)
+      mExtentsDirty = true;
+}
+
+
+// Compute our extents from scratch by visiting every object
+void GridDatabase::rebuildExtents() const
+{
+   mExtentsDirty = false;
 
-   // ...to HERE
+   if(mAllObjects.size() == 0)
+      return;
 
-   rect = mAllObjects[0]->getExtent();
+   mExtents = mAllObjects[0]->getExtent();
+   for(S32 i = 0; i < 4; i++)
+      mExtentEdgeCounts[i] = 1;
 
-   // Now start unioning the extents of remaining objects.  Should be all of them.
-   for(S32 i = /*first + */1; i < mAllObjects.size(); i++)
-      rect.unionRect(mAllObjects[i]->getExtent());
+   for(S32 i = 1; i < mAllObjects.size(); i++)
+   {
+      const Rect &extents = mAllObjects[i]->mExtent;
 
-   return rect;
+      growEdge(mExtents.min.x, mExtentEdgeCounts[0], extents.min.x, true);
+      growEdge(mExtents.min.y, mExtentEdgeCounts[1], extents.min.y, true);
+      growEdge(mExtents.max.x, mExtentEdgeCounts[2], extents.max.x, false);
+      growEdge(mExtents.max.y, mExtentEdgeCounts[3], extents.max.y, false);
+   }
+}
+
+
+// Changes whenever an object is added, removed or moved
+U32 GridDatabase::getChangeCount() const
+{
+   return mChangeCount;
 }
 
 
@@ -564,11 +922,14 @@ DatabaseObject::~DatabaseObject()
 // Code that needs to run for both constructor and copy constructor
 void DatabaseObject::initialize() 
 {
-   mLastQueryId = 0; 
    mExtent = Rect(); 
    mExtentSet = false;
    mDatabase = NULL;
    mBucketList = NULL;
+   mStaticIndex = -1;
+   mAllObjectsIndex = -1;
+   mTypeListIndex = -1;
+   mTypeListNumber = UnknownTypeNumber;
 }
 
 
@@ -583,17 +944,26 @@ DatabaseObject *GridDatabase::findObjectLOS(U8 typeNumber, U32 stateIndex,
 }
 
 
-// Format is a passthrough to polygonLineIntersect().  Will be true for most items, false for walls in editor.
 DatabaseObject *GridDatabase::findObjectLOS(U8 typeNumber, U32 stateIndex, bool format,
                                             const Point &rayStart, const Point &rayEnd,
                                             float &collisionTime, Point &surfaceNormal) const
+{
+   return findObjectLOS(getDefaultContext(), typeNumber, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
+}
+
+
+// Format is a passthrough to polygonLineIntersect().  Will be true for most items, false for walls in editor.
+DatabaseObject *GridDatabase::findObjectLOS(QueryContext &context, U8 typeNumber, U32 stateIndex, bool format,
+                                            const Point &rayStart, const Point &rayEnd,
+                                            float &collisionTime, Point &surfaceNormal) const
 {
    Rect queryRect(rayStart, rayEnd);
 
-   static Vector<DatabaseObject *> fillVector;  // Use local here, Most of code expects a global FillVector left unchanged
+   // Use the context's scratch vector here, most callers expect our global fillVector to be left unchanged
+   Vector<DatabaseObject *> &fillVector = context.scratch;
    fillVector.clear();
 
-   findObjects(typeNumber, fillVector, queryRect);
+   findObjects(context, typeNumber, fillVector, queryRect);
 
    Point collisionPoint;
 
@@ -649,13 +1019,22 @@ DatabaseObject *GridDatabase::findObjectLOS(U8 typeNumber, U32 stateIndex, bool
 DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, bool format,
                                             const Point &rayStart, const Point &rayEnd, 
                                             float &collisionTime, Point &surfaceNormal) const
+{
+   return findObjectLOS(getDefaultContext(), testFunc, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
+}
+
+
+DatabaseObject *GridDatabase::findObjectLOS(QueryContext &context, TestFunc testFunc, U32 stateIndex, bool format,
+                                            const Point &rayStart, const Point &rayEnd, 
+                                            float &collisionTime, Point &surfaceNormal) const
 {
    Rect queryRect(rayStart, rayEnd);
 
-   static Vector<DatabaseObject *> fillVector;  // Use local here, most callers expect our global fillVector to be left unchanged
+   // Use the context's scratch vector here, most callers expect our global fillVector to be left unchanged
+   Vector<DatabaseObject *> &fillVector = context.scratch;
    fillVector.clear();
 
-   findObjects(testFunc, fillVector, queryRect);
+   findObjects(context, testFunc, fillVector, queryRect);
 
    Point collisionPoint;
 
@@ -722,11 +1101,17 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex,
 
 
 bool GridDatabase::pointCanSeePoint(const Point &point1, const Point &point2)
+{
+   return pointCanSeePoint(getDefaultContext(), point1, point2);
+}
+
+
+bool GridDatabase::pointCanSeePoint(QueryContext &context, const Point &point1, const Point &point2) const
 {
    F32 time;
    Point coll;
 
-   return( findObjectLOS((TestFunc)isWallType, ActualState, true, point1, point2, time, coll) == NULL );
+   return( findObjectLOS(context, (TestFunc)isWallType, ActualState, true, point1, point2, time, coll) == NULL );
 }
 
 
@@ -761,36 +1146,19 @@ S32 GridDatabase::getObjectCount() const
 }
 
 
-// Return count of objects of specified type.  Only supports certain types at the moment.
+// Return count of objects filed under specified type, including any that have been deleted but not yet removed
 S32 GridDatabase::getObjectCount(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return mGoalZones.size();
-
-   if(typeNumber == FlagTypeNumber)
-      return mFlags.size();
-
-   if(typeNumber == SpyBugTypeNumber)
-      return mSpyBugs.size();
-
-   TNLAssert(false, "Unsupported type!");
-   return 0;
+   return mTypeLists[typeNumber].size();
 }
 
 
 bool GridDatabase::hasObjectOfType(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return mGoalZones.size() > 0;
-
-   if(typeNumber == FlagTypeNumber)
-      return mFlags.size() > 0;
+   const Vector<DatabaseObject *> &list = mTypeLists[typeNumber];
 
-   if(typeNumber == SpyBugTypeNumber)
-      return mSpyBugs.size() > 0;
-
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
+   for(S32 i = 0; i < list.size(); i++)
+      if(list[i]->getObjectTypeNumber() == typeNumber)
          return true;
 
    return false;
@@ -824,6 +1192,12 @@ bool DatabaseObject::isInDatabase()
 }
 
 
+bool DatabaseObject::isInStaticIndex() const
+{
+   return mStaticIndex != -1;
+}
+
+
 bool DatabaseObject::isDeleted() 
 {
    return mObjectTypeNumber == DeletedTypeNumber;
@@ -851,6 +1225,13 @@ const Vector<Point> *DatabaseObject::getCollisionPoly() const
 }  
 
 
+// Objects with fixed collision polygons can override this to skip repacking them on every test
+const PackedPolygon *DatabaseObject::getPackedCollisionPoly() const
+{
+   return NULL;
+}
+
+
 bool DatabaseObject::getCollisionCircle(U32 stateIndex, Point &point, F32 &radius) const
 {
    return false;
@@ -901,72 +1282,44 @@ void DatabaseObject::setExtent(const Rect &extents)
    GridDatabase *gridDB = getDatabase();
 
    if(gridDB)
-   {
-      // Remove from the extents database for current extents...
-      //gridDB->removeFromDatabase(this, mExtent);    // old extent
-      // ...and re-add for the new extent
-      //gridDB->addToDatabase(this, extents);
+      gridDB->mChangeCount++;
 
+   // Static objects aren't supposed to move, but if one does, we'll move it into the grid where it can be updated
+   if(gridDB && isInStaticIndex())
+   {
+      if(extents == mExtent)
+         return;
 
-      S32 minxold, minyold, maxxold, maxyold;
-      S32 minx, miny, maxx, maxy;
-
-      minxold = S32(mExtent.min.x) >> GridDatabase::BucketWidthBitShift;
-      minyold = S32(mExtent.min.y) >> GridDatabase::BucketWidthBitShift;
-      maxxold = S32(mExtent.max.x) >> GridDatabase::BucketWidthBitShift;
-      maxyold = S32(mExtent.max.y) >> GridDatabase::BucketWidthBitShift;
-
-      minx    = S32(extents.min.x) >> GridDatabase::BucketWidthBitShift;
-      miny    = S32(extents.min.y) >> GridDatabase::BucketWidthBitShift;
-      maxx    = S32(extents.max.x) >> GridDatabase::BucketWidthBitShift;
-      maxy    = S32(extents.max.y) >> GridDatabase::BucketWidthBitShift;
-
-      // Don't do anything if the buckets haven't changed...
-      if((minxold - minx) | (minyold - miny) | (maxxold - maxx) | (maxyold - maxy))
-      {
-         // They are different... remove and readd to database, but don't touch gridDB->mAllObjects
-         if(U32(maxx - minx) >= gridDB->BucketRowCount)        maxx    = minx    + gridDB->BucketRowCount - 1;
-         if(U32(maxy - miny) >= gridDB->BucketRowCount)        maxy    = miny    + gridDB->BucketRowCount - 1;
-         if(U32(maxxold >= minxold) + gridDB->BucketRowCount)  maxxold = minxold + gridDB->BucketRowCount - 1;
-         if(U32(maxyold >= minyold) + gridDB->BucketRowCount)  maxyold = minyold + gridDB->BucketRowCount - 1;
-
+      gridDB->removeFromStaticIndex(this);
+      gridDB->addToExtents(extents);
+      gridDB->removeFromExtents(mExtent);
+      mExtent.set(extents);
+      gridDB->addToBuckets(this);
+      return;
+   }
 
-         // Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
-         // Instead, use maxx - x >= 0, it will better handle overflows and avoid endless loop (MIN_S32 - MAX_S32 = +1)
+   IntRect newBins;
 
-         // Remove from the extents database for current extents...
-         while(mBucketList)
-         {
-            DatabaseBucketEntry *b = mBucketList;
-            TNLAssert(b->theObject == this, "Object mismatch");
-            TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-            if(b->nextInBucket)
-               b->nextInBucket->prevInBucket = b->prevInBucket;
-            b->prevInBucket->nextInBucket = b->nextInBucket;
-            mBucketList = b->nextInBucketForThisObject;
-            gridDB->mChunker->free(b);
-         }
+   if(gridDB)
+   {
+      gridDB->fillBins(extents, newBins);
 
-         // ...and re-add for the new extent
-         for(S32 x = minx; maxx - x >= 0; x++)
-            for(S32 y = miny; maxy - y >= 0; y++)
-            {
-               DatabaseBucketEntry *be = gridDB->mChunker->alloc();
-               DatabaseBucketEntryBase *base = &gridDB->mBuckets[x & gridDB->BucketMask][y & gridDB->BucketMask];
-               be->theObject = this;
-               if(base->nextInBucket)
-                  base->nextInBucket->prevInBucket = be;
-               be->nextInBucket = base->nextInBucket;
-               be->prevInBucket = base;
-               base->nextInBucket = be;
-               be->nextInBucketForThisObject = mBucketList;
-               mBucketList = be;
-            }
-      }
+      // Add new extents before removing old, so an object that doesn't actually move won't leave an edge uncounted
+      gridDB->addToExtents(extents);
+      gridDB->removeFromExtents(mExtent);
    }
 
    mExtent.set(extents);
    mExtentSet = true;
+
+   // Don't do anything if the buckets haven't changed...
+   const IntRect &oldBins = mBins;
+   if(gridDB && ((oldBins.minx - newBins.minx) | (oldBins.miny - newBins.miny) | (oldBins.maxx - newBins.maxx) | (oldBins.maxy - newBins.maxy)))
+   {
+      // They are different... remove and readd to database, but don't touch gridDB->mAllObjects
+      gridDB->removeFromBuckets(this);
+      gridDB->addToBuckets(this);
+   }
 }
 
 
@@ -977,11 +1330,206 @@ DatabaseObject *DatabaseObject::clone() const
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Contexts for threads other than the main one, which can't share the databases' own
+static ThreadStorage &getThreadQueryContexts()
+{
+   static ThreadStorage contexts;
+   return contexts;
+}
+
+
+// Searches that don't take a QueryContext use this one
+GridDatabase::QueryContext &GridDatabase::getDefaultContext() const
+{
+   QueryContext *context = static_cast<QueryContext *>(getThreadQueryContexts().get());
+   return context ? *context : mQueryContext;
+}
+
+
+// Call on a worker thread before it searches any database without a QueryContext; context must outlive those searches
+void GridDatabase::setThreadQueryContext(QueryContext *context)
+{
+   getThreadQueryContexts().set(context);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+GridDatabase::QueryContext::QueryContext()
+{
+   resetStats();
+}
+
+
+const GridDatabase::QueryStats &GridDatabase::QueryContext::getStats() const
+{
+   return mStats;
+}
+
+
+void GridDatabase::QueryContext::resetStats()
+{
+   mStats.queryCount = 0;
+   mStats.bucketsVisited = 0;
+   mStats.entriesVisited = 0;
+   mStats.staticNodesVisited = 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Sort helper for building the tree -- compares object centers along one axis
+struct CenterComparer
+{
+   bool useX;
+
+   explicit CenterComparer(bool useX) : useX(useX) { }
+
+   bool operator()(const DatabaseObject *a, const DatabaseObject *b) const
+   {
+      Point ca = a->getExtent().getCenter();
+      Point cb = b->getExtent().getCenter();
+
+      return useX ? ca.x < cb.x : ca.y < cb.y;
+   }
+};
+
+
+// Constructor
+StaticObjectTree::StaticObjectTree()
+{
+   mObjectCount = 0;
+}
+
+
+void StaticObjectTree::build(const Vector<DatabaseObject *> &objects)
+{
+   clear();
+
+   if(objects.size() == 0)
+      return;
+
+   mObjects = objects;
+   mNodes.reserve(2 * (objects.size() / MaxObjectsPerLeaf + 1));
+   mNodes.push_back(Node());
+
+   buildNode(0, 0, mObjects.size());
+
+   for(S32 i = 0; i < mObjects.size(); i++)
+      mObjects[i]->mStaticIndex = i;
+
+   mObjectCount = mObjects.size();
+}
+
+
+// Split objects [first, first + count) in half along the longer axis of their centers, until the halves are small enough to be leaves
+void StaticObjectTree::buildNode(S32 nodeIndex, S32 first, S32 count)
+{
+   Rect extent = mObjects[first]->getExtent();
+   Rect centers(mObjects[first]->getExtent().getCenter(), mObjects[first]->getExtent().getCenter());
+
+   for(S32 i = first + 1; i < first + count; i++)
+   {
+      extent.unionRect(mObjects[i]->getExtent());
+      centers.unionPoint(mObjects[i]->getExtent().getCenter());
+   }
+
+   mNodes[nodeIndex].extent = extent;
+
+   if(count <= MaxObjectsPerLeaf)
+   {
+      mNodes[nodeIndex].first = first;
+      mNodes[nodeIndex].count = count;
+      return;
+   }
+
+   S32 half = count / 2;
+   DatabaseObject **begin = &mObjects[first];
+   std::nth_element(begin, begin + half, begin + count, CenterComparer(centers.getWidth() >= centers.getHeight()));
+
+   S32 child = mNodes.size();
+   mNodes.push_back(Node());
+   mNodes.push_back(Node());
+
+   mNodes[nodeIndex].first = child;
+   mNodes[nodeIndex].count = 0;
+
+   buildNode(child,     first,        half);
+   buildNode(child + 1, first + half, count - half);
+}
+
+
+void StaticObjectTree::clear()
+{
+   mNodes.clear();
+   mObjects.clear();
+   mObjectCount = 0;
+}
+
+
+// Leaves a hole in the tree; the tree's extents aren't updated, which just makes queries a tiny bit slower
+void StaticObjectTree::remove(DatabaseObject *object)
+{
+   S32 index = object->mStaticIndex;
+
+   if(index >= 0 && index < mObjects.size() && mObjects[index] == object)
+   {
+      mObjects[index] = NULL;
+      mObjectCount--;
+   }
+}
+
+
+S32 StaticObjectTree::getObjectCount() const
+{
+   return mObjectCount;
+}
+
+
+const Vector<DatabaseObject *> &StaticObjectTree::getObjects() const
+{
+   return mObjects;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+static S32 QSORT_CALLBACK barriersFirstSort(DatabaseObject **a, DatabaseObject **b)
+{
+   return ((*b)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0) - ((*a)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0);
+}
+
+
+void sortBarriersFirst(Vector<DatabaseObject *> &objects)
+{
+   // See if there's a barrier that comes after a non-barrier; if not, we're already sorted
+   bool foundNonBarrier = false;
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      if(objects[i]->getObjectTypeNumber() != BarrierTypeNumber)
+         foundNonBarrier = true;
+      else if(foundNonBarrier)
+      {
+         objects.sort(barriersFirstSort);
+         return;
+      }
+   }
+}
+
+
 };
 
 // Reusable container for searching gridDatabases
 // Has to be outside of Zap namespace seems to help with debugging showing what's inside fillVector  (debugger forgets to add Zap::)
-Vector<Zap::DatabaseObject *> fillVector;
-Vector<Zap::DatabaseObject *> fillVector2;
+thread_local Vector<Zap::DatabaseObject *> fillVector;
+thread_local Vector<Zap::DatabaseObject *> fillVector2;
 
 
@@ -25,6 +25,7 @@ typedef bool (*TestFunc)(U8);
 // Interface for dealing with objects that can be in our spatial database.
 class GridDatabase;
 class EditorObjectDatabase;
+class PackedPolygon;
 struct DatabaseBucketEntry;
 class DatabaseObject;
 
@@ -47,14 +48,21 @@ class DatabaseObject : public GeomObject
 
    friend class GridDatabase;
    friend class EditorObjectDatabase;
+   friend class StaticObjectTree;
 
 
 private:
-   U32 mLastQueryId;
    Rect mExtent;
    bool mExtentSet;     // A flag to mark whether extent has been set on this object
    GridDatabase *mDatabase;
    DatabaseBucketEntry *mBucketList;
+   IntRect mBins;       // Buckets this object was linked into; only meaningful while mBucketList is set
+   S32 mStaticIndex;    // Index in the database's static tree, or -1 if object lives in the bucket grid
+
+   // Where this object lives in its database's object lists, so it can be removed without searching for it
+   S32 mAllObjectsIndex;
+   S32 mTypeListIndex;
+   U8 mTypeListNumber;  // Type the object was filed under when added; deleting an object changes its type, but not its list
 
 protected:
    U8 mObjectTypeNumber;
@@ -75,11 +83,13 @@ public:
    
 
    virtual const Vector<Point> *getCollisionPoly() const;
+   virtual const PackedPolygon *getPackedCollisionPoly() const;    // Same polygon, packed for the vectorized collision tests
    virtual bool getCollisionCircle(U32 stateIndex, Point &point, float &radius) const;
 
    virtual bool isCollisionEnabled() const;
 
    bool isInDatabase();
+   bool isInStaticIndex() const;
    bool isDeleted();
 
    void addToDatabase(GridDatabase *database);
@@ -101,43 +111,228 @@ class WallSegmentManager;
 class GoalZone;
 class BfObject;
 
+// Bounding volume hierarchy over objects that never move once the level is loaded.  Built once, in one go; objects can be
+// removed afterwards (they leave a hole behind) but not added.
+class StaticObjectTree
+{
+private:
+   struct Node
+   {
+      Rect extent;
+      S32 first;           // Leaves: index of first object in mObjects; interior nodes: index of first child (second is first + 1)
+      S32 count;           // Leaves: number of objects; interior nodes: 0
+   };
+
+   enum {
+      MaxObjectsPerLeaf = 4,
+      MaxDepth = 64,
+   };
+
+   Vector<Node> mNodes;
+   Vector<DatabaseObject *> mObjects;     // In leaf order; removed objects leave a NULL behind
+   S32 mObjectCount;                      // Number of objects remaining in the tree
+
+   void buildNode(S32 nodeIndex, S32 first, S32 count);
+
+public:
+   StaticObjectTree();     // Constructor
+
+   void build(const Vector<DatabaseObject *> &objects);
+   void clear();
+
+   void remove(DatabaseObject *object);
+   S32 getObjectCount() const;
+   const Vector<DatabaseObject *> &getObjects() const;
+
+   // Appends objects whose extents overlap extents (or all objects, if extents is NULL) to fillVector
+   template <class T>
+   void findObjects(const T &matches, const Rect *extents, Vector<DatabaseObject *> &fillVector, U32 &nodesVisited) const
+   {
+      if(mNodes.size() == 0)
+         return;
+
+      S32 stack[MaxDepth];
+      S32 stackSize = 0;
+
+      stack[stackSize++] = 0;
+
+      while(stackSize > 0)
+      {
+         const Node &node = mNodes[stack[--stackSize]];
+         nodesVisited++;
+
+         if(extents && !node.extent.intersects(*extents))
+            continue;
+
+         if(node.count == 0)
+         {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+            continue;
+         }
+
+         for(S32 i = node.first; i < node.first + node.count; i++)
+         {
+            DatabaseObject *obj = mObjects[i];
+
+            if(obj && (!extents || obj->mExtent.intersects(*extents)) && matches(obj))
+               fillVector.push_back(obj);
+         }
+      }
+   }
+};
+
+
 class GridDatabase
 {
+   friend class DatabaseObject;
+
+public:
+   // Counters for gauging how much work our spatial queries are doing; see getQueryStats()
+   struct QueryStats
+   {
+      U32 queryCount;            // Number of bucketed queries run
+      U32 bucketsVisited;        // Number of buckets examined by those queries
+      U32 entriesVisited;        // Number of bucket entries walked by those queries (including rejects)
+      U32 staticNodesVisited;    // Number of static tree nodes examined by those queries
+   };
+
+   // Holds everything a search needs to remember, so that nothing about a search lives in the database or its objects.
+   // Searches using different contexts can run at the same time, on different threads, even against the same database,
+   // as long as nothing is added to, removed from, or moved within that database while they run.  A context can only be
+   // used by one search at a time.
+   class QueryContext
+   {
+      friend class GridDatabase;
+
+   private:
+      struct PriorSearch
+      {
+         Rect extents;
+         TestFunc testFunc;
+      };
+
+      Vector<PriorSearch> mPriorSearches;    // Searches that have run since the last one with sameQuery == false
+      QueryStats mStats;
+
+   public:
+      QueryContext();      // Constructor
+
+      Vector<DatabaseObject *> scratch;      // Working space for findObjectLOS(); callers can use it between searches too
+
+      const QueryStats &getStats() const;
+      void resetStats();
+   };
+
 private:
    U32 mDatabaseId;
-   static U32 mQueryId;
    static U32 mCountGridDatabase;      // Reference counter for destruction of mChunker
 
    WallSegmentManager *mWallSegmentManager;
 
    Vector<DatabaseObject *> mAllObjects;
-   Vector<DatabaseObject *> mGoalZones;
-   Vector<DatabaseObject *> mFlags;
-   Vector<DatabaseObject *> mSpyBugs;
+   Vector<Vector<DatabaseObject *> > mTypeLists;   // Objects of each TypeNumber, indexed by type
+
+   // Normally objects are removed by moving the last object into the hole they leave, which scrambles the order of our
+   // lists.  Databases whose objects have been sorted (see copyObjects()) keep their order instead, at the cost of
+   // slower removals.
+   bool mKeepObjectOrder;
+
+   // Combined extents of everything in the database, kept current as objects come, go and move.  For each edge, we count
+   // how many objects touch it; when that count drops to zero, we don't know where the edge should be any more, so we
+   // mark the extents as dirty and rebuild them from scratch the next time they are needed.
+   mutable Rect mExtents;
+   mutable S32 mExtentEdgeCounts[4];      // Objects touching left, top, right and bottom edges of mExtents
+   mutable bool mExtentsDirty;
+
+   void addToExtents(const Rect &extents);
+   void removeFromExtents(const Rect &extents);
+   void rebuildExtents() const;
+
+   U32 mChangeCount;    // Bumped by every add, remove and move, so callers can tell when cached query results go stale
+
+   void addToList(Vector<DatabaseObject *> &list, DatabaseObject *object, S32 &index);
+   void removeFromList(Vector<DatabaseObject *> &list, S32 index, bool isTypeList);
 
-   void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery = false) const;
+   // Our spatial grid.  It covers a rectangular area of mGridWidth x mGridHeight buckets, whose upper-left bucket
+   // has bucket coordinates (mGridMinX, mGridMinY).  Anything outside that area is clamped into the edge buckets,
+   // so no two distant areas of the map ever share a bucket.  See resizeGrid().
+   U32 mBucketWidthBitShift;
+   S32 mGridMinX, mGridMinY;
+   S32 mGridWidth, mGridHeight;
+   Vector<DatabaseBucketEntryBase> mBuckets;
+
+   // Level geometry that never moves is kept out of the grid, in trees built by buildStaticIndex().  Barriers get their
+   // own tree so that they are always returned ahead of everything else, polywalls included; see sortBarriersFirst().
+   StaticObjectTree mStaticBarriers;
+   StaticObjectTree mStaticOther;
+
+   // Used by the search functions that don't take a QueryContext, unless the thread has set one of its own
+   mutable QueryContext mQueryContext;
+   QueryContext &getDefaultContext() const;
+
+   struct QueryMatcher;
+
+   template <class T>
+   void findMatchingObjects(QueryContext &context, const T &matches, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
    void fillBins(const Rect &extents, IntRect &bins) const;    // Helper function -- translates extents into bins to search
+   S32 getBin(F32 coord, S32 gridMin, S32 gridSize) const;
+
+   DatabaseBucketEntryBase *getBucket(S32 x, S32 y);
+   const DatabaseBucketEntryBase *getBucket(S32 x, S32 y) const;
+
+   void addToBuckets(DatabaseObject *theObject);
+   void removeFromBuckets(DatabaseObject *theObject);
+
+   void removeFromStaticIndex(DatabaseObject *theObject);
+   void clearStaticIndex(bool putBackInGrid);
 
 public:
    enum {
-      BucketRowCount = 16,    // Number of buckets per grid row, and number of rows; should be power of 2
-      BucketMask = BucketRowCount - 1,
+      DefaultBucketWidthBitShift = 8,     // Width/height of each bucket in pixels, in a form of 2 ^ n, 8 is 256 pixels
+      DefaultBucketRowCount = 16,         // Number of buckets per grid row, and number of rows, until resizeGrid() is called
+      MinBucketWidthBitShift = 6,         // Don't let buckets get smaller than 64 pixels...
+      MaxBucketWidthBitShift = 16,        // ...or bigger than 65536 pixels
+      MaxBucketRowCount = 256,            // Cap on buckets per row/column; larger levels will get larger buckets
    };
 
    static ClassChunker<DatabaseBucketEntry> *mChunker;
 
-   DatabaseBucketEntryBase mBuckets[BucketRowCount][BucketRowCount];
-
    explicit GridDatabase(bool createWallSegmentManager = true);   // Constructor
    // GridDatabase::GridDatabase(const GridDatabase &source);
    virtual ~GridDatabase();                                       // Destructor
 
 
-   static const S32 BucketWidthBitShift = 8;    // Width/height of each bucket in pixels, in a form of 2 ^ n, 8 is 256 pixels
+   void resizeGrid(const Rect &extents, U32 bucketWidthBitShift = DefaultBucketWidthBitShift);   // Rebuild grid to cover extents
+   static U32 getBucketWidthBitShift(U32 bucketWidth);                                            // Convert a width in pixels to a shift
+
+   static bool isStaticType(U8 typeNumber);     // Objects of these types are assumed never to move after the level loads
+   void buildStaticIndex();                     // Move all static objects currently in the database out of the grid
+   S32 getStaticObjectCount() const;
+
+   S32 getBucketWidth() const;
+   S32 getGridWidth() const;
+   S32 getGridHeight() const;
+
+   const QueryStats &getQueryStats() const;     // Stats for searches run without a QueryContext
+   static void setThreadQueryContext(QueryContext *context);   // For searches without a QueryContext on this thread
+   void resetQueryStats();
+
+   // Searches that can safely run alongside other searches, see QueryContext
+   void findObjects(QueryContext &context, U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
+   void findObjects(QueryContext &context, const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
+   void findObjects(QueryContext &context, TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, 
+                    bool sameQuery = false) const;
 
+   DatabaseObject *findObjectLOS(QueryContext &context, U8 typeNumber, U32 stateIndex, bool format, const Point &rayStart, 
+                                 const Point &rayEnd, float &collisionTime, Point &surfaceNormal) const;
+   DatabaseObject *findObjectLOS(QueryContext &context, TestFunc testFunc, U32 stateIndex, bool format, const Point &rayStart, 
+                                 const Point &rayEnd, float &collisionTime, Point &surfaceNormal) const;
+
+   bool pointCanSeePoint(QueryContext &context, const Point &point1, const Point &point2) const;
+
+   // The same searches, using the database's own context
    DatabaseObject *findObjectLOS(U8 typeNumber, U32 stateIndex, bool format, const Point &rayStart, const Point &rayEnd,
                                  float &collisionTime, Point &surfaceNormal) const;
    DatabaseObject *findObjectLOS(U8 typeNumber, U32 stateIndex, const Point &rayStart, const Point &rayEnd,
@@ -152,7 +347,7 @@ public:
 
    void findObjects(Vector<DatabaseObject *> &fillVector) const;     // Returns all objects in the database
    const Vector<DatabaseObject *> *findObjects_fast() const;         // Faster than above, but results can't be modified
-   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Currently only works with goalZones, may be expanded in the future
+   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Objects filed under typeNumber, including deleted ones
 
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
@@ -174,7 +369,8 @@ public:
    void dumpObjects();     // For debugging purposes
 
    
-   Rect getExtents();      // Get the combined extents of every object in the database
+   Rect getExtents() const;   // Get the combined extents of every object in the database
+   U32 getChangeCount() const;
 
    WallSegmentManager *getWallSegmentManager() const;      
 
@@ -192,12 +388,15 @@ public:
 };
 
 
-};
+// Puts barriers at the front of objects; does nothing if they're already there, as they will be if they all came from a static index
+void sortBarriersFirst(Vector<DatabaseObject *> &objects);
 
 
-// Reusable container for searching gridDatabases
+};
+
+// Reusable container for searching gridDatabases; one per thread, as robots can search from BotWorkerPool threads
 // putting it outside of Zap namespace seems to help with visual C++ debugging showing whats inside fillVector  (debugger forgets to add Zap::)
-extern Vector<Zap::DatabaseObject *> fillVector;
-extern Vector<Zap::DatabaseObject *> fillVector2;
+extern thread_local Vector<Zap::DatabaseObject *> fillVector;
+extern thread_local Vector<Zap::DatabaseObject *> fillVector2;
 
 #endif
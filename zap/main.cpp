@@ -83,6 +83,7 @@ include (replaces require)
 #include "zapjournal.h"
 
 #include "GameManager.h"
+#include "gameNetInterface.h"
 
 using namespace TNL;
 
@@ -120,9 +121,11 @@ using namespace TNL;
 #include "BotNavMeshZone.h"
 #include "ship.h"
 #include "LevelSource.h"
+#include "TickScheduler.h"
 
 #include <math.h>
 #include <stdarg.h>
+#include <signal.h>
 #include <sys/stat.h>
 
 #ifdef WIN32
@@ -268,6 +271,21 @@ void display()
 
 void shutdownBitfighter();    // Forward declaration
 
+// Set by ^C or SIGTERM on a dedicated server; idle() picks it up and shuts down the usual way
+static volatile sig_atomic_t gShutdownSignal = 0;
+
+static void requestShutdown(int sig)
+{
+   if(gShutdownSignal)     // Asked twice, and we still haven't gone... stop waiting
+   {
+      signal(sig, SIG_DFL);
+      raise(sig);
+      return;
+   }
+
+   gShutdownSignal = sig;
+}
+
 // If the server game exists, and is shutting down, close any ClientGame connections we might have to it, then delete it.
 // If there are no client games, delete it and return to the OS.
 void checkIfServerGameIsShuttingDown(U32 timeDelta)
@@ -319,12 +337,65 @@ void loadAnotherLevelOrStartHosting()
 }
 
 
+// Dedicated servers run the game at a fixed rate, and otherwise sleep until a packet comes in or the next tick is due
+static void dedicatedIdle(ServerGame *serverGame)
+{
+   // idle() loads one level per call; don't hold each one up for a tick.  Just answer any packets that are waiting.
+   if(GameManager::getHostingModePhase() == GameManager::LoadingLevels)
+   {
+      serverGame->getNetInterface()->checkIncomingPackets();
+      return;
+   }
+
+   TickScheduler *scheduler = serverGame->getTickScheduler();
+
+   // If there are no players, tick less often to reduce impact on the server.  Packets still get our attention as
+   // soon as they arrive, so pings from the server lobby stay accurate.
+   U32 tickRate = serverGame->isSuspended() ? 25 : serverGame->getSettings()->getIniSettings()->maxDedicatedFPS;
+
+   scheduler->setTickRate(tickRate);
+   scheduler->setSocket(serverGame->getNetInterface()->getSocket().getPlatformSocket());
+
+   S32 ticks = scheduler->wait();
+
+   if(ticks == 0)    // Woken by a packet; read it now, and reply on the next tick
+   {
+      serverGame->getNetInterface()->checkIncomingPackets();
+      return;
+   }
+
+   for(S32 i = 0; i < ticks; i++)
+   {
+      U32 deltaT = scheduler->takeTickTime();
+
+      checkIfServerGameIsShuttingDown(deltaT);
+      GameManager::idle(deltaT);
+
+#ifndef ZAP_DEDICATED
+      AppIntegrationController::idle(deltaT);      // Run 3rd-party app things
+#endif
+   }
+}
+
+
 // This is the master idle loop that is called on every game tick.
 // This in turn calls the idle functions for all other objects in the game.
 void idle()
 {
+   if(gShutdownSignal)
+   {
+      logprintf("Received signal %d, shutting down", (S32)gShutdownSignal);
+      shutdownBitfighter();
+   }
+
    loadAnotherLevelOrStartHosting();
 
+   if(GameManager::getServerGame() && GameManager::getServerGame()->isDedicated())
+   {
+      dedicatedIdle(GameManager::getServerGame());
+      return;
+   }
+
    // Acquire a settings object... from somewhere
    GameSettings *settings;
 
@@ -348,26 +419,19 @@ void idle()
 
    U32 sleepTime = 1;
 
-   bool dedicated = GameManager::getServerGame() && GameManager::getServerGame()->isDedicated();
-
-   U32 maxFPS = dedicated ? settings->getIniSettings()->maxDedicatedFPS : settings->getIniSettings()->maxFPS;
-
-   if(deltaT >= S32(1000 / maxFPS))
+   if(deltaT >= S32(1000 / settings->getIniSettings()->maxFPS))
    {
       checkIfServerGameIsShuttingDown(U32(deltaT));
       GameManager::idle(U32(deltaT));
 
 #ifndef ZAP_DEDICATED
-      if(!dedicated)
-         display();          // Draw the screen if not dedicated
+      display();          // Draw the screen
 
       // Run 3rd-party app things
       AppIntegrationController::idle(U32(deltaT));
 #endif
       deltaT = 0;
-
-      if(!dedicated)
-         sleepTime = 0;      
+      sleepTime = 0;      
    }
 
 
@@ -392,14 +456,7 @@ void idle()
 #endif
 
 
-   // Sleep a bit so we don't saturate the system. For a non-dedicated server,
-   // sleep(0) helps reduce the impact of OpenGL on windows.
-
-   // If there are no players, set sleepTime to 40 to further reduce impact on the server.
-   // We'll only go into this longer sleep on dedicated servers when there are no players.
-   if(dedicated && GameManager::getServerGame()->isSuspended())
-      sleepTime = 40;     // The higher this number, the less accurate the ping is on server lobby when empty, but the less power consumed.
-
+   // Sleep a bit so we don't saturate the system; sleep(0) helps reduce the impact of OpenGL on windows
    Platform::sleep(sleepTime);
 
 }  // end idle()
@@ -460,7 +517,10 @@ void shutdownBitfighter()
    if(GameManager::getClientGames()->size() == 0)
 #endif
       if(GameManager::getServerGame())
+      {
+         GameManager::getServerGame()->finishRecording();   // exitToOs() won't get as far as deleting the ServerGame
          exitToOs();
+      }
 
 // Grab a pointer to settings wherever we can.  Note that all Games (client or server) currently refer to the same settings object.
 #ifndef ZAP_DEDICATED
@@ -542,6 +602,9 @@ void setupLogging(IniSettings *iniSettings)
    //gMainLog.setMsgType(LogConsumer::LuaLevelGenerator,     iniSettings->luaLevelGenerator); 
    gMainLog.setMsgType(LogConsumer::LuaScriptMessage,      iniSettings->luaScriptMessage);      // Used for both bots and levelgens and plugins too!
    gMainLog.setMsgType(LogConsumer::ServerFilter,          iniSettings->serverFilter); 
+
+   gMainLog.setRotation  (iniSettings->logRotateSize * 1024 * 1024, iniSettings->logRotateHours * 60 * 60);
+   gServerLog.setRotation(iniSettings->logRotateSize * 1024 * 1024, iniSettings->logRotateHours * 60 * 60);
 }
 
 
@@ -1080,6 +1143,7 @@ void exceptionHandler(int sig) {
       logprintf(LogConsumer::LogError, "%d: %s", i, functions[i]);
 
    free(functions);
+   LogConsumer::flushAllFromSignal();     // Not flushAll(), which could wait forever on a lock the writer holds
    //exit(1); // let it die (or use debugger) the normal way, after we turn off our handler
 }
 #endif
@@ -1133,6 +1197,8 @@ int main(int argc, char **argv)
 //_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF | _CRTDBG_CHECK_ALWAYS_DF );
 
 
+   LogConsumer::flushAllOnExit();       // Logs are written on threads of their own; don't lose the last lines
+
 #ifdef USE_EXCEPTION_BACKTRACE
    signal(SIGSEGV, exceptionHandler);   // install our handler
 #endif
@@ -1219,6 +1285,10 @@ int main(int argc, char **argv)
    
    if(settings->isDedicatedServer())
    {
+      // No SDL here to turn these into SDL_QUIT, so we'll catch them ourselves
+      signal(SIGINT, requestShutdown);
+      signal(SIGTERM, requestShutdown);
+
 #ifndef ZAP_DEDICATED
       // Dedicated ClientGame needs fonts, but not external ones
       FontManager::initialize(settings.get(), false);
@@ -185,11 +185,12 @@ Point MoveObject::getPos(S32 stateIndex) const
 void MoveObject::setPos(S32 stateIndex, const Point &pos)
 {
    if(stateIndex == ActualState)
-      Parent::setPos(pos);
+      Parent::setPos(pos);    // Will update our outline
    else
+   {
       mMoveStates.setPos(stateIndex, pos);
-
-   setOutline();
+      setOutline();
+   }
 }
 
 
@@ -331,38 +332,48 @@ const F32 velocityEpsilon = 0.00001f;
 // Apply mMoveState info to an object to compute it's new position.  Used for ships et. al.
 // isBeingDisplaced is true when the object is being pushed by something else, which will only happen in a collision
 // Remember: stateIndex will be one of 0-ActualState, 1-RenderState, or 2-LastProcessState
-F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector<SafePtr<MoveObject> > displacerList)
+F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced)
+{
+   Vector<SafePtr<MoveObject> > displacerList;
+   return move(moveTime, stateIndex, isBeingDisplaced, displacerList);
+}
+
+
+// displacerList holds the objects that are pushing us, directly or through a chain of other objects.  We add ourselves to
+// it while we push others, and leave it as we found it when we return, so one list can be shared by the whole chain.
+F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector<SafePtr<MoveObject> > &displacerList)
 {
    U32 tryCount = 0;
    const U32 TRY_COUNT_MAX = 8;
    Vector<SafePtr<BfObject> > disabledList;
    F32 moveTimeStart = moveTime;
+   S32 displacerCount = displacerList.size();
 
-   static Point origPos;   // Reusable container
-   origPos = getPos(stateIndex);
+   Point origPos = getPos(stateIndex);
 
    while(moveTime > moveTimeEpsilon && tryCount < TRY_COUNT_MAX)     // moveTimeEpsilon is a very short, but non-zero, bit of time
    {
       tryCount++;
 
+      Point pos = getPos(stateIndex);
+      Point vel = getVel(stateIndex);
+
       // Ignore tiny movements unless we're processing a collision
-      if(!isBeingDisplaced && getVel(stateIndex).len() < velocityEpsilon)
+      if(!isBeingDisplaced && vel.len() < velocityEpsilon)
          break;
 
       F32 collisionTime = moveTime;
-      static Point collisionPoint, newPos;     // Reusable containers
+      Point collisionPoint;
 
       BfObject *objectHit = findFirstCollision(stateIndex, collisionTime, collisionPoint);
       if(!objectHit)    // No collision (or if isBeingDisplaced is true, we haven't been pushed into another object)
       {
-         newPos = getPos(stateIndex) + getVel(stateIndex) * moveTime;   // Move to desired destination
-         setPos(stateIndex, newPos);
+         setPos(stateIndex, pos + vel * moveTime);      // Move to desired destination
          break;
       }
 
       // Collision!  Advance to the point of collision
-      newPos = getPos(stateIndex) + getVel(stateIndex) * collisionTime;    // x = x + vt
-      setPos(stateIndex, newPos);                                          // setPos(x)
+      setPos(stateIndex, pos + vel * collisionTime);    // x = x + vt
 
       // Collided is a sort of collision pre-handler; it will return true if the collision was dealt with, false if not
       if(collided(objectHit, stateIndex) || objectHit->collided(this, stateIndex))
@@ -376,9 +387,8 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
          TNLAssert(dynamic_cast<MoveObject *>(objectHit), "Not a MoveObject");
          MoveObject *moveObjectThatWasHit = static_cast<MoveObject *>(objectHit);
 
-         static Point velDelta, posDelta;    // Reusable containers
-         velDelta = moveObjectThatWasHit->getVel(stateIndex) - getVel(stateIndex);
-         posDelta = moveObjectThatWasHit->getPos(stateIndex) - getPos(stateIndex);
+         Point velDelta = moveObjectThatWasHit->getVel(stateIndex) - getVel(stateIndex);
+         Point posDelta = moveObjectThatWasHit->getPos(stateIndex) - getPos(stateIndex);
 
          // Prevent infinite loops with a series of objects trying to displace each other forever
          if(isBeingDisplaced)
@@ -432,6 +442,8 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
    if(tryCount == TRY_COUNT_MAX && moveTime > moveTimeStart * 0.98f)
       setVel(stateIndex, Point(0,0));  // prevents some overload by not trying to move anymore
 
+   displacerList.resize(displacerCount);     // Take ourselves back off the list before returning to whoever pushed us
+
    return (getPos(stateIndex) - origPos).len();    // Return distance traveled during this move
 }
 
@@ -448,30 +460,31 @@ TestFunc MoveObject::collideTypes()
 }
 
 
-static S32 QSORT_CALLBACK sortBarriersFirst(DatabaseObject **a, DatabaseObject **b)
-{
-   return ((*b)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0) - ((*a)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0);
-}
-
-
 BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Point &collisionPoint)
 {
+   const Point pos = getPos(stateIndex);
+   const Point vel = getVel(stateIndex);
+
    // Check for collisions against other objects
-   Point delta = getVel(stateIndex) * collisionTime;
+   Point delta = vel * collisionTime;
 
-   Rect queryRect(getPos(stateIndex), getPos(stateIndex) + delta);
+   Rect queryRect(pos, pos + delta);
    queryRect.expand(Point(mRadius, mRadius));
 
    fillVector.clear();
 
    findObjects(collideTypes(), fillVector, queryRect);   // Free CPU for finding only the ones we care about
 
-   fillVector.sort(sortBarriersFirst);  // Sort to do Barriers::Collide first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client does /maxfps 10
+   sortBarriersFirst(fillVector);  // Sort to do Barriers::Collide first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client does /maxfps 10
 
    F32 collisionFraction;
 
    BfObject *collisionObject = NULL;
 
+   F32 myRadius = 0;
+   Point myPos;
+   bool haveMyCircle = false;
+
    for(S32 i = 0; i < fillVector.size(); i++)
    {
       BfObject *foundObject = static_cast<BfObject *>(fillVector[i]);
@@ -484,11 +497,15 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
       if(poly)
       {
          Point cp;
+         const PackedPolygon *packedPoly = foundObject->getPackedCollisionPoly();
+
+         bool hit = packedPoly ?
+               PolygonSweptCircleIntersect(*packedPoly, pos, delta, mRadius, cp, collisionFraction) :
+               PolygonSweptCircleIntersect(&poly->first(), poly->size(), pos, delta, mRadius, cp, collisionFraction);
 
-         if(PolygonSweptCircleIntersect(&poly->first(), poly->size(), getPos(stateIndex),
-                                        delta, mRadius, cp, collisionFraction))
+         if(hit)
          {
-            if(cp != getPos(stateIndex) || !isCollideableType(foundObject->getObjectTypeNumber()))   // Avoid getting stuck inside polygon wall
+            if(cp != pos || !isCollideableType(foundObject->getObjectTypeNumber()))   // Avoid getting stuck inside polygon wall
             {
                bool collide1 = collide(foundObject);
                bool collide2 = foundObject->collide(this);
@@ -508,14 +525,19 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
       }
       else
       {
-         F32   myRadius, otherRadius;
-         Point myPos,    shipPos;
+         F32   otherRadius;
+         Point shipPos;
 
-         getCollisionCircle(stateIndex, myPos, myRadius);
          if(foundObject->getCollisionCircle(stateIndex, shipPos, otherRadius))
          {
+            // Fetched lazily, as most of what we find has no collision circle
+            if(!haveMyCircle)
+            {
+               getCollisionCircle(stateIndex, myPos, myRadius);
+               haveMyCircle = true;
+            }
 
-            Point v = getVel(stateIndex);
+            const Point &v = vel;
             Point p = myPos - shipPos;
 
             if(v.dot(p) < 0)
@@ -553,7 +575,7 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
 
                      collisionTime = t;
                      collisionObject = foundObject;
-                     delta = getVel(stateIndex) * collisionTime;
+                     delta = vel * collisionTime;
 
                      p.normalize(otherRadius);  // we need this calculation, just to properly show bounce sparks at right position
                      collisionPoint = shipPos + p;
@@ -147,7 +147,8 @@ public:
 
    virtual void playCollisionSound(U32 stateIndex, MoveObject *moveObjectThatWasHit, F32 velocity);
 
-   F32 move(F32 time, U32 stateIndex, bool displacing = false, Vector<SafePtr<MoveObject> > = Vector<SafePtr<MoveObject> >());
+   F32 move(F32 time, U32 stateIndex, bool displacing = false);
+   F32 move(F32 time, U32 stateIndex, bool displacing, Vector<SafePtr<MoveObject> > &displacerList);
    virtual bool collide(BfObject *otherObject);
 
    // CollideTypes is used to improve speed on findFirstCollision
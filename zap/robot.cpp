@@ -7,6 +7,7 @@
 
 #include "playerInfo.h"          // For RobotPlayerInfo constructor
 #include "BotNavMeshZone.h"      // For BotNavMeshZone class definition
+#include "BotZoneGrid.h"         // For BotSightMemo
 #include "gameObjectRender.h"
 #include "GameSettings.h"
 
@@ -132,7 +133,8 @@ Robot::Robot(lua_State *L) : Ship(NULL, TEAM_NEUTRAL, Point(0,0), true),
    mObjectTypeNumber = RobotShipTypeNumber;
 
    mCurrentZone = U16_MAX;
-   flightPlanTo = U16_MAX;
+   mFlightPlanSize = 0;
+   mFlightPlanTo = U16_MAX;
 
    mPlayerInfo = new RobotPlayerInfo(this);
 
@@ -193,7 +195,7 @@ bool Robot::initialize(Point &pos)
 
    try
    {
-      flightPlan.clear();
+      clearFlightPlan();
 
       mCurrentZone = U16_MAX;   // Correct value will be calculated upon first request
 
@@ -500,6 +502,22 @@ F32 Robot::getAnglePt(Point point)
 
 
 bool Robot::canSeePoint(Point point, bool wallOnly)
+{
+   // Robots often look at the same things, and from the same places, more than once a tick
+   BotSightMemo *memo = static_cast<ServerGame *>(getGame())->getBotSightMemo();
+
+   bool canSee;
+   if(memo->lookup(getActualPos(), point, mRadius, wallOnly, canSee))
+      return canSee;
+
+   canSee = canSeePointUncached(point, wallOnly);
+   memo->store(getActualPos(), point, mRadius, wallOnly, canSee);
+
+   return canSee;
+}
+
+
+bool Robot::canSeePointUncached(const Point &point, bool wallOnly)
 {
    Point difference = point - getActualPos();
 
@@ -522,12 +540,13 @@ bool Robot::canSeePoint(Point point, bool wallOnly)
 
    Rect queryRect(thisPoints);
 
-   fillVector.clear();
-   mGame->getGameObjDatabase()->findObjects(wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType, fillVector, queryRect);
+   mFoundObjects.clear();
+   mGame->getGameObjDatabase()->findObjects(mQueryContext, wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType, 
+                                            mFoundObjects, queryRect);
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < mFoundObjects.size(); i++)
    {
-      const Vector<Point> *otherPoints = fillVector[i]->getCollisionPoly();
+      const Vector<Point> *otherPoints = mFoundObjects[i]->getCollisionPoly();
       if(otherPoints && polygonsIntersect(thisPoints, *otherPoints))
          return false;
    }
@@ -542,12 +561,41 @@ void Robot::renderLayer(S32 layerIndex)
    if(isGhost())                                         // Client rendering client's objects
       Parent::renderLayer(layerIndex);
 
-   else if(layerIndex == 1 && flightPlan.size() != 0)    // WARNING!!  Client hosting is rendering server objects
+   else if(layerIndex == 1 && mFlightPlanSize != 0)      // WARNING!!  Client hosting is rendering server objects
+   {
+      Vector<Point> flightPlan(mFlightPlanSize);
+      for(S32 i = 0; i < mFlightPlanSize; i++)
+         flightPlan.push_back(getFlightPlanPoint(i));
+
       renderFlightPlan(getActualPos(), flightPlan.last(), flightPlan);
+   }
 #endif
 }
 
 
+void Robot::setFlightPlan(const FlightPlanPtr &flightPlan, const Point &target)
+{
+   mFlightPlan = flightPlan;
+   mFlightPlanSize = flightPlan->size();
+   mFlightPlanTarget = target;
+}
+
+
+void Robot::clearFlightPlan()
+{
+   mFlightPlan.reset();
+   mFlightPlanSize = 0;
+}
+
+
+// The first point is always our target; the rest come from the plan
+Point Robot::getFlightPlanPoint(S32 index) const
+{
+   TNLAssert(index >= 0 && index < mFlightPlanSize, "Index out of range!");
+   return index == 0 ? mFlightPlanTarget : mFlightPlan->get(index);
+}
+
+
 void Robot::idle(BfObject::IdleCallPath path)
 {
    TNLAssert(path != BfObject::ServerProcessingUpdatesFromClient, "Should never idle with ServerProcessingUpdatesFromClient");
@@ -618,48 +666,7 @@ Robot *Robot::clone() const
 // Another helper function: returns id of closest zone to a given point
 U16 Robot::findClosestZone(const Point &point)
 {
-   U16 closestZone = U16_MAX;
-
-   // First, do a quick search for zone based on the buffer; should be 99% of the cases
-
-   // Search radius is just slightly larger than twice the zone buffers added to objects like barriers
-   S32 searchRadius = 2 * BotNavMeshZone::BufferRadius + 1;
-
-   Vector<DatabaseObject*> objects;
-   Rect rect = Rect(point.x + searchRadius, point.y + searchRadius, point.x - searchRadius, point.y - searchRadius);
-
-   getGame()->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, objects, rect);
-
-   for(S32 i = 0; i < objects.size(); i++)
-   {
-      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(objects[i]);
-      Point center = zone->getCenter();
-
-      if(getGame()->getGameObjDatabase()->pointCanSeePoint(center, point))  // This is an expensive test
-      {
-         closestZone = zone->getZoneId();
-         break;
-      }
-   }
-
-   // Target must be outside extents of the map, find nearest zone if a straight line was drawn
-   if(closestZone == U16_MAX)
-   {
-      Point extentsCenter = getGame()->getWorldExtents()->getCenter();
-
-      F32 collisionTimeIgnore;
-      Point surfaceNormalIgnore;
-
-      DatabaseObject* object = getGame()->getBotZoneDatabase()->findObjectLOS(BotNavMeshZoneTypeNumber,
-            ActualState, point, extentsCenter, collisionTimeIgnore, surfaceNormalIgnore);
-
-      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(object);
-
-      if (zone != NULL)
-         closestZone = zone->getZoneId();
-   }
-
-   return closestZone;
+   return static_cast<ServerGame *>(getGame())->findClosestZone(mQueryContext, point);
 }
 
 //// Lua methods
@@ -810,7 +817,7 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    // If we can see the target, go there directly
    if(canSeePoint(target, true))
    {
-      flightPlan.clear();
+      clearFlightPlan();
       return returnPoint(L, target);
    }
 
@@ -828,10 +835,10 @@ S32 Robot::lua_getWaypoint(lua_State *L)
 
    // Make sure target is still in the same zone it was in when we created our flightplan.
    // If we're not, our flightplan is invalid, and we need to skip forward and build a fresh one.
-   if(flightPlan.size() > 0 && targetZone == flightPlanTo)
+   if(mFlightPlanSize > 0 && targetZone == mFlightPlanTo)
    {
       // In case our target has moved, replace final point of our flightplan with the current target location
-      flightPlan[0] = target;
+      mFlightPlanTarget = target;
 
       // First, let's scan through our pre-calculated waypoints and see if we can see any of them.
       // If so, we'll just head there with no further rigamarole.  Remember that our flightplan is
@@ -840,9 +847,9 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       bool found = false;
 //      bool first = true;
 
-      while(flightPlan.size() > 0)
+      while(mFlightPlanSize > 0)
       {
-         Point last = flightPlan.last();
+         Point last = getFlightPlanPoint(mFlightPlanSize - 1);
 
          // We'll assume that if we could see the point on the previous turn, we can
          // still see it, even though in some cases, the turning of the ship around a
@@ -856,7 +863,7 @@ S32 Robot::lua_getWaypoint(lua_State *L)
             dest = last;
             found = true;
 //            first = false;
-            flightPlan.pop_back();   // Discard now possibly superfluous waypoint
+            mFlightPlanSize--;       // Discard now possibly superfluous waypoint
          }
          else
             break;
@@ -865,13 +872,13 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       // If we found one, that means we found a visible waypoint, and we can head there...
       if(found)
       {
-         flightPlan.push_back(dest);    // Put dest back at the end of the flightplan
+         mFlightPlanSize++;             // Put dest back at the end of the flightplan
          return returnPoint(L, dest);
       }
    }
 
    // We need to calculate a new flightplan
-   flightPlan.clear();
+   clearFlightPlan();
 
    U16 currentZone = getCurrentZone();     // Zone we're in
 
@@ -885,43 +892,32 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    if(currentZone == targetZone)
    {
       Point p;
-      flightPlan.push_back(target);
+      Vector<Point> *flightPlan = new Vector<Point>();
+      flightPlan->push_back(target);
 
       if(!canSeePoint(target, true))           // Possible, if we're just on a boundary, and a protrusion's blocking a ship edge
       {
          BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(getGame()->getBotZoneDatabase()->getObjectByIndex(targetZone));
 
          p = zone->getCenter();
-         flightPlan.push_back(p);
+         flightPlan->push_back(p);
       }
       else
          p = target;
 
+      setFlightPlan(FlightPlanPtr(flightPlan), target);
       return returnPoint(L, p);
    }
 
    // If we're still here, then we need to find a new path.  Either our original path was invalid for some reason,
    // or the path we had no longer applied to our current location
-   flightPlanTo = targetZone;
-
-   // check cache for path first
-   pair<S32,S32> pathIndex = pair<S32,S32>(currentZone, targetZone);
+   mFlightPlanTo = targetZone;
 
-   const Vector<BotNavMeshZone *> *zones = static_cast<ServerGame *>(getGame())->getBotZones();  // Our pre-cached list of nav zones
+   // Paths are cached, and shared with any other robot going the same way
+   setFlightPlan(static_cast<ServerGame *>(getGame())->getBotPathPlanner()->findPath(currentZone, targetZone), target);
 
-   if(getGame()->getGameType()->cachedBotFlightPlans.find(pathIndex) == getGame()->getGameType()->cachedBotFlightPlans.end())
-   {
-      // Not found so calculate flight plan
-      flightPlan = AStar::findPath(zones, currentZone, targetZone, target);
-
-      // Add to cache
-      getGame()->getGameType()->cachedBotFlightPlans[pathIndex] = flightPlan;
-   }
-   else
-      flightPlan = getGame()->getGameType()->cachedBotFlightPlans[pathIndex];
-
-   if(flightPlan.size() > 0)
-      return returnPoint(L, flightPlan.last());
+   if(mFlightPlanSize > 0)
+      return returnPoint(L, getFlightPlanPoint(mFlightPlanSize - 1));
    else
       return returnNil(L);    // Out of options, end of the road
 }
@@ -966,21 +962,21 @@ S32 Robot::lua_findClosestEnemy(lua_State *L)
    F32 minDist = F32_MAX;
    Ship *closest = NULL;
 
-   fillVector.clear();
+   mFoundObjects.clear();
 
    if(useRange)
-      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, fillVector, queryRect);   
+      getGame()->getGameObjDatabase()->findObjects(mQueryContext, (TestFunc)isShipType, mFoundObjects, queryRect);   
    else
-      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, fillVector);   
+      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, mFoundObjects);   
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < mFoundObjects.size(); i++)
    {
       // Ignore self 
-      if(fillVector[i] == this) 
+      if(mFoundObjects[i] == this) 
          continue;
 
       // Ignore ship/robot if it's dead or cloaked
-      Ship *ship = static_cast<Ship *>(fillVector[i]);
+      Ship *ship = static_cast<Ship *>(mFoundObjects[i]);
       if(ship->mHasExploded || !ship->isVisible(hasModule(ModuleSensor)))
          continue;
 
@@ -1371,10 +1367,8 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
    Rect queryRect(pos, pos);
    queryRect.expand(getGame()->computePlayerVisArea(this));
 
-   fillVector.clear();
-   static Vector<U8> types;
-
-   types.clear();
+   mFoundObjects.clear();
+   mSearchTypes.clear();
 
    // We expect the stack to look like this: -- objType1, objType2, ...
    // or this, if using the deprecated fill table option -- [fillTable], objType1, objType2, ...
@@ -1386,17 +1380,17 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
       U8 typenum = (U8)lua_tointeger(L, -1);
 
       // Requests for botzones have to be handled separately; not a problem, we'll just do the search here, and add them to
-      // fillVector, where they'll be merged with the rest of our search results.
+      // mFoundObjects, where they'll be merged with the rest of our search results.
       if(typenum != BotNavMeshZoneTypeNumber)
-         types.push_back(typenum);
+         mSearchTypes.push_back(typenum);
       else
-         getGame()->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, fillVector, queryRect);
+         getGame()->getBotZoneDatabase()->findObjects(mQueryContext, BotNavMeshZoneTypeNumber, mFoundObjects, queryRect);
 
       lua_pop(L, 1);
    }
 
    // Get other objects on screen-visible area only
-   getGame()->getGameObjDatabase()->findObjects(types, fillVector, queryRect);
+   getGame()->getGameObjDatabase()->findObjects(mQueryContext, mSearchTypes, mFoundObjects, queryRect);
 
 
    // We are expecting a table to be on top of the stack when we get here.  If not, we can add one.
@@ -1417,21 +1411,21 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
 
    S32 pushed = 0;      // Count of items we put into our table
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < mFoundObjects.size(); i++)
    {
-      if(isShipType(fillVector[i]->getObjectTypeNumber()))
+      if(isShipType(mFoundObjects[i]->getObjectTypeNumber()))
       {
-         if(fillVector[i] == this)  // Don't add this bot to the list of found objects!
+         if(mFoundObjects[i] == this)  // Don't add this bot to the list of found objects!
             continue;
 
          // Ignore ship/robot if it's dead or cloaked (unless bot has sensor)
-         Ship *ship = static_cast<Ship *>(fillVector[i]);
+         Ship *ship = static_cast<Ship *>(mFoundObjects[i]);
          bool callerHasSensor = this->hasModule(ModuleSensor);
          if(!ship->isVisible(callerHasSensor) || ship->mHasExploded)
             continue;
       }
 
-      static_cast<BfObject *>(fillVector[i])->push(L);
+      static_cast<BfObject *>(mFoundObjects[i])->push(L);
       pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
       lua_rawseti(L, 1, pushed);
    }
@@ -1567,7 +1561,8 @@ S32 Robot::lua_getInterceptCourse(lua_State *L)
  *
  * @param which The \ref EngineerBuildObjectEnum to build.
  *
- * @return `true` if the item was successfully deployed, false otherwise.
+ * @return `true` if the item was successfully deployed, false otherwise.  Called from onTick() on a server running
+ * robots on BotWorkerThreads, it returns nil, as the item isn't deployed until every robot is done thinking.
  */
 S32 Robot::lua_engineerDeployObject(lua_State *L)
 {
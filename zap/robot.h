@@ -8,6 +8,7 @@
 
 
 #include "ship.h"             // Parent class
+#include "BotPathPlanner.h"   // For FlightPlanPtr
 
 namespace Zap
 {
@@ -38,8 +39,25 @@ private:
 
    bool mHasSpawned;
 
+   // Bots run their spatial searches with their own state and buffers, rather than sharing the global fillVector
+   GridDatabase::QueryContext mQueryContext;
+   Vector<DatabaseObject *> mFoundObjects;
+   Vector<U8> mSearchTypes;
+
+   // Our flightplan is shared with any other robot going between the same zones, so rather than change it, we keep track
+   // of how much of it is left, and of where our own target is, which takes the place of the plan's first point
+   FlightPlanPtr mFlightPlan;       // List of points to get from one point to another
+   S32 mFlightPlanSize;             // Number of points from the start of mFlightPlan that we have yet to visit
+   Point mFlightPlanTarget;
+   U16 mFlightPlanTo;               // Zone our flightplan was calculated to
+
+   void setFlightPlan(const FlightPlanPtr &flightPlan, const Point &target);
+   void clearFlightPlan();
+   Point getFlightPlanPoint(S32 index) const;
+
    Point getNextWaypoint();                          // Helper function for getWaypoint()
    U16 findClosestZone(const Point &point);          // Finds zone closest to point, used when robots get off the map
+   bool canSeePointUncached(const Point &point, bool wallOnly);
 
 protected:
    void killScript();
@@ -63,9 +81,6 @@ public:
    void setCurrentZone(S32 zone);
    bool canSeePoint(Point point, bool wallOnly = false);         // Is point within robot's LOS?
 
-   Vector<Point> flightPlan;           // List of points to get from one point to another
-   U16 flightPlanTo;                   // Zone our flightplan was calculated to
-
    // Some informational functions
    F32 getAnglePt(Point point);
 
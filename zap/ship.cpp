@@ -1681,14 +1681,14 @@ void Ship::unpackUpdate(GhostConnection *connection, BitStream *stream)
 
 F32 Ship::getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips)
 {
-   F32 value = Parent::getUpdatePriority(connection, updateMask, updateSkips);
+   return Parent::getUpdatePriority(connection, updateMask, updateSkips) + getUpdatePriorityAdjustment(this);
+}
 
-   if(getControllingClient())
-      value += 2.3f;
-   else
-      value -= 2.3f;
 
-   return value;
+// Shared with BfObject::computeUpdatePriorities()
+F32 Ship::getUpdatePriorityAdjustment(BfObject *ship)
+{
+   return static_cast<Ship *>(ship)->getControllingClient() ? 2.3f : -2.3f;
 }
 
 
@@ -291,6 +291,7 @@ public:
    void updateInterpolation();
 
    F32 getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips);
+   static F32 getUpdatePriorityAdjustment(BfObject *ship);
 
    bool isRobot();
 
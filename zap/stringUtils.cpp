@@ -536,6 +536,37 @@ bool getFilesFromFolder(const string &dir, Vector<string> &files, const string e
 }
 
 
+// Delete the least recently modified files with the given extension from dir, until only filesToKeep are left
+void deleteOldestFiles(const string &dir, const string &extension, S32 filesToKeep)
+{
+   const string extensions[] = { extension };
+
+   Vector<string> files;
+   if(!getFilesFromFolder(dir, files, extensions, ARRAYSIZE(extensions)) || files.size() <= filesToKeep)
+      return;
+
+   Vector<time_t> times(files.size());
+
+   for(S32 i = 0; i < files.size(); i++)
+   {
+      struct stat st;
+      times.push_back(stat(joindir(dir, files[i]).c_str(), &st) == 0 ? st.st_mtime : 0);
+   }
+
+   while(files.size() > filesToKeep)
+   {
+      S32 oldest = 0;
+      for(S32 i = 1; i < files.size(); i++)
+         if(times[i] < times[oldest])
+            oldest = i;
+
+      remove(joindir(dir, files[oldest]).c_str());
+      files.erase_fast(oldest);
+      times.erase_fast(oldest);
+   }
+}
+
+
 // Make sure a file name is 'safe', i.e. not having a path component
 bool safeFilename(const char *str)
 {
@@ -90,6 +90,7 @@ string getFileSeparator();
 bool fileExists(const string &path);               // Does file exist?
 bool makeSureFolderExists(const string &dir);      // Like the man said: Make sure folder exists
 bool getFilesFromFolder(const string &dir, Vector<string> &files, const string extensions[] = 0, S32 extensionCount = 0);
+void deleteOldestFiles(const string &dir, const string &extension, S32 filesToKeep);
 bool safeFilename(const char *str);
 bool copyFile(const string &sourceFilename, const string &destFilename);
 bool copyFileToDir(const string &sourceFilename, const string &destDir);